@@ -125,10 +125,10 @@ public:
 	////////////////////////////////////////////////////
 	// wrapper versions that use uint32_t instead of handle
 	// for backward compatibility. Less type safe
-	void move(uint32_t p_handle, const AABB &p_aabb) {
+	void move(uint32_t p_handle, const AABB &p_aabb, bool p_defer_refit = false) {
 		BVHHandle h;
 		h.set(p_handle);
-		move(h, p_aabb);
+		move(h, p_aabb, p_defer_refit);
 	}
 
 	void erase(uint32_t p_handle) {
@@ -143,6 +143,12 @@ public:
 		force_collision_check(h);
 	}
 
+	void recheck_pairs(uint32_t p_handle) {
+		BVHHandle h;
+		h.set(p_handle);
+		recheck_pairs(h);
+	}
+
 	bool activate(uint32_t p_handle, const AABB &p_aabb, bool p_delay_collision_check = false) {
 		BVHHandle h;
 		h.set(p_handle);
@@ -180,9 +186,10 @@ public:
 
 	////////////////////////////////////////////////////
 
-	void move(BVHHandle p_handle, const AABB &p_aabb) {
+	// p_defer_refit leaves refitting the tree to update(), see BVH_Tree::item_move().
+	void move(BVHHandle p_handle, const AABB &p_aabb, bool p_defer_refit = false) {
 
-		if (tree.item_move(p_handle, p_aabb)) {
+		if (tree.item_move(p_handle, p_aabb, p_defer_refit)) {
 			if (USE_PAIRS) {
 				_add_changed_item(p_handle, p_aabb);
 			}
@@ -218,6 +225,42 @@ public:
 		}
 	}
 
+	// when the pair callback filters pairs on its side (e.g. by collision layers), the pairs it rejected
+	// are stored without userdata and never offered again. This asks the callback again for those,
+	// while pairs that already have userdata are kept as they are.
+	void recheck_pairs(BVHHandle p_handle) {
+		if (USE_PAIRS) {
+			typename BVHTREE_CLASS::ItemPairs &p_from = tree._pairs[p_handle.id()];
+
+			for (unsigned int n = 0; n < p_from.extended_pairs.size(); n++) {
+				typename BVHTREE_CLASS::ItemPairs::Link &link = p_from.extended_pairs[n];
+				if (link.userdata || !pair_callback) {
+					continue;
+				}
+
+				// same order as in _collide
+				BVHHandle ha = p_handle;
+				BVHHandle hb = link.handle;
+				tree._handle_sort(ha, hb);
+
+				const typename BVHTREE_CLASS::ItemExtra &exa = _get_extra(ha);
+				const typename BVHTREE_CLASS::ItemExtra &exb = _get_extra(hb);
+
+				void *callback_userdata = pair_callback(pair_callback_userdata, ha, exa.userdata, exa.subindex, hb, exb.userdata, exb.subindex);
+				if (!callback_userdata) {
+					continue;
+				}
+
+				// both sides store the userdata
+				link.userdata = callback_userdata;
+				typename BVHTREE_CLASS::ItemPairs &p_to = tree._pairs[link.handle.id()];
+				p_to.extended_pairs[p_to.find_pair_to(p_handle)].userdata = callback_userdata;
+			}
+
+			force_collision_check(p_handle);
+		}
+	}
+
 	// these should be read as set_visible for render trees,
 	// but generically this makes items add or remove from the
 	// tree internally, to speed things up by ignoring inactive items
@@ -362,7 +405,9 @@ public:
 		return params.result_count_overall;
 	}
 
-	int cull_convex(const Vector<Plane> &p_convex, T **p_result_array, int p_result_max, uint32_t p_mask = 0xFFFFFFFF) {
+	// p_hits can be used to provide per thread scratch, which allows
+	// culling the same BVH from several threads at once.
+	int cull_convex(const Vector<Plane> &p_convex, T **p_result_array, int p_result_max, uint32_t p_mask = 0xFFFFFFFF, LocalVector<uint32_t, uint32_t, true> *p_hits = nullptr) {
 		if (!p_convex.size())
 			return 0;
 
@@ -382,6 +427,7 @@ public:
 		params.hull.num_planes = p_convex.size();
 		params.hull.points = &convex_points[0];
 		params.hull.num_points = convex_points.size();
+		params.hits = p_hits;
 
 		tree.cull_convex(params);
 
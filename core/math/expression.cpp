@@ -2162,6 +2162,487 @@ bool Expression::_execute(const Array &p_inputs, Object *p_instance, Expression:
 	return false;
 }
 
+// While compiling, operands are tagged with their kind, as the register
+// layout is only known once all constants and temporaries are counted.
+enum {
+	OPERAND_INPUT,
+	OPERAND_CONSTANT,
+	OPERAND_TEMP,
+	OPERAND_KIND_BITS = 2,
+	OPERAND_KIND_MASK = (1 << OPERAND_KIND_BITS) - 1
+};
+
+static _FORCE_INLINE_ int _make_operand(int p_kind, int p_index) {
+	return (p_index << OPERAND_KIND_BITS) | p_kind;
+}
+
+static _FORCE_INLINE_ bool _is_constant_operand(int p_operand) {
+	return p_operand < 0 || (p_operand & OPERAND_KIND_MASK) == OPERAND_CONSTANT;
+}
+
+static bool _is_pure_func(Expression::BuiltinFunc p_func) {
+
+	switch (p_func) {
+		case Expression::MATH_RANDOMIZE:
+		case Expression::MATH_RAND:
+		case Expression::MATH_RANDF:
+		case Expression::MATH_RANDOM:
+		case Expression::MATH_SEED:
+		case Expression::MATH_RANDSEED:
+		case Expression::OBJ_WEAKREF:
+		case Expression::FUNC_FUNCREF:
+		case Expression::TYPE_EXISTS:
+		case Expression::TEXT_PRINT:
+		case Expression::TEXT_PRINTERR:
+		case Expression::TEXT_PRINTRAW:
+			return false;
+		default:
+			return true;
+	}
+}
+
+int Expression::_compile_node(ENode *p_node) {
+
+	int constants_mark = constants.size();
+
+	Instruction ins;
+	ins.a = -1;
+	ins.b = -1;
+	ins.arg_ofs = 0;
+	ins.arg_count = 0;
+	ins.extra = 0;
+
+	LocalVector<int> args;
+	bool foldable = false;
+
+	switch (p_node->type) {
+		case ENode::TYPE_INPUT: {
+
+			int index = static_cast<InputNode *>(p_node)->index;
+			ERR_FAIL_COND_V(index < 0, -1);
+			while ((int)input_used.size() <= index) {
+				input_used.push_back(false);
+			}
+			input_used[index] = true;
+			return _make_operand(OPERAND_INPUT, index);
+		} break;
+		case ENode::TYPE_CONSTANT: {
+
+			constants.push_back(static_cast<ConstantNode *>(p_node)->value);
+			return _make_operand(OPERAND_CONSTANT, constants.size() - 1);
+		} break;
+		case ENode::TYPE_SELF: {
+
+			ins.op = Instruction::OP_SELF;
+		} break;
+		case ENode::TYPE_OPERATOR: {
+
+			OperatorNode *op = static_cast<OperatorNode *>(p_node);
+			ins.op = Instruction::OP_OPERATOR;
+			ins.extra = op->op;
+			ins.a = _compile_node(op->nodes[0]);
+			if (op->nodes[1]) {
+				ins.b = _compile_node(op->nodes[1]);
+			}
+			foldable = _is_constant_operand(ins.a) && _is_constant_operand(ins.b);
+		} break;
+		case ENode::TYPE_INDEX: {
+
+			IndexNode *index = static_cast<IndexNode *>(p_node);
+			ins.op = Instruction::OP_INDEX;
+			ins.a = _compile_node(index->base);
+			ins.b = _compile_node(index->index);
+			foldable = _is_constant_operand(ins.a) && _is_constant_operand(ins.b);
+		} break;
+		case ENode::TYPE_NAMED_INDEX: {
+
+			NamedIndexNode *index = static_cast<NamedIndexNode *>(p_node);
+			ins.op = Instruction::OP_NAMED_INDEX;
+			ins.a = _compile_node(index->base);
+			ins.extra = program_names.size();
+			program_names.push_back(index->name);
+			foldable = _is_constant_operand(ins.a);
+		} break;
+		case ENode::TYPE_ARRAY: {
+
+			ArrayNode *array = static_cast<ArrayNode *>(p_node);
+			ins.op = Instruction::OP_ARRAY;
+			for (int i = 0; i < array->array.size(); i++) {
+				args.push_back(_compile_node(array->array[i]));
+			}
+		} break;
+		case ENode::TYPE_DICTIONARY: {
+
+			DictionaryNode *dictionary = static_cast<DictionaryNode *>(p_node);
+			ins.op = Instruction::OP_DICTIONARY;
+			for (int i = 0; i < dictionary->dict.size(); i++) {
+				args.push_back(_compile_node(dictionary->dict[i]));
+			}
+		} break;
+		case ENode::TYPE_CONSTRUCTOR: {
+
+			ConstructorNode *constructor = static_cast<ConstructorNode *>(p_node);
+			ins.op = Instruction::OP_CONSTRUCTOR;
+			ins.extra = constructor->data_type;
+			foldable = true;
+			for (int i = 0; i < constructor->arguments.size(); i++) {
+				args.push_back(_compile_node(constructor->arguments[i]));
+				foldable = foldable && _is_constant_operand(args[i]);
+			}
+		} break;
+		case ENode::TYPE_BUILTIN_FUNC: {
+
+			BuiltinFuncNode *bifunc = static_cast<BuiltinFuncNode *>(p_node);
+			ins.op = Instruction::OP_BUILTIN_FUNC;
+			ins.extra = bifunc->func;
+			foldable = _is_pure_func(bifunc->func);
+			for (int i = 0; i < bifunc->arguments.size(); i++) {
+				args.push_back(_compile_node(bifunc->arguments[i]));
+				foldable = foldable && _is_constant_operand(args[i]);
+			}
+		} break;
+		case ENode::TYPE_CALL: {
+
+			CallNode *call = static_cast<CallNode *>(p_node);
+			ins.op = Instruction::OP_CALL;
+			ins.a = _compile_node(call->base);
+			ins.extra = program_names.size();
+			program_names.push_back(call->method);
+			for (int i = 0; i < call->arguments.size(); i++) {
+				args.push_back(_compile_node(call->arguments[i]));
+			}
+		} break;
+	}
+
+	if (foldable) {
+		// Every operand is known, so evaluate once now. Failures are left for
+		// execution to report, and reference types are never folded so each
+		// execution still gets its own Array, Dictionary or Object.
+		Variant value;
+		String error;
+		if (!_execute(Array(), NULL, p_node, value, error)) {
+			Variant::Type type = value.get_type();
+			if (type != Variant::OBJECT && type != Variant::ARRAY && type != Variant::DICTIONARY) {
+				if (ins.op == Instruction::OP_NAMED_INDEX) {
+					program_names.resize(ins.extra);
+				}
+				constants.resize(constants_mark);
+				constants.push_back(value);
+				return _make_operand(OPERAND_CONSTANT, constants.size() - 1);
+			}
+		}
+	}
+
+	ins.arg_ofs = program_args.size();
+	ins.arg_count = args.size();
+	for (uint32_t i = 0; i < args.size(); i++) {
+		program_args.push_back(args[i]);
+	}
+	max_arguments = MAX(max_arguments, ins.arg_count);
+
+	ins.dst = _make_operand(OPERAND_TEMP, temp_count++);
+	program.push_back(ins);
+	return ins.dst;
+}
+
+int Expression::_get_register(int p_operand) const {
+
+	if (p_operand < 0) {
+		return -1;
+	}
+	int index = p_operand >> OPERAND_KIND_BITS;
+	switch (p_operand & OPERAND_KIND_MASK) {
+		case OPERAND_INPUT: return index;
+		case OPERAND_CONSTANT: return input_count + index;
+		default: return input_count + constants.size() + index;
+	}
+}
+
+void Expression::_compile_program() {
+
+	program.clear();
+	program_args.clear();
+	program_names.clear();
+	constants.clear();
+	registers.clear();
+	bound_inputs.clear();
+	input_used.clear();
+	temp_count = 0;
+	max_arguments = 0;
+
+	int result = _compile_node(root);
+
+	input_count = MAX(input_names.size(), (int)input_used.size());
+	while ((int)input_used.size() < input_count) {
+		input_used.push_back(false);
+	}
+
+	Instruction *code = program.ptrw();
+	for (int i = 0; i < program.size(); i++) {
+		code[i].dst = _get_register(code[i].dst);
+		code[i].a = _get_register(code[i].a);
+		code[i].b = _get_register(code[i].b);
+	}
+	int *args = program_args.ptrw();
+	for (int i = 0; i < program_args.size(); i++) {
+		args[i] = _get_register(args[i]);
+	}
+	result_register = _get_register(result);
+
+	bound_inputs.resize(input_count);
+	registers.resize(input_count + constants.size() + temp_count);
+	for (uint32_t i = 0; i < constants.size(); i++) {
+		registers[input_count + i] = constants[i];
+	}
+}
+
+// Arithmetic and comparisons on int/float operands, done without going
+// through Variant::evaluate(). Division by zero is left to the generic path
+// so it reports the usual error.
+static _FORCE_INLINE_ bool _evaluate_numeric(Variant::Operator p_op, const Variant &p_a, const Variant &p_b, Variant &r_ret) {
+
+	Variant::Type type_a = p_a.get_type();
+	Variant::Type type_b = p_b.get_type();
+
+	if (type_a == Variant::INT && type_b == Variant::INT) {
+		int64_t a = p_a;
+		int64_t b = p_b;
+		switch (p_op) {
+			case Variant::OP_ADD: r_ret = a + b; return true;
+			case Variant::OP_SUBTRACT: r_ret = a - b; return true;
+			case Variant::OP_MULTIPLY: r_ret = a * b; return true;
+			case Variant::OP_DIVIDE: {
+				if (b == 0) {
+					return false;
+				}
+				r_ret = a / b;
+				return true;
+			}
+			case Variant::OP_EQUAL: r_ret = a == b; return true;
+			case Variant::OP_NOT_EQUAL: r_ret = a != b; return true;
+			case Variant::OP_LESS: r_ret = a < b; return true;
+			case Variant::OP_LESS_EQUAL: r_ret = a <= b; return true;
+			case Variant::OP_GREATER: r_ret = a > b; return true;
+			case Variant::OP_GREATER_EQUAL: r_ret = a >= b; return true;
+			default: return false;
+		}
+	}
+
+	if (p_a.is_num() && p_b.is_num()) {
+		double a = p_a;
+		double b = p_b;
+		switch (p_op) {
+			case Variant::OP_ADD: r_ret = a + b; return true;
+			case Variant::OP_SUBTRACT: r_ret = a - b; return true;
+			case Variant::OP_MULTIPLY: r_ret = a * b; return true;
+			case Variant::OP_DIVIDE: {
+				if (b == 0) {
+					return false;
+				}
+				r_ret = a / b;
+				return true;
+			}
+			case Variant::OP_EQUAL: r_ret = a == b; return true;
+			case Variant::OP_NOT_EQUAL: r_ret = a != b; return true;
+			case Variant::OP_LESS: r_ret = a < b; return true;
+			case Variant::OP_LESS_EQUAL: r_ret = a <= b; return true;
+			case Variant::OP_GREATER: r_ret = a > b; return true;
+			case Variant::OP_GREATER_EQUAL: r_ret = a >= b; return true;
+			default: return false;
+		}
+	}
+
+	if (p_op == Variant::OP_NEGATE && type_b == Variant::NIL) {
+		if (type_a == Variant::INT) {
+			r_ret = -int64_t(p_a);
+			return true;
+		}
+		if (type_a == Variant::REAL) {
+			r_ret = -double(p_a);
+			return true;
+		}
+	}
+
+	return false;
+}
+
+bool Expression::_run(Variant *p_registers, const Variant **p_argp, Object *p_instance, String &r_error_str) const {
+
+	const Variant nil;
+	const Instruction *code = program.ptr();
+	const int *args = program_args.ptr();
+	int code_size = program.size();
+
+	for (int i = 0; i < code_size; i++) {
+
+		const Instruction &ins = code[i];
+		Variant &dst = p_registers[ins.dst];
+
+		for (int j = 0; j < ins.arg_count; j++) {
+			p_argp[j] = &p_registers[args[ins.arg_ofs + j]];
+		}
+
+		switch (ins.op) {
+			case Instruction::OP_SELF: {
+
+				if (!p_instance) {
+					r_error_str = RTR("self can't be used because instance is null (not passed)");
+					return true;
+				}
+				dst = p_instance;
+			} break;
+			case Instruction::OP_OPERATOR: {
+
+				Variant::Operator op = Variant::Operator(ins.extra);
+				const Variant &a = p_registers[ins.a];
+				const Variant &b = ins.b >= 0 ? p_registers[ins.b] : nil;
+
+				if (_evaluate_numeric(op, a, b, dst)) {
+					break;
+				}
+
+				bool valid = true;
+				Variant::evaluate(op, a, b, dst, valid);
+				if (!valid) {
+					r_error_str = vformat(RTR("Invalid operands to operator %s, %s and %s."), Variant::get_operator_name(op), Variant::get_type_name(a.get_type()), Variant::get_type_name(b.get_type()));
+					return true;
+				}
+			} break;
+			case Instruction::OP_INDEX: {
+
+				const Variant &base = p_registers[ins.a];
+				const Variant &idx = p_registers[ins.b];
+
+				bool valid;
+				dst = base.get(idx, &valid);
+				if (!valid) {
+					r_error_str = vformat(RTR("Invalid index of type %s for base type %s"), Variant::get_type_name(idx.get_type()), Variant::get_type_name(base.get_type()));
+					return true;
+				}
+			} break;
+			case Instruction::OP_NAMED_INDEX: {
+
+				const Variant &base = p_registers[ins.a];
+				const StringName &name = program_names[ins.extra];
+
+				bool valid;
+				dst = base.get_named(name, &valid);
+				if (!valid) {
+					r_error_str = vformat(RTR("Invalid named index '%s' for base type %s"), String(name), Variant::get_type_name(base.get_type()));
+					return true;
+				}
+			} break;
+			case Instruction::OP_ARRAY: {
+
+				Array arr;
+				arr.resize(ins.arg_count);
+				for (int j = 0; j < ins.arg_count; j++) {
+					arr[j] = *p_argp[j];
+				}
+				dst = arr;
+			} break;
+			case Instruction::OP_DICTIONARY: {
+
+				Dictionary d;
+				for (int j = 0; j < ins.arg_count; j += 2) {
+					d[*p_argp[j + 0]] = *p_argp[j + 1];
+				}
+				dst = d;
+			} break;
+			case Instruction::OP_CONSTRUCTOR: {
+
+				Variant::Type type = Variant::Type(ins.extra);
+				Variant::CallError ce;
+				dst = Variant::construct(type, p_argp, ins.arg_count, ce);
+
+				if (ce.error != Variant::CallError::CALL_OK) {
+					r_error_str = vformat(RTR("Invalid arguments to construct '%s'"), Variant::get_type_name(type));
+					return true;
+				}
+			} break;
+			case Instruction::OP_BUILTIN_FUNC: {
+
+				Variant::CallError ce;
+				exec_func(BuiltinFunc(ins.extra), p_argp, &dst, ce, r_error_str);
+
+				if (ce.error != Variant::CallError::CALL_OK) {
+					r_error_str = "Builtin Call Failed. " + r_error_str;
+					return true;
+				}
+			} break;
+			case Instruction::OP_CALL: {
+
+				const StringName &method = program_names[ins.extra];
+				Variant::CallError ce;
+				dst = p_registers[ins.a].call(method, p_argp, ins.arg_count, ce);
+
+				if (ce.error != Variant::CallError::CALL_OK) {
+					r_error_str = vformat(RTR("On call to '%s':"), String(method));
+					return true;
+				}
+			} break;
+		}
+	}
+
+	return false;
+}
+
+bool Expression::_run_program(const Array *p_inputs, Object *p_instance, Variant &r_ret, String &r_error_str) {
+
+	if (p_inputs) {
+		for (int i = p_inputs->size(); i < input_count; i++) {
+			if (input_used[i]) {
+				r_error_str = vformat(RTR("Invalid input %i (not passed) in expression"), i);
+				return true;
+			}
+		}
+	}
+
+	const Variant **argp = (const Variant **)alloca(sizeof(Variant *) * MAX(max_arguments, 1));
+	int passed = p_inputs ? MIN(p_inputs->size(), input_count) : input_count;
+
+	bool shared = running.increment() == 1;
+	LocalVector<Variant> local;
+	Variant *regs;
+	if (shared) {
+		regs = registers.ptr();
+	} else {
+		// Re-entrant call (e.g. a method called from this expression executes it
+		// again) or use from another thread: run on a private register file.
+		local.resize(registers.size());
+		for (uint32_t i = 0; i < constants.size(); i++) {
+			local[input_count + i] = constants[i];
+		}
+		regs = local.ptr();
+	}
+
+	for (int i = 0; i < passed; i++) {
+		regs[i] = p_inputs ? (*p_inputs)[i] : bound_inputs[i];
+	}
+
+	bool err = _run(regs, argp, p_instance, r_error_str);
+	if (!err) {
+		r_ret = regs[result_register];
+	}
+
+	if (shared) {
+		// Don't let inputs and temporaries keep objects and containers alive
+		// until the next execution.
+		for (int i = 0; i < input_count; i++) {
+			regs[i] = Variant();
+		}
+		for (uint32_t i = input_count + constants.size(); i < registers.size(); i++) {
+			Variant::Type type = regs[i].get_type();
+			if (type == Variant::OBJECT || type == Variant::ARRAY || type == Variant::DICTIONARY) {
+				regs[i] = Variant();
+			}
+		}
+	}
+
+	running.decrement();
+	return err;
+}
+
 Error Expression::parse(const String &p_expression, const Vector<String> &p_input_names) {
 
 	if (nodes) {
@@ -2187,6 +2668,8 @@ Error Expression::parse(const String &p_expression, const Vector<String> &p_inpu
 		return ERR_INVALID_PARAMETER;
 	}
 
+	_compile_program();
+
 	return OK;
 }
 
@@ -2197,7 +2680,38 @@ Variant Expression::execute(Array p_inputs, Object *p_base, bool p_show_error) {
 	execution_error = false;
 	Variant output;
 	String error_txt;
-	bool err = _execute(p_inputs, p_base, root, output, error_txt);
+	bool err = _run_program(&p_inputs, p_base, output, error_txt);
+	if (err) {
+		execution_error = true;
+		error_str = error_txt;
+		ERR_FAIL_COND_V_MSG(p_show_error, Variant(), error_str);
+	}
+
+	return output;
+}
+
+void Expression::set_input(int p_index, const Variant &p_value) {
+
+	ERR_FAIL_COND_MSG(error_set, "There was previously a parse error: " + error_str + ".");
+	ERR_FAIL_INDEX(p_index, input_count);
+	bound_inputs[p_index] = p_value;
+}
+
+Variant Expression::get_input(int p_index) const {
+
+	ERR_FAIL_COND_V_MSG(error_set, Variant(), "There was previously a parse error: " + error_str + ".");
+	ERR_FAIL_INDEX_V(p_index, input_count, Variant());
+	return bound_inputs[p_index];
+}
+
+Variant Expression::execute_bound(Object *p_base, bool p_show_error) {
+
+	ERR_FAIL_COND_V_MSG(error_set, Variant(), "There was previously a parse error: " + error_str + ".");
+
+	execution_error = false;
+	Variant output;
+	String error_txt;
+	bool err = _run_program(NULL, p_base, output, error_txt);
 	if (err) {
 		execution_error = true;
 		error_str = error_txt;
@@ -2219,6 +2733,9 @@ void Expression::_bind_methods() {
 
 	ClassDB::bind_method(D_METHOD("parse", "expression", "input_names"), &Expression::parse, DEFVAL(Vector<String>()));
 	ClassDB::bind_method(D_METHOD("execute", "inputs", "base_instance", "show_error"), &Expression::execute, DEFVAL(Array()), DEFVAL(Variant()), DEFVAL(true));
+	ClassDB::bind_method(D_METHOD("set_input", "index", "value"), &Expression::set_input);
+	ClassDB::bind_method(D_METHOD("get_input", "index"), &Expression::get_input);
+	ClassDB::bind_method(D_METHOD("execute_bound", "base_instance", "show_error"), &Expression::execute_bound, DEFVAL(Variant()), DEFVAL(true));
 	ClassDB::bind_method(D_METHOD("has_execute_failed"), &Expression::has_execute_failed);
 	ClassDB::bind_method(D_METHOD("get_error_text"), &Expression::get_error_text);
 }
@@ -2229,7 +2746,11 @@ Expression::Expression() :
 		error_set(true),
 		root(NULL),
 		nodes(NULL),
-		execution_error(false) {
+		execution_error(false),
+		input_count(0),
+		temp_count(0),
+		result_register(-1),
+		max_arguments(0) {
 }
 
 Expression::~Expression() {
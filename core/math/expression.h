@@ -31,7 +31,9 @@
 #ifndef EXPRESSION_H
 #define EXPRESSION_H
 
+#include "core/local_vector.h"
 #include "core/reference.h"
+#include "core/safe_refcount.h"
 
 class Expression : public Reference {
 	GDCLASS(Expression, Reference);
@@ -348,12 +350,61 @@ private:
 	bool execution_error;
 	bool _execute(const Array &p_inputs, Object *p_instance, Expression::ENode *p_node, Variant &r_ret, String &r_error_str);
 
+	// Compiled form of the tree: a flat program over a register file laid
+	// out as [inputs][constants][temporaries]. Every instruction writes a
+	// fresh temporary, so executing never allocates registers.
+	struct Instruction {
+
+		enum Op {
+			OP_SELF,
+			OP_OPERATOR,
+			OP_INDEX,
+			OP_NAMED_INDEX,
+			OP_ARRAY,
+			OP_DICTIONARY,
+			OP_CONSTRUCTOR,
+			OP_BUILTIN_FUNC,
+			OP_CALL,
+		};
+
+		Op op;
+		int dst;
+		int a; // Operand, or base of index/call.
+		int b; // Second operand or index, -1 if none.
+		int arg_ofs; // Into program_args.
+		int arg_count;
+		int extra; // Variant::Operator, BuiltinFunc, Variant::Type or name index.
+	};
+
+	Vector<Instruction> program;
+	Vector<int> program_args;
+	Vector<StringName> program_names;
+	LocalVector<Variant> constants;
+	LocalVector<Variant> registers;
+	LocalVector<Variant> bound_inputs; // Set with set_input(), copied in by execute_bound().
+	LocalVector<bool> input_used;
+	int input_count;
+	int temp_count;
+	int result_register;
+	int max_arguments;
+	SafeNumeric<uint32_t> running;
+
+	int _compile_node(ENode *p_node);
+	void _compile_program();
+	int _get_register(int p_operand) const;
+	bool _run(Variant *p_registers, const Variant **p_argp, Object *p_instance, String &r_error_str) const;
+	bool _run_program(const Array *p_inputs, Object *p_instance, Variant &r_ret, String &r_error_str);
+
 protected:
 	static void _bind_methods();
 
 public:
 	Error parse(const String &p_expression, const Vector<String> &p_input_names = Vector<String>());
 	Variant execute(Array p_inputs, Object *p_base = NULL, bool p_show_error = true);
+
+	void set_input(int p_index, const Variant &p_value);
+	Variant get_input(int p_index) const;
+	Variant execute_bound(Object *p_base = NULL, bool p_show_error = true);
 	bool has_execute_failed() const;
 	String get_error_text() const;
 
@@ -40,28 +40,7 @@
 #include "core/script_language.h"
 #include "core/translation.h"
 
-#if 0
-
-struct _ObjectDebugLock {
-
-	Object *obj;
-
-	_ObjectDebugLock(Object *p_obj) {
-		obj = p_obj;
-		obj->_lock_index.ref();
-	}
-	~_ObjectDebugLock() {
-		obj->_lock_index.unref();
-	}
-};
-
-#define OBJ_DEBUG_LOCK _ObjectDebugLock _debug_lock(this);
-
-#else
-
-#define OBJ_DEBUG_LOCK
-
-#endif
+#define OBJ_DEBUG_LOCK OBJ_DEBUG_LOCK_OBJECT(this)
 
 PropertyInfo::operator Dictionary() const {
 
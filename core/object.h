@@ -775,6 +775,31 @@ public:
 bool predelete_handler(Object *p_object);
 void postinitialize_handler(Object *p_object);
 
+// Keeps an object from being freed while one of its methods runs, see Object::call().
+// Code calling a MethodBind directly on an object takes it too.
+#if 0
+
+struct _ObjectDebugLock {
+
+	Object *obj;
+
+	_ObjectDebugLock(Object *p_obj) {
+		obj = p_obj;
+		obj->_lock_index.ref();
+	}
+	~_ObjectDebugLock() {
+		obj->_lock_index.unref();
+	}
+};
+
+#define OBJ_DEBUG_LOCK_OBJECT(m_obj) _ObjectDebugLock _debug_lock(m_obj);
+
+#else
+
+#define OBJ_DEBUG_LOCK_OBJECT(m_obj)
+
+#endif
+
 class ObjectDB {
 
 	struct ObjectPtrHash {
@@ -0,0 +1,121 @@
+/*************************************************************************/
+/*  thread_work_pool.cpp                                                 */
+/*************************************************************************/
+/*                       This file is part of:                           */
+/*                           GODOT ENGINE                                */
+/*                      https://godotengine.org                          */
+/*************************************************************************/
+/* Copyright (c) 2007-2021 Juan Linietsky, Ariel Manzur.                 */
+/* Copyright (c) 2014-2021 Godot Engine contributors (cf. AUTHORS.md).   */
+/*                                                                       */
+/* Permission is hereby granted, free of charge, to any person obtaining */
+/* a copy of this software and associated documentation files (the       */
+/* "Software"), to deal in the Software without restriction, including   */
+/* without limitation the rights to use, copy, modify, merge, publish,   */
+/* distribute, sublicense, and/or sell copies of the Software, and to    */
+/* permit persons to whom the Software is furnished to do so, subject to */
+/* the following conditions:                                             */
+/*                                                                       */
+/* The above copyright notice and this permission notice shall be        */
+/* included in all copies or substantial portions of the Software.       */
+/*                                                                       */
+/* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,       */
+/* EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF    */
+/* MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.*/
+/* IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY  */
+/* CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,  */
+/* TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE     */
+/* SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.                */
+/*************************************************************************/
+
+#include "thread_work_pool.h"
+
+#include "core/os/os.h"
+
+void ThreadWorkPool::_thread_function(void *p_user) {
+
+	ThreadData *thread = (ThreadData *)p_user;
+	while (true) {
+		thread->start.wait();
+		if (thread->exit.is_set()) {
+			break;
+		}
+		thread->work->work();
+		thread->completed.post();
+	}
+}
+
+void ThreadWorkPool::_run(BaseWork *p_work, uint32_t p_elements) {
+
+	index.set(0);
+	p_work->index = &index;
+	p_work->max_elements = p_elements;
+
+	// The calling thread takes one share, so one element less is enough to keep everyone busy.
+	uint32_t helpers = MIN(p_elements - 1, thread_count);
+	for (uint32_t i = 0; i < helpers; i++) {
+		threads[i].work = p_work;
+		threads[i].start.post();
+	}
+
+	p_work->work();
+
+	for (uint32_t i = 0; i < helpers; i++) {
+		threads[i].completed.wait();
+		threads[i].work = NULL;
+	}
+}
+
+void ThreadWorkPool::init(int p_thread_count) {
+
+	ERR_FAIL_COND(threads != NULL);
+
+	if (p_thread_count < 0) {
+		p_thread_count = OS::get_singleton()->get_processor_count();
+	}
+
+#ifdef NO_THREADS
+	thread_count = 0;
+#else
+	thread_count = MAX(p_thread_count, 1) - 1;
+#endif
+	if (thread_count == 0) {
+		return;
+	}
+
+	threads = memnew_arr(ThreadData, thread_count);
+	for (uint32_t i = 0; i < thread_count; i++) {
+		threads[i].work = NULL;
+		threads[i].thread.start(&ThreadWorkPool::_thread_function, &threads[i]);
+	}
+}
+
+void ThreadWorkPool::finish() {
+
+	if (threads == NULL) {
+		return;
+	}
+
+	for (uint32_t i = 0; i < thread_count; i++) {
+		threads[i].exit.set();
+		threads[i].start.post();
+	}
+	for (uint32_t i = 0; i < thread_count; i++) {
+		threads[i].thread.wait_to_finish();
+	}
+
+	memdelete_arr(threads);
+	threads = NULL;
+	thread_count = 0;
+}
+
+ThreadWorkPool::ThreadWorkPool() {
+
+	threads = NULL;
+	thread_count = 0;
+}
+
+ThreadWorkPool::~ThreadWorkPool() {
+
+	finish();
+}
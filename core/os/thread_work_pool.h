@@ -0,0 +1,119 @@
+/*************************************************************************/
+/*  thread_work_pool.h                                                   */
+/*************************************************************************/
+/*                       This file is part of:                           */
+/*                           GODOT ENGINE                                */
+/*                      https://godotengine.org                          */
+/*************************************************************************/
+/* Copyright (c) 2007-2021 Juan Linietsky, Ariel Manzur.                 */
+/* Copyright (c) 2014-2021 Godot Engine contributors (cf. AUTHORS.md).   */
+/*                                                                       */
+/* Permission is hereby granted, free of charge, to any person obtaining */
+/* a copy of this software and associated documentation files (the       */
+/* "Software"), to deal in the Software without restriction, including   */
+/* without limitation the rights to use, copy, modify, merge, publish,   */
+/* distribute, sublicense, and/or sell copies of the Software, and to    */
+/* permit persons to whom the Software is furnished to do so, subject to */
+/* the following conditions:                                             */
+/*                                                                       */
+/* The above copyright notice and this permission notice shall be        */
+/* included in all copies or substantial portions of the Software.       */
+/*                                                                       */
+/* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,       */
+/* EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF    */
+/* MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.*/
+/* IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY  */
+/* CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,  */
+/* TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE     */
+/* SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.                */
+/*************************************************************************/
+
+#ifndef THREAD_WORK_POOL_H
+#define THREAD_WORK_POOL_H
+
+#include "core/os/semaphore.h"
+#include "core/os/thread.h"
+#include "core/safe_refcount.h"
+
+// Runs indexed jobs like thread_process_array(), but on threads started once by
+// init() instead of on every call. The calling thread takes part in the work.
+// do_work() blocks until all elements are processed. While the threads are busy,
+// calls from inside a job or from another thread run on the calling thread alone.
+class ThreadWorkPool {
+
+	struct BaseWork {
+		SafeNumeric<uint32_t> *index;
+		uint32_t max_elements;
+
+		virtual void work() = 0;
+		virtual ~BaseWork() {}
+	};
+
+	template <class C, class M, class U>
+	struct Work : public BaseWork {
+		C *instance;
+		M method;
+		U userdata;
+
+		virtual void work() {
+			while (true) {
+				uint32_t work_index = this->index->postincrement();
+				if (work_index >= this->max_elements) {
+					break;
+				}
+				(instance->*method)(work_index, userdata);
+			}
+		}
+	};
+
+	struct ThreadData {
+		Thread thread;
+		Semaphore start;
+		Semaphore completed;
+		SafeFlag exit;
+		BaseWork *work;
+	};
+
+	SafeNumeric<uint32_t> index;
+	ThreadData *threads;
+	uint32_t thread_count;
+	SafeNumeric<uint32_t> users; // Callers inside do_work(), only the first one gets the threads.
+
+	static void _thread_function(void *p_user);
+	void _run(BaseWork *p_work, uint32_t p_elements);
+
+public:
+	template <class C, class M, class U>
+	void do_work(uint32_t p_elements, C *p_instance, M p_method, U p_userdata) {
+
+		if (p_elements > 1 && thread_count > 0) {
+			if (users.postincrement() == 0) {
+				Work<C, M, U> w;
+				w.instance = p_instance;
+				w.method = p_method;
+				w.userdata = p_userdata;
+				_run(&w, p_elements);
+				users.decrement();
+				return;
+			}
+			users.decrement();
+		}
+
+		// Nothing to share, or the threads are busy.
+		for (uint32_t i = 0; i < p_elements; i++) {
+			(p_instance->*p_method)(i, p_userdata);
+		}
+	}
+
+	// Threads that take part in do_work(), including the calling one.
+	_FORCE_INLINE_ int get_thread_count() const { return thread_count + 1; }
+
+	// p_thread_count includes the calling thread; -1 uses one thread per processor.
+	void init(int p_thread_count = -1);
+	void finish();
+
+	ThreadWorkPool();
+	~ThreadWorkPool();
+};
+
+#endif // THREAD_WORK_POOL_H
@@ -356,6 +356,7 @@ public:
 
 	virtual void reload_all_scripts() = 0;
 	virtual void reload_tool_script(const Ref<Script> &p_script, bool p_soft_reload) = 0;
+	virtual void preload_scripts(const Vector<String> &p_paths) {} //optional, load scripts the project will need before they are first requested
 	/* LOADER FUNCTIONS */
 
 	virtual void get_recognized_extensions(List<String> *p_extensions) const = 0;
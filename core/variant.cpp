@@ -3239,6 +3239,22 @@ Vector<Variant> varray(const Variant &p_arg1, const Variant &p_arg2, const Varia
 void Variant::static_assign(const Variant &p_variant) {
 }
 
+void *Variant::get_ptrcall_ptr() {
+
+	switch (type) {
+		case NIL:
+		case OBJECT: return NULL;
+		case BOOL: return &_data._bool;
+		case INT: return &_data._int;
+		case REAL: return &_data._real;
+		case TRANSFORM2D: return _data._transform2d;
+		case AABB: return _data._aabb;
+		case BASIS: return _data._basis;
+		case TRANSFORM: return _data._transform;
+		default: return _data._mem;
+	}
+}
+
 bool Variant::is_shared() const {
 
 	switch (type) {
@@ -229,6 +229,17 @@ public:
 	operator PoolVector<Plane>() const;
 	operator PoolVector<Face3>() const;
 
+	// In-place access to the array held by a POOL_*_ARRAY variant, without
+	// converting or taking a reference. The caller must check get_type() first.
+	template <class T>
+	_FORCE_INLINE_ PoolVector<T> *get_pool_vector_ptr() { return reinterpret_cast<PoolVector<T> *>(_data._mem); }
+	template <class T>
+	_FORCE_INLINE_ const PoolVector<T> *get_pool_vector_ptr() const { return reinterpret_cast<const PoolVector<T> *>(_data._mem); }
+
+	// The held value laid out the way MethodBind::ptrcall() takes arguments and
+	// return values of this type. NULL for NIL and OBJECT.
+	void *get_ptrcall_ptr();
+
 	operator Vector<Variant>() const;
 	operator Vector<uint8_t>() const;
 	operator Vector<int>() const;
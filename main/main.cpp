@@ -185,6 +185,10 @@ void initialize_physics() {
 	physics_server->init();
 
 	/// 2D Physics server
+
+	// This must be defined BEFORE the 2d physics server is created
+	GLOBAL_DEF("physics/2d/use_bvh", false);
+
 	physics_2d_server = Physics2DServerManager::new_server(ProjectSettings::get_singleton()->get(Physics2DServerManager::setting_property_name));
 	if (!physics_2d_server) {
 		// Physics server not found, Use the default physics
@@ -1766,6 +1770,24 @@ bool Main::start() {
 					}
 				}
 
+				//give languages a chance to load the scripts autoloads need in bulk
+				Vector<String> autoload_paths;
+				for (List<PropertyInfo>::Element *E = props.front(); E; E = E->next()) {
+
+					String s = E->get().name;
+					if (!s.begins_with("autoload/"))
+						continue;
+					String path = ProjectSettings::get_singleton()->get(s);
+					if (path.begins_with("*")) {
+						path = path.substr(1, path.length() - 1);
+					}
+					autoload_paths.push_back(path);
+				}
+
+				for (int i = 0; i < ScriptServer::get_language_count(); i++) {
+					ScriptServer::get_language(i)->preload_scripts(autoload_paths);
+				}
+
 				//second pass, load into global constants
 				List<Node *> to_add;
 				for (List<PropertyInfo>::Element *E = props.front(); E; E = E->next()) {
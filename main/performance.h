@@ -83,6 +83,7 @@ public:
 		PHYSICS_3D_ISLAND_COUNT,
 		//physics
 		AUDIO_OUTPUT_LATENCY,
+		RENDER_OCCLUDED_OBJECTS_IN_FRAME,
 		MONITOR_MAX
 	};
 
@@ -0,0 +1,175 @@
+/*************************************************************************/
+/*  test_expression.cpp                                                  */
+/*************************************************************************/
+/*                       This file is part of:                           */
+/*                           GODOT ENGINE                                */
+/*                      https://godotengine.org                          */
+/*************************************************************************/
+/* Copyright (c) 2007-2021 Juan Linietsky, Ariel Manzur.                 */
+/* Copyright (c) 2014-2021 Godot Engine contributors (cf. AUTHORS.md).   */
+/*                                                                       */
+/* Permission is hereby granted, free of charge, to any person obtaining */
+/* a copy of this software and associated documentation files (the       */
+/* "Software"), to deal in the Software without restriction, including   */
+/* without limitation the rights to use, copy, modify, merge, publish,   */
+/* distribute, sublicense, and/or sell copies of the Software, and to    */
+/* permit persons to whom the Software is furnished to do so, subject to */
+/* the following conditions:                                             */
+/*                                                                       */
+/* The above copyright notice and this permission notice shall be        */
+/* included in all copies or substantial portions of the Software.       */
+/*                                                                       */
+/* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,       */
+/* EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF    */
+/* MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.*/
+/* IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY  */
+/* CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,  */
+/* TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE     */
+/* SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.                */
+/*************************************************************************/
+
+#include "test_expression.h"
+
+#include "core/math/expression.h"
+#include "core/math/math_funcs.h"
+#include "core/os/os.h"
+#include "core/reference.h"
+
+namespace TestExpression {
+
+static bool check(const String &p_expression, const Vector<String> &p_input_names, const Array &p_inputs, const Variant &p_expected) {
+
+	Ref<Expression> expression;
+	expression.instance();
+	if (expression->parse(p_expression, p_input_names) != OK) {
+		OS::get_singleton()->print("FAIL: '%s' didn't parse: %s\n", p_expression.utf8().get_data(), expression->get_error_text().utf8().get_data());
+		return false;
+	}
+
+	Variant result = expression->execute(p_inputs, NULL, false);
+	if (expression->has_execute_failed() || result != p_expected) {
+		OS::get_singleton()->print("FAIL: '%s' = %s, expected %s\n", p_expression.utf8().get_data(), String(result).utf8().get_data(), String(p_expected).utf8().get_data());
+		return false;
+	}
+	return true;
+}
+
+static bool test_results() {
+
+	Vector<String> names;
+	names.push_back("x");
+	names.push_back("y");
+
+	Array inputs;
+	inputs.push_back(3);
+	inputs.push_back(4.0);
+
+	bool ok = true;
+	ok = check("1 + 2 * 3", Vector<String>(), Array(), 7) && ok;
+	ok = check("7 / 2", Vector<String>(), Array(), 3) && ok;
+	ok = check("-x + 1", names, inputs, -2) && ok;
+	ok = check("sqrt(x * x + y * y)", names, inputs, 5.0) && ok;
+	ok = check("x < y and y != 0", names, inputs, true) && ok;
+	ok = check("Vector2(x, 1).x + Vector2(2, 2).length_squared()", names, inputs, 11.0) && ok;
+	ok = check("[x, y][1]", names, inputs, 4.0) && ok;
+	ok = check("{\"a\": x}[\"a\"]", names, inputs, 3) && ok;
+
+	// Folded containers must not be shared between executions.
+	Ref<Expression> expression;
+	expression.instance();
+	expression->parse("[1, 2]");
+	Array first = expression->execute(Array());
+	first.push_back(3);
+	Array second = expression->execute(Array());
+	if (second.size() != 2) {
+		OS::get_singleton()->print("FAIL: array literal shared between executions\n");
+		ok = false;
+	}
+
+	// Inputs that are used but not passed are still an error.
+	expression->parse("x + y", names);
+	Array partial;
+	partial.push_back(1);
+	expression->execute(partial, NULL, false);
+	if (!expression->has_execute_failed()) {
+		OS::get_singleton()->print("FAIL: missing input not reported\n");
+		ok = false;
+	}
+
+	// Inputs are released once execute() returns.
+	Ref<Reference> held;
+	held.instance();
+	Array objects;
+	objects.push_back(held);
+	objects.push_back(0);
+	expression->parse("[x, y]", names);
+	expression->execute(objects);
+	objects.clear();
+	if (held->reference_get_count() != 1) {
+		OS::get_singleton()->print("FAIL: input still referenced after execution\n");
+		ok = false;
+	}
+
+	// Division by zero is reported rather than folded.
+	expression->parse("1 / 0");
+	expression->execute(Array(), NULL, false);
+	if (!expression->has_execute_failed()) {
+		OS::get_singleton()->print("FAIL: division by zero not reported\n");
+		ok = false;
+	}
+
+	return ok;
+}
+
+static void benchmark(int p_count) {
+
+	Vector<String> names;
+	names.push_back("x");
+	names.push_back("y");
+	names.push_back("t");
+
+	Ref<Expression> expression;
+	expression.instance();
+	expression->parse("sqrt(x * x + y * y) * (PI / 4.0) + sin(t) * 0.5 - clamp(x, 0.0, 1.0)", names);
+
+	Array inputs;
+	inputs.resize(3);
+
+	double sum = 0;
+	uint64_t begin = OS::get_singleton()->get_ticks_usec();
+	for (int i = 0; i < p_count; i++) {
+		inputs[0] = i * 0.001;
+		inputs[1] = 1.0 - i * 0.002;
+		inputs[2] = i * 0.01;
+		sum += double(expression->execute(inputs));
+	}
+	uint64_t array_usec = OS::get_singleton()->get_ticks_usec() - begin;
+
+	double bound_sum = 0;
+	begin = OS::get_singleton()->get_ticks_usec();
+	for (int i = 0; i < p_count; i++) {
+		expression->set_input(0, i * 0.001);
+		expression->set_input(1, 1.0 - i * 0.002);
+		expression->set_input(2, i * 0.01);
+		bound_sum += double(expression->execute_bound());
+	}
+	uint64_t bound_usec = OS::get_singleton()->get_ticks_usec() - begin;
+
+	OS::get_singleton()->print("%d evaluations, execute(): %d msec, execute_bound(): %d msec\n", p_count, int(array_usec / 1000), int(bound_usec / 1000));
+	if (!Math::is_equal_approx(sum, bound_sum)) {
+		OS::get_singleton()->print("FAIL: bound results differ: %f != %f\n", sum, bound_sum);
+	}
+}
+
+MainLoop *test() {
+
+	OS::get_singleton()->print("\n\nTest 1: compiled expression results\n");
+	OS::get_singleton()->print("%s\n", test_results() ? "PASS" : "FAIL");
+
+	OS::get_singleton()->print("\n\nTest 2: benchmark\n");
+	benchmark(1000000);
+
+	return NULL;
+}
+
+} // namespace TestExpression
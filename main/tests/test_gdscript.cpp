@@ -578,6 +578,22 @@ static void _disassemble_class(const Ref<GDScript> &p_class, const Vector<String
 					txt += DADDR(3);
 					incr += 5;
 
+				} break;
+				case GDScriptFunction::OPCODE_OPERATOR_INT:
+				case GDScriptFunction::OPCODE_OPERATOR_REAL: {
+
+					int op = code[ip + 1];
+					txt += code[ip] == GDScriptFunction::OPCODE_OPERATOR_INT ? " op-int " : " op-real ";
+
+					String opname = Variant::get_operator_name(Variant::Operator(op));
+
+					txt += DADDR(4);
+					txt += " = ";
+					txt += DADDR(2);
+					txt += " " + opname + " ";
+					txt += DADDR(3);
+					incr += 5;
+
 				} break;
 				case GDScriptFunction::OPCODE_SET: {
 
@@ -610,19 +626,42 @@ static void _disassemble_class(const Ref<GDScript> &p_class, const Vector<String
 					txt += func.get_global_name(code[ip + 2]);
 					txt += "\"]=";
 					txt += DADDR(3);
-					incr += 4;
+					incr += 5;
 
 				} break;
 				case GDScriptFunction::OPCODE_GET_NAMED: {
 
 					txt += " get_named ";
-					txt += DADDR(3);
+					txt += DADDR(4);
 					txt += "=";
 					txt += DADDR(1);
 					txt += "[\"";
 					txt += func.get_global_name(code[ip + 2]);
 					txt += "\"]";
-					incr += 4;
+					incr += 5;
+
+				} break;
+				case GDScriptFunction::OPCODE_SET_NAMED_VECTOR: {
+
+					txt += " set_named_vector ";
+					txt += DADDR(1);
+					txt += "[\"";
+					txt += func.get_global_name(code[ip + 2]);
+					txt += "\"]=";
+					txt += DADDR(4);
+					incr += 5;
+
+				} break;
+				case GDScriptFunction::OPCODE_GET_NAMED_VECTOR: {
+
+					txt += " get_named_vector ";
+					txt += DADDR(4);
+					txt += "=";
+					txt += DADDR(1);
+					txt += "[\"";
+					txt += func.get_global_name(code[ip + 2]);
+					txt += "\"]";
+					incr += 5;
 
 				} break;
 				case GDScriptFunction::OPCODE_SET_MEMBER: {
@@ -778,7 +817,7 @@ static void _disassemble_class(const Ref<GDScript> &p_class, const Vector<String
 
 					int argc = code[ip + 1];
 					if (ret) {
-						txt += DADDR(4 + argc) + "=";
+						txt += DADDR(5 + argc) + "=";
 					}
 
 					txt += DADDR(2) + ".";
@@ -788,11 +827,47 @@ static void _disassemble_class(const Ref<GDScript> &p_class, const Vector<String
 					for (int i = 0; i < argc; i++) {
 						if (i > 0)
 							txt += ", ";
-						txt += DADDR(4 + i);
+						txt += DADDR(5 + i);
 					}
 					txt += ")";
 
-					incr = 5 + argc;
+					incr = 6 + argc;
+
+				} break;
+				case GDScriptFunction::OPCODE_CALL_METHOD_BIND:
+				case GDScriptFunction::OPCODE_CALL_METHOD_BIND_RETURN:
+				case GDScriptFunction::OPCODE_CALL_PTRCALL:
+				case GDScriptFunction::OPCODE_CALL_PTRCALL_RETURN: {
+
+					bool ret = code[ip] == GDScriptFunction::OPCODE_CALL_METHOD_BIND_RETURN || code[ip] == GDScriptFunction::OPCODE_CALL_PTRCALL_RETURN;
+					bool ptrcall = code[ip] == GDScriptFunction::OPCODE_CALL_PTRCALL || code[ip] == GDScriptFunction::OPCODE_CALL_PTRCALL_RETURN;
+
+					if (ptrcall)
+						txt += ret ? " call-ptrcall-ret " : " call-ptrcall ";
+					else if (ret)
+						txt += " call-method-bind-ret ";
+					else
+						txt += " call-method-bind ";
+
+					int argc = code[ip + 1];
+					if (ret) {
+						txt += DADDR(5 + argc) + "=";
+					}
+
+					MethodBind *mb = func.get_method_bind(code[ip + 4]);
+					txt += DADDR(2) + ".";
+					txt += (mb ? mb->get_instance_class() : String()) + "::";
+					txt += String(func.get_global_name(code[ip + 3]));
+					txt += "(";
+
+					for (int i = 0; i < argc; i++) {
+						if (i > 0)
+							txt += ", ";
+						txt += DADDR(5 + i);
+					}
+					txt += ")";
+
+					incr = 6 + argc;
 
 				} break;
 				case GDScriptFunction::OPCODE_CALL_BUILT_IN: {
@@ -941,8 +1016,105 @@ static void _disassemble_class(const Ref<GDScript> &p_class, const Vector<String
 	}
 }
 
+// Runs code that the compiler turns into the typed operator, vector member and method bind opcodes,
+// and checks the results against the generic paths. Checks are done in untyped code, so they don't
+// depend on the opcodes under test.
+static const char *_opcodes_script =
+		"extends Reference\n"
+		"\n"
+		"class Shadow extends Reference:\n"
+		"	func get_class() -> String:\n"
+		"		return 'Shadow'\n"
+		"\n"
+		"var failures = []\n"
+		"\n"
+		"func check(p_what, p_got, p_expected):\n"
+		"	if typeof(p_got) != typeof(p_expected) or p_got != p_expected:\n"
+		"		failures.push_back('%s: got %s, expected %s' % [p_what, var2str(p_got), var2str(p_expected)])\n"
+		"\n"
+		"func int_ops(a: int, b: int):\n"
+		"	check('int +', a + b, 10)\n"
+		"	check('int -', a - b, 4)\n"
+		"	check('int *', a * b, 21)\n"
+		"	check('int /', a / b, 2)\n"
+		"	check('int %', a % b, 1)\n"
+		"	check('int <', a < b, false)\n"
+		"	check('int ==', a == b, false)\n"
+		"	check('int negative /', -a / b, -2)\n"
+		"\n"
+		"func real_ops(a: float, b: float):\n"
+		"	check('real +', a + b, 9.5)\n"
+		"	check('real -', a - b, 5.5)\n"
+		"	check('real *', a * b, 15.0)\n"
+		"	check('real /', a / b, 3.75)\n"
+		"	check('real >', a > b, true)\n"
+		"	check('real !=', a != b, true)\n"
+		"\n"
+		"func vector_members():\n"
+		"	var v: Vector2 = Vector2(1, 2)\n"
+		"	v.x += 3\n"
+		"	var w: Vector3 = Vector3(1, 2, 3)\n"
+		"	w.z = v.x + w.y\n"
+		"	check('Vector2 x', v.x, 4.0)\n"
+		"	check('Vector2 y', v.y, 2.0)\n"
+		"	check('Vector3 z', w.z, 6.0)\n"
+		"	check('Vector3', w, Vector3(1, 2, 6))\n"
+		"\n"
+		"func method_binds():\n"
+		"	var plain: Reference = Reference.new()\n"
+		"	check('method bind', plain.get_class(), 'Reference')\n"
+		"	check('method bind with argument', plain.is_class('Object'), true)\n"
+		"	var shadow: Reference = Shadow.new()\n"
+		"	check('method bind shadowed by a script', shadow.get_class(), 'Shadow')\n"
+		"	var action = InputEventAction.new()\n"
+		"	action.pressed = true\n"
+		"	var subclass: Resource = action\n"
+		"	check('method bind on a subclass', subclass.get_class(), 'InputEventAction')\n"
+		"	var rebound: InputEvent = action\n"
+		"	check('method bind bound again by a subclass', rebound.is_pressed(), true)\n"
+		"\n"
+		"func run():\n"
+		"	int_ops(7, 3)\n"
+		"	real_ops(7.5, 2.0)\n"
+		"	vector_members()\n"
+		"	method_binds()\n"
+		"	return failures\n";
+
+static MainLoop *_test_opcodes() {
+
+	Ref<GDScript> gds;
+	gds.instance();
+	gds->set_source_code(_opcodes_script);
+	Error err = gds->reload();
+	if (err != OK) {
+		print_line("Typed opcodes: the test script failed to compile.");
+		return NULL;
+	}
+
+	Ref<Reference> obj;
+	obj.instance();
+	obj->set_script(gds.get_ref_ptr());
+
+	Variant::CallError ce;
+	Array failures = obj->call("run", NULL, 0, ce);
+	if (ce.error != Variant::CallError::CALL_OK) {
+		print_line("Typed opcodes: calling the test script failed.");
+		return NULL;
+	}
+
+	for (int i = 0; i < failures.size(); i++) {
+		print_line("Typed opcodes: " + String(failures[i]));
+	}
+	print_line(failures.empty() ? "Typed opcodes: passed." : "Typed opcodes: FAILED.");
+	return NULL;
+}
+
 MainLoop *test(TestType p_type) {
 
+	if (p_type == TEST_OPCODES) {
+		return _test_opcodes();
+	}
+
 	List<String> cmdlargs = OS::get_singleton()->get_cmdline_args();
 
 	if (cmdlargs.empty()) {
@@ -36,6 +36,7 @@
 
 #include "test_astar.h"
 #include "test_basis.h"
+#include "test_expression.h"
 #include "test_gdscript.h"
 #include "test_gui.h"
 #include "test_math.h"
@@ -43,9 +44,12 @@
 #include "test_ordered_hash_map.h"
 #include "test_physics.h"
 #include "test_physics_2d.h"
+#include "test_physics_2d_bench.h"
+#include "test_physics_2d_determinism.h"
 #include "test_render.h"
 #include "test_shader_lang.h"
 #include "test_string.h"
+#include "test_visual_scene_bench.h"
 
 const char **tests_get_names() {
 
@@ -55,7 +59,10 @@ const char **tests_get_names() {
 		"basis",
 		"physics",
 		"physics_2d",
+		"physics_2d_bench",
+		"physics_2d_determinism",
 		"render",
+		"visual_scene_bench",
 		"oa_hash_map",
 		"gui",
 		"shaderlang",
@@ -63,8 +70,10 @@ const char **tests_get_names() {
 		"gd_parser",
 		"gd_compiler",
 		"gd_bytecode",
+		"gd_opcodes",
 		"ordered_hash_map",
 		"astar",
+		"expression",
 		NULL
 	};
 
@@ -98,11 +107,26 @@ MainLoop *test_main(String p_test, const List<String> &p_args) {
 		return TestPhysics2D::test();
 	}
 
+	if (p_test == "physics_2d_bench") {
+
+		return TestPhysics2DBench::test();
+	}
+
+	if (p_test == "physics_2d_determinism") {
+
+		return TestPhysics2DDeterminism::test();
+	}
+
 	if (p_test == "render") {
 
 		return TestRender::test();
 	}
 
+	if (p_test == "visual_scene_bench") {
+
+		return TestVisualSceneBench::test();
+	}
+
 	if (p_test == "oa_hash_map") {
 
 		return TestOAHashMap::test();
@@ -140,6 +164,11 @@ MainLoop *test_main(String p_test, const List<String> &p_args) {
 		return TestGDScript::test(TestGDScript::TEST_BYTECODE);
 	}
 
+	if (p_test == "gd_opcodes") {
+
+		return TestGDScript::test(TestGDScript::TEST_OPCODES);
+	}
+
 	if (p_test == "ordered_hash_map") {
 
 		return TestOrderedHashMap::test();
@@ -150,6 +179,11 @@ MainLoop *test_main(String p_test, const List<String> &p_args) {
 		return TestAStar::test();
 	}
 
+	if (p_test == "expression") {
+
+		return TestExpression::test();
+	}
+
 	print_line("Unknown test: " + p_test);
 	return NULL;
 }
@@ -0,0 +1,484 @@
+/*************************************************************************/
+/*  test_physics_2d_bench.cpp                                            */
+/*************************************************************************/
+/*                       This file is part of:                           */
+/*                           GODOT ENGINE                                */
+/*                      https://godotengine.org                          */
+/*************************************************************************/
+/* Copyright (c) 2007-2021 Juan Linietsky, Ariel Manzur.                 */
+/* Copyright (c) 2014-2021 Godot Engine contributors (cf. AUTHORS.md).   */
+/*                                                                       */
+/* Permission is hereby granted, free of charge, to any person obtaining */
+/* a copy of this software and associated documentation files (the       */
+/* "Software"), to deal in the Software without restriction, including   */
+/* without limitation the rights to use, copy, modify, merge, publish,   */
+/* distribute, sublicense, and/or sell copies of the Software, and to    */
+/* permit persons to whom the Software is furnished to do so, subject to */
+/* the following conditions:                                             */
+/*                                                                       */
+/* The above copyright notice and this permission notice shall be        */
+/* included in all copies or substantial portions of the Software.       */
+/*                                                                       */
+/* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,       */
+/* EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF    */
+/* MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.*/
+/* IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY  */
+/* CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,  */
+/* TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE     */
+/* SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.                */
+/*************************************************************************/
+
+#include "test_physics_2d_bench.h"
+
+#include "core/math/math_funcs.h"
+#include "core/os/main_loop.h"
+#include "core/os/os.h"
+#include "core/print_string.h"
+#include "servers/physics_2d/broad_phase_2d_bvh.h"
+#include "servers/physics_2d/broad_phase_2d_hash_grid.h"
+#include "servers/physics_2d_server.h"
+
+namespace TestPhysics2DBench {
+
+// Steps the same scenes with each 2D broadphase and prints the average step time.
+// In the static level, also compares casting rays one by one with casting them in one batch.
+// Then stacks a box pyramid with several solver settings, and prints how far the boxes drifted as well.
+// One substepped run also gives the boxes force integration callbacks, and checks they are called at most once a step.
+// Last, fires bullets at a thin wall with each continuous collision detection mode, and counts those that went through.
+// The physics server must be the built-in one, as the broadphase is picked through BroadPhase2DSW::create_func.
+class TestPhysics2DBenchMainLoop : public MainLoop {
+
+	GDCLASS(TestPhysics2DBenchMainLoop, MainLoop);
+
+	enum Scene {
+		SCENE_STATIC_LEVEL,
+		SCENE_DYNAMIC_SWARM,
+		SCENE_MAX
+	};
+
+	enum {
+		TILE_SIZE = 32,
+		QUADRANT_SIZE = 16,
+		LEVEL_WIDTH = 512, // In tiles.
+		LEVEL_HEIGHT = 64,
+		LEVEL_BODIES = 1000,
+		SWARM_BODIES = 2000,
+		SWARM_SIZE = 2048, // In pixels.
+		PYRAMID_BASE = 20, // In boxes, 210 boxes in total.
+		PYRAMID_BOX_SIZE = 32,
+		RAY_AGENTS = 64,
+		RAY_FAN = 16, // Rays cast by each agent.
+		RAY_LENGTH = 320,
+		RAY_REPEATS = 10,
+		BULLETS = 512,
+		BULLET_SPACING = 16,
+		BULLET_SPEED = 3000, // 50 pixels a step, more than the wall and a bullet together.
+		BULLET_WALL_X = 400,
+		STEPS = 300
+	};
+
+	RID space;
+	Vector<RID> rids;
+	int integrate_calls;
+
+	void _integrate_forces(Object *p_state) {
+
+		integrate_calls++;
+	}
+
+	RID _add_shape(RID p_shape) {
+
+		rids.push_back(p_shape);
+		return p_shape;
+	}
+
+	RID _add_body(Physics2DServer::BodyMode p_mode, const Vector2 &p_pos) {
+
+		Physics2DServer *ps = Physics2DServer::get_singleton();
+
+		RID body = ps->body_create();
+		ps->body_set_mode(body, p_mode);
+		ps->body_set_space(body, space);
+		ps->body_set_state(body, Physics2DServer::BODY_STATE_TRANSFORM, Transform2D(0, p_pos));
+		rids.push_back(body);
+		return body;
+	}
+
+	void _make_static_level() {
+
+		Physics2DServer *ps = Physics2DServer::get_singleton();
+
+		RID tile = _add_shape(ps->rectangle_shape_create());
+		ps->shape_set_data(tile, Vector2(TILE_SIZE / 2, TILE_SIZE / 2));
+
+		// Tiles are grouped in one static body per quadrant, like TileMap does, with solid ground and random platforms.
+		for (int qy = 0; qy < LEVEL_HEIGHT / QUADRANT_SIZE; qy++) {
+			for (int qx = 0; qx < LEVEL_WIDTH / QUADRANT_SIZE; qx++) {
+
+				RID body;
+				for (int y = 0; y < QUADRANT_SIZE; y++) {
+					for (int x = 0; x < QUADRANT_SIZE; x++) {
+
+						int tx = qx * QUADRANT_SIZE + x;
+						int ty = qy * QUADRANT_SIZE + y;
+						bool solid = ty >= LEVEL_HEIGHT - 4 || (ty % 8 == 0 && (tx / 8 + ty) % 3 == 0);
+						if (!solid) {
+							continue;
+						}
+
+						if (!body.is_valid()) {
+							body = _add_body(Physics2DServer::BODY_MODE_STATIC, Vector2());
+						}
+						ps->body_add_shape(body, tile, Transform2D(0, Vector2((tx + 0.5) * TILE_SIZE, (ty + 0.5) * TILE_SIZE)));
+					}
+				}
+			}
+		}
+
+		// Walls and a ceiling spanning the whole level, larger than the hash grid likes.
+		RID wall = _add_shape(ps->rectangle_shape_create());
+		ps->shape_set_data(wall, Vector2(TILE_SIZE, LEVEL_HEIGHT * TILE_SIZE / 2));
+		_add_body(Physics2DServer::BODY_MODE_STATIC, Vector2(-TILE_SIZE, LEVEL_HEIGHT * TILE_SIZE / 2));
+		ps->body_add_shape(rids[rids.size() - 1], wall);
+		_add_body(Physics2DServer::BODY_MODE_STATIC, Vector2((LEVEL_WIDTH + 1) * TILE_SIZE, LEVEL_HEIGHT * TILE_SIZE / 2));
+		ps->body_add_shape(rids[rids.size() - 1], wall);
+
+		RID ceiling = _add_shape(ps->rectangle_shape_create());
+		ps->shape_set_data(ceiling, Vector2(LEVEL_WIDTH * TILE_SIZE / 2, TILE_SIZE));
+		_add_body(Physics2DServer::BODY_MODE_STATIC, Vector2(LEVEL_WIDTH * TILE_SIZE / 2, -TILE_SIZE));
+		ps->body_add_shape(rids[rids.size() - 1], ceiling);
+
+		RID circle = _add_shape(ps->circle_shape_create());
+		ps->shape_set_data(circle, 8);
+
+		for (int i = 0; i < LEVEL_BODIES; i++) {
+
+			Vector2 pos(Math::random(0.0f, (float)LEVEL_WIDTH * TILE_SIZE), Math::random(0.0f, (float)(LEVEL_HEIGHT - 8) * TILE_SIZE));
+			RID body = _add_body(Physics2DServer::BODY_MODE_RIGID, pos);
+			ps->body_add_shape(body, circle);
+		}
+	}
+
+	void _make_dynamic_swarm() {
+
+		Physics2DServer *ps = Physics2DServer::get_singleton();
+
+		ps->area_set_param(space, Physics2DServer::AREA_PARAM_GRAVITY, 0);
+
+		Array arr;
+		const Vector2 normals[4] = { Vector2(0, 1), Vector2(0, -1), Vector2(1, 0), Vector2(-1, 0) };
+		const real_t distances[4] = { 0, -SWARM_SIZE, 0, -SWARM_SIZE };
+		for (int i = 0; i < 4; i++) {
+			RID line = _add_shape(ps->line_shape_create());
+			arr.clear();
+			arr.push_back(normals[i]);
+			arr.push_back(distances[i]);
+			ps->shape_set_data(line, arr);
+			RID body = _add_body(Physics2DServer::BODY_MODE_STATIC, Vector2());
+			ps->body_add_shape(body, line);
+		}
+
+		RID circle = _add_shape(ps->circle_shape_create());
+		ps->shape_set_data(circle, 6);
+
+		for (int i = 0; i < SWARM_BODIES; i++) {
+
+			Vector2 pos(Math::random(16.0f, SWARM_SIZE - 16.0f), Math::random(16.0f, SWARM_SIZE - 16.0f));
+			RID body = _add_body(Physics2DServer::BODY_MODE_RIGID, pos);
+			ps->body_add_shape(body, circle);
+			ps->body_set_param(body, Physics2DServer::BODY_PARAM_LINEAR_DAMP, 0);
+			ps->body_set_state(body, Physics2DServer::BODY_STATE_LINEAR_VELOCITY, Vector2(Math::random(-200.0f, 200.0f), Math::random(-200.0f, 200.0f)));
+			ps->body_set_state(body, Physics2DServer::BODY_STATE_CAN_SLEEP, false);
+		}
+	}
+
+	uint64_t _simulate(int &r_pairs) {
+
+		Physics2DServer *ps = Physics2DServer::get_singleton();
+
+		uint64_t step_time = 0;
+		r_pairs = 0;
+
+		for (int i = 0; i < STEPS; i++) {
+
+			ps->sync();
+			ps->flush_queries();
+			ps->end_sync();
+
+			uint64_t begin = OS::get_singleton()->get_ticks_usec();
+			ps->step(1.0 / 60.0);
+			step_time += OS::get_singleton()->get_ticks_usec() - begin;
+
+			r_pairs += ps->get_process_info(Physics2DServer::INFO_COLLISION_PAIRS);
+		}
+
+		return step_time;
+	}
+
+	void _free_all() {
+
+		Physics2DServer *ps = Physics2DServer::get_singleton();
+
+		for (int i = rids.size() - 1; i >= 0; i--) {
+			ps->free(rids[i]);
+		}
+		rids.clear();
+		ps->free(space);
+	}
+
+	void _run_rays(const String &p_broadphase) {
+
+		Physics2DServer *ps = Physics2DServer::get_singleton();
+
+		ps->sync();
+		Physics2DDirectSpaceState *dss = ps->space_get_direct_state(space);
+
+		// Agents spread over the level, each casting a fan of line of sight rays.
+		Vector<Vector2> points;
+		for (int i = 0; i < RAY_AGENTS; i++) {
+
+			Vector2 origin(Math::random(0.0f, (float)LEVEL_WIDTH * TILE_SIZE), Math::random(0.0f, (float)LEVEL_HEIGHT * TILE_SIZE));
+			for (int j = 0; j < RAY_FAN; j++) {
+
+				real_t angle = j * Math_PI * 2.0 / RAY_FAN;
+				points.push_back(origin);
+				points.push_back(origin + Vector2(Math::cos(angle), Math::sin(angle)) * RAY_LENGTH);
+			}
+		}
+
+		int ray_count = points.size() / 2;
+
+		Vector<Physics2DDirectSpaceState::RayResult> results;
+		results.resize(ray_count);
+		Vector<bool> hits;
+		hits.resize(ray_count);
+
+		uint64_t begin = OS::get_singleton()->get_ticks_usec();
+		for (int r = 0; r < RAY_REPEATS; r++) {
+			for (int i = 0; i < ray_count; i++) {
+				hits.write[i] = dss->intersect_ray(points[i * 2 + 0], points[i * 2 + 1], results.write[i]);
+			}
+		}
+		uint64_t single_time = OS::get_singleton()->get_ticks_usec() - begin;
+
+		Vector<Physics2DDirectSpaceState::RayResult> batch_results;
+		batch_results.resize(ray_count);
+		Vector<bool> batch_hits;
+		batch_hits.resize(ray_count);
+
+		begin = OS::get_singleton()->get_ticks_usec();
+		for (int r = 0; r < RAY_REPEATS; r++) {
+			dss->intersect_rays_batch(points.ptr(), ray_count, batch_results.ptrw(), batch_hits.ptrw());
+		}
+		uint64_t batch_time = OS::get_singleton()->get_ticks_usec() - begin;
+
+		ps->end_sync();
+
+		int mismatches = 0;
+		for (int i = 0; i < ray_count; i++) {
+			if (hits[i] != batch_hits[i] || (hits[i] && (results[i].rid != batch_results[i].rid || results[i].position.distance_to(batch_results[i].position) > CMP_EPSILON))) {
+				mismatches++;
+			}
+		}
+
+		print_line(vformat("%d rays, %s: one by one %.3f ms, batched %.3f ms, %d mismatches", ray_count, p_broadphase, single_time / 1000.0 / RAY_REPEATS, batch_time / 1000.0 / RAY_REPEATS, mismatches));
+	}
+
+	void _run_pyramid(int p_iterations, int p_substeps, bool p_callbacks = false) {
+
+		Physics2DServer *ps = Physics2DServer::get_singleton();
+
+		space = ps->space_create();
+		ps->space_set_active(space, true);
+		ps->space_set_param(space, Physics2DServer::SPACE_PARAM_SOLVER_ITERATIONS, p_iterations);
+		ps->space_set_param(space, Physics2DServer::SPACE_PARAM_SOLVER_SUBSTEPS, p_substeps);
+
+		RID ground = _add_shape(ps->rectangle_shape_create());
+		ps->shape_set_data(ground, Vector2(PYRAMID_BASE * PYRAMID_BOX_SIZE, PYRAMID_BOX_SIZE));
+		RID ground_body = _add_body(Physics2DServer::BODY_MODE_STATIC, Vector2(0, PYRAMID_BOX_SIZE));
+		ps->body_add_shape(ground_body, ground);
+
+		RID box = _add_shape(ps->rectangle_shape_create());
+		ps->shape_set_data(box, Vector2(PYRAMID_BOX_SIZE / 2, PYRAMID_BOX_SIZE / 2));
+
+		// Rows start touching, so any drift comes from the solver.
+		Vector<RID> boxes;
+		Vector<Vector2> start;
+		for (int row = 0; row < PYRAMID_BASE; row++) {
+			for (int i = 0; i < PYRAMID_BASE - row; i++) {
+
+				Vector2 pos((i - (PYRAMID_BASE - row - 1) * 0.5) * PYRAMID_BOX_SIZE, -(row + 0.5) * PYRAMID_BOX_SIZE);
+				RID body = _add_body(Physics2DServer::BODY_MODE_RIGID, pos);
+				ps->body_add_shape(body, box);
+				if (p_callbacks) {
+					ps->body_set_force_integration_callback(body, this, "_integrate_forces");
+				}
+				boxes.push_back(body);
+				start.push_back(pos);
+			}
+		}
+
+		integrate_calls = 0;
+
+		int pairs;
+		uint64_t step_time = _simulate(pairs);
+
+		real_t max_drift = 0;
+		int sleeping = 0;
+		for (int i = 0; i < boxes.size(); i++) {
+
+			Transform2D xform = ps->body_get_state(boxes[i], Physics2DServer::BODY_STATE_TRANSFORM);
+			max_drift = MAX(max_drift, xform.get_origin().distance_to(start[i]));
+			if (ps->body_get_state(boxes[i], Physics2DServer::BODY_STATE_SLEEPING)) {
+				sleeping++;
+			}
+		}
+
+		Transform2D top = ps->body_get_state(boxes[boxes.size() - 1], Physics2DServer::BODY_STATE_TRANSFORM);
+		bool standing = top.get_origin().distance_to(start[start.size() - 1]) < PYRAMID_BOX_SIZE / 2;
+
+		_free_all();
+
+		String name = vformat("box pyramid, %d iterations, %d substeps", p_iterations, p_substeps);
+		print_line(vformat("%s: step %.3f ms, max drift %.2f px, %d asleep, %s", name, step_time / 1000.0 / STEPS, max_drift, sleeping, standing ? "standing" : "collapsed"));
+		if (p_callbacks) {
+			// Substeps must still call each callback at most once a step.
+			int max_calls = boxes.size() * STEPS;
+			print_line(vformat("%s: %d force integration calls, %s", name, integrate_calls, integrate_calls <= max_calls ? "at most one per box and step" : "called more than once a step"));
+		}
+	}
+
+	void _run_bullets(Physics2DServer::CCDMode p_mode, const String &p_name) {
+
+		Physics2DServer *ps = Physics2DServer::get_singleton();
+
+		space = ps->space_create();
+		ps->space_set_active(space, true);
+		ps->area_set_param(space, Physics2DServer::AREA_PARAM_GRAVITY, 0);
+
+		RID wall = _add_shape(ps->rectangle_shape_create());
+		ps->shape_set_data(wall, Vector2(2, (BULLETS + 2) * BULLET_SPACING / 2));
+		RID wall_body = _add_body(Physics2DServer::BODY_MODE_STATIC, Vector2(BULLET_WALL_X, BULLETS * BULLET_SPACING / 2));
+		ps->body_add_shape(wall_body, wall);
+
+		RID bullet = _add_shape(ps->circle_shape_create());
+		ps->shape_set_data(bullet, 4);
+
+		Vector<RID> bullets;
+		for (int i = 0; i < BULLETS; i++) {
+
+			RID body = _add_body(Physics2DServer::BODY_MODE_RIGID, Vector2(0, (i + 0.5) * BULLET_SPACING));
+			ps->body_add_shape(body, bullet);
+			ps->body_set_continuous_collision_detection_mode(body, p_mode);
+			ps->body_set_state(body, Physics2DServer::BODY_STATE_LINEAR_VELOCITY, Vector2(BULLET_SPEED, 0));
+			bullets.push_back(body);
+		}
+
+		int pairs;
+		uint64_t step_time = _simulate(pairs);
+
+		int tunneled = 0;
+		for (int i = 0; i < bullets.size(); i++) {
+
+			Transform2D xform = ps->body_get_state(bullets[i], Physics2DServer::BODY_STATE_TRANSFORM);
+			if (xform.get_origin().x > BULLET_WALL_X) {
+				tunneled++;
+			}
+		}
+
+		_free_all();
+
+		print_line(vformat("%d bullets, %s: step %.3f ms, %d went through the wall", BULLETS, p_name, step_time / 1000.0 / STEPS, tunneled));
+	}
+
+	void _run(Scene p_scene, const String &p_broadphase, BroadPhase2DSW::CreateFunction p_create_func) {
+
+		Physics2DServer *ps = Physics2DServer::get_singleton();
+
+		BroadPhase2DSW::CreateFunction prev_create_func = BroadPhase2DSW::create_func;
+		BroadPhase2DSW::create_func = p_create_func;
+
+		Math::seed(1234);
+
+		uint64_t setup_begin = OS::get_singleton()->get_ticks_usec();
+
+		space = ps->space_create();
+		ps->space_set_active(space, true);
+
+		switch (p_scene) {
+			case SCENE_STATIC_LEVEL: {
+				_make_static_level();
+			} break;
+			case SCENE_DYNAMIC_SWARM: {
+				_make_dynamic_swarm();
+			} break;
+			default: {
+			}
+		}
+
+		uint64_t setup_time = OS::get_singleton()->get_ticks_usec() - setup_begin;
+		int pairs;
+		uint64_t step_time = _simulate(pairs);
+
+		if (p_scene == SCENE_STATIC_LEVEL) {
+			_run_rays(p_broadphase);
+		}
+
+		_free_all();
+
+		BroadPhase2DSW::create_func = prev_create_func;
+
+		static const char *scene_names[SCENE_MAX] = { "static level", "dynamic swarm" };
+		print_line(vformat("%s, %s: setup %.2f ms, step %.3f ms, %d pairs", scene_names[p_scene], p_broadphase, setup_time / 1000.0, step_time / 1000.0 / STEPS, pairs / STEPS));
+	}
+
+public:
+	virtual void init() {
+
+		Physics2DServer *ps = Physics2DServer::get_singleton();
+		ps->set_active(true);
+
+		for (int i = 0; i < SCENE_MAX; i++) {
+			_run(Scene(i), "hash grid", BroadPhase2DHashGrid::_create);
+			_run(Scene(i), "bvh", BroadPhase2DBVH::_create);
+		}
+
+		_run_pyramid(16, 1);
+		_run_pyramid(8, 1);
+		_run_pyramid(4, 1);
+		_run_pyramid(4, 2);
+		_run_pyramid(4, 2, true);
+
+		_run_bullets(Physics2DServer::CCD_MODE_DISABLED, "no ccd");
+		_run_bullets(Physics2DServer::CCD_MODE_CAST_RAY, "ray ccd");
+		_run_bullets(Physics2DServer::CCD_MODE_CAST_SHAPE, "shape ccd");
+	}
+
+	virtual bool iteration(float p_time) {
+
+		return true;
+	}
+
+	virtual bool idle(float p_time) {
+
+		return true;
+	}
+
+	virtual void finish() {
+	}
+
+	static void _bind_methods() {
+
+		ClassDB::bind_method(D_METHOD("_integrate_forces"), &TestPhysics2DBenchMainLoop::_integrate_forces);
+	}
+
+	TestPhysics2DBenchMainLoop() {
+		integrate_calls = 0;
+	}
+};
+
+MainLoop *test() {
+
+	return memnew(TestPhysics2DBenchMainLoop);
+}
+} // namespace TestPhysics2DBench
@@ -0,0 +1,236 @@
+/*************************************************************************/
+/*  test_physics_2d_determinism.cpp                                      */
+/*************************************************************************/
+/*                       This file is part of:                           */
+/*                           GODOT ENGINE                                */
+/*                      https://godotengine.org                          */
+/*************************************************************************/
+/* Copyright (c) 2007-2021 Juan Linietsky, Ariel Manzur.                 */
+/* Copyright (c) 2014-2021 Godot Engine contributors (cf. AUTHORS.md).   */
+/*                                                                       */
+/* Permission is hereby granted, free of charge, to any person obtaining */
+/* a copy of this software and associated documentation files (the       */
+/* "Software"), to deal in the Software without restriction, including   */
+/* without limitation the rights to use, copy, modify, merge, publish,   */
+/* distribute, sublicense, and/or sell copies of the Software, and to    */
+/* permit persons to whom the Software is furnished to do so, subject to */
+/* the following conditions:                                             */
+/*                                                                       */
+/* The above copyright notice and this permission notice shall be        */
+/* included in all copies or substantial portions of the Software.       */
+/*                                                                       */
+/* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,       */
+/* EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF    */
+/* MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.*/
+/* IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY  */
+/* CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,  */
+/* TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE     */
+/* SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.                */
+/*************************************************************************/
+
+#include "test_physics_2d_determinism.h"
+
+#include "core/hashfuncs.h"
+#include "core/os/main_loop.h"
+#include "core/print_string.h"
+#include "servers/physics_2d_server.h"
+
+namespace TestPhysics2DDeterminism {
+
+// Runs the same scene twice in a deterministic space and compares the hashes of the saved states along the way.
+// Then saves the state halfway, steps on, restores it and steps again, which must end in the same state as well.
+class TestPhysics2DDeterminismMainLoop : public MainLoop {
+
+	GDCLASS(TestPhysics2DDeterminismMainLoop, MainLoop);
+
+	enum {
+		PILE_WIDTH = 8,
+		PILE_HEIGHT = 12,
+		BOX_SIZE = 24,
+		CHAIN_LINKS = 6,
+		STEPS = 240,
+		HASH_INTERVAL = 30,
+		HASH_COUNT = STEPS / HASH_INTERVAL,
+		REPLAY_STEPS = 60
+	};
+
+	RID space;
+	Vector<RID> rids;
+
+	RID _add_body(Physics2DServer::BodyMode p_mode, const Vector2 &p_pos, RID p_shape) {
+
+		Physics2DServer *ps = Physics2DServer::get_singleton();
+
+		RID body = ps->body_create();
+		ps->body_set_mode(body, p_mode);
+		ps->body_set_space(body, space);
+		ps->body_add_shape(body, p_shape);
+		ps->body_set_state(body, Physics2DServer::BODY_STATE_TRANSFORM, Transform2D(0, p_pos));
+		rids.push_back(body);
+		return body;
+	}
+
+	void _make_scene() {
+
+		Physics2DServer *ps = Physics2DServer::get_singleton();
+
+		space = ps->space_create();
+		ps->space_set_active(space, true);
+		ps->space_set_param(space, Physics2DServer::SPACE_PARAM_DETERMINISTIC, 1);
+
+		RID ground = ps->rectangle_shape_create();
+		ps->shape_set_data(ground, Vector2(1000, 20));
+		rids.push_back(ground);
+		RID box = ps->rectangle_shape_create();
+		ps->shape_set_data(box, Vector2(BOX_SIZE / 2, BOX_SIZE / 2));
+		rids.push_back(box);
+		RID circle = ps->circle_shape_create();
+		ps->shape_set_data(circle, BOX_SIZE / 2);
+		rids.push_back(circle);
+
+		_add_body(Physics2DServer::BODY_MODE_STATIC, Vector2(0, 20), ground);
+
+		// A loose pile of boxes and circles, offset so they tumble into each other.
+		for (int y = 0; y < PILE_HEIGHT; y++) {
+			for (int x = 0; x < PILE_WIDTH; x++) {
+
+				Vector2 pos((x - PILE_WIDTH / 2) * (BOX_SIZE + 4) + (y % 3) * 7, -BOX_SIZE - y * (BOX_SIZE + 8));
+				RID body = _add_body(Physics2DServer::BODY_MODE_RIGID, pos, (x + y) % 2 ? circle : box);
+				ps->body_set_state(body, Physics2DServer::BODY_STATE_ANGULAR_VELOCITY, (x - y) * 0.1);
+			}
+		}
+
+		// A chain swinging into the pile, to have joints in the state too.
+		RID prev;
+		for (int i = 0; i < CHAIN_LINKS; i++) {
+
+			Vector2 pos(-300 + i * BOX_SIZE, -400);
+			RID link = _add_body(i == 0 ? Physics2DServer::BODY_MODE_STATIC : Physics2DServer::BODY_MODE_RIGID, pos, circle);
+			if (prev.is_valid()) {
+				rids.push_back(ps->pin_joint_create(pos - Vector2(BOX_SIZE / 2, 0), prev, link));
+			}
+			prev = link;
+		}
+	}
+
+	void _step(int p_steps) {
+
+		Physics2DServer *ps = Physics2DServer::get_singleton();
+
+		for (int i = 0; i < p_steps; i++) {
+
+			ps->sync();
+			ps->flush_queries();
+			ps->end_sync();
+			ps->step(1.0 / 60.0);
+		}
+	}
+
+	uint32_t _hash_state() {
+
+		PoolVector<uint8_t> state = Physics2DServer::get_singleton()->space_save_state(space);
+		PoolVector<uint8_t>::Read r = state.read();
+		return hash_djb2_buffer(r.ptr(), state.size());
+	}
+
+	void _free_all() {
+
+		Physics2DServer *ps = Physics2DServer::get_singleton();
+
+		for (int i = rids.size() - 1; i >= 0; i--) {
+			ps->free(rids[i]);
+		}
+		rids.clear();
+		ps->free(space);
+	}
+
+	void _run(uint32_t *r_hashes) {
+
+		_make_scene();
+		for (int i = 0; i < HASH_COUNT; i++) {
+			_step(HASH_INTERVAL);
+			r_hashes[i] = _hash_state();
+		}
+		_free_all();
+	}
+
+	bool _test_repeat() {
+
+		uint32_t first[HASH_COUNT];
+		uint32_t second[HASH_COUNT];
+		_run(first);
+		_run(second);
+
+		for (int i = 0; i < HASH_COUNT; i++) {
+			if (first[i] != second[i]) {
+				print_line(vformat("Repeat: states differ after %d steps (%x != %x).", (i + 1) * HASH_INTERVAL, first[i], second[i]));
+				return false;
+			}
+		}
+
+		print_line(vformat("Repeat: %d states match over %d steps, last hash %x.", HASH_COUNT, STEPS, first[HASH_COUNT - 1]));
+		return true;
+	}
+
+	bool _test_restore() {
+
+		Physics2DServer *ps = Physics2DServer::get_singleton();
+
+		_make_scene();
+		_step(STEPS / 2);
+
+		PoolVector<uint8_t> saved = ps->space_save_state(space);
+		_step(REPLAY_STEPS);
+		uint32_t expected = _hash_state();
+
+		bool restored = ps->space_restore_state(space, saved);
+		_step(REPLAY_STEPS);
+		uint32_t replayed = _hash_state();
+
+		_free_all();
+
+		if (!restored) {
+			print_line("Restore: the saved state was rejected.");
+			return false;
+		}
+		if (expected != replayed) {
+			print_line(vformat("Restore: replaying %d steps ended in a different state (%x != %x).", REPLAY_STEPS, expected, replayed));
+			return false;
+		}
+
+		print_line(vformat("Restore: replaying %d steps from a %d bytes state matches, hash %x.", REPLAY_STEPS, saved.size(), replayed));
+		return true;
+	}
+
+public:
+	virtual void init() {
+
+		Physics2DServer::get_singleton()->set_active(true);
+
+		bool ok = _test_repeat();
+		ok = _test_restore() && ok;
+
+		print_line(ok ? "Physics 2D determinism: passed." : "Physics 2D determinism: FAILED.");
+	}
+
+	virtual bool iteration(float p_time) {
+
+		return true;
+	}
+
+	virtual bool idle(float p_time) {
+
+		return true;
+	}
+
+	virtual void finish() {
+	}
+
+	TestPhysics2DDeterminismMainLoop() {}
+};
+
+MainLoop *test() {
+
+	return memnew(TestPhysics2DDeterminismMainLoop);
+}
+} // namespace TestPhysics2DDeterminism
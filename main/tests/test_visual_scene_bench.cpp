@@ -0,0 +1,486 @@
+/*************************************************************************/
+/*  test_visual_scene_bench.cpp                                          */
+/*************************************************************************/
+/*                       This file is part of:                           */
+/*                           GODOT ENGINE                                */
+/*                      https://godotengine.org                          */
+/*************************************************************************/
+/* Copyright (c) 2007-2021 Juan Linietsky, Ariel Manzur.                 */
+/* Copyright (c) 2014-2021 Godot Engine contributors (cf. AUTHORS.md).   */
+/*                                                                       */
+/* Permission is hereby granted, free of charge, to any person obtaining */
+/* a copy of this software and associated documentation files (the       */
+/* "Software"), to deal in the Software without restriction, including   */
+/* without limitation the rights to use, copy, modify, merge, publish,   */
+/* distribute, sublicense, and/or sell copies of the Software, and to    */
+/* permit persons to whom the Software is furnished to do so, subject to */
+/* the following conditions:                                             */
+/*                                                                       */
+/* The above copyright notice and this permission notice shall be        */
+/* included in all copies or substantial portions of the Software.       */
+/*                                                                       */
+/* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,       */
+/* EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF    */
+/* MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.*/
+/* IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY  */
+/* CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,  */
+/* TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE     */
+/* SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.                */
+/*************************************************************************/
+
+#include "test_visual_scene_bench.h"
+
+#include "core/io/json.h"
+#include "core/math/camera_matrix.h"
+#include "core/math/math_funcs.h"
+#include "core/os/os.h"
+#include "core/print_string.h"
+#include "drivers/dummy/rasterizer_dummy.h"
+#include "servers/visual/visual_server_globals.h"
+#include "servers/visual/visual_server_scene.h"
+
+namespace TestVisualSceneBench {
+
+// RasterizerStorageDummy keeps no light data and reports empty mesh bounds, so nothing would ever be culled.
+// The bench keeps just what culling and shadow setup read here, leaving the dummy driver untouched.
+class RasterizerStorageBench : public RasterizerStorageDummy {
+
+	struct BenchLight : public RID_Data {
+		VS::LightType type;
+		float param[VS::LIGHT_PARAM_MAX];
+		bool shadow;
+		VS::LightOmniShadowMode omni_shadow_mode;
+		VS::LightDirectionalShadowMode directional_shadow_mode;
+		uint64_t version;
+	};
+
+	mutable RID_Owner<BenchLight> light_owner;
+
+public:
+	AABB mesh_get_aabb(RID p_mesh, RID p_skeleton) const {
+		DummyMesh *m = mesh_owner.getornull(p_mesh);
+		ERR_FAIL_COND_V(!m, AABB());
+
+		AABB aabb;
+		for (int i = 0; i < m->surfaces.size(); i++) {
+			if (i == 0) {
+				aabb = m->surfaces[i].aabb;
+			} else {
+				aabb.merge_with(m->surfaces[i].aabb);
+			}
+		}
+		return aabb;
+	}
+
+	RID light_create(VS::LightType p_type) {
+		BenchLight *light = memnew(BenchLight);
+		ERR_FAIL_COND_V(!light, RID());
+		light->type = p_type;
+		for (int i = 0; i < VS::LIGHT_PARAM_MAX; i++) {
+			light->param[i] = 0.0;
+		}
+		light->param[VS::LIGHT_PARAM_RANGE] = 1.0;
+		light->param[VS::LIGHT_PARAM_SPOT_ANGLE] = 45;
+		light->shadow = false;
+		light->omni_shadow_mode = VS::LIGHT_OMNI_SHADOW_DUAL_PARABOLOID;
+		light->directional_shadow_mode = VS::LIGHT_DIRECTIONAL_SHADOW_ORTHOGONAL;
+		light->version = 0;
+		return light_owner.make_rid(light);
+	}
+
+	RID directional_light_create() { return light_create(VS::LIGHT_DIRECTIONAL); }
+	RID omni_light_create() { return light_create(VS::LIGHT_OMNI); }
+	RID spot_light_create() { return light_create(VS::LIGHT_SPOT); }
+
+	void light_set_param(RID p_light, VS::LightParam p_param, float p_value) {
+		BenchLight *light = light_owner.getornull(p_light);
+		ERR_FAIL_COND(!light);
+		ERR_FAIL_INDEX(p_param, VS::LIGHT_PARAM_MAX);
+		light->param[p_param] = p_value;
+		light->version++;
+	}
+	void light_set_shadow(RID p_light, bool p_enabled) {
+		BenchLight *light = light_owner.getornull(p_light);
+		ERR_FAIL_COND(!light);
+		light->shadow = p_enabled;
+		light->version++;
+	}
+	void light_omni_set_shadow_mode(RID p_light, VS::LightOmniShadowMode p_mode) {
+		BenchLight *light = light_owner.getornull(p_light);
+		ERR_FAIL_COND(!light);
+		light->omni_shadow_mode = p_mode;
+	}
+	void light_directional_set_shadow_mode(RID p_light, VS::LightDirectionalShadowMode p_mode) {
+		BenchLight *light = light_owner.getornull(p_light);
+		ERR_FAIL_COND(!light);
+		light->directional_shadow_mode = p_mode;
+	}
+
+	VS::LightDirectionalShadowMode light_directional_get_shadow_mode(RID p_light) {
+		const BenchLight *light = light_owner.getornull(p_light);
+		ERR_FAIL_COND_V(!light, VS::LIGHT_DIRECTIONAL_SHADOW_ORTHOGONAL);
+		return light->directional_shadow_mode;
+	}
+	VS::LightOmniShadowMode light_omni_get_shadow_mode(RID p_light) {
+		const BenchLight *light = light_owner.getornull(p_light);
+		ERR_FAIL_COND_V(!light, VS::LIGHT_OMNI_SHADOW_DUAL_PARABOLOID);
+		return light->omni_shadow_mode;
+	}
+	bool light_has_shadow(RID p_light) const {
+		const BenchLight *light = light_owner.getornull(p_light);
+		ERR_FAIL_COND_V(!light, false);
+		return light->shadow;
+	}
+	VS::LightType light_get_type(RID p_light) const {
+		const BenchLight *light = light_owner.getornull(p_light);
+		ERR_FAIL_COND_V(!light, VS::LIGHT_OMNI);
+		return light->type;
+	}
+	AABB light_get_aabb(RID p_light) const {
+		const BenchLight *light = light_owner.getornull(p_light);
+		ERR_FAIL_COND_V(!light, AABB());
+
+		switch (light->type) {
+			case VS::LIGHT_SPOT: {
+				float len = light->param[VS::LIGHT_PARAM_RANGE];
+				float size = Math::tan(Math::deg2rad(light->param[VS::LIGHT_PARAM_SPOT_ANGLE])) * len;
+				return AABB(Vector3(-size, -size, -len), Vector3(size * 2, size * 2, len));
+			}
+			case VS::LIGHT_OMNI: {
+				float r = light->param[VS::LIGHT_PARAM_RANGE];
+				return AABB(-Vector3(r, r, r), Vector3(r, r, r) * 2);
+			}
+			default: {
+				return AABB();
+			}
+		}
+	}
+	float light_get_param(RID p_light, VS::LightParam p_param) {
+		const BenchLight *light = light_owner.getornull(p_light);
+		ERR_FAIL_COND_V(!light, 0.0);
+		ERR_FAIL_INDEX_V(p_param, VS::LIGHT_PARAM_MAX, 0.0);
+		return light->param[p_param];
+	}
+	uint64_t light_get_version(RID p_light) const {
+		const BenchLight *light = light_owner.getornull(p_light);
+		ERR_FAIL_COND_V(!light, 0);
+		return light->version;
+	}
+
+	VS::InstanceType get_base_type(RID p_rid) const {
+		if (light_owner.owns(p_rid)) {
+			return VS::INSTANCE_LIGHT;
+		}
+		return RasterizerStorageDummy::get_base_type(p_rid);
+	}
+
+	bool free(RID p_rid) {
+		if (light_owner.owns(p_rid)) {
+			BenchLight *light = light_owner.getornull(p_rid);
+			light_owner.free(p_rid);
+			memdelete(light);
+			return true;
+		}
+		return RasterizerStorageDummy::free(p_rid);
+	}
+};
+
+class RasterizerBench : public RasterizerDummy {
+
+	RasterizerStorageBench bench_storage;
+
+public:
+	RasterizerStorage *get_storage() { return &bench_storage; }
+};
+
+// Times the CPU side of 3D rendering, with a VisualServerScene of its own drawing through a RasterizerDummy that tracks lights and mesh bounds, so no GPU is needed.
+// Each run fills a scenario with static and moving instances, lights and cameras, then over several frames times
+// update_dirty_instances(), _prepare_scene() for each camera and the shadow culls of the lights each camera sees.
+// Runs with the BVH and the octree, and prints one JSON object per run so builds can be compared by scripts.
+// The rasterizer globals are swapped while it runs, so it refuses to run with a separate render thread.
+class TestVisualSceneBenchMainLoop : public MainLoop {
+
+	GDCLASS(TestVisualSceneBenchMainLoop, MainLoop);
+
+	enum {
+		INSTANCE_SPACING = 4, // Average distance between instances on the ground plane.
+		INSTANCE_HEIGHT = 8,
+		MOVING_PERCENT = 25,
+		MOVE_RANGE = 4,
+		OMNI_LIGHTS = 16, // Half of them use cube shadows.
+		OMNI_RANGE = 20,
+		SPOT_LIGHTS = 16,
+		SPOT_RANGE = 30,
+		CAMERAS = 4,
+		CAMERA_FAR = 200,
+		FRAMES = 60
+	};
+
+	struct Mover {
+		RID instance;
+		Vector3 origin;
+		Vector3 axis;
+		float phase;
+	};
+
+	VisualServerScene *scene;
+	RID scenario;
+	RID mesh;
+	Vector<RID> lights; // Bases, owned by the storage.
+	Vector<RID> instances;
+	Vector<Mover> movers;
+
+	RID _add_instance(RID p_base, const Transform &p_xform) {
+
+		RID instance = scene->instance_create();
+		scene->instance_set_base(instance, p_base);
+		scene->instance_set_scenario(instance, scenario);
+		scene->instance_set_transform(instance, p_xform);
+		instances.push_back(instance);
+		return instance;
+	}
+
+	RID _add_light(VS::LightType p_type, float p_range, const Transform &p_xform) {
+
+		RID light = VSG::storage->light_create(p_type);
+		VSG::storage->light_set_param(light, VS::LIGHT_PARAM_RANGE, p_range);
+		VSG::storage->light_set_param(light, VS::LIGHT_PARAM_SPOT_ANGLE, 40);
+		VSG::storage->light_set_shadow(light, true);
+		lights.push_back(light);
+		return _add_instance(light, p_xform);
+	}
+
+	void _make_scene(int p_count, real_t p_size) {
+
+		mesh = VSG::storage->mesh_create();
+		VSG::storage->mesh_add_surface(mesh, VS::ARRAY_FORMAT_VERTEX, VS::PRIMITIVE_TRIANGLES, PoolVector<uint8_t>(), 0, PoolVector<uint8_t>(), 0, AABB(Vector3(-1, -1, -1), Vector3(2, 2, 2)));
+
+		for (int i = 0; i < p_count; i++) {
+
+			Vector3 origin(Math::random(0.0f, p_size), Math::random(0.0f, (float)INSTANCE_HEIGHT), Math::random(0.0f, p_size));
+			Transform xform(Basis(Vector3(0, 1, 0), Math::random(0.0f, (float)Math_TAU)), origin);
+			RID instance = _add_instance(mesh, xform);
+
+			if (i % 100 < MOVING_PERCENT) {
+				Mover mover;
+				mover.instance = instance;
+				mover.origin = origin;
+				mover.axis = Vector3(Math::random(-1.0f, 1.0f), 0, Math::random(-1.0f, 1.0f)).normalized();
+				mover.phase = Math::random(0.0f, (float)Math_TAU);
+				movers.push_back(mover);
+			}
+		}
+
+		Transform sun;
+		sun.basis = Basis(Vector3(1, 0, 0), -Math_PI / 3) * Basis(Vector3(0, 1, 0), Math_PI / 4);
+		_add_light(VS::LIGHT_DIRECTIONAL, 1, sun);
+		VSG::storage->light_directional_set_shadow_mode(lights[lights.size() - 1], VS::LIGHT_DIRECTIONAL_SHADOW_PARALLEL_4_SPLITS);
+
+		for (int i = 0; i < OMNI_LIGHTS; i++) {
+
+			Vector3 origin(Math::random(0.0f, p_size), INSTANCE_HEIGHT, Math::random(0.0f, p_size));
+			_add_light(VS::LIGHT_OMNI, OMNI_RANGE, Transform(Basis(), origin));
+			VSG::storage->light_omni_set_shadow_mode(lights[lights.size() - 1], i % 2 ? VS::LIGHT_OMNI_SHADOW_CUBE : VS::LIGHT_OMNI_SHADOW_DUAL_PARABOLOID);
+		}
+
+		for (int i = 0; i < SPOT_LIGHTS; i++) {
+
+			Vector3 origin(Math::random(0.0f, p_size), INSTANCE_HEIGHT * 2, Math::random(0.0f, p_size));
+			_add_light(VS::LIGHT_SPOT, SPOT_RANGE, Transform(Basis(Vector3(1, 0, 0), -Math_PI / 2), origin));
+		}
+	}
+
+	void _free_all() {
+
+		for (int i = instances.size() - 1; i >= 0; i--) {
+			scene->free(instances[i]);
+		}
+		instances.clear();
+		movers.clear();
+
+		for (int i = 0; i < lights.size(); i++) {
+			VSG::storage->free(lights[i]);
+		}
+		lights.clear();
+
+		VSG::storage->free(mesh);
+		scene->free(scenario);
+	}
+
+	void _run(bool p_bvh, int p_count) {
+
+		Math::seed(1234);
+
+		scene->_use_bvh = p_bvh;
+
+		real_t size = Math::sqrt((real_t)p_count) * INSTANCE_SPACING;
+
+		uint64_t setup_begin = OS::get_singleton()->get_ticks_usec();
+
+		scenario = scene->scenario_create();
+		_make_scene(p_count, size);
+		scene->update_dirty_instances();
+
+		uint64_t setup_time = OS::get_singleton()->get_ticks_usec() - setup_begin;
+
+		VisualServerScene::Scenario *scenario_ptr = scene->scenario_owner.getornull(scenario);
+
+		// Cameras on the edges of the world, looking across it.
+		Transform cam_xforms[CAMERAS];
+		for (int i = 0; i < CAMERAS; i++) {
+
+			real_t angle = i * Math_TAU / CAMERAS;
+			Vector3 center(size * 0.5, 0, size * 0.5);
+			Vector3 eye = center + Vector3(Math::cos(angle), 0, Math::sin(angle)) * size * 0.5 + Vector3(0, INSTANCE_HEIGHT * 2, 0);
+			cam_xforms[i] = Transform(Basis(), eye).looking_at(center, Vector3(0, 1, 0));
+		}
+
+		CameraMatrix projection;
+		projection.set_perspective(70, 16.0 / 9.0, 0.05, CAMERA_FAR);
+
+		uint64_t update_time = 0;
+		uint64_t prepare_time = 0;
+		uint64_t shadow_time = 0;
+		uint64_t visible_instances = 0;
+		uint64_t visible_lights = 0;
+
+		// Movers are pushed through the batched API, the way a game moving many objects would.
+		Vector<RID> mover_instances;
+		mover_instances.resize(movers.size());
+		for (int i = 0; i < movers.size(); i++) {
+			mover_instances.write[i] = movers[i].instance;
+		}
+
+		PoolVector<float> mover_xforms;
+		mover_xforms.resize(movers.size() * 12);
+
+		for (int frame = 0; frame < FRAMES; frame++) {
+
+			{
+				PoolVector<float>::Write w = mover_xforms.write();
+				for (int i = 0; i < movers.size(); i++) {
+
+					const Mover &mover = movers[i];
+					Vector3 origin = mover.origin + mover.axis * Math::sin(frame * 0.1 + mover.phase) * MOVE_RANGE;
+					float *f = &w[i * 12];
+					f[0] = 1;
+					f[1] = 0;
+					f[2] = 0;
+					f[3] = origin.x;
+					f[4] = 0;
+					f[5] = 1;
+					f[6] = 0;
+					f[7] = origin.y;
+					f[8] = 0;
+					f[9] = 0;
+					f[10] = 1;
+					f[11] = origin.z;
+				}
+			}
+			scene->instances_set_transforms(mover_instances, mover_xforms);
+
+			uint64_t begin = OS::get_singleton()->get_ticks_usec();
+			scene->update_dirty_instances();
+			update_time += OS::get_singleton()->get_ticks_usec() - begin;
+
+			for (int i = 0; i < CAMERAS; i++) {
+
+				begin = OS::get_singleton()->get_ticks_usec();
+				// No shadow atlas, so the shadows are left to the loop below.
+				scene->_prepare_scene(cam_xforms[i], projection, false, RID(), 0xFFFFFFFF, scenario, RID(), RID());
+				prepare_time += OS::get_singleton()->get_ticks_usec() - begin;
+
+				visible_instances += scene->instance_cull_count;
+				visible_lights += scene->light_cull_count;
+
+				begin = OS::get_singleton()->get_ticks_usec();
+				for (List<VisualServerScene::Instance *>::Element *E = scenario_ptr->directional_lights.front(); E; E = E->next()) {
+					scene->_light_instance_update_shadow(E->get(), cam_xforms[i], projection, false, RID(), scenario_ptr, true);
+				}
+				for (int j = 0; j < scene->light_cull_count; j++) {
+					scene->_light_instance_update_shadow(scene->light_cull_result[j], cam_xforms[i], projection, false, RID(), scenario_ptr, true);
+				}
+				shadow_time += OS::get_singleton()->get_ticks_usec() - begin;
+			}
+		}
+
+		_free_all();
+
+		Dictionary result;
+		result["benchmark"] = "visual_scene";
+		result["partitioning"] = p_bvh ? "bvh" : "octree";
+		result["instances"] = p_count;
+		result["moving"] = p_count * MOVING_PERCENT / 100;
+		result["lights"] = 1 + OMNI_LIGHTS + SPOT_LIGHTS;
+		result["cameras"] = CAMERAS;
+		result["frames"] = FRAMES;
+		result["setup_ms"] = setup_time / 1000.0;
+		result["update_ms"] = update_time / 1000.0 / FRAMES;
+		result["prepare_ms"] = prepare_time / 1000.0 / (FRAMES * CAMERAS);
+		result["shadow_ms"] = shadow_time / 1000.0 / (FRAMES * CAMERAS);
+		result["visible_instances"] = visible_instances / (FRAMES * CAMERAS);
+		result["visible_lights"] = visible_lights / (FRAMES * CAMERAS);
+		print_line(JSON::print(result, "", false));
+	}
+
+public:
+	virtual void init() {
+
+		if (OS::get_singleton()->get_render_thread_mode() == OS::RENDER_SEPARATE_THREAD) {
+			ERR_PRINT("The visual scene benchmark can't run with a separate render thread.");
+			return;
+		}
+
+		RasterizerStorage *prev_base_storage = RasterizerStorage::base_singleton;
+		Rasterizer *prev_rasterizer = VSG::rasterizer;
+		RasterizerStorage *prev_storage = VSG::storage;
+		RasterizerScene *prev_scene_render = VSG::scene_render;
+		VisualServerScene *prev_scene_singleton = VisualServerScene::singleton;
+
+		Rasterizer *rasterizer = memnew(RasterizerBench);
+		VSG::rasterizer = rasterizer;
+		VSG::storage = rasterizer->get_storage();
+		VSG::scene_render = rasterizer->get_scene();
+
+		scene = memnew(VisualServerScene);
+
+		static const int counts[] = { 1000, 10000, 50000 };
+		for (int i = 0; i < 3; i++) {
+			_run(true, counts[i]);
+			_run(false, counts[i]);
+		}
+
+		memdelete(scene);
+		scene = NULL;
+
+		VSG::rasterizer = prev_rasterizer;
+		VSG::storage = prev_storage;
+		VSG::scene_render = prev_scene_render;
+		VisualServerScene::singleton = prev_scene_singleton;
+		memdelete(rasterizer);
+		RasterizerStorage::base_singleton = prev_base_storage;
+	}
+
+	virtual bool iteration(float p_time) {
+
+		return true;
+	}
+
+	virtual bool idle(float p_time) {
+
+		return true;
+	}
+
+	virtual void finish() {
+	}
+
+	TestVisualSceneBenchMainLoop() {
+		scene = NULL;
+	}
+};
+
+MainLoop *test() {
+
+	return memnew(TestVisualSceneBenchMainLoop);
+}
+} // namespace TestVisualSceneBench
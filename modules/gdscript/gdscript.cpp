@@ -37,7 +37,10 @@
 #include "core/os/file_access.h"
 #include "core/os/os.h"
 #include "core/project_settings.h"
+#include "gdscript_compiled_cache.h"
 #include "gdscript_compiler.h"
+#include "gdscript_preloader.h"
+#include "gdscript_sampler.h"
 
 ///////////////////////////
 
@@ -769,6 +772,22 @@ Error GDScript::load_byte_code(const String &p_path) {
 	ERR_FAIL_COND_V(bytecode.size() == 0, ERR_PARSE_ERROR);
 	path = p_path;
 
+	if (GDScriptCompiledCache::is_cache(bytecode)) {
+		Vector<uint8_t> tokens;
+		Error err = GDScriptCompiledCache::load(this, bytecode, tokens);
+		if (err == OK) {
+			valid = true;
+			for (Map<StringName, Ref<GDScript> >::Element *E = subclasses.front(); E; E = E->next()) {
+				_set_subclass_path(E->get(), path);
+			}
+			return OK;
+		}
+
+		// Compiled for another build or missing a dependency, compile the embedded tokens instead.
+		ERR_FAIL_COND_V_MSG(tokens.empty(), ERR_FILE_CORRUPT, "Invalid compiled GDScript cache: '" + p_path + "'.");
+		bytecode = tokens;
+	}
+
 	String basedir = path;
 
 	if (basedir == "")
@@ -951,6 +970,7 @@ GDScript::~GDScript() {
 	if (GDScriptLanguage::singleton == NULL) {
 		return;
 	}
+	GDScriptLanguage::get_singleton()->invalidate_inline_caches();
 	GDScriptLanguage::get_singleton()->lock.lock();
 	while (SelfList<GDScriptFunctionState> *E = pending_func_states.first()) {
 		// Order matters since clearing the stack may already cause
@@ -1473,6 +1493,10 @@ void GDScriptLanguage::init() {
 
 		_add_global(E->get().name, E->get().ptr);
 	}
+
+	if (GLOBAL_GET("gdscript/sampling_profiler/enabled") && !Engine::get_singleton()->is_editor_hint()) {
+		sampler = memnew(GDScriptSampler(GLOBAL_GET("gdscript/sampling_profiler/interval_usec")));
+	}
 }
 
 String GDScriptLanguage::get_type() const {
@@ -1489,6 +1513,18 @@ Error GDScriptLanguage::execute_file(const String &p_path) {
 	return OK;
 }
 void GDScriptLanguage::finish() {
+
+	preloaded_scripts.clear();
+
+	if (sampler) {
+		String path = GLOBAL_GET("gdscript/sampling_profiler/output_path");
+		print_verbose("GDScript: Saving " + itos(sampler->get_total_samples()) + " samples to " + path);
+		if (path != String()) {
+			sampler->save_collapsed_stacks(path);
+		}
+		memdelete(sampler);
+		sampler = NULL;
+	}
 }
 
 void GDScriptLanguage::profiling_start() {
@@ -1758,6 +1794,41 @@ void GDScriptLanguage::reload_tool_script(const Ref<Script> &p_script, bool p_so
 #endif
 }
 
+void GDScriptLanguage::preload_scripts(const Vector<String> &p_paths) {
+
+	if (!GLOBAL_GET("gdscript/loading/parallel_preload")) {
+		return;
+	}
+
+	uint64_t begin = OS::get_singleton()->get_ticks_usec();
+
+	GDScriptPreloader preloader;
+	for (int i = 0; i < p_paths.size(); i++) {
+		preloader.add_path(p_paths[i]);
+	}
+
+	// Global classes are referenced by name from anywhere, so they are almost always needed.
+	List<StringName> global_classes;
+	ScriptServer::get_global_class_list(&global_classes);
+	for (List<StringName>::Element *E = global_classes.front(); E; E = E->next()) {
+		if (ScriptServer::get_global_class_language(E->get()) == get_name()) {
+			preloader.add_path(ScriptServer::get_global_class_path(E->get()));
+		}
+	}
+
+	List<GDScriptPreloader::Timing> timings;
+	preloader.load(&preloaded_scripts, &timings);
+
+	if (OS::get_singleton()->is_stdout_verbose()) {
+		for (List<GDScriptPreloader::Timing>::Element *E = timings.front(); E; E = E->next()) {
+			const GDScriptPreloader::Timing &t = E->get();
+			String where = t.wave >= 0 ? "wave " + itos(t.wave) : String("main thread");
+			print_line("GDScript: Preloaded " + t.path + " in " + rtos(t.usec / 1000.0) + " ms (" + where + ")" + (t.loaded ? "" : ", failed"));
+		}
+		print_line("GDScript: Preloaded " + itos(timings.size()) + " scripts in " + rtos((OS::get_singleton()->get_ticks_usec() - begin) / 1000.0) + " ms.");
+	}
+}
+
 void GDScriptLanguage::frame() {
 
 	calls = 0;
@@ -2136,6 +2207,7 @@ GDScriptWarning::Code GDScriptWarning::get_code_from_name(const String &p_name)
 GDScriptLanguage::GDScriptLanguage() {
 
 	calls = 0;
+	inline_cache_epoch.set(1);
 	ERR_FAIL_COND(singleton);
 	singleton = this;
 	strings._init = StaticCString::create("_init");
@@ -2153,6 +2225,12 @@ GDScriptLanguage::GDScriptLanguage() {
 	_debug_call_stack_pos = 0;
 	int dmcs = GLOBAL_DEF("debug/settings/gdscript/max_call_stack", 1024);
 	ProjectSettings::get_singleton()->set_custom_property_info("debug/settings/gdscript/max_call_stack", PropertyInfo(Variant::INT, "debug/settings/gdscript/max_call_stack", PROPERTY_HINT_RANGE, "1024,4096,1,or_greater")); //minimum is 1024
+	GLOBAL_DEF("gdscript/loading/parallel_preload", false);
+	GLOBAL_DEF("gdscript/sampling_profiler/enabled", false);
+	GLOBAL_DEF("gdscript/sampling_profiler/interval_usec", 1000);
+	ProjectSettings::get_singleton()->set_custom_property_info("gdscript/sampling_profiler/interval_usec", PropertyInfo(Variant::INT, "gdscript/sampling_profiler/interval_usec", PROPERTY_HINT_RANGE, "100,100000,1,or_greater"));
+	GLOBAL_DEF("gdscript/sampling_profiler/output_path", "user://gdscript_samples.txt");
+	sampler = NULL;
 
 	if (ScriptDebugger::get_singleton()) {
 		//debugging enabled!
@@ -2209,14 +2287,22 @@ GDScriptLanguage::~GDScriptLanguage() {
 		script->unreference();
 	}
 
+	for (int i = 0; i < FRAME_POOL_BUCKETS; i++) {
+		for (uint32_t j = 0; j < frame_pool[i].size(); j++) {
+			memfree(frame_pool[i][j]);
+		}
+	}
+
 	singleton = NULL;
 }
 
 void GDScriptLanguage::add_orphan_subclass(const String &p_qualified_name, const ObjectID &p_subclass) {
+	MutexLock mutex_lock(lock);
 	orphan_subclasses[p_qualified_name] = p_subclass;
 }
 
 Ref<GDScript> GDScriptLanguage::get_orphan_subclass(const String &p_qualified_name) {
+	MutexLock mutex_lock(lock);
 	Map<String, ObjectID>::Element *orphan_subclass_element = orphan_subclasses.find(p_qualified_name);
 	if (!orphan_subclass_element)
 		return Ref<GDScript>();
@@ -2228,6 +2314,44 @@ Ref<GDScript> GDScriptLanguage::get_orphan_subclass(const String &p_qualified_na
 	return Ref<GDScript>(Object::cast_to<GDScript>(obj));
 }
 
+uint8_t *GDScriptLanguage::alloc_frame(uint32_t p_size, uint32_t &r_capacity) {
+
+	r_capacity = next_power_of_2(MAX(p_size, 1u << FRAME_POOL_MIN_SHIFT));
+	int bucket = get_shift_from_power_of_2(r_capacity) - FRAME_POOL_MIN_SHIFT;
+
+	if (bucket < FRAME_POOL_BUCKETS) {
+		lock.lock();
+		uint32_t free_count = frame_pool[bucket].size();
+		if (free_count) {
+			uint8_t *frame = frame_pool[bucket][free_count - 1];
+			frame_pool[bucket].resize(free_count - 1);
+			lock.unlock();
+			return frame;
+		}
+		lock.unlock();
+	}
+
+	return (uint8_t *)memalloc(r_capacity);
+}
+
+void GDScriptLanguage::free_frame(uint8_t *p_frame, uint32_t p_capacity) {
+
+	int bucket = get_shift_from_power_of_2(p_capacity) - FRAME_POOL_MIN_SHIFT;
+
+	if (bucket >= 0 && bucket < FRAME_POOL_BUCKETS) {
+		lock.lock();
+		if (frame_pool[bucket].size() < FRAME_POOL_MAX_FREE) {
+			frame_pool[bucket].push_back(p_frame);
+			p_frame = NULL;
+		}
+		lock.unlock();
+	}
+
+	if (p_frame) {
+		memfree(p_frame);
+	}
+}
+
 /*************** RESOURCE ***************/
 
 RES ResourceFormatLoaderGDScript::load(const String &p_path, const String &p_original_path, Error *r_error) {
@@ -33,6 +33,7 @@
 
 #include "core/io/resource_loader.h"
 #include "core/io/resource_saver.h"
+#include "core/local_vector.h"
 #include "core/script_language.h"
 #include "gdscript_function.h"
 
@@ -70,6 +71,7 @@ class GDScript : public Script {
 	friend class GDScriptInstance;
 	friend class GDScriptFunction;
 	friend class GDScriptCompiler;
+	friend class GDScriptCompiledCache;
 	friend class GDScriptFunctions;
 	friend class GDScriptLanguage;
 
@@ -320,6 +322,8 @@ struct GDScriptWarning {
 };
 #endif // DEBUG_ENABLED
 
+class GDScriptSampler;
+
 class GDScriptLanguage : public ScriptLanguage {
 
 	friend class GDScriptFunctionState;
@@ -364,6 +368,24 @@ class GDScriptLanguage : public ScriptLanguage {
 
 	Map<String, ObjectID> orphan_subclasses;
 
+	List<RES> preloaded_scripts; // Kept alive until finish(), so the work isn't lost on the first unload.
+
+	GDScriptSampler *sampler;
+
+	// Stack frames of yielded functions, recycled by power of two size class.
+	enum {
+		FRAME_POOL_MIN_SHIFT = 6,
+		FRAME_POOL_BUCKETS = 12,
+		FRAME_POOL_MAX_FREE = 64,
+	};
+
+	LocalVector<uint8_t *> frame_pool[FRAME_POOL_BUCKETS];
+
+	// Bumped whenever script tables change or a script is freed, invalidating all inline caches.
+	SafeNumeric<uint32_t> inline_cache_epoch;
+	// Bumped whenever a function is freed, after which its address can be reused by another one.
+	SafeNumeric<uint32_t> function_free_count;
+
 public:
 	int calls;
 
@@ -494,6 +516,7 @@ public:
 
 	virtual void reload_all_scripts();
 	virtual void reload_tool_script(const Ref<Script> &p_script, bool p_soft_reload);
+	virtual void preload_scripts(const Vector<String> &p_paths);
 
 	virtual void frame();
 
@@ -518,6 +541,14 @@ public:
 	void add_orphan_subclass(const String &p_qualified_name, const ObjectID &p_subclass);
 	Ref<GDScript> get_orphan_subclass(const String &p_qualified_name);
 
+	uint8_t *alloc_frame(uint32_t p_size, uint32_t &r_capacity);
+	void free_frame(uint8_t *p_frame, uint32_t p_capacity);
+
+	_FORCE_INLINE_ uint32_t get_inline_cache_epoch() const { return inline_cache_epoch.get(); }
+	_FORCE_INLINE_ void invalidate_inline_caches() { inline_cache_epoch.increment(); }
+
+	_FORCE_INLINE_ uint32_t get_function_free_count() const { return function_free_count.get(); }
+
 	GDScriptLanguage();
 	~GDScriptLanguage();
 };
@@ -0,0 +1,1767 @@
+/*************************************************************************/
+/*  gdscript_compiled_cache.cpp                                          */
+/*************************************************************************/
+/*                       This file is part of:                           */
+/*                           GODOT ENGINE                                */
+/*                      https://godotengine.org                          */
+/*************************************************************************/
+/* Copyright (c) 2007-2021 Juan Linietsky, Ariel Manzur.                 */
+/* Copyright (c) 2014-2021 Godot Engine contributors (cf. AUTHORS.md).   */
+/*                                                                       */
+/* Permission is hereby granted, free of charge, to any person obtaining */
+/* a copy of this software and associated documentation files (the       */
+/* "Software"), to deal in the Software without restriction, including   */
+/* without limitation the rights to use, copy, modify, merge, publish,   */
+/* distribute, sublicense, and/or sell copies of the Software, and to    */
+/* permit persons to whom the Software is furnished to do so, subject to */
+/* the following conditions:                                             */
+/*                                                                       */
+/* The above copyright notice and this permission notice shall be        */
+/* included in all copies or substantial portions of the Software.       */
+/*                                                                       */
+/* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,       */
+/* EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF    */
+/* MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.*/
+/* IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY  */
+/* CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,  */
+/* TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE     */
+/* SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.                */
+/*************************************************************************/
+
+#include "gdscript_compiled_cache.h"
+
+#include "core/class_db.h"
+#include "core/hashfuncs.h"
+#include "core/io/marshalls.h"
+#include "core/io/resource_loader.h"
+#include "core/version.h"
+#include "core/version_hash.gen.h"
+#include "gdscript_compiler.h"
+#include "gdscript_functions.h"
+#include "gdscript_parser.h"
+
+static const uint8_t compiled_cache_magic[4] = { 'G', 'D', 'B', 'C' };
+
+struct GDScriptCompiledCache::Writer {
+
+	Vector<uint8_t> data;
+
+	void put_buffer(const uint8_t *p_data, int p_size) {
+		if (p_size == 0) {
+			return;
+		}
+		int ofs = data.size();
+		data.resize(ofs + p_size);
+		copymem(data.ptrw() + ofs, p_data, p_size);
+	}
+
+	void put_u8(uint8_t p_value) {
+		data.push_back(p_value);
+	}
+
+	void put_u32(uint32_t p_value) {
+		int ofs = data.size();
+		data.resize(ofs + 4);
+		encode_uint32(p_value, data.ptrw() + ofs);
+	}
+
+	void put_string(const String &p_string) {
+		CharString utf8 = p_string.utf8();
+		put_u32(utf8.length());
+		put_buffer((const uint8_t *)utf8.get_data(), utf8.length());
+	}
+
+	bool put_plain(const Variant &p_value) {
+		int len;
+		if (encode_variant(p_value, NULL, len) != OK) {
+			return false;
+		}
+		put_u32(len);
+		int ofs = data.size();
+		data.resize(ofs + len);
+		return encode_variant(p_value, data.ptrw() + ofs, len) == OK;
+	}
+};
+
+// Reads never go past the end of the buffer; a short or malformed buffer only sets the error flag.
+struct GDScriptCompiledCache::Reader {
+
+	const uint8_t *data;
+	int size;
+	int pos;
+	bool error;
+
+	bool _check(int p_bytes) {
+		if (error || p_bytes < 0 || p_bytes > size - pos) {
+			error = true;
+			return false;
+		}
+		return true;
+	}
+
+	void skip(int p_bytes) {
+		if (_check(p_bytes)) {
+			pos += p_bytes;
+		}
+	}
+
+	uint8_t get_u8() {
+		if (!_check(1)) {
+			return 0;
+		}
+		return data[pos++];
+	}
+
+	uint32_t get_u32() {
+		if (!_check(4)) {
+			return 0;
+		}
+		uint32_t value = decode_uint32(data + pos);
+		pos += 4;
+		return value;
+	}
+
+	// Size of a following table or blob. Bounded by the bytes left, so corrupt data can't cause huge allocations.
+	int get_count() {
+		uint32_t count = get_u32();
+		if (error || count > uint32_t(size - pos)) {
+			error = true;
+			return 0;
+		}
+		return count;
+	}
+
+	String get_string() {
+		int len = get_count();
+		String string;
+		if (len && !error) {
+			string.parse_utf8((const char *)(data + pos), len);
+			pos += len;
+		}
+		return string;
+	}
+
+	Variant get_plain() {
+		int len = get_count();
+		Variant value;
+		if (!error && decode_variant(value, data + pos, len) != OK) {
+			error = true;
+		}
+		skip(len);
+		return value;
+	}
+
+	Reader(const uint8_t *p_data, int p_size, int p_pos = 0) :
+			data(p_data),
+			size(p_size),
+			pos(p_pos),
+			error(false) {}
+};
+
+struct GDScriptCompiledCache::SaveContext {
+
+	String path;
+	GDScript *root;
+
+	Vector<Object *> reference_objects;
+	Writer reference_table;
+	Vector<StringName> global_index_names; // Editor global array index to name.
+	Vector<StringName> globals;
+	Vector<StringName> method_classes;
+	Vector<StringName> method_names;
+	Vector<GDScriptFunction::MethodBindInfo> method_infos;
+
+	int add_global(const StringName &p_name) {
+		int idx = globals.find(p_name);
+		if (idx == -1) {
+			idx = globals.size();
+			globals.push_back(p_name);
+		}
+		return idx;
+	}
+
+	int add_method(const StringName &p_class, const GDScriptFunction::MethodBindInfo &p_info) {
+		StringName method = p_info.method->get_name();
+		for (int i = 0; i < method_classes.size(); i++) {
+			if (method_classes[i] == p_class && method_names[i] == method) {
+				return i;
+			}
+		}
+		method_classes.push_back(p_class);
+		method_names.push_back(method);
+		method_infos.push_back(p_info);
+		return method_classes.size() - 1;
+	}
+};
+
+struct GDScriptCompiledCache::LoadContext {
+
+	Vector<uint8_t> buffer;
+	GDScript *root;
+	StringName source;
+
+	Vector<Variant> references;
+	Vector<int> globals;
+	Vector<GDScriptFunction::MethodBindInfo> methods;
+};
+
+uint32_t GDScriptCompiledCache::_get_fingerprint() {
+
+	// Anything that changes the meaning of the emitted code words. The commit hash covers opcode and
+	// MethodBind layout changes between builds of the same version.
+	uint32_t hash = hash_djb2_buffer((const uint8_t *)VERSION_FULL_CONFIG, strlen(VERSION_FULL_CONFIG));
+	hash = hash_djb2_buffer((const uint8_t *)VERSION_HASH, strlen(VERSION_HASH), hash);
+	hash = hash_djb2_one_32(GDScriptFunction::OPCODE_END, hash);
+	hash = hash_djb2_one_32(GDScriptFunctions::FUNC_MAX, hash);
+	hash = hash_djb2_one_32(Variant::VARIANT_MAX, hash);
+	hash = hash_djb2_one_32(Variant::OP_MAX, hash);
+	hash = hash_djb2_one_32(GDScriptFunction::ADDR_BITS, hash);
+	hash = hash_djb2_one_32(sizeof(real_t), hash);
+	return hash;
+}
+
+StringName GDScriptCompiledCache::_get_class_name(void *p_class_ptr) {
+
+	const StringName *K = NULL;
+	while ((K = ClassDB::classes.next(K))) {
+		if (ClassDB::classes[*K].class_ptr == p_class_ptr) {
+			return *K;
+		}
+	}
+	return StringName();
+}
+
+void GDScriptCompiledCache::_write_ptrcall_signature(Writer &w, const GDScriptFunction::MethodBindInfo &p_info) {
+
+	// Argument types can't be queried in release builds, so the signature is stored as well.
+	int argc = p_info.ptrcall_argc;
+	for (int i = -1; i < argc; i++) {
+		const GDScriptFunction::PtrcallArg &arg = i < 0 ? p_info.ptrcall_return : p_info.ptrcall_args[i];
+		if (arg.class_ptr && _get_class_name(arg.class_ptr) == StringName()) {
+			argc = -1;
+		}
+	}
+
+	w.put_u32((uint32_t)argc);
+	for (int i = -1; i < argc; i++) {
+		const GDScriptFunction::PtrcallArg &arg = i < 0 ? p_info.ptrcall_return : p_info.ptrcall_args[i];
+		w.put_u8(arg.kind);
+		w.put_u8(arg.type);
+		w.put_string(arg.class_ptr ? _get_class_name(arg.class_ptr) : StringName());
+	}
+}
+
+#if defined(PTRCALL_ENABLED) && defined(DEBUG_METHODS_ENABLED)
+static bool _ptrcall_args_equal(const GDScriptFunction::PtrcallArg &p_a, const GDScriptFunction::PtrcallArg &p_b) {
+
+	return p_a.kind == p_b.kind && p_a.type == p_b.type && p_a.class_ptr == p_b.class_ptr;
+}
+#endif
+
+// Returns false when a class the signature refers to doesn't exist anymore; a malformed
+// signature, or one that doesn't fit the method, only sets the error flag of the reader.
+bool GDScriptCompiledCache::_read_ptrcall_signature(Reader &r, GDScriptFunction::MethodBindInfo &r_info) {
+
+	typedef GDScriptFunction::PtrcallArg PtrcallArg;
+
+	r_info.ptrcall_argc = -1;
+
+	// ptrcall() reads every declared argument, so only the exact count the compiler emits is valid.
+	int argc = (int32_t)r.get_u32();
+	if (argc != -1 && (argc < 0 || argc > GDScriptFunction::MAX_PTRCALL_ARGS || argc != r_info.method->get_argument_count() || r_info.method->is_vararg())) {
+		r.error = true;
+		return true;
+	}
+
+	for (int i = -1; i < argc; i++) {
+		PtrcallArg &arg = i < 0 ? r_info.ptrcall_return : r_info.ptrcall_args[i];
+		uint8_t kind = r.get_u8();
+		uint8_t type = r.get_u8();
+		StringName class_name = r.get_string();
+		if (r.error || kind > PtrcallArg::KIND_REFERENCE || type >= Variant::VARIANT_MAX) {
+			r.error = true;
+			return true;
+		}
+		arg.kind = PtrcallArg::Kind(kind);
+		arg.type = Variant::Type(type);
+		arg.class_ptr = NULL;
+
+		// Same combinations as GDScriptCompiler::make_ptrcall_signature() produces. Only the
+		// return value can be missing, and only when the method doesn't return anything.
+		bool valid = false;
+		switch (arg.kind) {
+			case PtrcallArg::KIND_NONE: {
+				valid = i < 0 && arg.type == Variant::NIL && !r_info.method->has_return();
+			} break;
+			case PtrcallArg::KIND_VARIANT: {
+				valid = arg.type == Variant::NIL;
+			} break;
+			case PtrcallArg::KIND_BUILTIN: {
+				valid = arg.type != Variant::NIL && arg.type != Variant::OBJECT;
+			} break;
+			case PtrcallArg::KIND_ENUM: {
+				valid = arg.type == Variant::INT;
+			} break;
+			case PtrcallArg::KIND_OBJECT:
+			case PtrcallArg::KIND_REFERENCE: {
+				valid = arg.type == Variant::OBJECT;
+			} break;
+		}
+		if (!valid || (i < 0 && arg.kind != PtrcallArg::KIND_NONE && !r_info.method->has_return())) {
+			r.error = true;
+			return true;
+		}
+
+		if (arg.kind == PtrcallArg::KIND_OBJECT || arg.kind == PtrcallArg::KIND_REFERENCE) {
+			ClassDB::ClassInfo *ci = ClassDB::classes.getptr(class_name);
+			if (!ci || !ci->class_ptr) {
+				return false;
+			}
+			// A reference argument is passed as a Ref<T>, which only exists for Reference types.
+			if (arg.kind == PtrcallArg::KIND_REFERENCE && !ClassDB::is_parent_class(class_name, "Reference")) {
+				r.error = true;
+				return true;
+			}
+			arg.class_ptr = ci->class_ptr;
+		}
+	}
+
+#if defined(PTRCALL_ENABLED) && defined(DEBUG_METHODS_ENABLED)
+	// When this build knows the argument types, a stored signature has to match them exactly.
+	GDScriptFunction::MethodBindInfo actual = r_info;
+	GDScriptCompiler::make_ptrcall_signature(actual);
+	if (argc != -1 && actual.ptrcall_argc != argc) {
+		r.error = true;
+		return true;
+	}
+	for (int i = -1; i < argc; i++) {
+		if (!_ptrcall_args_equal(i < 0 ? actual.ptrcall_return : actual.ptrcall_args[i], i < 0 ? r_info.ptrcall_return : r_info.ptrcall_args[i])) {
+			r.error = true;
+			return true;
+		}
+	}
+#endif
+
+	// The fingerprint ties the signature to the build that wrote it. Builds made outside of git have
+	// no commit hash in it, so they keep using Variant calls.
+	r_info.ptrcall_argc = VERSION_HASH[0] != '\0' ? argc : -1;
+	return true;
+}
+
+String GDScriptCompiledCache::_get_subpath(const GDScript *p_script, const GDScript **r_root) {
+
+	String subpath;
+	const GDScript *script = p_script;
+	while (script->_owner) {
+		const GDScript *owner = script->_owner;
+		for (const Map<StringName, Ref<GDScript> >::Element *E = owner->subclasses.front(); E; E = E->next()) {
+			if (E->get().ptr() == script) {
+				subpath = subpath.empty() ? String(E->key()) : String(E->key()) + "/" + subpath;
+				break;
+			}
+		}
+		script = owner;
+	}
+
+	if (r_root) {
+		*r_root = script;
+	}
+	return subpath;
+}
+
+GDScript *GDScriptCompiledCache::_find_subclass(GDScript *p_root, const String &p_subpath) {
+
+	if (p_subpath.empty()) {
+		return p_root;
+	}
+
+	GDScript *script = p_root;
+	Vector<String> names = p_subpath.split("/");
+	for (int i = 0; i < names.size(); i++) {
+		Map<StringName, Ref<GDScript> >::Element *E = script->subclasses.find(names[i]);
+		if (!E) {
+			return NULL;
+		}
+		script = E->get().ptr();
+	}
+	return script;
+}
+
+void GDScriptCompiledCache::_add_class_ordered(GDScript *p_script, const GDScript *p_root, Vector<GDScript *> &r_order) {
+
+	if (r_order.find(p_script) != -1) {
+		return;
+	}
+
+	// Classes extending another class of the same file need its member layout when loading.
+	if (p_script->_base) {
+		const GDScript *base_root;
+		_get_subpath(p_script->_base, &base_root);
+		if (base_root == p_root) {
+			_add_class_ordered(p_script->_base, p_root, r_order);
+		}
+	}
+
+	r_order.push_back(p_script);
+
+	for (Map<StringName, Ref<GDScript> >::Element *E = p_script->subclasses.front(); E; E = E->next()) {
+		_add_class_ordered(E->get().ptr(), p_root, r_order);
+	}
+}
+
+void GDScriptCompiledCache::_add_operands(LocalVector<OperandKind> &r_operands, OperandKind p_kind, int p_count) {
+
+	for (int i = 0; i < p_count; i++) {
+		r_operands.push_back(p_kind);
+	}
+}
+
+// Lists the operands of the instruction at p_ip, in the order GDScriptFunction::call() reads them, and
+// returns its length. Returns 0 for an unknown opcode or an instruction that runs past the code.
+int GDScriptCompiledCache::_decode_instruction(const int *p_code, int p_code_size, int p_ip, LocalVector<OperandKind> &r_operands) {
+
+	r_operands.clear();
+
+	int available = p_code_size - p_ip - 1;
+	// Argument counts come before the operands they size; -1 when they are past the end.
+	int count_1 = available >= 1 ? p_code[p_ip + 1] : -1;
+	int count_2 = available >= 2 ? p_code[p_ip + 2] : -1;
+
+	switch (p_code[p_ip]) {
+		case GDScriptFunction::OPCODE_OPERATOR:
+		case GDScriptFunction::OPCODE_OPERATOR_INT:
+		case GDScriptFunction::OPCODE_OPERATOR_REAL: {
+			_add_operands(r_operands, OPERAND_OPERATOR);
+			_add_operands(r_operands, OPERAND_ADDRESS, 3);
+		} break;
+		case GDScriptFunction::OPCODE_EXTENDS_TEST:
+		case GDScriptFunction::OPCODE_SET:
+		case GDScriptFunction::OPCODE_GET:
+		case GDScriptFunction::OPCODE_ASSIGN_TYPED_NATIVE:
+		case GDScriptFunction::OPCODE_ASSIGN_TYPED_SCRIPT:
+		case GDScriptFunction::OPCODE_CAST_TO_NATIVE:
+		case GDScriptFunction::OPCODE_CAST_TO_SCRIPT: {
+			_add_operands(r_operands, OPERAND_ADDRESS, 3);
+		} break;
+		case GDScriptFunction::OPCODE_IS_BUILTIN: {
+			_add_operands(r_operands, OPERAND_ADDRESS);
+			_add_operands(r_operands, OPERAND_VARIANT_TYPE);
+			_add_operands(r_operands, OPERAND_ADDRESS);
+		} break;
+		case GDScriptFunction::OPCODE_SET_NAMED: {
+			_add_operands(r_operands, OPERAND_ADDRESS);
+			_add_operands(r_operands, OPERAND_GLOBAL_NAME);
+			_add_operands(r_operands, OPERAND_ADDRESS);
+			_add_operands(r_operands, OPERAND_INLINE_CACHE);
+		} break;
+		case GDScriptFunction::OPCODE_GET_NAMED: {
+			_add_operands(r_operands, OPERAND_ADDRESS);
+			_add_operands(r_operands, OPERAND_GLOBAL_NAME);
+			_add_operands(r_operands, OPERAND_INLINE_CACHE);
+			_add_operands(r_operands, OPERAND_ADDRESS);
+		} break;
+		case GDScriptFunction::OPCODE_SET_NAMED_VECTOR:
+		case GDScriptFunction::OPCODE_GET_NAMED_VECTOR: {
+			_add_operands(r_operands, OPERAND_ADDRESS);
+			_add_operands(r_operands, OPERAND_GLOBAL_NAME);
+			_add_operands(r_operands, OPERAND_AXIS);
+			_add_operands(r_operands, OPERAND_ADDRESS);
+		} break;
+		case GDScriptFunction::OPCODE_SET_MEMBER:
+		case GDScriptFunction::OPCODE_GET_MEMBER: {
+			_add_operands(r_operands, OPERAND_GLOBAL_NAME);
+			_add_operands(r_operands, OPERAND_ADDRESS);
+		} break;
+		case GDScriptFunction::OPCODE_ASSIGN:
+		case GDScriptFunction::OPCODE_YIELD_SIGNAL: {
+			_add_operands(r_operands, OPERAND_ADDRESS, 2);
+		} break;
+		case GDScriptFunction::OPCODE_ASSIGN_TRUE:
+		case GDScriptFunction::OPCODE_ASSIGN_FALSE:
+		case GDScriptFunction::OPCODE_AWAIT:
+		case GDScriptFunction::OPCODE_YIELD_RESUME:
+		case GDScriptFunction::OPCODE_RETURN: {
+			_add_operands(r_operands, OPERAND_ADDRESS);
+		} break;
+		case GDScriptFunction::OPCODE_ASSIGN_TYPED_BUILTIN:
+		case GDScriptFunction::OPCODE_CAST_TO_BUILTIN: {
+			_add_operands(r_operands, OPERAND_VARIANT_TYPE);
+			_add_operands(r_operands, OPERAND_ADDRESS, 2);
+		} break;
+		case GDScriptFunction::OPCODE_CONSTRUCT: {
+			if (count_2 < 0 || count_2 > available) {
+				return 0;
+			}
+			_add_operands(r_operands, OPERAND_VARIANT_TYPE);
+			_add_operands(r_operands, OPERAND_CALL_ARGUMENT_COUNT);
+			_add_operands(r_operands, OPERAND_ADDRESS, count_2 + 1);
+		} break;
+		case GDScriptFunction::OPCODE_CONSTRUCT_ARRAY: {
+			if (count_1 < 0 || count_1 > available) {
+				return 0;
+			}
+			_add_operands(r_operands, OPERAND_ELEMENT_COUNT);
+			_add_operands(r_operands, OPERAND_ADDRESS, count_1 + 1);
+		} break;
+		case GDScriptFunction::OPCODE_CONSTRUCT_DICTIONARY: {
+			if (count_1 < 0 || count_1 > available / 2) {
+				return 0;
+			}
+			_add_operands(r_operands, OPERAND_ELEMENT_COUNT);
+			_add_operands(r_operands, OPERAND_ADDRESS, count_1 * 2 + 1);
+		} break;
+		case GDScriptFunction::OPCODE_CALL:
+		case GDScriptFunction::OPCODE_CALL_RETURN: {
+			if (count_1 < 0 || count_1 > available) {
+				return 0;
+			}
+			_add_operands(r_operands, OPERAND_CALL_ARGUMENT_COUNT);
+			_add_operands(r_operands, OPERAND_ADDRESS);
+			_add_operands(r_operands, OPERAND_GLOBAL_NAME);
+			_add_operands(r_operands, OPERAND_INLINE_CACHE);
+			_add_operands(r_operands, OPERAND_ADDRESS, count_1 + 1);
+		} break;
+		case GDScriptFunction::OPCODE_CALL_METHOD_BIND:
+		case GDScriptFunction::OPCODE_CALL_METHOD_BIND_RETURN:
+		case GDScriptFunction::OPCODE_CALL_PTRCALL:
+		case GDScriptFunction::OPCODE_CALL_PTRCALL_RETURN: {
+			if (count_1 < 0 || count_1 > available) {
+				return 0;
+			}
+			_add_operands(r_operands, OPERAND_CALL_ARGUMENT_COUNT);
+			_add_operands(r_operands, OPERAND_ADDRESS);
+			_add_operands(r_operands, OPERAND_GLOBAL_NAME);
+			_add_operands(r_operands, OPERAND_METHOD_BIND);
+			_add_operands(r_operands, OPERAND_ADDRESS, count_1 + 1);
+		} break;
+		case GDScriptFunction::OPCODE_CALL_BUILT_IN: {
+			if (count_2 < 0 || count_2 > available) {
+				return 0;
+			}
+			_add_operands(r_operands, OPERAND_BUILTIN_FUNCTION);
+			_add_operands(r_operands, OPERAND_CALL_ARGUMENT_COUNT);
+			_add_operands(r_operands, OPERAND_ADDRESS, count_2 + 1);
+		} break;
+		case GDScriptFunction::OPCODE_CALL_SELF_BASE: {
+			if (count_2 < 0 || count_2 > available) {
+				return 0;
+			}
+			_add_operands(r_operands, OPERAND_GLOBAL_NAME);
+			_add_operands(r_operands, OPERAND_CALL_ARGUMENT_COUNT);
+			_add_operands(r_operands, OPERAND_ADDRESS, count_2 + 1);
+		} break;
+		case GDScriptFunction::OPCODE_JUMP: {
+			_add_operands(r_operands, OPERAND_JUMP);
+		} break;
+		case GDScriptFunction::OPCODE_JUMP_IF:
+		case GDScriptFunction::OPCODE_JUMP_IF_NOT: {
+			_add_operands(r_operands, OPERAND_ADDRESS);
+			_add_operands(r_operands, OPERAND_JUMP);
+		} break;
+		case GDScriptFunction::OPCODE_ITERATE_BEGIN:
+		case GDScriptFunction::OPCODE_ITERATE: {
+			_add_operands(r_operands, OPERAND_ADDRESS, 2);
+			_add_operands(r_operands, OPERAND_JUMP);
+			_add_operands(r_operands, OPERAND_ADDRESS);
+		} break;
+		case GDScriptFunction::OPCODE_ASSERT: {
+			_add_operands(r_operands, OPERAND_ADDRESS);
+			_add_operands(r_operands, OPERAND_OPTIONAL_ADDRESS);
+		} break;
+		case GDScriptFunction::OPCODE_LINE: {
+			_add_operands(r_operands, OPERAND_LINE);
+		} break;
+		case GDScriptFunction::OPCODE_YIELD:
+		case GDScriptFunction::OPCODE_JUMP_TO_DEF_ARGUMENT:
+		case GDScriptFunction::OPCODE_BREAKPOINT:
+		case GDScriptFunction::OPCODE_END: {
+		} break;
+		default: {
+			// Includes OPCODE_CALL_SELF, which the compiler never emits.
+			return 0;
+		}
+	}
+
+	if ((int)r_operands.size() > available) {
+		return 0;
+	}
+	return 1 + r_operands.size();
+}
+
+bool GDScriptCompiledCache::_write_object(Writer &w, Object *p_object, SaveContext &ctx) {
+
+	if (!p_object) {
+		w.put_u8(VALUE_NULL_OBJECT);
+		return true;
+	}
+
+	GDScript *script = Object::cast_to<GDScript>(p_object);
+	const GDScript *script_root = NULL;
+	String subpath;
+	if (script) {
+		subpath = _get_subpath(script, &script_root);
+		if (script_root == ctx.root || script_root->get_path() == ctx.path) {
+			w.put_u8(VALUE_OWN_SCRIPT);
+			w.put_string(subpath);
+			return true;
+		}
+	}
+
+	int idx = ctx.reference_objects.find(p_object);
+	if (idx == -1) {
+		Writer &t = ctx.reference_table;
+		GDScriptNativeClass *native = Object::cast_to<GDScriptNativeClass>(p_object);
+		Resource *resource = Object::cast_to<Resource>(p_object);
+
+		if (script) {
+			if (!script_root->get_path().is_resource_file()) {
+				return false;
+			}
+			t.put_u8(REFERENCE_SCRIPT);
+			t.put_string(script_root->get_path());
+			t.put_string(subpath);
+		} else if (native) {
+			t.put_u8(REFERENCE_NATIVE_CLASS);
+			t.put_string(native->get_name());
+		} else if (resource && resource->get_path().is_resource_file()) {
+			t.put_u8(REFERENCE_RESOURCE);
+			t.put_string(resource->get_path());
+			t.put_string(resource->get_class());
+		} else {
+			// Built-in resources and plain objects can't be restored from a path.
+			return false;
+		}
+
+		idx = ctx.reference_objects.size();
+		ctx.reference_objects.push_back(p_object);
+	}
+
+	w.put_u8(VALUE_REFERENCE);
+	w.put_u32(idx);
+	return true;
+}
+
+bool GDScriptCompiledCache::_write_value(Writer &w, const Variant &p_value, SaveContext &ctx) {
+
+	switch (p_value.get_type()) {
+		case Variant::OBJECT: {
+			return _write_object(w, p_value, ctx);
+		} break;
+		case Variant::ARRAY: {
+			Array array = p_value;
+			w.put_u8(VALUE_ARRAY);
+			w.put_u32(array.size());
+			for (int i = 0; i < array.size(); i++) {
+				if (!_write_value(w, array[i], ctx)) {
+					return false;
+				}
+			}
+		} break;
+		case Variant::DICTIONARY: {
+			Dictionary dict = p_value;
+			List<Variant> keys;
+			dict.get_key_list(&keys);
+			w.put_u8(VALUE_DICTIONARY);
+			w.put_u32(keys.size());
+			for (List<Variant>::Element *E = keys.front(); E; E = E->next()) {
+				if (!_write_value(w, E->get(), ctx) || !_write_value(w, dict[E->get()], ctx)) {
+					return false;
+				}
+			}
+		} break;
+		default: {
+			w.put_u8(VALUE_PLAIN);
+			return w.put_plain(p_value);
+		}
+	}
+	return true;
+}
+
+bool GDScriptCompiledCache::_write_type(Writer &w, const GDScriptDataType &p_type, SaveContext &ctx) {
+
+	w.put_u8(p_type.has_type);
+	if (!p_type.has_type) {
+		return true;
+	}
+
+	w.put_u8(p_type.kind);
+	w.put_u32(p_type.builtin_type);
+	w.put_string(p_type.native_type);
+	if (p_type.kind == GDScriptDataType::SCRIPT || p_type.kind == GDScriptDataType::GDSCRIPT) {
+		return _write_object(w, p_type.script_type, ctx);
+	}
+	return true;
+}
+
+bool GDScriptCompiledCache::_write_function(Writer &w, const GDScriptFunction *p_function, bool p_initializer, SaveContext &ctx) {
+
+	w.put_string(p_function->name);
+	w.put_u8(p_function->_static);
+	w.put_u32(p_function->rpc_mode);
+	w.put_u32(p_function->_argument_count);
+
+	w.put_u32(p_function->argument_types.size());
+	for (int i = 0; i < p_function->argument_types.size(); i++) {
+		if (!_write_type(w, p_function->argument_types[i], ctx)) {
+			return false;
+		}
+	}
+	if (!_write_type(w, p_function->return_type, ctx)) {
+		return false;
+	}
+
+#ifdef TOOLS_ENABLED
+	w.put_u32(p_function->arg_names.size());
+	for (int i = 0; i < p_function->arg_names.size(); i++) {
+		w.put_string(p_function->arg_names[i]);
+	}
+#else
+	w.put_u32(0);
+#endif
+
+	w.put_u32(p_function->default_arguments.size());
+	for (int i = 0; i < p_function->default_arguments.size(); i++) {
+		w.put_u32(p_function->default_arguments[i]);
+	}
+
+	w.put_u32(p_function->_stack_size);
+	w.put_u32(p_function->_call_size);
+	w.put_u32(p_function->_initial_line);
+	w.put_u32(p_function->inline_caches.size());
+	w.put_u32(p_function->code.size());
+	w.put_u8(p_initializer);
+
+	// Everything below is only decoded on the first call. The counts come first, so that the code can
+	// be checked on load without decoding the rest.
+	Writer b;
+	b.put_u32(p_function->constants.size());
+	b.put_u32(p_function->global_names.size());
+	b.put_u32(p_function->method_binds.size());
+
+	b.put_u32(p_function->code.size());
+	for (int i = 0; i < p_function->code.size(); i++) {
+		b.put_u32(p_function->code[i]);
+	}
+
+	// Global addresses index the language's global array, which differs between editor and game.
+	const int *code = p_function->code.ptr();
+	int code_size = p_function->code.size();
+	Vector<int> relocations;
+	LocalVector<OperandKind> operands;
+	for (int ip = 0; ip < code_size;) {
+		int length = _decode_instruction(code, code_size, ip, operands);
+		if (!length) {
+			return false;
+		}
+		for (uint32_t i = 0; i < operands.size(); i++) {
+			int word = code[ip + 1 + i];
+			if ((operands[i] != OPERAND_ADDRESS && operands[i] != OPERAND_OPTIONAL_ADDRESS) || word == 0) {
+				continue;
+			}
+			int type = (word & GDScriptFunction::ADDR_TYPE_MASK) >> GDScriptFunction::ADDR_BITS;
+			int index = word & GDScriptFunction::ADDR_MASK;
+			StringName global;
+			if (type == GDScriptFunction::ADDR_TYPE_GLOBAL) {
+				if (index >= ctx.global_index_names.size()) {
+					return false;
+				}
+				global = ctx.global_index_names[index];
+			} else if (type == GDScriptFunction::ADDR_TYPE_NAMED_GLOBAL) {
+#ifdef TOOLS_ENABLED
+				// Autoloads are named globals in the editor, but regular globals in the game.
+				if (index >= p_function->named_globals.size()) {
+					return false;
+				}
+				global = p_function->named_globals[index];
+#endif
+				if (global == StringName()) {
+					return false;
+				}
+			} else {
+				continue;
+			}
+			relocations.push_back(ip + 1 + i);
+			relocations.push_back(ctx.add_global(global));
+		}
+		ip += length;
+	}
+	b.put_u32(relocations.size() / 2);
+	for (int i = 0; i < relocations.size(); i++) {
+		b.put_u32(relocations[i]);
+	}
+
+	for (int i = 0; i < p_function->method_binds.size(); i++) {
+		const GDScriptFunction::MethodBindInfo &mbi = p_function->method_binds[i];
+		StringName class_name = _get_class_name(mbi.class_ptr);
+		if (class_name == StringName()) {
+			return false;
+		}
+		b.put_u32(ctx.add_method(class_name, mbi));
+	}
+
+	for (int i = 0; i < p_function->global_names.size(); i++) {
+		b.put_string(p_function->global_names[i]);
+	}
+
+	for (int i = 0; i < p_function->constants.size(); i++) {
+		if (!_write_value(b, p_function->constants[i], ctx)) {
+			return false;
+		}
+	}
+
+	b.put_u32(p_function->stack_debug.size());
+	for (const List<GDScriptFunction::StackDebug>::Element *E = p_function->stack_debug.front(); E; E = E->next()) {
+		b.put_u32(E->get().line);
+		b.put_u32(E->get().pos);
+		b.put_u8(E->get().added);
+		b.put_string(E->get().identifier);
+	}
+
+	w.put_u32(b.data.size());
+	w.put_buffer(b.data.ptr(), b.data.size());
+	return true;
+}
+
+bool GDScriptCompiledCache::_write_class(Writer &w, GDScript *p_script, SaveContext &ctx) {
+
+	w.put_string(_get_subpath(p_script));
+	w.put_string(p_script->name);
+	w.put_u8(p_script->tool);
+
+	if (p_script->_base) {
+		w.put_u8(1);
+		if (!_write_object(w, p_script->_base, ctx)) {
+			return false;
+		}
+	} else {
+		if (p_script->native.is_null()) {
+			return false;
+		}
+		w.put_u8(0);
+		w.put_string(p_script->native->get_name());
+	}
+
+	// Own members come after the inherited ones, in index order.
+	int base_count = p_script->member_indices.size() - p_script->members.size();
+	Vector<StringName> own_members;
+	own_members.resize(p_script->members.size());
+	for (Map<StringName, GDScript::MemberInfo>::Element *E = p_script->member_indices.front(); E; E = E->next()) {
+		if (!p_script->members.has(E->key())) {
+			continue;
+		}
+		int idx = E->get().index - base_count;
+		if (idx < 0 || idx >= own_members.size()) {
+			return false;
+		}
+		own_members.write[idx] = E->key();
+	}
+
+	w.put_u32(own_members.size());
+	for (int i = 0; i < own_members.size(); i++) {
+		const GDScript::MemberInfo &minfo = p_script->member_indices[own_members[i]];
+		const PropertyInfo &pinfo = p_script->member_info[own_members[i]];
+		w.put_string(own_members[i]);
+		w.put_string(minfo.setter);
+		w.put_string(minfo.getter);
+		w.put_u32(minfo.rpc_mode);
+		if (!_write_type(w, minfo.data_type, ctx)) {
+			return false;
+		}
+		w.put_u32(pinfo.type);
+		w.put_string(pinfo.class_name);
+		w.put_u32(pinfo.hint);
+		w.put_string(pinfo.hint_string);
+		w.put_u32(pinfo.usage);
+	}
+
+	// Inner classes are stored as constants too; they're recreated from the skeleton.
+	w.put_u32(p_script->constants.size() - p_script->subclasses.size());
+	for (Map<StringName, Variant>::Element *E = p_script->constants.front(); E; E = E->next()) {
+		if (p_script->subclasses.has(E->key())) {
+			continue;
+		}
+		w.put_string(E->key());
+		if (!_write_value(w, E->get(), ctx)) {
+			return false;
+		}
+	}
+
+	w.put_u32(p_script->_signals.size());
+	for (Map<StringName, Vector<StringName> >::Element *E = p_script->_signals.front(); E; E = E->next()) {
+		w.put_string(E->key());
+		w.put_u32(E->get().size());
+		for (int i = 0; i < E->get().size(); i++) {
+			w.put_string(E->get()[i]);
+		}
+	}
+
+	w.put_u32(p_script->member_functions.size());
+	for (Map<StringName, GDScriptFunction *>::Element *E = p_script->member_functions.front(); E; E = E->next()) {
+		if (!_write_function(w, E->get(), E->get() == p_script->initializer, ctx)) {
+			return false;
+		}
+	}
+
+	return true;
+}
+
+void GDScriptCompiledCache::_write_skeleton(Writer &w, const GDScript *p_script) {
+
+	w.put_u32(p_script->subclasses.size());
+	for (const Map<StringName, Ref<GDScript> >::Element *E = p_script->subclasses.front(); E; E = E->next()) {
+		w.put_string(E->key());
+		_write_skeleton(w, E->get().ptr());
+	}
+}
+
+bool GDScriptCompiledCache::is_cache(const Vector<uint8_t> &p_buffer) {
+
+	return p_buffer.size() >= 4 && memcmp(p_buffer.ptr(), compiled_cache_magic, 4) == 0;
+}
+
+Vector<uint8_t> GDScriptCompiledCache::get_tokens(const Vector<uint8_t> &p_buffer) {
+
+	ERR_FAIL_COND_V(!is_cache(p_buffer), Vector<uint8_t>());
+
+	Reader r(p_buffer.ptr(), p_buffer.size(), 8);
+	int token_size = r.get_count();
+	Vector<uint8_t> tokens;
+	if (!r.error && token_size) {
+		tokens.resize(token_size);
+		copymem(tokens.ptrw(), p_buffer.ptr() + r.pos, token_size);
+	}
+	return tokens;
+}
+
+Error GDScriptCompiledCache::save(const String &p_path, const String &p_source, const Vector<uint8_t> &p_tokens, bool p_debug, Vector<uint8_t> &r_buffer) {
+
+	GDScriptParser parser;
+	Error err = parser.parse(p_source, p_path.get_base_dir(), false, p_path);
+	if (err) {
+		return err;
+	}
+
+	Ref<GDScript> script;
+	script.instance();
+	script->set_script_path(p_path);
+
+	GDScriptCompiler compiler;
+	compiler.set_debug_info(p_debug);
+	err = compiler.compile(&parser, script.ptr());
+	if (err) {
+		return err;
+	}
+
+	SaveContext ctx;
+	ctx.path = p_path;
+	ctx.root = script.ptr();
+
+	const Map<StringName, int> &global_map = GDScriptLanguage::get_singleton()->get_global_map();
+	ctx.global_index_names.resize(GDScriptLanguage::get_singleton()->get_global_array_size());
+	for (const Map<StringName, int>::Element *E = global_map.front(); E; E = E->next()) {
+		ctx.global_index_names.write[E->get()] = E->key();
+	}
+
+	Vector<GDScript *> order;
+	_add_class_ordered(script.ptr(), script.ptr(), order);
+
+	Writer classes;
+	classes.put_u32(order.size());
+	for (int i = 0; i < order.size(); i++) {
+		if (!_write_class(classes, order[i], ctx)) {
+			return ERR_UNAVAILABLE;
+		}
+	}
+
+	Writer payload;
+	payload.put_u32(ctx.reference_objects.size());
+	payload.put_buffer(ctx.reference_table.data.ptr(), ctx.reference_table.data.size());
+	payload.put_u32(ctx.globals.size());
+	for (int i = 0; i < ctx.globals.size(); i++) {
+		payload.put_string(ctx.globals[i]);
+	}
+	payload.put_u32(ctx.method_classes.size());
+	for (int i = 0; i < ctx.method_classes.size(); i++) {
+		payload.put_string(ctx.method_classes[i]);
+		payload.put_string(ctx.method_names[i]);
+		_write_ptrcall_signature(payload, ctx.method_infos[i]);
+	}
+	_write_skeleton(payload, script.ptr());
+	payload.put_buffer(classes.data.ptr(), classes.data.size());
+
+	Writer w;
+	w.put_buffer(compiled_cache_magic, 4);
+	w.put_u32(FORMAT_VERSION);
+	w.put_u32(p_tokens.size());
+	w.put_buffer(p_tokens.ptr(), p_tokens.size());
+	w.put_u32(_get_fingerprint());
+	w.put_u32(p_debug ? FLAG_DEBUG : 0);
+	w.put_u32(payload.data.size());
+	w.put_u32(hash_djb2_buffer(payload.data.ptr(), payload.data.size()));
+	w.put_buffer(payload.data.ptr(), payload.data.size());
+
+	r_buffer = w.data;
+	return OK;
+}
+
+bool GDScriptCompiledCache::_read_value(Reader &r, const Vector<Variant> &p_references, GDScript *p_root, Variant &r_value) {
+
+	switch (r.get_u8()) {
+		case VALUE_PLAIN: {
+			r_value = r.get_plain();
+		} break;
+		case VALUE_NULL_OBJECT: {
+			r_value = Variant((Object *)NULL);
+		} break;
+		case VALUE_OWN_SCRIPT: {
+			GDScript *script = _find_subclass(p_root, r.get_string());
+			if (!script) {
+				return false;
+			}
+			r_value = Ref<GDScript>(script);
+		} break;
+		case VALUE_REFERENCE: {
+			uint32_t idx = r.get_u32();
+			if (idx >= (uint32_t)p_references.size()) {
+				return false;
+			}
+			r_value = p_references[idx];
+		} break;
+		case VALUE_ARRAY: {
+			int size = r.get_count();
+			Array array;
+			array.resize(size);
+			for (int i = 0; i < size; i++) {
+				if (!_read_value(r, p_references, p_root, array[i])) {
+					return false;
+				}
+			}
+			r_value = array;
+		} break;
+		case VALUE_DICTIONARY: {
+			int size = r.get_count();
+			Dictionary dict;
+			for (int i = 0; i < size; i++) {
+				Variant key;
+				Variant value;
+				if (!_read_value(r, p_references, p_root, key) || !_read_value(r, p_references, p_root, value)) {
+					return false;
+				}
+				dict[key] = value;
+			}
+			r_value = dict;
+		} break;
+		default: {
+			return false;
+		}
+	}
+
+	return !r.error;
+}
+
+bool GDScriptCompiledCache::_read_type(Reader &r, LoadContext &ctx, const GDScript *p_owner, GDScriptDataType &r_type) {
+
+	r_type = GDScriptDataType();
+	r_type.has_type = r.get_u8();
+	if (!r_type.has_type) {
+		return !r.error;
+	}
+
+	uint32_t kind = r.get_u8();
+	uint32_t builtin_type = r.get_u32();
+	if (kind > GDScriptDataType::GDSCRIPT || builtin_type >= Variant::VARIANT_MAX) {
+		return false;
+	}
+	r_type.kind = (decltype(r_type.kind))kind;
+	r_type.builtin_type = Variant::Type(builtin_type);
+	r_type.native_type = r.get_string();
+
+	if (r_type.kind == GDScriptDataType::SCRIPT || r_type.kind == GDScriptDataType::GDSCRIPT) {
+		Variant value;
+		if (!_read_value(r, ctx.references, ctx.root, value)) {
+			return false;
+		}
+		Ref<Script> script = value;
+		if (script.is_null()) {
+			return false;
+		}
+		r_type.script_type = script.ptr();
+		// Same as the compiler: no strong reference to the owner, to avoid cycles.
+		if (script.ptr() != p_owner) {
+			r_type.script_type_ref = script;
+		}
+	}
+
+	return !r.error;
+}
+
+bool GDScriptCompiledCache::_read_function(Reader &r, LoadContext &ctx, GDScript *p_script) {
+
+	StringName name = r.get_string();
+	if (r.error || p_script->member_functions.has(name)) {
+		return false;
+	}
+
+	GDScriptFunction *f = memnew(GDScriptFunction);
+	p_script->member_functions[name] = f; // Owned by the class from here on, also on failure.
+
+	f->name = name;
+	f->_script = p_script;
+	f->source = ctx.source;
+	f->_static = r.get_u8();
+	f->rpc_mode = MultiplayerAPI::RPCMode(r.get_u32());
+	f->_argument_count = r.get_u32();
+
+	int arg_type_count = r.get_count();
+	f->argument_types.resize(arg_type_count);
+	for (int i = 0; i < arg_type_count; i++) {
+		if (!_read_type(r, ctx, p_script, f->argument_types.write[i])) {
+			return false;
+		}
+	}
+	if (!_read_type(r, ctx, p_script, f->return_type)) {
+		return false;
+	}
+
+	int arg_name_count = r.get_count();
+	for (int i = 0; i < arg_name_count; i++) {
+		String arg_name = r.get_string();
+#ifdef TOOLS_ENABLED
+		f->arg_names.push_back(arg_name);
+#endif
+	}
+
+	int default_arg_count = r.get_count();
+	f->default_arguments.resize(default_arg_count);
+	for (int i = 0; i < default_arg_count; i++) {
+		f->default_arguments.write[i] = r.get_u32();
+	}
+	if (default_arg_count) {
+		f->_default_arg_count = default_arg_count - 1;
+		f->_default_arg_ptr = f->default_arguments.ptr();
+	} else {
+		f->_default_arg_count = 0;
+		f->_default_arg_ptr = NULL;
+	}
+
+	f->_stack_size = r.get_u32();
+	f->_call_size = r.get_u32();
+	f->_initial_line = r.get_u32();
+
+	int inline_cache_count = r.get_count();
+	if (inline_cache_count) {
+		f->inline_caches.resize(inline_cache_count);
+		f->_inline_caches_ptr = f->inline_caches.ptrw();
+		f->_inline_caches_count = inline_cache_count;
+	}
+
+	f->_code_size = r.get_u32();
+	if (r.get_u8()) {
+		p_script->initializer = f;
+	}
+
+	// Left empty until materialize_function().
+	f->_code_ptr = NULL;
+	f->_constants_ptr = NULL;
+	f->_constant_count = 0;
+	f->_global_names_ptr = NULL;
+	f->_global_names_count = 0;
+	f->_method_binds_ptr = NULL;
+	f->_method_binds_count = 0;
+#ifdef TOOLS_ENABLED
+	f->_named_globals_ptr = NULL;
+	f->_named_globals_count = 0;
+	p_script->member_lines[name] = f->_initial_line;
+#endif
+
+	int body_size = r.get_count();
+	if (r.error || !_validate_body(Reader(r.data, r.pos + body_size, r.pos), ctx, f, p_script)) {
+		return false;
+	}
+	f->lazy_body.offset = r.pos;
+	f->lazy_body.buffer = ctx.buffer;
+	f->lazy_body.references = ctx.references;
+	f->lazy_body.globals = ctx.globals;
+	f->lazy_body.methods = ctx.methods;
+	f->lazy_pending.set();
+	r.skip(body_size);
+
+#ifdef DEBUG_ENABLED
+	if (ScriptDebugger::get_singleton()) {
+		String signature = String(ctx.source) + "::" + itos(f->_initial_line);
+		if (p_script->name != String()) {
+			signature += "::" + p_script->name + "." + String(name);
+		} else {
+			signature += "::" + String(name);
+		}
+		f->profile.signature = signature;
+	}
+
+	f->func_cname = (String(ctx.source) + " - " + String(name)).utf8();
+	f->_func_cname = f->func_cname.get_data();
+#endif
+
+	return !r.error;
+}
+
+static bool _is_jump_target(const LocalVector<uint8_t> &p_starts, int p_target) {
+
+	return p_target >= 0 && p_target < (int)p_starts.size() && p_starts[p_target];
+}
+
+// The VM trusts the compiler and checks little in release builds, so everything it would index with
+// an operand is checked against the function's tables here, before the function can run.
+bool GDScriptCompiledCache::_validate_body(Reader r, const LoadContext &ctx, const GDScriptFunction *p_function, const GDScript *p_script) {
+
+	const GDScriptFunction *f = p_function;
+	if (f->_argument_count < 0 || f->_stack_size < f->_argument_count || f->_call_size < 0 || f->argument_types.size() != f->_argument_count || f->_default_arg_count > f->_argument_count) {
+		return false;
+	}
+
+	int constant_count = r.get_count();
+	int global_name_count = r.get_count();
+	int method_bind_count = r.get_count();
+	int code_size = r.get_count();
+	if (r.error || code_size != f->_code_size || code_size > (r.size - r.pos) / 4) {
+		return false;
+	}
+
+	LocalVector<int> code;
+	code.resize(code_size);
+	for (int i = 0; i < code_size; i++) {
+		code[i] = r.get_u32();
+	}
+
+	LocalVector<uint8_t> relocated;
+	relocated.resize(code_size);
+	for (int i = 0; i < code_size; i++) {
+		relocated[i] = 0;
+	}
+	int relocation_count = r.get_count();
+	for (int i = 0; i < relocation_count; i++) {
+		uint32_t pos = r.get_u32();
+		uint32_t idx = r.get_u32();
+		if (r.error || pos >= (uint32_t)code_size || idx >= (uint32_t)ctx.globals.size()) {
+			return false;
+		}
+		relocated[pos] = 1;
+	}
+
+	for (int i = 0; i < method_bind_count; i++) {
+		if (r.get_u32() >= (uint32_t)ctx.methods.size()) {
+			return false;
+		}
+	}
+	if (r.error) {
+		return false;
+	}
+
+	LocalVector<uint8_t> starts;
+	starts.resize(code_size);
+	for (int i = 0; i < code_size; i++) {
+		starts[i] = 0;
+	}
+	LocalVector<int> jumps;
+	LocalVector<OperandKind> operands;
+	int opcode = -1;
+
+	for (int ip = 0; ip < code_size;) {
+		int length = _decode_instruction(code.ptr(), code_size, ip, operands);
+		if (!length) {
+			return false;
+		}
+
+		// Yields resume on the next instruction, which has to store the result.
+		bool resumes = opcode == GDScriptFunction::OPCODE_YIELD || opcode == GDScriptFunction::OPCODE_YIELD_SIGNAL || opcode == GDScriptFunction::OPCODE_AWAIT;
+		opcode = code[ip];
+		if (resumes != (opcode == GDScriptFunction::OPCODE_YIELD_RESUME)) {
+			return false;
+		}
+		// Members are read through the instance, which static functions don't have.
+		if (f->_static && (opcode == GDScriptFunction::OPCODE_SET_MEMBER || opcode == GDScriptFunction::OPCODE_GET_MEMBER)) {
+			return false;
+		}
+		starts[ip] = 1;
+
+		for (uint32_t i = 0; i < operands.size(); i++) {
+			int pos = ip + 1 + i;
+			int word = code[pos];
+			bool valid = false;
+
+			switch (operands[i]) {
+				case OPERAND_OPTIONAL_ADDRESS: {
+					if (word == 0) {
+						valid = !relocated[pos];
+						break;
+					}
+					FALLTHROUGH;
+				}
+				case OPERAND_ADDRESS: {
+					uint32_t type = uint32_t(word & GDScriptFunction::ADDR_TYPE_MASK) >> GDScriptFunction::ADDR_BITS;
+					int index = word & GDScriptFunction::ADDR_MASK;
+					switch (type) {
+						case GDScriptFunction::ADDR_TYPE_SELF:
+						case GDScriptFunction::ADDR_TYPE_CLASS:
+						case GDScriptFunction::ADDR_TYPE_NIL: {
+							valid = true;
+						} break;
+						case GDScriptFunction::ADDR_TYPE_MEMBER: {
+							valid = !f->_static && index < p_script->member_indices.size();
+						} break;
+						case GDScriptFunction::ADDR_TYPE_CLASS_CONSTANT: {
+							valid = index < global_name_count;
+						} break;
+						case GDScriptFunction::ADDR_TYPE_LOCAL_CONSTANT: {
+							valid = index < constant_count;
+						} break;
+						case GDScriptFunction::ADDR_TYPE_STACK:
+						case GDScriptFunction::ADDR_TYPE_STACK_VARIABLE: {
+							valid = index < f->_stack_size;
+						} break;
+						case GDScriptFunction::ADDR_TYPE_GLOBAL:
+						case GDScriptFunction::ADDR_TYPE_NAMED_GLOBAL: {
+							// Only valid as the editor's address of a global the file resolves by name.
+							valid = relocated[pos];
+						} break;
+					}
+					if (relocated[pos] && type != GDScriptFunction::ADDR_TYPE_GLOBAL && type != GDScriptFunction::ADDR_TYPE_NAMED_GLOBAL) {
+						valid = false;
+					}
+				} break;
+				case OPERAND_JUMP: {
+					jumps.push_back(word);
+					valid = true;
+				} break;
+				case OPERAND_GLOBAL_NAME: {
+					valid = word >= 0 && word < global_name_count;
+				} break;
+				case OPERAND_INLINE_CACHE: {
+					valid = word >= 0 && word < f->_inline_caches_count;
+				} break;
+				case OPERAND_METHOD_BIND: {
+					valid = word >= 0 && word < method_bind_count;
+				} break;
+				case OPERAND_OPERATOR: {
+					valid = word >= 0 && word < Variant::OP_MAX;
+				} break;
+				case OPERAND_VARIANT_TYPE: {
+					valid = word >= 0 && word < Variant::VARIANT_MAX;
+				} break;
+				case OPERAND_BUILTIN_FUNCTION: {
+					valid = word >= 0 && word < GDScriptFunctions::FUNC_MAX;
+				} break;
+				case OPERAND_CALL_ARGUMENT_COUNT: {
+					valid = word <= f->_call_size;
+				} break;
+				case OPERAND_AXIS: {
+					valid = word >= 0 && word < 3;
+				} break;
+				case OPERAND_ELEMENT_COUNT:
+				case OPERAND_LINE: {
+					valid = true;
+				} break;
+			}
+
+			if (!valid || (relocated[pos] && operands[i] != OPERAND_ADDRESS && operands[i] != OPERAND_OPTIONAL_ADDRESS)) {
+				return false;
+			}
+		}
+
+		ip += length;
+	}
+
+	// The code has to end in OPCODE_END, so execution can't run past it.
+	if (opcode != GDScriptFunction::OPCODE_END) {
+		return false;
+	}
+	for (uint32_t i = 0; i < jumps.size(); i++) {
+		if (!_is_jump_target(starts, jumps[i])) {
+			return false;
+		}
+	}
+	for (int i = 0; i < f->default_arguments.size(); i++) {
+		if (!_is_jump_target(starts, f->default_arguments[i])) {
+			return false;
+		}
+	}
+
+	return true;
+}
+
+bool GDScriptCompiledCache::_read_class(Reader &r, LoadContext &ctx) {
+
+	GDScript *script = _find_subclass(ctx.root, r.get_string());
+	if (!script) {
+		return false;
+	}
+
+	// Same reset as GDScriptCompiler::_parse_class_level().
+	script->native = Ref<GDScriptNativeClass>();
+	script->base = Ref<GDScript>();
+	script->_base = NULL;
+	script->members.clear();
+	script->constants.clear();
+	for (Map<StringName, GDScriptFunction *>::Element *E = script->member_functions.front(); E; E = E->next()) {
+		memdelete(E->get());
+	}
+	script->member_functions.clear();
+	script->member_indices.clear();
+	script->member_info.clear();
+	script->_signals.clear();
+	script->initializer = NULL;
+
+	script->name = r.get_string();
+	script->tool = r.get_u8();
+
+	if (r.get_u8()) {
+		Variant value;
+		if (!_read_value(r, ctx.references, ctx.root, value)) {
+			return false;
+		}
+		Ref<GDScript> base = value;
+		if (base.is_null() || !base->valid) {
+			return false;
+		}
+		script->base = base;
+		script->_base = base.ptr();
+		script->member_indices = base->member_indices;
+	} else {
+		const Map<StringName, int>::Element *E = GDScriptLanguage::get_singleton()->get_global_map().find(r.get_string());
+		if (!E) {
+			return false;
+		}
+		Ref<GDScriptNativeClass> native = GDScriptLanguage::get_singleton()->get_global_array()[E->get()];
+		if (native.is_null()) {
+			return false;
+		}
+		script->native = native;
+	}
+
+	int member_count = r.get_count();
+	for (int i = 0; i < member_count; i++) {
+		StringName name = r.get_string();
+
+		GDScript::MemberInfo minfo;
+		minfo.index = script->member_indices.size();
+		minfo.setter = r.get_string();
+		minfo.getter = r.get_string();
+		minfo.rpc_mode = MultiplayerAPI::RPCMode(r.get_u32());
+		if (!_read_type(r, ctx, script, minfo.data_type)) {
+			return false;
+		}
+
+		PropertyInfo pinfo;
+		pinfo.name = name;
+		pinfo.type = Variant::Type(r.get_u32());
+		pinfo.class_name = r.get_string();
+		pinfo.hint = PropertyHint(r.get_u32());
+		pinfo.hint_string = r.get_string();
+		pinfo.usage = r.get_u32();
+		if (pinfo.type >= Variant::VARIANT_MAX) {
+			return false;
+		}
+
+		script->member_info[name] = pinfo;
+		script->member_indices[name] = minfo;
+		script->members.insert(name);
+	}
+
+	int constant_count = r.get_count();
+	for (int i = 0; i < constant_count; i++) {
+		StringName name = r.get_string();
+		Variant value;
+		if (!_read_value(r, ctx.references, ctx.root, value)) {
+			return false;
+		}
+		script->constants.insert(name, value);
+	}
+	for (Map<StringName, Ref<GDScript> >::Element *E = script->subclasses.front(); E; E = E->next()) {
+		script->constants.insert(E->key(), E->get());
+	}
+
+	int signal_count = r.get_count();
+	for (int i = 0; i < signal_count; i++) {
+		StringName name = r.get_string();
+		int arg_count = r.get_count();
+		Vector<StringName> args;
+		for (int j = 0; j < arg_count; j++) {
+			args.push_back(r.get_string());
+		}
+		script->_signals[name] = args;
+	}
+
+	int function_count = r.get_count();
+	for (int i = 0; i < function_count; i++) {
+		if (!_read_function(r, ctx, script)) {
+			return false;
+		}
+	}
+
+	if (r.error || !script->initializer) {
+		return false;
+	}
+
+	script->valid = true;
+	return true;
+}
+
+bool GDScriptCompiledCache::_read_skeleton(Reader &r, GDScript *p_script) {
+
+	p_script->subclasses.clear();
+
+	int count = r.get_count();
+	for (int i = 0; i < count; i++) {
+		StringName name = r.get_string();
+		if (r.error) {
+			return false;
+		}
+
+		Ref<GDScript> subclass;
+		String fully_qualified_name = p_script->fully_qualified_name + "::" + name;
+		Ref<GDScript> orphan_subclass = GDScriptLanguage::get_singleton()->get_orphan_subclass(fully_qualified_name);
+		if (orphan_subclass.is_valid()) {
+			subclass = orphan_subclass;
+		} else {
+			subclass.instance();
+		}
+
+		subclass->_owner = p_script;
+		subclass->fully_qualified_name = fully_qualified_name;
+		p_script->subclasses.insert(name, subclass);
+
+		if (!_read_skeleton(r, subclass.ptr())) {
+			return false;
+		}
+	}
+
+	return true;
+}
+
+Error GDScriptCompiledCache::load(GDScript *p_script, const Vector<uint8_t> &p_buffer, Vector<uint8_t> &r_tokens) {
+
+	ERR_FAIL_COND_V(!is_cache(p_buffer), ERR_FILE_UNRECOGNIZED);
+
+	Reader r(p_buffer.ptr(), p_buffer.size(), 4);
+
+	// This prefix is the same in every format version, so the tokens are always usable.
+	uint32_t version = r.get_u32();
+	int token_size = r.get_count();
+	if (r.error) {
+		return ERR_FILE_CORRUPT;
+	}
+	r_tokens.resize(token_size);
+	if (token_size) {
+		copymem(r_tokens.ptrw(), p_buffer.ptr() + r.pos, token_size);
+	}
+	r.skip(token_size);
+
+	if (version != FORMAT_VERSION) {
+		return ERR_FILE_UNRECOGNIZED;
+	}
+
+	uint32_t fingerprint = r.get_u32();
+	uint32_t flags = r.get_u32();
+	int payload_size = r.get_count();
+	uint32_t payload_hash = r.get_u32();
+	if (r.error || payload_size != r.size - r.pos) {
+		return ERR_FILE_CORRUPT;
+	}
+
+#ifdef DEBUG_ENABLED
+	const uint32_t build_flags = FLAG_DEBUG;
+#else
+	const uint32_t build_flags = 0;
+#endif
+	if (fingerprint != _get_fingerprint() || flags != build_flags) {
+		return ERR_FILE_UNRECOGNIZED;
+	}
+	if (hash_djb2_buffer(p_buffer.ptr() + r.pos, payload_size) != payload_hash) {
+		return ERR_FILE_CORRUPT;
+	}
+
+	LoadContext ctx;
+	ctx.buffer = p_buffer;
+	ctx.root = p_script;
+	ctx.source = p_script->get_path();
+
+	// Resolve everything the code depends on before touching the script.
+	GDScriptLanguage *language = GDScriptLanguage::get_singleton();
+
+	int reference_count = r.get_count();
+	for (int i = 0; i < reference_count; i++) {
+		uint8_t kind = r.get_u8();
+		String name = r.get_string();
+		if (r.error) {
+			return ERR_FILE_CORRUPT;
+		}
+
+		switch (kind) {
+			case REFERENCE_RESOURCE: {
+				RES resource = ResourceLoader::load(name, r.get_string());
+				if (resource.is_null()) {
+					return ERR_FILE_MISSING_DEPENDENCIES;
+				}
+				ctx.references.push_back(resource);
+			} break;
+			case REFERENCE_SCRIPT: {
+				Ref<GDScript> script = ResourceLoader::load(name);
+				GDScript *subclass = script.is_valid() ? _find_subclass(script.ptr(), r.get_string()) : NULL;
+				if (!subclass) {
+					return ERR_FILE_MISSING_DEPENDENCIES;
+				}
+				ctx.references.push_back(Ref<GDScript>(subclass));
+			} break;
+			case REFERENCE_NATIVE_CLASS: {
+				const Map<StringName, int>::Element *E = language->get_global_map().find(name);
+				Ref<GDScriptNativeClass> native = E ? Ref<GDScriptNativeClass>(language->get_global_array()[E->get()]) : Ref<GDScriptNativeClass>();
+				if (native.is_null()) {
+					return ERR_FILE_MISSING_DEPENDENCIES;
+				}
+				ctx.references.push_back(native);
+			} break;
+			default: {
+				return ERR_FILE_CORRUPT;
+			}
+		}
+	}
+
+	int global_count = r.get_count();
+	for (int i = 0; i < global_count; i++) {
+		const Map<StringName, int>::Element *E = language->get_global_map().find(r.get_string());
+		if (!E) {
+			return ERR_FILE_MISSING_DEPENDENCIES;
+		}
+		ctx.globals.push_back(E->get());
+	}
+
+	int method_count = r.get_count();
+	for (int i = 0; i < method_count; i++) {
+		StringName class_name = r.get_string();
+		StringName method_name = r.get_string();
+		ClassDB::ClassInfo *ci = ClassDB::classes.getptr(class_name);
+		MethodBind *method = ClassDB::get_method(class_name, method_name);
+		if (!ci || !ci->class_ptr || !method) {
+			return ERR_FILE_MISSING_DEPENDENCIES;
+		}
+		GDScriptFunction::MethodBindInfo mbi;
+		mbi.method = method;
+		mbi.class_name = class_name;
+		mbi.class_ptr = ci->class_ptr;
+		if (!_read_ptrcall_signature(r, mbi)) {
+			return ERR_FILE_MISSING_DEPENDENCIES;
+		}
+		ctx.methods.push_back(mbi);
+	}
+
+	if (r.error) {
+		return ERR_FILE_CORRUPT;
+	}
+
+	// From here on the script is rebuilt, like GDScriptCompiler::compile() does.
+	language->invalidate_inline_caches();
+
+	p_script->valid = false;
+	p_script->fully_qualified_name = p_script->path;
+	p_script->_owner = NULL;
+	if (!_read_skeleton(r, p_script)) {
+		return ERR_FILE_CORRUPT;
+	}
+
+	int class_count = r.get_count();
+	for (int i = 0; i < class_count; i++) {
+		if (!_read_class(r, ctx)) {
+			p_script->valid = false;
+			return ERR_FILE_CORRUPT;
+		}
+	}
+
+	return r.error ? ERR_FILE_CORRUPT : OK;
+}
+
+void GDScriptCompiledCache::materialize_function(GDScriptFunction *p_function) {
+
+	GDScriptFunction *f = p_function;
+	GDScriptFunction::LazyBody &lazy = f->lazy_body;
+	Reader r(lazy.buffer.ptr(), lazy.buffer.size(), lazy.offset);
+
+	GDScript *root = f->_script;
+	while (root->_owner) {
+		root = root->_owner;
+	}
+
+	// Checked by _validate_body() on load.
+	int constant_count = r.get_count();
+	int global_name_count = r.get_count();
+	int method_count = r.get_count();
+
+	int code_size = r.get_count();
+	f->code.resize(code_size);
+	for (int i = 0; i < code_size; i++) {
+		f->code.write[i] = r.get_u32();
+	}
+
+	int relocation_count = r.get_count();
+	for (int i = 0; i < relocation_count; i++) {
+		uint32_t pos = r.get_u32();
+		uint32_t idx = r.get_u32();
+		if (pos >= (uint32_t)code_size || idx >= (uint32_t)lazy.globals.size()) {
+			r.error = true;
+			break;
+		}
+		f->code.write[pos] = lazy.globals[idx] | (GDScriptFunction::ADDR_TYPE_GLOBAL << GDScriptFunction::ADDR_BITS);
+	}
+
+	f->method_binds.resize(method_count);
+	for (int i = 0; i < method_count && !r.error; i++) {
+		uint32_t idx = r.get_u32();
+		if (idx >= (uint32_t)lazy.methods.size()) {
+			r.error = true;
+			break;
+		}
+		f->method_binds.write[i] = lazy.methods[idx];
+	}
+
+	f->global_names.resize(global_name_count);
+	for (int i = 0; i < global_name_count; i++) {
+		f->global_names.write[i] = r.get_string();
+	}
+
+	f->constants.resize(constant_count);
+	for (int i = 0; i < constant_count && !r.error; i++) {
+		if (!_read_value(r, lazy.references, root, f->constants.write[i])) {
+			r.error = true;
+		}
+	}
+
+	int stack_debug_count = r.get_count();
+	for (int i = 0; i < stack_debug_count; i++) {
+		GDScriptFunction::StackDebug sd;
+		sd.line = r.get_u32();
+		sd.pos = r.get_u32();
+		sd.added = r.get_u8();
+		sd.identifier = r.get_string();
+		f->stack_debug.push_back(sd);
+	}
+
+	if (r.error || code_size != f->_code_size) {
+		// The payload hash was checked on load, so this is a bug. Leave the function empty.
+		ERR_PRINT("Invalid compiled body for GDScript function '" + String(f->name) + "' in '" + String(f->source) + "'.");
+		f->code.clear();
+		f->constants.clear();
+		f->global_names.clear();
+		f->method_binds.clear();
+		f->stack_debug.clear();
+	}
+
+	f->_code_size = f->code.size();
+	f->_code_ptr = f->code.size() ? f->code.ptr() : NULL;
+	f->_constant_count = f->constants.size();
+	f->_constants_ptr = f->constants.size() ? f->constants.ptrw() : NULL;
+	f->_global_names_count = f->global_names.size();
+	f->_global_names_ptr = f->global_names.size() ? f->global_names.ptr() : NULL;
+	f->_method_binds_count = f->method_binds.size();
+	f->_method_binds_ptr = f->method_binds.size() ? f->method_binds.ptr() : NULL;
+
+	// Drops this function's share of the file buffer and tables.
+	lazy = GDScriptFunction::LazyBody();
+}
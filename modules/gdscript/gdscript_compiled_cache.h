@@ -0,0 +1,135 @@
+/*************************************************************************/
+/*  gdscript_compiled_cache.h                                            */
+/*************************************************************************/
+/*                       This file is part of:                           */
+/*                           GODOT ENGINE                                */
+/*                      https://godotengine.org                          */
+/*************************************************************************/
+/* Copyright (c) 2007-2021 Juan Linietsky, Ariel Manzur.                 */
+/* Copyright (c) 2014-2021 Godot Engine contributors (cf. AUTHORS.md).   */
+/*                                                                       */
+/* Permission is hereby granted, free of charge, to any person obtaining */
+/* a copy of this software and associated documentation files (the       */
+/* "Software"), to deal in the Software without restriction, including   */
+/* without limitation the rights to use, copy, modify, merge, publish,   */
+/* distribute, sublicense, and/or sell copies of the Software, and to    */
+/* permit persons to whom the Software is furnished to do so, subject to */
+/* the following conditions:                                             */
+/*                                                                       */
+/* The above copyright notice and this permission notice shall be        */
+/* included in all copies or substantial portions of the Software.       */
+/*                                                                       */
+/* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,       */
+/* EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF    */
+/* MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.*/
+/* IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY  */
+/* CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,  */
+/* TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE     */
+/* SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.                */
+/*************************************************************************/
+
+#ifndef GDSCRIPT_COMPILED_CACHE_H
+#define GDSCRIPT_COMPILED_CACHE_H
+
+#include "core/local_vector.h"
+#include "gdscript.h"
+
+// Ahead-of-time compiled GDScript, written at export in place of the plain token
+// stream. The cache stores the class layout and the bytecode produced by
+// GDScriptCompiler, so loading a script skips parsing and compiling entirely.
+// Function bodies stay encoded in the loaded buffer until they are first called,
+// but their bytecode is checked operand by operand when the file is loaded.
+//
+// Layout: magic "GDBC", format version, token stream (size + data), then a
+// payload guarded by a build fingerprint and a hash. Anything the running build
+// can't use (other engine version, debug/release mismatch, missing globals or
+// methods) makes load() return an error and hand back the token stream, which
+// is then compiled the usual way.
+class GDScriptCompiledCache {
+
+public:
+	enum {
+		FORMAT_VERSION = 3,
+	};
+
+	static bool is_cache(const Vector<uint8_t> &p_buffer);
+
+	// Compiles p_source (with debug opcodes if p_debug) and wraps the result together with p_tokens.
+	static Error save(const String &p_path, const String &p_source, const Vector<uint8_t> &p_tokens, bool p_debug, Vector<uint8_t> &r_buffer);
+
+	// The embedded token stream, for tools that only need to scan the source.
+	static Vector<uint8_t> get_tokens(const Vector<uint8_t> &p_buffer);
+
+	// Fills p_script from the cache. On failure r_tokens holds the embedded token stream, if any.
+	static Error load(GDScript *p_script, const Vector<uint8_t> &p_buffer, Vector<uint8_t> &r_tokens);
+
+	static void materialize_function(GDScriptFunction *p_function);
+
+private:
+	struct Writer;
+	struct Reader;
+	struct SaveContext;
+	struct LoadContext;
+
+	enum ValueTag {
+		VALUE_PLAIN,
+		VALUE_NULL_OBJECT,
+		VALUE_OWN_SCRIPT, // Class defined in the cached file itself, by inner class path.
+		VALUE_REFERENCE, // Index in the reference table.
+		VALUE_ARRAY,
+		VALUE_DICTIONARY,
+	};
+
+	enum ReferenceKind {
+		REFERENCE_RESOURCE,
+		REFERENCE_SCRIPT,
+		REFERENCE_NATIVE_CLASS,
+	};
+
+	enum {
+		FLAG_DEBUG = 1,
+	};
+
+	// What an operand word of an instruction holds.
+	enum OperandKind {
+		OPERAND_ADDRESS,
+		OPERAND_OPTIONAL_ADDRESS, // Address, or 0 for none.
+		OPERAND_JUMP,
+		OPERAND_GLOBAL_NAME,
+		OPERAND_INLINE_CACHE,
+		OPERAND_METHOD_BIND,
+		OPERAND_OPERATOR,
+		OPERAND_VARIANT_TYPE,
+		OPERAND_BUILTIN_FUNCTION,
+		OPERAND_CALL_ARGUMENT_COUNT,
+		OPERAND_ELEMENT_COUNT,
+		OPERAND_AXIS,
+		OPERAND_LINE,
+	};
+
+	static uint32_t _get_fingerprint();
+	static StringName _get_class_name(void *p_class_ptr);
+	static String _get_subpath(const GDScript *p_script, const GDScript **r_root = NULL);
+	static GDScript *_find_subclass(GDScript *p_root, const String &p_subpath);
+	static void _add_class_ordered(GDScript *p_script, const GDScript *p_root, Vector<GDScript *> &r_order);
+	static void _add_operands(LocalVector<OperandKind> &r_operands, OperandKind p_kind, int p_count = 1);
+	static int _decode_instruction(const int *p_code, int p_code_size, int p_ip, LocalVector<OperandKind> &r_operands);
+
+	static bool _write_object(Writer &w, Object *p_object, SaveContext &ctx);
+	static bool _write_value(Writer &w, const Variant &p_value, SaveContext &ctx);
+	static bool _write_type(Writer &w, const GDScriptDataType &p_type, SaveContext &ctx);
+	static bool _write_function(Writer &w, const GDScriptFunction *p_function, bool p_initializer, SaveContext &ctx);
+	static bool _write_class(Writer &w, GDScript *p_script, SaveContext &ctx);
+	static void _write_skeleton(Writer &w, const GDScript *p_script);
+	static void _write_ptrcall_signature(Writer &w, const GDScriptFunction::MethodBindInfo &p_info);
+
+	static bool _read_value(Reader &r, const Vector<Variant> &p_references, GDScript *p_root, Variant &r_value);
+	static bool _read_type(Reader &r, LoadContext &ctx, const GDScript *p_owner, GDScriptDataType &r_type);
+	static bool _read_function(Reader &r, LoadContext &ctx, GDScript *p_script);
+	static bool _validate_body(Reader r, const LoadContext &ctx, const GDScriptFunction *p_function, const GDScript *p_script);
+	static bool _read_class(Reader &r, LoadContext &ctx);
+	static bool _read_skeleton(Reader &r, GDScript *p_script);
+	static bool _read_ptrcall_signature(Reader &r, GDScriptFunction::MethodBindInfo &r_info);
+};
+
+#endif // GDSCRIPT_COMPILED_CACHE_H
@@ -104,13 +104,199 @@ bool GDScriptCompiler::_create_binary_operator(CodeGen &codegen, const GDScriptP
 	if (src_address_b < 0)
 		return false;
 
-	codegen.opcodes.push_back(GDScriptFunction::OPCODE_OPERATOR); // perform operator
+	codegen.opcodes.push_back(_get_operator_opcode(on, op)); // perform operator
 	codegen.opcodes.push_back(op); //which operator
 	codegen.opcodes.push_back(src_address_a); // argument 1
 	codegen.opcodes.push_back(src_address_b); // argument 2 (unary only takes one parameter)
 	return true;
 }
 
+GDScriptFunction::Opcode GDScriptCompiler::_get_operator_opcode(const GDScriptParser::OperatorNode *on, Variant::Operator op) const {
+
+	switch (op) {
+		case Variant::OP_ADD:
+		case Variant::OP_SUBTRACT:
+		case Variant::OP_MULTIPLY:
+		case Variant::OP_DIVIDE:
+		case Variant::OP_MODULE:
+		case Variant::OP_EQUAL:
+		case Variant::OP_NOT_EQUAL:
+		case Variant::OP_LESS:
+		case Variant::OP_LESS_EQUAL:
+		case Variant::OP_GREATER:
+		case Variant::OP_GREATER_EQUAL:
+			break;
+		default:
+			return GDScriptFunction::OPCODE_OPERATOR;
+	}
+
+	GDScriptParser::DataType a = on->arguments[0]->get_datatype();
+	GDScriptParser::DataType b = on->arguments[1]->get_datatype();
+
+	if (!a.has_type || !b.has_type || a.kind != GDScriptParser::DataType::BUILTIN || b.kind != GDScriptParser::DataType::BUILTIN || a.builtin_type != b.builtin_type) {
+		return GDScriptFunction::OPCODE_OPERATOR;
+	}
+
+	if (a.builtin_type == Variant::INT) {
+		return GDScriptFunction::OPCODE_OPERATOR_INT;
+	} else if (a.builtin_type == Variant::REAL && op != Variant::OP_MODULE) {
+		return GDScriptFunction::OPCODE_OPERATOR_REAL;
+	}
+	return GDScriptFunction::OPCODE_OPERATOR;
+}
+
+int GDScriptCompiler::_get_vector_axis(const GDScriptParser::Node *p_base, const StringName &p_name) const {
+
+	GDScriptParser::DataType base_type = p_base->get_datatype();
+	if (!base_type.has_type || base_type.kind != GDScriptParser::DataType::BUILTIN) {
+		return -1;
+	}
+
+	int axis_count = 0;
+	if (base_type.builtin_type == Variant::VECTOR2) {
+		axis_count = 2;
+	} else if (base_type.builtin_type == Variant::VECTOR3) {
+		axis_count = 3;
+	}
+
+	String name = p_name;
+	if (name.length() != 1) {
+		return -1;
+	}
+
+	int axis = name[0] - 'x';
+	return axis >= 0 && axis < axis_count ? axis : -1;
+}
+
+MethodBind *GDScriptCompiler::_get_native_method(const GDScriptParser::Node *p_base, const StringName &p_name, StringName *r_class) const {
+
+	GDScriptParser::DataType base_type = p_base->get_datatype();
+	if (!base_type.has_type || base_type.kind != GDScriptParser::DataType::NATIVE) {
+		return NULL;
+	}
+
+	StringName native = base_type.native_type;
+	if (!ClassDB::class_exists(native)) {
+		// Some classes are exposed with an underscore prefix (e.g. _File as File).
+		native = "_" + native;
+		if (!ClassDB::class_exists(native)) {
+			return NULL;
+		}
+	}
+
+	MethodBind *mb = ClassDB::get_method(native, p_name);
+	if (!mb) {
+		return NULL;
+	}
+
+	ClassDB::ClassInfo *ci = ClassDB::classes.getptr(native);
+	if (!ci || !ci->class_ptr) {
+		return NULL;
+	}
+
+	*r_class = native;
+	return mb;
+}
+
+#if defined(PTRCALL_ENABLED) && defined(DEBUG_METHODS_ENABLED)
+static bool _get_ptrcall_arg(const PropertyInfo &p_info, GDScriptFunction::PtrcallArg &r_arg) {
+
+	r_arg.type = p_info.type;
+	r_arg.class_ptr = NULL;
+
+	switch (p_info.type) {
+		case Variant::NIL: {
+			r_arg.kind = (p_info.usage & PROPERTY_USAGE_NIL_IS_VARIANT) ? GDScriptFunction::PtrcallArg::KIND_VARIANT : GDScriptFunction::PtrcallArg::KIND_NONE;
+		} break;
+		case Variant::INT: {
+			// Enums are passed as int, every other integer as int64_t.
+			r_arg.kind = (p_info.usage & PROPERTY_USAGE_CLASS_IS_ENUM) ? GDScriptFunction::PtrcallArg::KIND_ENUM : GDScriptFunction::PtrcallArg::KIND_BUILTIN;
+		} break;
+		case Variant::OBJECT: {
+			// Ref<T> and RefPtr carry their class in the hint, plain pointers in class_name.
+			bool reference = p_info.hint == PROPERTY_HINT_RESOURCE_TYPE;
+			ClassDB::ClassInfo *ci = ClassDB::classes.getptr(reference ? StringName(p_info.hint_string) : p_info.class_name);
+			if (!ci || !ci->class_ptr) {
+				return false;
+			}
+			r_arg.kind = reference ? GDScriptFunction::PtrcallArg::KIND_REFERENCE : GDScriptFunction::PtrcallArg::KIND_OBJECT;
+			r_arg.class_ptr = ci->class_ptr;
+		} break;
+		default: {
+			r_arg.kind = GDScriptFunction::PtrcallArg::KIND_BUILTIN;
+		} break;
+	}
+	return true;
+}
+#endif
+
+void GDScriptCompiler::make_ptrcall_signature(GDScriptFunction::MethodBindInfo &r_info) {
+
+	r_info.ptrcall_argc = -1;
+
+#if defined(PTRCALL_ENABLED) && defined(DEBUG_METHODS_ENABLED)
+	// Argument types are only known with DEBUG_METHODS_ENABLED; release builds get
+	// the signature from the compiled cache.
+	MethodBind *method = r_info.method;
+	int argc = method->get_argument_count();
+	if (method->is_vararg() || argc > GDScriptFunction::MAX_PTRCALL_ARGS) {
+		return;
+	}
+
+	if (!_get_ptrcall_arg(method->get_return_info(), r_info.ptrcall_return)) {
+		return;
+	}
+	for (int i = 0; i < argc; i++) {
+		if (!_get_ptrcall_arg(method->get_argument_info(i), r_info.ptrcall_args[i]) || r_info.ptrcall_args[i].kind == GDScriptFunction::PtrcallArg::KIND_NONE) {
+			return;
+		}
+	}
+	r_info.ptrcall_argc = argc;
+#endif
+}
+
+bool GDScriptCompiler::_can_ptrcall(const GDScriptFunction::MethodBindInfo &p_info, const GDScriptParser::OperatorNode *p_call) const {
+
+	int argc = p_call->arguments.size() - 2;
+	if (p_info.ptrcall_argc < 0 || argc > p_info.ptrcall_argc || argc < p_info.ptrcall_argc - p_info.method->get_default_argument_count()) {
+		return false;
+	}
+
+	// The VM checks the actual values again, this only avoids emitting calls that would always fall back.
+	for (int i = 0; i < argc; i++) {
+
+		const GDScriptFunction::PtrcallArg &arg = p_info.ptrcall_args[i];
+		if (arg.kind == GDScriptFunction::PtrcallArg::KIND_VARIANT) {
+			continue;
+		}
+
+		GDScriptParser::DataType type = p_call->arguments[i + 2]->get_datatype();
+		if (!type.has_type) {
+			return false;
+		}
+		bool builtin = type.kind == GDScriptParser::DataType::BUILTIN;
+
+		switch (arg.kind) {
+			case GDScriptFunction::PtrcallArg::KIND_BUILTIN: {
+				if (!builtin || (type.builtin_type != arg.type && !(arg.type == Variant::REAL && type.builtin_type == Variant::INT))) {
+					return false;
+				}
+			} break;
+			case GDScriptFunction::PtrcallArg::KIND_ENUM: {
+				if (!builtin || type.builtin_type != Variant::INT) {
+					return false;
+				}
+			} break;
+			default: {
+				if (builtin) {
+					return false;
+				}
+			} break;
+		}
+	}
+	return true;
+}
+
 GDScriptDataType GDScriptCompiler::_gdtype_from_datatype(const GDScriptParser::DataType &p_datatype, GDScript *p_owner) const {
 	if (!p_datatype.has_type) {
 		return GDScriptDataType();
@@ -665,11 +851,34 @@ int GDScriptCompiler::_parse_expression(CodeGen &codegen, const GDScriptParser::
 							arguments.push_back(ret);
 						}
 
-						codegen.opcodes.push_back(p_root ? GDScriptFunction::OPCODE_CALL : GDScriptFunction::OPCODE_CALL_RETURN); // perform operator
-						codegen.opcodes.push_back(on->arguments.size() - 2);
-						codegen.alloc_call(on->arguments.size() - 2);
-						for (int i = 0; i < arguments.size(); i++)
-							codegen.opcodes.push_back(arguments[i]);
+						StringName native_class;
+						MethodBind *method = _get_native_method(instance, static_cast<GDScriptParser::IdentifierNode *>(on->arguments[1])->name, &native_class);
+
+						if (method) {
+							// Receiver has a known native type, call the resolved method directly.
+							int method_pos = codegen.get_method_bind_pos(method, native_class);
+							if (_can_ptrcall(codegen.method_binds[method_pos], on)) {
+								codegen.opcodes.push_back(p_root ? GDScriptFunction::OPCODE_CALL_PTRCALL : GDScriptFunction::OPCODE_CALL_PTRCALL_RETURN);
+							} else {
+								codegen.opcodes.push_back(p_root ? GDScriptFunction::OPCODE_CALL_METHOD_BIND : GDScriptFunction::OPCODE_CALL_METHOD_BIND_RETURN);
+							}
+							codegen.opcodes.push_back(on->arguments.size() - 2);
+							codegen.alloc_call(on->arguments.size() - 2);
+							codegen.opcodes.push_back(arguments[0]); // base
+							codegen.opcodes.push_back(arguments[1]); // method name
+							codegen.opcodes.push_back(method_pos);
+							for (int i = 2; i < arguments.size(); i++)
+								codegen.opcodes.push_back(arguments[i]);
+						} else {
+							codegen.opcodes.push_back(p_root ? GDScriptFunction::OPCODE_CALL : GDScriptFunction::OPCODE_CALL_RETURN); // perform operator
+							codegen.opcodes.push_back(on->arguments.size() - 2);
+							codegen.alloc_call(on->arguments.size() - 2);
+							codegen.opcodes.push_back(arguments[0]); // base
+							codegen.opcodes.push_back(arguments[1]); // method name
+							codegen.opcodes.push_back(codegen.alloc_inline_cache());
+							for (int i = 2; i < arguments.size(); i++)
+								codegen.opcodes.push_back(arguments[i]);
+						}
 					}
 				} break;
 				case GDScriptParser::OperatorNode::OP_YIELD: {
@@ -771,9 +980,24 @@ int GDScriptCompiler::_parse_expression(CodeGen &codegen, const GDScriptParser::
 						}
 					}
 
-					codegen.opcodes.push_back(named ? GDScriptFunction::OPCODE_GET_NAMED : GDScriptFunction::OPCODE_GET); // perform operator
-					codegen.opcodes.push_back(from); // argument 1
-					codegen.opcodes.push_back(index); // argument 2 (unary only takes one parameter)
+					int axis = -1;
+					if (on->op == GDScriptParser::OperatorNode::OP_INDEX_NAMED && p_index_addr == 0) {
+						axis = _get_vector_axis(on->arguments[0], static_cast<GDScriptParser::IdentifierNode *>(on->arguments[1])->name);
+					}
+
+					if (axis >= 0) {
+						codegen.opcodes.push_back(GDScriptFunction::OPCODE_GET_NAMED_VECTOR);
+						codegen.opcodes.push_back(from); // argument 1
+						codegen.opcodes.push_back(index); // argument 2 (used if the base is not a vector at runtime)
+						codegen.opcodes.push_back(axis);
+					} else {
+						codegen.opcodes.push_back(named ? GDScriptFunction::OPCODE_GET_NAMED : GDScriptFunction::OPCODE_GET); // perform operator
+						codegen.opcodes.push_back(from); // argument 1
+						codegen.opcodes.push_back(index); // argument 2 (unary only takes one parameter)
+						if (named) {
+							codegen.opcodes.push_back(codegen.alloc_inline_cache());
+						}
+					}
 
 				} break;
 				case GDScriptParser::OperatorNode::OP_AND: {
@@ -1076,6 +1300,9 @@ int GDScriptCompiler::_parse_expression(CodeGen &codegen, const GDScriptParser::
 							codegen.opcodes.push_back(named ? GDScriptFunction::OPCODE_GET_NAMED : GDScriptFunction::OPCODE_GET);
 							codegen.opcodes.push_back(prev_pos);
 							codegen.opcodes.push_back(key_idx);
+							if (named) {
+								codegen.opcodes.push_back(codegen.alloc_inline_cache());
+							}
 							slevel++;
 							codegen.alloc_stack(slevel);
 							int dst_pos = (GDScriptFunction::ADDR_TYPE_STACK << GDScriptFunction::ADDR_BITS) | slevel;
@@ -1084,6 +1311,9 @@ int GDScriptCompiler::_parse_expression(CodeGen &codegen, const GDScriptParser::
 
 							//add in reverse order, since it will be reverted
 
+							if (named) {
+								setchain.push_back(codegen.alloc_inline_cache());
+							}
 							setchain.push_back(dst_pos);
 							setchain.push_back(key_idx);
 							setchain.push_back(prev_pos);
@@ -1119,10 +1349,26 @@ int GDScriptCompiler::_parse_expression(CodeGen &codegen, const GDScriptParser::
 						if (set_value < 0) //error
 							return set_value;
 
-						codegen.opcodes.push_back(named ? GDScriptFunction::OPCODE_SET_NAMED : GDScriptFunction::OPCODE_SET);
-						codegen.opcodes.push_back(prev_pos);
-						codegen.opcodes.push_back(set_index);
-						codegen.opcodes.push_back(set_value);
+						int axis = -1;
+						if (op->op == GDScriptParser::OperatorNode::OP_INDEX_NAMED) {
+							axis = _get_vector_axis(op->arguments[0], static_cast<const GDScriptParser::IdentifierNode *>(op->arguments[1])->name);
+						}
+
+						if (axis >= 0) {
+							codegen.opcodes.push_back(GDScriptFunction::OPCODE_SET_NAMED_VECTOR);
+							codegen.opcodes.push_back(prev_pos);
+							codegen.opcodes.push_back(set_index);
+							codegen.opcodes.push_back(axis);
+							codegen.opcodes.push_back(set_value);
+						} else {
+							codegen.opcodes.push_back(named ? GDScriptFunction::OPCODE_SET_NAMED : GDScriptFunction::OPCODE_SET);
+							codegen.opcodes.push_back(prev_pos);
+							codegen.opcodes.push_back(set_index);
+							codegen.opcodes.push_back(set_value);
+							if (named) {
+								codegen.opcodes.push_back(codegen.alloc_inline_cache());
+							}
+						}
 
 						for (int i = 0; i < setchain.size(); i++) {
 
@@ -1295,12 +1541,12 @@ Error GDScriptCompiler::_parse_block(CodeGen &codegen, const GDScriptParser::Blo
 
 		switch (s->type) {
 			case GDScriptParser::Node::TYPE_NEWLINE: {
-#ifdef DEBUG_ENABLED
-				const GDScriptParser::NewLineNode *nl = static_cast<const GDScriptParser::NewLineNode *>(s);
-				codegen.opcodes.push_back(GDScriptFunction::OPCODE_LINE);
-				codegen.opcodes.push_back(nl->line);
-				codegen.current_line = nl->line;
-#endif
+				if (debug_code) {
+					const GDScriptParser::NewLineNode *nl = static_cast<const GDScriptParser::NewLineNode *>(s);
+					codegen.opcodes.push_back(GDScriptFunction::OPCODE_LINE);
+					codegen.opcodes.push_back(nl->line);
+					codegen.current_line = nl->line;
+				}
 			} break;
 			case GDScriptParser::Node::TYPE_CONTROL_FLOW: {
 				// try subblocks
@@ -1539,32 +1785,32 @@ Error GDScriptCompiler::_parse_block(CodeGen &codegen, const GDScriptParser::Blo
 				}
 			} break;
 			case GDScriptParser::Node::TYPE_ASSERT: {
-#ifdef DEBUG_ENABLED
-				// try subblocks
-
-				const GDScriptParser::AssertNode *as = static_cast<const GDScriptParser::AssertNode *>(s);
+				if (debug_code) {
+					// try subblocks
 
-				int ret2 = _parse_expression(codegen, as->condition, p_stack_level, false);
-				if (ret2 < 0)
-					return ERR_PARSE_ERROR;
+					const GDScriptParser::AssertNode *as = static_cast<const GDScriptParser::AssertNode *>(s);
 
-				int message_ret = 0;
-				if (as->message) {
-					message_ret = _parse_expression(codegen, as->message, p_stack_level + 1, false);
-					if (message_ret < 0)
+					int ret2 = _parse_expression(codegen, as->condition, p_stack_level, false);
+					if (ret2 < 0)
 						return ERR_PARSE_ERROR;
-				}
 
-				codegen.opcodes.push_back(GDScriptFunction::OPCODE_ASSERT);
-				codegen.opcodes.push_back(ret2);
-				codegen.opcodes.push_back(message_ret);
-#endif
+					int message_ret = 0;
+					if (as->message) {
+						message_ret = _parse_expression(codegen, as->message, p_stack_level + 1, false);
+						if (message_ret < 0)
+							return ERR_PARSE_ERROR;
+					}
+
+					codegen.opcodes.push_back(GDScriptFunction::OPCODE_ASSERT);
+					codegen.opcodes.push_back(ret2);
+					codegen.opcodes.push_back(message_ret);
+				}
 			} break;
 			case GDScriptParser::Node::TYPE_BREAKPOINT: {
-#ifdef DEBUG_ENABLED
-				// try subblocks
-				codegen.opcodes.push_back(GDScriptFunction::OPCODE_BREAKPOINT);
-#endif
+				if (debug_code) {
+					// try subblocks
+					codegen.opcodes.push_back(GDScriptFunction::OPCODE_BREAKPOINT);
+				}
 			} break;
 			case GDScriptParser::Node::TYPE_LOCAL_VAR: {
 
@@ -1605,7 +1851,8 @@ Error GDScriptCompiler::_parse_function(GDScript *p_script, const GDScriptParser
 	codegen.stack_max = 0;
 	codegen.current_line = 0;
 	codegen.call_max = 0;
-	codegen.debug_stack = ScriptDebugger::get_singleton() != NULL;
+	codegen.inline_cache_count = 0;
+	codegen.debug_stack = force_debug_stack || ScriptDebugger::get_singleton() != NULL;
 	Vector<StringName> argnames;
 
 	int stack_level = 0;
@@ -1752,6 +1999,28 @@ Error GDScriptCompiler::_parse_function(GDScript *p_script, const GDScriptParser
 		gdfunc->_global_names_count = 0;
 	}
 
+	//native methods
+	if (codegen.method_binds.size()) {
+
+		gdfunc->method_binds = codegen.method_binds;
+		gdfunc->_method_binds_ptr = gdfunc->method_binds.ptr();
+		gdfunc->_method_binds_count = gdfunc->method_binds.size();
+	} else {
+		gdfunc->_method_binds_ptr = NULL;
+		gdfunc->_method_binds_count = 0;
+	}
+
+	//inline caches, filled at runtime
+	if (codegen.inline_cache_count) {
+
+		gdfunc->inline_caches.resize(codegen.inline_cache_count);
+		gdfunc->_inline_caches_ptr = gdfunc->inline_caches.ptrw();
+		gdfunc->_inline_caches_count = gdfunc->inline_caches.size();
+	} else {
+		gdfunc->_inline_caches_ptr = NULL;
+		gdfunc->_inline_caches_count = 0;
+	}
+
 #ifdef TOOLS_ENABLED
 	// Named globals
 	if (codegen.named_globals.size()) {
@@ -2182,6 +2451,9 @@ Error GDScriptCompiler::compile(const GDScriptParser *p_parser, GDScript *p_scri
 
 	source = p_script->get_path();
 
+	// Member and function tables are about to be rebuilt.
+	GDScriptLanguage::get_singleton()->invalidate_inline_caches();
+
 	// The best fully qualified name for a base level script is its file path
 	p_script->fully_qualified_name = p_script->path;
 
@@ -2215,5 +2487,18 @@ int GDScriptCompiler::get_error_column() const {
 	return err_column;
 }
 
+void GDScriptCompiler::set_debug_info(bool p_enable) {
+
+	debug_code = p_enable;
+	force_debug_stack = p_enable;
+}
+
 GDScriptCompiler::GDScriptCompiler() {
+
+#ifdef DEBUG_ENABLED
+	debug_code = true;
+#else
+	debug_code = false;
+#endif
+	force_debug_stack = false;
 }
@@ -121,6 +121,29 @@ class GDScriptCompiler {
 			return pos;
 		}
 
+		Vector<GDScriptFunction::MethodBindInfo> method_binds;
+		Map<MethodBind *, int> method_bind_map;
+
+		int get_method_bind_pos(MethodBind *p_method, const StringName &p_class) {
+			if (method_bind_map.has(p_method))
+				return method_bind_map[p_method];
+			GDScriptFunction::MethodBindInfo mbi;
+			mbi.method = p_method;
+			mbi.class_name = p_class;
+			mbi.class_ptr = ClassDB::classes[p_class].class_ptr;
+			make_ptrcall_signature(mbi);
+			int pos = method_binds.size();
+			method_binds.push_back(mbi);
+			method_bind_map[p_method] = pos;
+			return pos;
+		}
+
+		int inline_cache_count;
+
+		int alloc_inline_cache() {
+			return inline_cache_count++;
+		}
+
 		Vector<int> opcodes;
 		void alloc_stack(int p_level) {
 			if (p_level >= stack_max) stack_max = p_level + 1;
@@ -144,6 +167,11 @@ class GDScriptCompiler {
 
 	GDScriptDataType _gdtype_from_datatype(const GDScriptParser::DataType &p_datatype, GDScript *p_owner = NULL) const;
 
+	GDScriptFunction::Opcode _get_operator_opcode(const GDScriptParser::OperatorNode *on, Variant::Operator op) const;
+	int _get_vector_axis(const GDScriptParser::Node *p_base, const StringName &p_name) const;
+	MethodBind *_get_native_method(const GDScriptParser::Node *p_base, const StringName &p_name, StringName *r_class) const;
+	bool _can_ptrcall(const GDScriptFunction::MethodBindInfo &p_info, const GDScriptParser::OperatorNode *p_call) const;
+
 	int _parse_assign_right_expression(CodeGen &codegen, const GDScriptParser::OperatorNode *p_expression, int p_stack_level, int p_index_addr = 0);
 	int _parse_expression(CodeGen &codegen, const GDScriptParser::Node *p_expression, int p_stack_level, bool p_root = false, bool p_initializer = false, int p_index_addr = 0);
 	Error _parse_block(CodeGen &codegen, const GDScriptParser::BlockNode *p_block, int p_stack_level = 0, int p_break_addr = -1, int p_continue_addr = -1);
@@ -155,10 +183,19 @@ class GDScriptCompiler {
 	int err_column;
 	StringName source;
 	String error;
+	bool debug_code;
+	bool force_debug_stack;
 
 public:
 	Error compile(const GDScriptParser *p_parser, GDScript *p_script, bool p_keep_state = false);
 
+	// Overrides whether line, assert and breakpoint opcodes and local variable debug
+	// info are generated, which otherwise follows the engine build.
+	void set_debug_info(bool p_enable);
+
+	// Fills the ptrcall signature of r_info.method, when the build can tell the argument types.
+	static void make_ptrcall_signature(GDScriptFunction::MethodBindInfo &r_info);
+
 	String get_error() const;
 	int get_error_line() const;
 	int get_error_column() const;
@@ -30,9 +30,12 @@
 
 #include "gdscript_function.h"
 
+#include "core/core_string_names.h"
 #include "core/os/os.h"
 #include "gdscript.h"
+#include "gdscript_compiled_cache.h"
 #include "gdscript_functions.h"
+#include "gdscript_sampler.h"
 
 Variant *GDScriptFunction::_get_variant(int p_address, GDScriptInstance *p_instance, GDScript *p_script, Variant &self, Variant &static_ref, Variant *p_stack, String &r_error) const {
 
@@ -189,16 +192,559 @@ String GDScriptFunction::_get_call_error(const Variant::CallError &p_err, const
 	return err_text;
 }
 
+static _FORCE_INLINE_ bool _evaluate_operator(Variant::Operator p_op, const Variant *p_a, const Variant *p_b, Variant *r_dst, String &r_err_text) {
+
+	bool valid;
+#ifdef DEBUG_ENABLED
+	//allow better error message in cases where a or b and dst are the same stack position
+	Variant ret;
+	Variant::evaluate(p_op, *p_a, *p_b, ret, valid);
+	if (!valid) {
+
+		if (ret.get_type() == Variant::STRING) {
+			//return a string when invalid with the error
+			r_err_text = ret;
+			r_err_text += " in operator '" + Variant::get_operator_name(p_op) + "'.";
+		} else {
+			r_err_text = "Invalid operands '" + Variant::get_type_name(p_a->get_type()) + "' and '" + Variant::get_type_name(p_b->get_type()) + "' in operator '" + Variant::get_operator_name(p_op) + "'.";
+		}
+		return false;
+	}
+	*r_dst = ret;
+#else
+	Variant::evaluate(p_op, *p_a, *p_b, *r_dst, valid);
+#endif
+	return true;
+}
+
+// Packed array fast paths: elements are read and written in place on the
+// PoolVector held by the Variant, without going through Variant::get()/set()
+// or the iterator protocol. Anything unusual (non-int index, out of bounds,
+// mismatched value type) returns false so the generic path reports errors.
+//
+// Each access takes its own PoolVector::Read/Write, which is one atomic
+// increment and decrement of the allocation's lock count. A `for` loop can't
+// hold one Read for its whole run: its container slot shares the allocation
+// with the iterated variable, and PoolVector::resize() checks that lock count
+// before copying on write, so append()/resize() on the variable inside the
+// loop body would fail with ERR_LOCKED. The loop state also only has Variant
+// stack slots, which yield saves and restores as they are.
+
+template <class T>
+static _FORCE_INLINE_ bool _pool_array_get(const Variant *p_array, int64_t p_index, Variant *r_dst) {
+
+	const PoolVector<T> *arr = p_array->get_pool_vector_ptr<T>();
+	int size = arr->size();
+	if (p_index < 0) {
+		p_index += size;
+	}
+	if (unlikely(p_index < 0 || p_index >= size)) {
+		return false;
+	}
+	// Copy out first, r_dst may be the very Variant holding the array.
+	const T value = arr->read()[p_index];
+	*r_dst = value;
+	return true;
+}
+
+template <class T>
+static _FORCE_INLINE_ bool _pool_array_set(Variant *p_array, int64_t p_index, const T &p_value) {
+
+	PoolVector<T> *arr = p_array->get_pool_vector_ptr<T>();
+	int size = arr->size();
+	if (p_index < 0) {
+		p_index += size;
+	}
+	if (unlikely(p_index < 0 || p_index >= size)) {
+		return false;
+	}
+	arr->write()[p_index] = p_value;
+	return true;
+}
+
+static _FORCE_INLINE_ bool _pool_array_get_indexed(const Variant *p_array, const Variant *p_index, Variant *r_dst) {
+
+	if (p_index->get_type() != Variant::INT) {
+		return false;
+	}
+	int64_t index = *p_index;
+
+	switch (p_array->get_type()) {
+		case Variant::POOL_BYTE_ARRAY: return _pool_array_get<uint8_t>(p_array, index, r_dst);
+		case Variant::POOL_INT_ARRAY: return _pool_array_get<int>(p_array, index, r_dst);
+		case Variant::POOL_REAL_ARRAY: return _pool_array_get<real_t>(p_array, index, r_dst);
+		case Variant::POOL_STRING_ARRAY: return _pool_array_get<String>(p_array, index, r_dst);
+		case Variant::POOL_VECTOR2_ARRAY: return _pool_array_get<Vector2>(p_array, index, r_dst);
+		case Variant::POOL_VECTOR3_ARRAY: return _pool_array_get<Vector3>(p_array, index, r_dst);
+		case Variant::POOL_COLOR_ARRAY: return _pool_array_get<Color>(p_array, index, r_dst);
+		default: return false;
+	}
+}
+
+static _FORCE_INLINE_ bool _pool_array_set_indexed(Variant *p_array, const Variant *p_index, const Variant *p_value) {
+
+	if (p_index->get_type() != Variant::INT) {
+		return false;
+	}
+	int64_t index = *p_index;
+	Variant::Type value_type = p_value->get_type();
+
+	switch (p_array->get_type()) {
+		case Variant::POOL_BYTE_ARRAY: return p_value->is_num() && _pool_array_set<uint8_t>(p_array, index, *p_value);
+		case Variant::POOL_INT_ARRAY: return p_value->is_num() && _pool_array_set<int>(p_array, index, *p_value);
+		case Variant::POOL_REAL_ARRAY: return p_value->is_num() && _pool_array_set<real_t>(p_array, index, *p_value);
+		case Variant::POOL_STRING_ARRAY: return value_type == Variant::STRING && _pool_array_set<String>(p_array, index, *p_value);
+		case Variant::POOL_VECTOR2_ARRAY: return value_type == Variant::VECTOR2 && _pool_array_set<Vector2>(p_array, index, *p_value);
+		case Variant::POOL_VECTOR3_ARRAY: return value_type == Variant::VECTOR3 && _pool_array_set<Vector3>(p_array, index, *p_value);
+		case Variant::POOL_COLOR_ARRAY: return value_type == Variant::COLOR && _pool_array_set<Color>(p_array, index, *p_value);
+		default: return false;
+	}
+}
+
+template <class T>
+static _FORCE_INLINE_ int _pool_array_iter(const Variant *p_container, int64_t p_index, Variant *r_iterator) {
+
+	const PoolVector<T> *arr = p_container->get_pool_vector_ptr<T>();
+	if (p_index >= arr->size()) {
+		return 0;
+	}
+	const T value = arr->read()[p_index];
+	*r_iterator = value;
+	return 1;
+}
+
+// Returns 1 when element p_index was stored in r_iterator, 0 when the loop is
+// over, and -1 when p_container is not a packed array.
+static _FORCE_INLINE_ int _pool_array_iterate(const Variant *p_container, int64_t p_index, Variant *r_iterator) {
+
+	switch (p_container->get_type()) {
+		case Variant::POOL_BYTE_ARRAY: return _pool_array_iter<uint8_t>(p_container, p_index, r_iterator);
+		case Variant::POOL_INT_ARRAY: return _pool_array_iter<int>(p_container, p_index, r_iterator);
+		case Variant::POOL_REAL_ARRAY: return _pool_array_iter<real_t>(p_container, p_index, r_iterator);
+		case Variant::POOL_STRING_ARRAY: return _pool_array_iter<String>(p_container, p_index, r_iterator);
+		case Variant::POOL_VECTOR2_ARRAY: return _pool_array_iter<Vector2>(p_container, p_index, r_iterator);
+		case Variant::POOL_VECTOR3_ARRAY: return _pool_array_iter<Vector3>(p_container, p_index, r_iterator);
+		case Variant::POOL_COLOR_ARRAY: return _pool_array_iter<Color>(p_container, p_index, r_iterator);
+		default: return -1;
+	}
+}
+
+#ifdef PTRCALL_ENABLED
+// Calls p_info.method through MethodBind::ptrcall(), skipping the Variant
+// conversions of MethodBind::call(). Returns false, without calling anything,
+// when an argument doesn't have the exact layout the signature expects; the
+// caller then goes through the regular call path, which also reports errors.
+static bool _ptrcall_method(const GDScriptFunction::MethodBindInfo &p_info, Object *p_object, Variant **p_args, int p_argc, Variant *r_ret) {
+
+	typedef GDScriptFunction::PtrcallArg PtrcallArg;
+
+	int argc = p_info.ptrcall_argc;
+	if (p_argc > argc || p_argc < argc - p_info.method->get_default_argument_count()) {
+		return false;
+	}
+
+	const void *ptrargs[GDScriptFunction::MAX_PTRCALL_ARGS];
+	double reals[GDScriptFunction::MAX_PTRCALL_ARGS];
+	int enums[GDScriptFunction::MAX_PTRCALL_ARGS];
+	Variant defaults[GDScriptFunction::MAX_PTRCALL_ARGS];
+
+	for (int i = 0; i < argc; i++) {
+
+		const PtrcallArg &arg = p_info.ptrcall_args[i];
+		Variant *value;
+		if (i < p_argc) {
+			value = p_args[i];
+		} else {
+			defaults[i] = p_info.method->get_default_argument(i);
+			value = &defaults[i];
+		}
+
+		Variant::Type type = value->get_type();
+		switch (arg.kind) {
+			case PtrcallArg::KIND_VARIANT: {
+				ptrargs[i] = value;
+			} break;
+			case PtrcallArg::KIND_BUILTIN: {
+				if (type == arg.type) {
+					ptrargs[i] = value->get_ptrcall_ptr();
+				} else if (arg.type == Variant::REAL && type == Variant::INT) {
+					reals[i] = (double)value->operator int64_t();
+					ptrargs[i] = &reals[i];
+				} else {
+					return false;
+				}
+			} break;
+			case PtrcallArg::KIND_ENUM: {
+				if (type != Variant::INT) {
+					return false;
+				}
+				enums[i] = value->operator int();
+				ptrargs[i] = &enums[i];
+			} break;
+			case PtrcallArg::KIND_OBJECT:
+			case PtrcallArg::KIND_REFERENCE: {
+				if (type == Variant::NIL) {
+					ptrargs[i] = NULL;
+				} else if (type == Variant::OBJECT) {
+					Object *obj = value->operator Object *();
+					if (!obj || !obj->is_class_ptr(arg.class_ptr)) {
+						return false;
+					}
+					ptrargs[i] = obj;
+				} else {
+					return false;
+				}
+			} break;
+			default: {
+				return false;
+			}
+		}
+	}
+
+	const PtrcallArg &ret = p_info.ptrcall_return;
+	switch (ret.kind) {
+		case PtrcallArg::KIND_NONE: {
+			p_info.method->ptrcall(p_object, ptrargs, NULL);
+			if (r_ret) {
+				*r_ret = Variant();
+			}
+		} break;
+		case PtrcallArg::KIND_VARIANT: {
+			Variant value;
+			p_info.method->ptrcall(p_object, ptrargs, &value);
+			if (r_ret) {
+				*r_ret = value;
+			}
+		} break;
+		case PtrcallArg::KIND_BUILTIN: {
+			// Encode straight into the destination when it already holds the right type,
+			// unless it is also one of the arguments.
+			bool in_place = r_ret && r_ret->get_type() == ret.type;
+			for (int i = 0; in_place && i < p_argc; i++) {
+				in_place = p_args[i] != r_ret;
+			}
+			if (in_place) {
+				p_info.method->ptrcall(p_object, ptrargs, r_ret->get_ptrcall_ptr());
+			} else {
+				Variant::CallError ce;
+				Variant value = Variant::construct(ret.type, NULL, 0, ce);
+				p_info.method->ptrcall(p_object, ptrargs, value.get_ptrcall_ptr());
+				if (r_ret) {
+					*r_ret = value;
+				}
+			}
+		} break;
+		case PtrcallArg::KIND_ENUM: {
+			int value = 0;
+			p_info.method->ptrcall(p_object, ptrargs, &value);
+			if (r_ret) {
+				*r_ret = value;
+			}
+		} break;
+		case PtrcallArg::KIND_OBJECT: {
+			Object *value = NULL;
+			p_info.method->ptrcall(p_object, ptrargs, &value);
+			if (r_ret) {
+				*r_ret = value;
+			}
+		} break;
+		case PtrcallArg::KIND_REFERENCE: {
+			Ref<Reference> value;
+			p_info.method->ptrcall(p_object, ptrargs, &value);
+			if (r_ret) {
+				*r_ret = value;
+			}
+		} break;
+	}
+	return true;
+}
+#endif // PTRCALL_ENABLED
+
+GDScriptInstance *GDScriptFunction::_get_cacheable_instance(Object *p_object, bool &r_cacheable) {
+
+	ScriptInstance *si = p_object->get_script_instance();
+	if (!si) {
+		r_cacheable = true;
+		return NULL;
+	}
+
+	// Other languages and placeholders resolve names in ways the cache can't mirror.
+	r_cacheable = si->get_language() == GDScriptLanguage::get_singleton() && !si->is_placeholder();
+	return r_cacheable ? static_cast<GDScriptInstance *>(si) : NULL;
+}
+
+void GDScriptFunction::_inline_cache_fill_get(InlineCacheEntry &r_entry, Object *p_object, GDScriptInstance *p_instance, const StringName &p_name) {
+
+	r_entry.kind = InlineCacheEntry::KIND_NONE;
+	r_entry.script = p_instance ? p_instance->script.ptr() : NULL;
+	r_entry.native_class = p_object->get_class_name();
+
+	// Same lookup order as GDScriptInstance::get() followed by ClassDB::get_property().
+	if (p_instance) {
+		const Map<StringName, GDScript::MemberInfo>::Element *E = r_entry.script->member_indices.find(p_name);
+		if (E) {
+			if (E->get().getter == StringName()) {
+				r_entry.kind = InlineCacheEntry::KIND_MEMBER;
+				r_entry.index = E->get().index;
+			}
+			return;
+		}
+		for (const GDScript *sptr = r_entry.script; sptr; sptr = sptr->_base) {
+			if (sptr->constants.has(p_name) || sptr->member_functions.has(GDScriptLanguage::get_singleton()->strings._get)) {
+				return;
+			}
+		}
+	}
+
+	const ClassDB::ClassInfo *check = ClassDB::classes.getptr(r_entry.native_class);
+	while (check) {
+		const ClassDB::PropertySetGet *psg = check->property_setget.getptr(p_name);
+		if (psg) {
+			if (psg->getter == StringName()) {
+				return;
+			}
+			MethodBind *method = psg->index < 0 ? psg->_getptr : NULL;
+			if (!method) {
+				// Resolved through Object::call(), which gives the script a chance first.
+				if (p_instance && p_instance->has_method(psg->getter)) {
+					return;
+				}
+				method = ClassDB::get_method(r_entry.native_class, psg->getter);
+			}
+			if (method) {
+				r_entry.kind = InlineCacheEntry::KIND_PROPERTY;
+				r_entry.index = psg->index;
+				r_entry.method = method;
+			}
+			return;
+		}
+		if (check->constant_map.has(p_name)) {
+			return;
+		}
+		check = check->inherits_ptr;
+	}
+}
+
+void GDScriptFunction::_inline_cache_fill_set(InlineCacheEntry &r_entry, Object *p_object, GDScriptInstance *p_instance, const StringName &p_name) {
+
+	r_entry.kind = InlineCacheEntry::KIND_NONE;
+	r_entry.script = p_instance ? p_instance->script.ptr() : NULL;
+	r_entry.native_class = p_object->get_class_name();
+
+	// Same lookup order as GDScriptInstance::set() followed by ClassDB::set_property().
+	if (p_instance) {
+		const Map<StringName, GDScript::MemberInfo>::Element *E = r_entry.script->member_indices.find(p_name);
+		if (E) {
+			const GDScriptDataType &type = E->get().data_type;
+			if (E->get().setter == StringName() && (!type.has_type || type.kind == GDScriptDataType::BUILTIN)) {
+				r_entry.kind = InlineCacheEntry::KIND_MEMBER;
+				r_entry.index = E->get().index;
+				r_entry.member_type = type.has_type ? type.builtin_type : Variant::NIL;
+			}
+			return;
+		}
+		for (const GDScript *sptr = r_entry.script; sptr; sptr = sptr->_base) {
+			if (sptr->member_functions.has(GDScriptLanguage::get_singleton()->strings._set)) {
+				return;
+			}
+		}
+	}
+
+	const ClassDB::ClassInfo *check = ClassDB::classes.getptr(r_entry.native_class);
+	while (check) {
+		const ClassDB::PropertySetGet *psg = check->property_setget.getptr(p_name);
+		if (psg) {
+			if (psg->setter != StringName() && psg->_setptr) {
+				r_entry.kind = InlineCacheEntry::KIND_PROPERTY;
+				r_entry.index = psg->index;
+				r_entry.method = psg->_setptr;
+			}
+			return;
+		}
+		check = check->inherits_ptr;
+	}
+}
+
+void GDScriptFunction::_inline_cache_fill_call(InlineCacheEntry &r_entry, Object *p_object, GDScriptInstance *p_instance, const StringName &p_name) {
+
+	r_entry.kind = InlineCacheEntry::KIND_NONE;
+	r_entry.script = p_instance ? p_instance->script.ptr() : NULL;
+	r_entry.native_class = p_object->get_class_name();
+
+	// Same lookup order as Object::call(); free() stays on the generic path.
+	if (p_name == CoreStringNames::get_singleton()->_free) {
+		return;
+	}
+
+	if (p_instance) {
+		const GDScript *sptr = r_entry.script;
+		while (sptr) {
+			const Map<StringName, GDScriptFunction *>::Element *E = sptr->member_functions.find(p_name);
+			if (E) {
+				r_entry.kind = InlineCacheEntry::KIND_FUNCTION;
+				r_entry.function = E->get();
+				return;
+			}
+			sptr = sptr->_base;
+		}
+	}
+
+	MethodBind *method = ClassDB::get_method(r_entry.native_class, p_name);
+	if (method) {
+		r_entry.kind = InlineCacheEntry::KIND_METHOD;
+		r_entry.method = method;
+	}
+}
+
+const GDScriptFunction::InlineCacheEntry *GDScriptFunction::_inline_cache_lookup(InlineCache &r_cache, Object *p_object, const StringName &p_name, InlineCacheFillFunc p_fill, GDScriptInstance *&r_instance) {
+
+	bool cacheable;
+	r_instance = _get_cacheable_instance(p_object, cacheable);
+	if (!cacheable) {
+		return NULL;
+	}
+
+	uint32_t epoch = GDScriptLanguage::get_singleton()->get_inline_cache_epoch();
+	if (r_cache.epoch != epoch) {
+		r_cache.epoch = epoch;
+		r_cache.count = 0;
+		r_cache.megamorphic = false;
+	}
+
+	GDScript *script = r_instance ? r_instance->script.ptr() : NULL;
+	const StringName &native_class = p_object->get_class_name();
+	for (int i = 0; i < r_cache.count; i++) {
+		const InlineCacheEntry &entry = r_cache.entries[i];
+		if (entry.script == script && entry.native_class == native_class) {
+			return &entry;
+		}
+	}
+
+	if (r_cache.megamorphic) {
+		return NULL;
+	}
+	if (r_cache.count == InlineCache::MAX_ENTRIES) {
+		// Too many shapes to be worth scanning, leave the site to the generic path until the next reload.
+		r_cache.megamorphic = true;
+		return NULL;
+	}
+
+	InlineCacheEntry &entry = r_cache.entries[r_cache.count++];
+	entry = InlineCacheEntry();
+	p_fill(entry, p_object, r_instance, p_name);
+	return &entry;
+}
+
+bool GDScriptFunction::_inline_cache_get(InlineCache &r_cache, Object *p_object, const StringName &p_name, Variant &r_ret) {
+
+	GDScriptInstance *instance;
+	const InlineCacheEntry *entry = _inline_cache_lookup(r_cache, p_object, p_name, _inline_cache_fill_get, instance);
+	if (!entry) {
+		return false;
+	}
+
+	switch (entry->kind) {
+		case InlineCacheEntry::KIND_MEMBER: {
+			r_ret = instance->members[entry->index];
+			return true;
+		} break;
+		case InlineCacheEntry::KIND_PROPERTY: {
+			Variant::CallError ce;
+			if (entry->index >= 0) {
+				Variant index = entry->index;
+				const Variant *arg[1] = { &index };
+				r_ret = entry->method->call(p_object, arg, 1, ce);
+			} else {
+				r_ret = entry->method->call(p_object, NULL, 0, ce);
+			}
+			return true;
+		} break;
+		default: {
+			return false;
+		}
+	}
+}
+
+bool GDScriptFunction::_inline_cache_set(InlineCache &r_cache, Object *p_object, const StringName &p_name, const Variant &p_value, bool &r_valid) {
+
+#ifdef TOOLS_ENABLED
+	// Object::set() flags the object as edited, leave that to the generic path.
+	if (!p_object->is_edited()) {
+		return false;
+	}
+#endif
+
+	GDScriptInstance *instance;
+	const InlineCacheEntry *entry = _inline_cache_lookup(r_cache, p_object, p_name, _inline_cache_fill_set, instance);
+	if (!entry) {
+		return false;
+	}
+
+	switch (entry->kind) {
+		case InlineCacheEntry::KIND_MEMBER: {
+			if (entry->member_type != Variant::NIL && p_value.get_type() != entry->member_type) {
+				return false; // Needs a conversion.
+			}
+			instance->members.write[entry->index] = p_value;
+			r_valid = true;
+			return true;
+		} break;
+		case InlineCacheEntry::KIND_PROPERTY: {
+			Variant::CallError ce;
+			if (entry->index >= 0) {
+				Variant index = entry->index;
+				const Variant *arg[2] = { &index, &p_value };
+				entry->method->call(p_object, arg, 2, ce);
+			} else {
+				const Variant *arg[1] = { &p_value };
+				entry->method->call(p_object, arg, 1, ce);
+			}
+			r_valid = ce.error == Variant::CallError::CALL_OK;
+			return true;
+		} break;
+		default: {
+			return false;
+		}
+	}
+}
+
+bool GDScriptFunction::_inline_cache_call(InlineCache &r_cache, Object *p_object, const StringName &p_name, const Variant **p_args, int p_argcount, Variant &r_ret, Variant::CallError &r_err) {
+
+	GDScriptInstance *instance;
+	const InlineCacheEntry *entry = _inline_cache_lookup(r_cache, p_object, p_name, _inline_cache_fill_call, instance);
+	if (!entry) {
+		return false;
+	}
+
+	switch (entry->kind) {
+		case InlineCacheEntry::KIND_FUNCTION: {
+			r_ret = entry->function->call(instance, p_args, p_argcount, r_err);
+			return true;
+		} break;
+		case InlineCacheEntry::KIND_METHOD: {
+			r_ret = entry->method->call(p_object, p_args, p_argcount, r_err);
+			return true;
+		} break;
+		default: {
+			return false;
+		}
+	}
+}
+
 #if defined(__GNUC__)
 #define OPCODES_TABLE                         \
 	static const void *switch_table_ops[] = { \
 		&&OPCODE_OPERATOR,                    \
+		&&OPCODE_OPERATOR_INT,                \
+		&&OPCODE_OPERATOR_REAL,               \
 		&&OPCODE_EXTENDS_TEST,                \
 		&&OPCODE_IS_BUILTIN,                  \
 		&&OPCODE_SET,                         \
 		&&OPCODE_GET,                         \
 		&&OPCODE_SET_NAMED,                   \
 		&&OPCODE_GET_NAMED,                   \
+		&&OPCODE_SET_NAMED_VECTOR,            \
+		&&OPCODE_GET_NAMED_VECTOR,            \
 		&&OPCODE_SET_MEMBER,                  \
 		&&OPCODE_GET_MEMBER,                  \
 		&&OPCODE_ASSIGN,                      \
@@ -215,6 +761,10 @@ String GDScriptFunction::_get_call_error(const Variant::CallError &p_err, const
 		&&OPCODE_CONSTRUCT_DICTIONARY,        \
 		&&OPCODE_CALL,                        \
 		&&OPCODE_CALL_RETURN,                 \
+		&&OPCODE_CALL_METHOD_BIND,            \
+		&&OPCODE_CALL_METHOD_BIND_RETURN,     \
+		&&OPCODE_CALL_PTRCALL,                \
+		&&OPCODE_CALL_PTRCALL_RETURN,         \
 		&&OPCODE_CALL_BUILT_IN,               \
 		&&OPCODE_CALL_SELF,                   \
 		&&OPCODE_CALL_SELF_BASE,              \
@@ -262,6 +812,10 @@ Variant GDScriptFunction::call(GDScriptInstance *p_instance, const Variant **p_a
 
 	OPCODES_TABLE;
 
+	if (unlikely(lazy_pending.is_set())) {
+		_materialize();
+	}
+
 	if (!_code_ptr) {
 
 		return Variant();
@@ -289,11 +843,11 @@ Variant GDScriptFunction::call(GDScriptInstance *p_instance, const Variant **p_a
 
 	if (p_state) {
 		//use existing (supplied) state (yielded)
-		stack = (Variant *)p_state->stack.ptr();
-		call_args = (Variant **)&p_state->stack.ptr()[sizeof(Variant) * p_state->stack_size]; //ptr() to avoid bounds check
+		stack = (Variant *)p_state->stack;
+		call_args = (Variant **)&p_state->stack[sizeof(Variant) * p_state->stack_size];
 		line = p_state->line;
 		ip = p_state->ip;
-		alloca_size = p_state->stack.size();
+		alloca_size = p_state->alloca_size;
 		script = p_state->script;
 		p_instance = p_state->instance;
 		defarg = p_state->defarg;
@@ -384,8 +938,21 @@ Variant GDScriptFunction::call(GDScriptInstance *p_instance, const Variant **p_a
 
 	static_ref = script;
 
+	// Inline caches are only read and filled from the main thread.
+	bool use_inline_caches = _inline_caches_count && Thread::get_caller_id() == Thread::get_main_id();
+
 	String err_text;
 
+	// Only the main thread is sampled.
+	GDScriptSampler *sampler = GDScriptSampler::get_singleton();
+	if (unlikely(sampler != NULL)) {
+		if (Thread::get_caller_id() == Thread::get_main_id()) {
+			sampler->enter_function(this);
+		} else {
+			sampler = NULL;
+		}
+	}
+
 #ifdef DEBUG_ENABLED
 
 	if (ScriptDebugger::get_singleton())
@@ -445,7 +1012,6 @@ Variant GDScriptFunction::call(GDScriptInstance *p_instance, const Variant **p_a
 
 				CHECK_SPACE(5);
 
-				bool valid;
 				Variant::Operator op = (Variant::Operator)_code_ptr[ip + 1];
 				GD_ERR_BREAK(op >= Variant::OP_MAX);
 
@@ -453,27 +1019,112 @@ Variant GDScriptFunction::call(GDScriptInstance *p_instance, const Variant **p_a
 				GET_VARIANT_PTR(b, 3);
 				GET_VARIANT_PTR(dst, 4);
 
-#ifdef DEBUG_ENABLED
+				if (unlikely(!_evaluate_operator(op, a, b, dst, err_text))) {
+					OPCODE_BREAK;
+				}
+				ip += 5;
+			}
+			DISPATCH_OPCODE;
 
-				Variant ret;
-				Variant::evaluate(op, *a, *b, ret, valid);
-#else
-				Variant::evaluate(op, *a, *b, *dst, valid);
-#endif
-#ifdef DEBUG_ENABLED
-				if (!valid) {
+			OPCODE(OPCODE_OPERATOR_INT) {
 
-					if (ret.get_type() == Variant::STRING) {
-						//return a string when invalid with the error
-						err_text = ret;
-						err_text += " in operator '" + Variant::get_operator_name(op) + "'.";
-					} else {
-						err_text = "Invalid operands '" + Variant::get_type_name(a->get_type()) + "' and '" + Variant::get_type_name(b->get_type()) + "' in operator '" + Variant::get_operator_name(op) + "'.";
+				CHECK_SPACE(5);
+
+				Variant::Operator op = (Variant::Operator)_code_ptr[ip + 1];
+				GD_ERR_BREAK(op >= Variant::OP_MAX);
+
+				GET_VARIANT_PTR(a, 2);
+				GET_VARIANT_PTR(b, 3);
+				GET_VARIANT_PTR(dst, 4);
+
+				// The compiler only emits this when both operands are statically typed as int,
+				// but values are still checked so a mismatch falls back to regular evaluation.
+				bool done = false;
+				if (likely(a->get_type() == Variant::INT && b->get_type() == Variant::INT)) {
+
+					int64_t va = *a;
+					int64_t vb = *b;
+					done = true;
+
+					switch (op) {
+						case Variant::OP_ADD: *dst = va + vb; break;
+						case Variant::OP_SUBTRACT: *dst = va - vb; break;
+						case Variant::OP_MULTIPLY: *dst = va * vb; break;
+						case Variant::OP_DIVIDE: {
+							if (vb != 0) {
+								*dst = va / vb;
+							} else {
+								done = false; // Let the generic path report division by zero.
+							}
+						} break;
+						case Variant::OP_MODULE: {
+							if (vb != 0) {
+								*dst = va % vb;
+							} else {
+								done = false;
+							}
+						} break;
+						case Variant::OP_EQUAL: *dst = va == vb; break;
+						case Variant::OP_NOT_EQUAL: *dst = va != vb; break;
+						case Variant::OP_LESS: *dst = va < vb; break;
+						case Variant::OP_LESS_EQUAL: *dst = va <= vb; break;
+						case Variant::OP_GREATER: *dst = va > vb; break;
+						case Variant::OP_GREATER_EQUAL: *dst = va >= vb; break;
+						default: done = false;
 					}
+				}
+
+				if (!done && unlikely(!_evaluate_operator(op, a, b, dst, err_text))) {
 					OPCODE_BREAK;
 				}
-				*dst = ret;
+				ip += 5;
+			}
+			DISPATCH_OPCODE;
+
+			OPCODE(OPCODE_OPERATOR_REAL) {
+
+				CHECK_SPACE(5);
+
+				Variant::Operator op = (Variant::Operator)_code_ptr[ip + 1];
+				GD_ERR_BREAK(op >= Variant::OP_MAX);
+
+				GET_VARIANT_PTR(a, 2);
+				GET_VARIANT_PTR(b, 3);
+				GET_VARIANT_PTR(dst, 4);
+
+				bool done = false;
+				if (likely(a->get_type() == Variant::REAL && b->get_type() == Variant::REAL)) {
+
+					double va = *a;
+					double vb = *b;
+					done = true;
+
+					switch (op) {
+						case Variant::OP_ADD: *dst = va + vb; break;
+						case Variant::OP_SUBTRACT: *dst = va - vb; break;
+						case Variant::OP_MULTIPLY: *dst = va * vb; break;
+						case Variant::OP_DIVIDE: {
+#ifdef DEBUG_ENABLED
+							if (vb == 0) {
+								done = false; // Let the generic path report division by zero.
+								break;
+							}
 #endif
+							*dst = va / vb;
+						} break;
+						case Variant::OP_EQUAL: *dst = va == vb; break;
+						case Variant::OP_NOT_EQUAL: *dst = va != vb; break;
+						case Variant::OP_LESS: *dst = va < vb; break;
+						case Variant::OP_LESS_EQUAL: *dst = va <= vb; break;
+						case Variant::OP_GREATER: *dst = va > vb; break;
+						case Variant::OP_GREATER_EQUAL: *dst = va >= vb; break;
+						default: done = false;
+					}
+				}
+
+				if (!done && unlikely(!_evaluate_operator(op, a, b, dst, err_text))) {
+					OPCODE_BREAK;
+				}
 				ip += 5;
 			}
 			DISPATCH_OPCODE;
@@ -570,21 +1221,23 @@ Variant GDScriptFunction::call(GDScriptInstance *p_instance, const Variant **p_a
 				GET_VARIANT_PTR(index, 2);
 				GET_VARIANT_PTR(value, 3);
 
-				bool valid;
-				dst->set(*index, *value, &valid);
+				if (!_pool_array_set_indexed(dst, index, value)) {
+					bool valid;
+					dst->set(*index, *value, &valid);
 
 #ifdef DEBUG_ENABLED
-				if (!valid) {
-					String v = index->operator String();
-					if (v != "") {
-						v = "'" + v + "'";
-					} else {
-						v = "of type '" + _get_var_type(index) + "'";
+					if (!valid) {
+						String v = index->operator String();
+						if (v != "") {
+							v = "'" + v + "'";
+						} else {
+							v = "of type '" + _get_var_type(index) + "'";
+						}
+						err_text = "Invalid set index " + v + " (on base: '" + _get_var_type(dst) + "') with value of type '" + _get_var_type(value) + "'";
+						OPCODE_BREAK;
 					}
-					err_text = "Invalid set index " + v + " (on base: '" + _get_var_type(dst) + "') with value of type '" + _get_var_type(value) + "'";
-					OPCODE_BREAK;
-				}
 #endif
+				}
 				ip += 4;
 			}
 			DISPATCH_OPCODE;
@@ -597,45 +1250,52 @@ Variant GDScriptFunction::call(GDScriptInstance *p_instance, const Variant **p_a
 				GET_VARIANT_PTR(index, 2);
 				GET_VARIANT_PTR(dst, 3);
 
-				bool valid;
+				if (!_pool_array_get_indexed(src, index, dst)) {
+					bool valid;
 #ifdef DEBUG_ENABLED
-				//allow better error message in cases where src and dst are the same stack position
-				Variant ret = src->get(*index, &valid);
+					//allow better error message in cases where src and dst are the same stack position
+					Variant ret = src->get(*index, &valid);
 #else
-				*dst = src->get(*index, &valid);
+					*dst = src->get(*index, &valid);
 
 #endif
 #ifdef DEBUG_ENABLED
-				if (!valid) {
-					String v = index->operator String();
-					if (v != "") {
-						v = "'" + v + "'";
-					} else {
-						v = "of type '" + _get_var_type(index) + "'";
+					if (!valid) {
+						String v = index->operator String();
+						if (v != "") {
+							v = "'" + v + "'";
+						} else {
+							v = "of type '" + _get_var_type(index) + "'";
+						}
+						err_text = "Invalid get index " + v + " (on base: '" + _get_var_type(src) + "').";
+						OPCODE_BREAK;
 					}
-					err_text = "Invalid get index " + v + " (on base: '" + _get_var_type(src) + "').";
-					OPCODE_BREAK;
-				}
-				*dst = ret;
+					*dst = ret;
 #endif
+				}
 				ip += 4;
 			}
 			DISPATCH_OPCODE;
 
 			OPCODE(OPCODE_SET_NAMED) {
 
-				CHECK_SPACE(3);
+				CHECK_SPACE(5);
 
 				GET_VARIANT_PTR(dst, 1);
 				GET_VARIANT_PTR(value, 3);
 
 				int indexname = _code_ptr[ip + 2];
+				int cacheidx = _code_ptr[ip + 4];
 
 				GD_ERR_BREAK(indexname < 0 || indexname >= _global_names_count);
+				GD_ERR_BREAK(cacheidx < 0 || cacheidx >= _inline_caches_count);
 				const StringName *index = &_global_names_ptr[indexname];
 
 				bool valid;
-				dst->set_named(*index, *value, &valid);
+				Object *obj = use_inline_caches && dst->get_type() == Variant::OBJECT ? dst->operator Object *() : NULL;
+				if (!obj || !_inline_cache_set(_inline_caches_ptr[cacheidx], obj, *index, *value, valid)) {
+					dst->set_named(*index, *value, &valid);
+				}
 
 #ifdef DEBUG_ENABLED
 				if (!valid) {
@@ -644,30 +1304,33 @@ Variant GDScriptFunction::call(GDScriptInstance *p_instance, const Variant **p_a
 					OPCODE_BREAK;
 				}
 #endif
-				ip += 4;
+				ip += 5;
 			}
 			DISPATCH_OPCODE;
 
 			OPCODE(OPCODE_GET_NAMED) {
 
-				CHECK_SPACE(4);
+				CHECK_SPACE(5);
 
 				GET_VARIANT_PTR(src, 1);
-				GET_VARIANT_PTR(dst, 3);
+				GET_VARIANT_PTR(dst, 4);
 
 				int indexname = _code_ptr[ip + 2];
+				int cacheidx = _code_ptr[ip + 3];
 
 				GD_ERR_BREAK(indexname < 0 || indexname >= _global_names_count);
+				GD_ERR_BREAK(cacheidx < 0 || cacheidx >= _inline_caches_count);
 				const StringName *index = &_global_names_ptr[indexname];
 
 				bool valid;
-#ifdef DEBUG_ENABLED
-				//allow better error message in cases where src and dst are the same stack position
-				Variant ret = src->get_named(*index, &valid);
-
-#else
-				*dst = src->get_named(*index, &valid);
-#endif
+				// Read into a temporary, src and dst may be the same stack position.
+				Variant ret;
+				Object *obj = use_inline_caches && src->get_type() == Variant::OBJECT ? src->operator Object *() : NULL;
+				if (obj && _inline_cache_get(_inline_caches_ptr[cacheidx], obj, *index, ret)) {
+					valid = true;
+				} else {
+					ret = src->get_named(*index, &valid);
+				}
 #ifdef DEBUG_ENABLED
 				if (!valid) {
 					if (src->has_method(*index)) {
@@ -677,9 +1340,82 @@ Variant GDScriptFunction::call(GDScriptInstance *p_instance, const Variant **p_a
 					}
 					OPCODE_BREAK;
 				}
+#endif
 				*dst = ret;
+				ip += 5;
+			}
+			DISPATCH_OPCODE;
+
+			OPCODE(OPCODE_SET_NAMED_VECTOR) {
+
+				CHECK_SPACE(5);
+
+				GET_VARIANT_PTR(dst, 1);
+				GET_VARIANT_PTR(value, 4);
+
+				int indexname = _code_ptr[ip + 2];
+				int axis = _code_ptr[ip + 3];
+
+				GD_ERR_BREAK(indexname < 0 || indexname >= _global_names_count);
+
+				bool numeric = value->get_type() == Variant::REAL || value->get_type() == Variant::INT;
+				if (likely(numeric && dst->get_type() == Variant::VECTOR2 && axis < 2)) {
+					Vector2 v = *dst;
+					v[axis] = *value;
+					*dst = v;
+				} else if (likely(numeric && dst->get_type() == Variant::VECTOR3)) {
+					Vector3 v = *dst;
+					v[axis] = *value;
+					*dst = v;
+				} else {
+					const StringName *index = &_global_names_ptr[indexname];
+
+					bool valid;
+					dst->set_named(*index, *value, &valid);
+
+#ifdef DEBUG_ENABLED
+					if (!valid) {
+						err_text = "Invalid set index '" + String(*index) + "' (on base: '" + _get_var_type(dst) + "') with value of type '" + _get_var_type(value) + "'.";
+						OPCODE_BREAK;
+					}
 #endif
-				ip += 4;
+				}
+				ip += 5;
+			}
+			DISPATCH_OPCODE;
+
+			OPCODE(OPCODE_GET_NAMED_VECTOR) {
+
+				CHECK_SPACE(5);
+
+				GET_VARIANT_PTR(src, 1);
+				GET_VARIANT_PTR(dst, 4);
+
+				int indexname = _code_ptr[ip + 2];
+				int axis = _code_ptr[ip + 3];
+
+				GD_ERR_BREAK(indexname < 0 || indexname >= _global_names_count);
+
+				if (likely(src->get_type() == Variant::VECTOR2 && axis < 2)) {
+					*dst = src->operator Vector2()[axis];
+				} else if (likely(src->get_type() == Variant::VECTOR3)) {
+					*dst = src->operator Vector3()[axis];
+				} else {
+					const StringName *index = &_global_names_ptr[indexname];
+
+					bool valid;
+#ifdef DEBUG_ENABLED
+					Variant ret = src->get_named(*index, &valid);
+					if (!valid) {
+						err_text = "Invalid get index '" + index->operator String() + "' (on base: '" + _get_var_type(src) + "').";
+						OPCODE_BREAK;
+					}
+					*dst = ret;
+#else
+					*dst = src->get_named(*index, &valid);
+#endif
+				}
+				ip += 5;
 			}
 			DISPATCH_OPCODE;
 
@@ -1048,18 +1784,20 @@ Variant GDScriptFunction::call(GDScriptInstance *p_instance, const Variant **p_a
 			OPCODE(OPCODE_CALL_RETURN)
 			OPCODE(OPCODE_CALL) {
 
-				CHECK_SPACE(4);
+				CHECK_SPACE(5);
 				bool call_ret = _code_ptr[ip] == OPCODE_CALL_RETURN;
 
 				int argc = _code_ptr[ip + 1];
 				GET_VARIANT_PTR(base, 2);
 				int nameg = _code_ptr[ip + 3];
+				int cacheidx = _code_ptr[ip + 4];
 
 				GD_ERR_BREAK(nameg < 0 || nameg >= _global_names_count);
+				GD_ERR_BREAK(cacheidx < 0 || cacheidx >= _inline_caches_count);
 				const StringName *methodname = &_global_names_ptr[nameg];
 
 				GD_ERR_BREAK(argc < 0);
-				ip += 4;
+				ip += 5;
 				CHECK_SPACE(argc + 1);
 				Variant **argptrs = call_args;
 
@@ -1076,8 +1814,19 @@ Variant GDScriptFunction::call(GDScriptInstance *p_instance, const Variant **p_a
 				}
 
 #endif
+				// Read before the call, the return value may be stored over the receiver.
+				Variant::Type base_type = base->get_type();
+				Object *base_obj = base_type == Variant::OBJECT ? base->operator Object *() : NULL;
+
 				Variant::CallError err;
-				if (call_ret) {
+				Object *obj = use_inline_caches ? base_obj : NULL;
+				Variant cached_ret;
+				if (obj && _inline_cache_call(_inline_caches_ptr[cacheidx], obj, *methodname, (const Variant **)argptrs, argc, cached_ret, err)) {
+					if (call_ret && err.error == Variant::CallError::CALL_OK) {
+						GET_VARIANT_PTR(ret, argc);
+						*ret = cached_ret;
+					}
+				} else if (call_ret) {
 
 					GET_VARIANT_PTR(ret, argc);
 					base->call_ptr(*methodname, (const Variant **)argptrs, argc, ret, err);
@@ -1085,6 +1834,9 @@ Variant GDScriptFunction::call(GDScriptInstance *p_instance, const Variant **p_a
 
 					base->call_ptr(*methodname, (const Variant **)argptrs, argc, NULL, err);
 				}
+				if (unlikely(sampler && sampler->has_pending())) {
+					sampler->sample_call(base_type, base_obj, *methodname);
+				}
 #ifdef DEBUG_ENABLED
 				if (GDScriptLanguage::get_singleton()->profiling) {
 					function_call_time += OS::get_singleton()->get_ticks_usec() - call_time;
@@ -1133,6 +1885,105 @@ Variant GDScriptFunction::call(GDScriptInstance *p_instance, const Variant **p_a
 			}
 			DISPATCH_OPCODE;
 
+			OPCODE(OPCODE_CALL_PTRCALL_RETURN)
+			OPCODE(OPCODE_CALL_PTRCALL)
+			OPCODE(OPCODE_CALL_METHOD_BIND_RETURN)
+			OPCODE(OPCODE_CALL_METHOD_BIND) {
+
+				CHECK_SPACE(5);
+				int opcode = _code_ptr[ip];
+				bool call_ret = opcode == OPCODE_CALL_METHOD_BIND_RETURN || opcode == OPCODE_CALL_PTRCALL_RETURN;
+#ifdef PTRCALL_ENABLED
+				// The compiler also checked the static argument types against the ptrcall signature.
+				bool ptrcall = opcode == OPCODE_CALL_PTRCALL || opcode == OPCODE_CALL_PTRCALL_RETURN;
+#endif
+
+				int argc = _code_ptr[ip + 1];
+				GET_VARIANT_PTR(base, 2);
+				int nameg = _code_ptr[ip + 3];
+				int methodg = _code_ptr[ip + 4];
+
+				GD_ERR_BREAK(nameg < 0 || nameg >= _global_names_count);
+				GD_ERR_BREAK(methodg < 0 || methodg >= _method_binds_count);
+				const StringName *methodname = &_global_names_ptr[nameg];
+				const MethodBindInfo &mbi = _method_binds_ptr[methodg];
+
+				GD_ERR_BREAK(argc < 0);
+				ip += 5;
+				CHECK_SPACE(argc + 1);
+				Variant **argptrs = call_args;
+
+				for (int i = 0; i < argc; i++) {
+					GET_VARIANT_PTR(v, i);
+					argptrs[i] = v;
+				}
+
+#ifdef DEBUG_ENABLED
+				uint64_t call_time = 0;
+
+				if (GDScriptLanguage::get_singleton()->profiling) {
+					call_time = OS::get_singleton()->get_ticks_usec();
+				}
+
+#endif
+				// The method was resolved from the static type of the receiver. Only use it when
+				// Object::call() would pick the same one: no script method shadows it, and the
+				// actual class, if it is a subclass, didn't bind its own method of that name.
+				// Read before the call, the return value may be stored over the receiver.
+				Variant::Type base_type = base->get_type();
+				Object *obj = base_type == Variant::OBJECT ? base->operator Object *() : NULL;
+				bool direct = obj && !(obj->get_script_instance() && obj->get_script_instance()->has_method(*methodname));
+				if (direct) {
+					StringName obj_class = obj->get_class_name();
+					direct = obj_class == mbi.class_name || ClassDB::get_method(obj_class, *methodname) == mbi.method;
+				}
+
+				Variant::CallError err;
+				if (direct) {
+					OBJ_DEBUG_LOCK_OBJECT(obj)
+					bool called = false;
+#ifdef PTRCALL_ENABLED
+					if (ptrcall) {
+						Variant *dst = NULL;
+						if (call_ret) {
+							GET_VARIANT_PTR(ret, argc);
+							dst = ret;
+						}
+						called = _ptrcall_method(mbi, obj, argptrs, argc, dst);
+					}
+#endif
+					if (called) {
+						err.error = Variant::CallError::CALL_OK;
+					} else {
+						Variant ret = mbi.method->call(obj, (const Variant **)argptrs, argc, err);
+						if (call_ret && err.error == Variant::CallError::CALL_OK) {
+							GET_VARIANT_PTR(dst, argc);
+							*dst = ret;
+						}
+					}
+				} else if (call_ret) {
+					GET_VARIANT_PTR(ret, argc);
+					base->call_ptr(*methodname, (const Variant **)argptrs, argc, ret, err);
+				} else {
+					base->call_ptr(*methodname, (const Variant **)argptrs, argc, NULL, err);
+				}
+				if (unlikely(sampler && sampler->has_pending())) {
+					sampler->sample_call(base_type, obj, *methodname);
+				}
+#ifdef DEBUG_ENABLED
+				if (GDScriptLanguage::get_singleton()->profiling) {
+					function_call_time += OS::get_singleton()->get_ticks_usec() - call_time;
+				}
+
+				if (err.error != Variant::CallError::CALL_OK) {
+					err_text = _get_call_error(err, "function '" + String(*methodname) + "' in base '" + _get_var_type(base) + "'", (const Variant **)argptrs);
+					OPCODE_BREAK;
+				}
+#endif
+				ip += argc + 1;
+			}
+			DISPATCH_OPCODE;
+
 			OPCODE(OPCODE_CALL_BUILT_IN) {
 
 				CHECK_SPACE(4);
@@ -1155,6 +2006,9 @@ Variant GDScriptFunction::call(GDScriptInstance *p_instance, const Variant **p_a
 				Variant::CallError err;
 
 				GDScriptFunctions::call(func, (const Variant **)argptrs, argc, *dst, err);
+				if (unlikely(sampler && sampler->has_pending())) {
+					sampler->sample_call("@GDScript", GDScriptFunctions::get_func_name(func));
+				}
 
 #ifdef DEBUG_ENABLED
 				if (err.error != Variant::CallError::CALL_OK) {
@@ -1229,6 +2083,9 @@ Variant GDScriptFunction::call(GDScriptInstance *p_instance, const Variant **p_a
 							err.error = Variant::CallError::CALL_ERROR_INVALID_METHOD;
 						} else {
 							*dst = mb->call(p_instance->owner, (const Variant **)argptrs, argc, err);
+							if (unlikely(sampler && sampler->has_pending())) {
+								sampler->sample_call(gds->native->get_name(), *methodname);
+							}
 						}
 					} else {
 						err.error = Variant::CallError::CALL_OK;
@@ -1269,22 +2126,39 @@ Variant GDScriptFunction::call(GDScriptInstance *p_instance, const Variant **p_a
 					CHECK_SPACE(2);
 				}
 
+				if (_code_ptr[ip] == OPCODE_AWAIT) {
+					// Awaiting a function state that already completed would never resume,
+					// so continue right away with its result instead of yielding.
+					GET_VARIANT_PTR(argobj, 1);
+					GDScriptFunctionState *awaited = Object::cast_to<GDScriptFunctionState>(argobj->operator Object *());
+					if (awaited && awaited->completed) {
+						GD_ERR_BREAK(_code_ptr[ip + 2] != OPCODE_YIELD_RESUME);
+						GET_VARIANT_PTR(result, 3);
+						*result = awaited->completed_result;
+						ip += 4;
+						DISPATCH_OPCODE;
+					}
+				}
+
 				Ref<GDScriptFunctionState> gdfs = memnew(GDScriptFunctionState);
 				gdfs->function = this;
 
-				gdfs->state.stack.resize(alloca_size);
-				//copy variant stack
+				gdfs->state.stack = GDScriptLanguage::get_singleton()->alloc_frame(alloca_size, gdfs->state.stack_capacity);
+				Variant *state_stack = (Variant *)gdfs->state.stack;
+				//move variant stack, the function is exiting so the values don't need to be copied
 				for (int i = 0; i < _stack_size; i++) {
-					Variant var = stack[i];
 					if (stack[i].get_type() == Variant::OBJECT) {
-						Object *obj = Object::cast_to<Object>((Object*)var);
+						Variant var = stack[i];
+						Object *obj = Object::cast_to<Object>((Object *)var);
 						if (obj != NULL) {
 							gdfs->state.keeper.append(stack[i]);
 							var = obj;
-
 						}
+						memnew_placement(&state_stack[i], Variant(var));
+					} else {
+						memcpy((void *)&state_stack[i], (const void *)&stack[i], sizeof(Variant));
+						memnew_placement(&stack[i], Variant);
 					}
-					memnew_placement(&gdfs->state.stack.write[sizeof(Variant) * i], Variant(var));
 				}
 				gdfs->state.stack_size = _stack_size;
 				gdfs->state.self = self;
@@ -1418,6 +2292,9 @@ Variant GDScriptFunction::call(GDScriptInstance *p_instance, const Variant **p_a
 				int to = _code_ptr[ip + 1];
 
 				GD_ERR_BREAK(to < 0 || to > _code_size);
+				if (unlikely(sampler && to < ip && sampler->has_pending())) {
+					sampler->sample();
+				}
 				ip = to;
 			}
 			DISPATCH_OPCODE;
@@ -1482,28 +2359,40 @@ Variant GDScriptFunction::call(GDScriptInstance *p_instance, const Variant **p_a
 
 				GET_VARIANT_PTR(counter, 1);
 				GET_VARIANT_PTR(container, 2);
-
-				bool valid;
-				if (!container->iter_init(*counter, valid)) {
+				GET_VARIANT_PTR(iterator, 4);
+
+				bool has_next;
+				int pool_step = _pool_array_iterate(container, 0, iterator);
+				if (pool_step >= 0) {
+					has_next = pool_step > 0;
+					if (has_next) {
+						*counter = 0;
+					}
+				} else {
+					bool valid;
+					has_next = container->iter_init(*counter, valid);
 #ifdef DEBUG_ENABLED
-					if (!valid) {
+					if (!has_next && !valid) {
 						err_text = "Unable to iterate on object of type '" + Variant::get_type_name(container->get_type()) + "'.";
 						OPCODE_BREAK;
 					}
 #endif
+					if (has_next) {
+						*iterator = container->iter_get(*counter, valid);
+#ifdef DEBUG_ENABLED
+						if (!valid) {
+							err_text = "Unable to obtain iterator object of type '" + Variant::get_type_name(container->get_type()) + "'.";
+							OPCODE_BREAK;
+						}
+#endif
+					}
+				}
+
+				if (!has_next) {
 					int jumpto = _code_ptr[ip + 3];
 					GD_ERR_BREAK(jumpto < 0 || jumpto > _code_size);
 					ip = jumpto;
 				} else {
-					GET_VARIANT_PTR(iterator, 4);
-
-					*iterator = container->iter_get(*counter, valid);
-#ifdef DEBUG_ENABLED
-					if (!valid) {
-						err_text = "Unable to obtain iterator object of type '" + Variant::get_type_name(container->get_type()) + "'.";
-						OPCODE_BREAK;
-					}
-#endif
 					ip += 5; //skip regular iterate which is always next
 				}
 			}
@@ -1515,28 +2404,45 @@ Variant GDScriptFunction::call(GDScriptInstance *p_instance, const Variant **p_a
 
 				GET_VARIANT_PTR(counter, 1);
 				GET_VARIANT_PTR(container, 2);
-
-				bool valid;
-				if (!container->iter_next(*counter, valid)) {
+				GET_VARIANT_PTR(iterator, 4);
+
+				bool has_next;
+				int pool_step = -1;
+				int64_t pool_index = 0;
+				if (counter->get_type() == Variant::INT) {
+					pool_index = int64_t(*counter) + 1;
+					pool_step = _pool_array_iterate(container, pool_index, iterator);
+				}
+				if (pool_step >= 0) {
+					has_next = pool_step > 0;
+					if (has_next) {
+						*counter = pool_index;
+					}
+				} else {
+					bool valid;
+					has_next = container->iter_next(*counter, valid);
 #ifdef DEBUG_ENABLED
-					if (!valid) {
+					if (!has_next && !valid) {
 						err_text = "Unable to iterate on object of type '" + Variant::get_type_name(container->get_type()) + "' (type changed since first iteration?).";
 						OPCODE_BREAK;
 					}
 #endif
+					if (has_next) {
+						*iterator = container->iter_get(*counter, valid);
+#ifdef DEBUG_ENABLED
+						if (!valid) {
+							err_text = "Unable to obtain iterator object of type '" + Variant::get_type_name(container->get_type()) + "' (but was obtained on first iteration?).";
+							OPCODE_BREAK;
+						}
+#endif
+					}
+				}
+
+				if (!has_next) {
 					int jumpto = _code_ptr[ip + 3];
 					GD_ERR_BREAK(jumpto < 0 || jumpto > _code_size);
 					ip = jumpto;
 				} else {
-					GET_VARIANT_PTR(iterator, 4);
-
-					*iterator = container->iter_get(*counter, valid);
-#ifdef DEBUG_ENABLED
-					if (!valid) {
-						err_text = "Unable to obtain iterator object of type '" + Variant::get_type_name(container->get_type()) + "' (but was obtained on first iteration?).";
-						OPCODE_BREAK;
-					}
-#endif
 					ip += 5; //loop again
 				}
 			}
@@ -1655,6 +2561,11 @@ Variant GDScriptFunction::call(GDScriptInstance *p_instance, const Variant **p_a
 	}
 
 	OPCODES_OUT
+
+	if (sampler) {
+		sampler->exit_function();
+	}
+
 #ifdef DEBUG_ENABLED
 	if (GDScriptLanguage::get_singleton()->profiling) {
 		uint64_t time_taken = OS::get_singleton()->get_ticks_usec() - function_start_time;
@@ -1687,8 +2598,21 @@ Variant GDScriptFunction::call(GDScriptInstance *p_instance, const Variant **p_a
 	return retvalue;
 }
 
+void GDScriptFunction::_materialize() {
+
+	MutexLock lock(GDScriptLanguage::get_singleton()->lock);
+	if (lazy_pending.is_set()) { // Another thread may have decoded it meanwhile.
+		GDScriptCompiledCache::materialize_function(this);
+		// Release order, so threads that see the flag cleared also see the decoded code and tables.
+		lazy_pending.clear();
+	}
+}
+
 const int *GDScriptFunction::get_code() const {
 
+	if (lazy_pending.is_set()) {
+		const_cast<GDScriptFunction *>(this)->_materialize();
+	}
 	return _code_ptr;
 }
 int GDScriptFunction::get_code_size() const {
@@ -1708,6 +2632,12 @@ StringName GDScriptFunction::get_global_name(int p_idx) const {
 	return global_names[p_idx];
 }
 
+MethodBind *GDScriptFunction::get_method_bind(int p_idx) const {
+
+	ERR_FAIL_INDEX_V(p_idx, method_binds.size(), NULL);
+	return method_binds[p_idx].method;
+}
+
 int GDScriptFunction::get_default_argument_count() const {
 
 	return _default_arg_count;
@@ -1812,6 +2742,10 @@ GDScriptFunction::GDScriptFunction() :
 
 	_stack_size = 0;
 	_call_size = 0;
+	_method_binds_ptr = NULL;
+	_method_binds_count = 0;
+	_inline_caches_ptr = NULL;
+	_inline_caches_count = 0;
 	rpc_mode = MultiplayerAPI::RPC_MODE_DISABLED;
 	name = "<anonymous>";
 #ifdef DEBUG_ENABLED
@@ -1835,6 +2769,9 @@ GDScriptFunction::GDScriptFunction() :
 }
 
 GDScriptFunction::~GDScriptFunction() {
+	if (GDScriptLanguage::get_singleton()) {
+		GDScriptLanguage::get_singleton()->function_free_count.increment();
+	}
 #ifdef DEBUG_ENABLED
 	GDScriptLanguage::get_singleton()->lock.lock();
 	GDScriptLanguage::get_singleton()->function_list.remove(&function_list);
@@ -1947,12 +2884,14 @@ Variant GDScriptFunctionState::resume(const Variant &p_arg) {
 	function = NULL; //cleaned up;
 	state.result = Variant();
 
+	// Signal handlers may drop the last reference to this state, keep it alive until the frame is released.
+	Ref<GDScriptFunctionState> self_ref(this);
+
 	if (completed) {
-		if (first_state.is_valid()) {
-			first_state->emit_signal("completed", ret);
-		} else {
-			emit_signal("completed", ret);
-		}
+		GDScriptFunctionState *emitter = first_state.is_valid() ? first_state.ptr() : this;
+		emitter->completed = true;
+		emitter->completed_result = ret;
+		emitter->emit_signal("completed", ret);
 
 #ifdef DEBUG_ENABLED
 		if (ScriptDebugger::get_singleton())
@@ -1960,19 +2899,39 @@ Variant GDScriptFunctionState::resume(const Variant &p_arg) {
 #endif
 	}
 
+	// The frame is not used anymore, either the function ended or its stack
+	// was moved to a new state when yielding again.
+	_clear_stack();
+	_release_frame();
+
 	return ret;
 }
 
 void GDScriptFunctionState::_clear_stack() {
 
 	if (state.stack_size) {
-		Variant *stack = (Variant *)state.stack.ptr();
+		Variant *stack = (Variant *)state.stack;
 		for (int i = 0; i < state.stack_size; i++)
 			stack[i].~Variant();
 		state.stack_size = 0;
 	}
 }
 
+void GDScriptFunctionState::_release_frame() {
+
+	if (!state.stack) {
+		return;
+	}
+
+	if (GDScriptLanguage::singleton) {
+		GDScriptLanguage::singleton->free_frame(state.stack, state.stack_capacity);
+	} else {
+		memfree(state.stack);
+	}
+	state.stack = NULL;
+	state.stack_capacity = 0;
+}
+
 void GDScriptFunctionState::_clear_connections() {
 	List<Object::Connection> connections;
 	get_signals_connected_to_this(&connections);
@@ -1996,11 +2955,16 @@ GDScriptFunctionState::GDScriptFunctionState() :
 		instances_list(this) {
 
 	function = NULL;
+	completed = false;
+	state.stack = NULL;
+	state.stack_capacity = 0;
+	state.stack_size = 0;
 }
 
 GDScriptFunctionState::~GDScriptFunctionState() {
 
 	_clear_stack();
+	_release_frame();
 
 	if (GDScriptLanguage::singleton == NULL) {
 		// If GDScriptLanguage::singleton == NULL, it means that the GDScriptLanguage singleton has already been deleted,
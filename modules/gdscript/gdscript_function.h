@@ -34,6 +34,7 @@
 #include "core/os/thread.h"
 #include "core/pair.h"
 #include "core/reference.h"
+#include "core/safe_refcount.h"
 #include "core/script_language.h"
 #include "core/self_list.h"
 #include "core/string_name.h"
@@ -158,12 +159,16 @@ class GDScriptFunction {
 public:
 	enum Opcode {
 		OPCODE_OPERATOR,
+		OPCODE_OPERATOR_INT,
+		OPCODE_OPERATOR_REAL,
 		OPCODE_EXTENDS_TEST,
 		OPCODE_IS_BUILTIN,
 		OPCODE_SET,
 		OPCODE_GET,
 		OPCODE_SET_NAMED,
 		OPCODE_GET_NAMED,
+		OPCODE_SET_NAMED_VECTOR,
+		OPCODE_GET_NAMED_VECTOR,
 		OPCODE_SET_MEMBER,
 		OPCODE_GET_MEMBER,
 		OPCODE_ASSIGN,
@@ -180,6 +185,10 @@ public:
 		OPCODE_CONSTRUCT_DICTIONARY,
 		OPCODE_CALL,
 		OPCODE_CALL_RETURN,
+		OPCODE_CALL_METHOD_BIND,
+		OPCODE_CALL_METHOD_BIND_RETURN,
+		OPCODE_CALL_PTRCALL,
+		OPCODE_CALL_PTRCALL_RETURN,
 		OPCODE_CALL_BUILT_IN,
 		OPCODE_CALL_SELF,
 		OPCODE_CALL_SELF_BASE,
@@ -224,8 +233,92 @@ public:
 		StringName identifier;
 	};
 
+	enum {
+		MAX_PTRCALL_ARGS = 8
+	};
+
+	// How a value is passed to or returned from MethodBind::ptrcall().
+	struct PtrcallArg {
+
+		enum Kind {
+			KIND_NONE, // No value (void return).
+			KIND_VARIANT, // A Variant, passed as is.
+			KIND_BUILTIN, // Laid out as inside a Variant of the given type.
+			KIND_ENUM, // An int passed as 32 bits.
+			KIND_OBJECT, // An Object pointer, class_ptr is its required class.
+			KIND_REFERENCE, // A Ref<T>, class_ptr is the required class.
+		};
+
+		Kind kind;
+		Variant::Type type;
+		void *class_ptr;
+	};
+
+	// Native method resolved at compile time for a statically typed receiver.
+	struct MethodBindInfo {
+
+		MethodBind *method;
+		StringName class_name; // Static type of the receiver the method was resolved from.
+		void *class_ptr;
+		// Signature for OPCODE_CALL_PTRCALL, -1 when the method can't be ptrcalled.
+		int ptrcall_argc;
+		PtrcallArg ptrcall_return;
+		PtrcallArg ptrcall_args[MAX_PTRCALL_ARGS];
+	};
+
+	// How one receiver shape of a GET_NAMED, SET_NAMED or CALL site was resolved.
+	// A shape is the receiver's native class and script.
+	struct InlineCacheEntry {
+
+		enum Kind {
+			KIND_NONE, // Receiver shape seen, but it can't be cached.
+			KIND_MEMBER, // Script member variable without setget.
+			KIND_PROPERTY, // Native property with a bound getter or setter.
+			KIND_FUNCTION, // Script function.
+			KIND_METHOD, // Native method.
+		};
+
+		Kind kind;
+		GDScript *script;
+		StringName native_class;
+		int index; // Member index, or property index for indexed native properties.
+		Variant::Type member_type; // NIL when the member accepts any type.
+		GDScriptFunction *function;
+		MethodBind *method;
+
+		InlineCacheEntry() :
+				kind(KIND_NONE),
+				script(NULL),
+				index(-1),
+				member_type(Variant::NIL),
+				function(NULL),
+				method(NULL) {}
+	};
+
+	// Remembers the first few receiver shapes seen at a site. Sites that see more shapes
+	// than fit are megamorphic and use the generic path. Entries are dropped when a script
+	// was reloaded or freed since they were filled (see GDScriptLanguage::inline_cache_epoch).
+	struct InlineCache {
+
+		enum {
+			MAX_ENTRIES = 4
+		};
+
+		InlineCacheEntry entries[MAX_ENTRIES];
+		uint32_t epoch;
+		int count;
+		bool megamorphic;
+
+		InlineCache() :
+				epoch(0),
+				count(0),
+				megamorphic(false) {}
+	};
+
 private:
 	friend class GDScriptCompiler;
+	friend class GDScriptCompiledCache;
+	friend class GDScriptSampler;
 
 	StringName source;
 
@@ -234,6 +327,10 @@ private:
 	int _constant_count;
 	const StringName *_global_names_ptr;
 	int _global_names_count;
+	const MethodBindInfo *_method_binds_ptr;
+	int _method_binds_count;
+	InlineCache *_inline_caches_ptr;
+	int _inline_caches_count;
 #ifdef TOOLS_ENABLED
 	const StringName *_named_globals_ptr;
 	int _named_globals_count;
@@ -254,6 +351,8 @@ private:
 	StringName name;
 	Vector<Variant> constants;
 	Vector<StringName> global_names;
+	Vector<MethodBindInfo> method_binds;
+	Vector<InlineCache> inline_caches;
 #ifdef TOOLS_ENABLED
 	Vector<StringName> named_globals;
 #endif
@@ -268,9 +367,36 @@ private:
 
 	List<StackDebug> stack_debug;
 
+	// Body of a function loaded from a compiled cache, decoded on first use (see GDScriptCompiledCache).
+	// Only touched with the language lock held, other threads check lazy_pending instead.
+	struct LazyBody {
+
+		Vector<uint8_t> buffer;
+		Vector<Variant> references;
+		Vector<int> globals;
+		Vector<MethodBindInfo> methods;
+		int offset;
+
+		LazyBody() :
+				offset(-1) {}
+	} lazy_body;
+	SafeFlag lazy_pending; // Cleared once the decoded body is published.
+
+	void _materialize();
+
 	_FORCE_INLINE_ Variant *_get_variant(int p_address, GDScriptInstance *p_instance, GDScript *p_script, Variant &self, Variant &static_ref, Variant *p_stack, String &r_error) const;
 	_FORCE_INLINE_ String _get_call_error(const Variant::CallError &p_err, const String &p_where, const Variant **argptrs) const;
 
+	static GDScriptInstance *_get_cacheable_instance(Object *p_object, bool &r_cacheable);
+	typedef void (*InlineCacheFillFunc)(InlineCacheEntry &r_entry, Object *p_object, GDScriptInstance *p_instance, const StringName &p_name);
+	static void _inline_cache_fill_get(InlineCacheEntry &r_entry, Object *p_object, GDScriptInstance *p_instance, const StringName &p_name);
+	static void _inline_cache_fill_set(InlineCacheEntry &r_entry, Object *p_object, GDScriptInstance *p_instance, const StringName &p_name);
+	static void _inline_cache_fill_call(InlineCacheEntry &r_entry, Object *p_object, GDScriptInstance *p_instance, const StringName &p_name);
+	static const InlineCacheEntry *_inline_cache_lookup(InlineCache &r_cache, Object *p_object, const StringName &p_name, InlineCacheFillFunc p_fill, GDScriptInstance *&r_instance);
+	static bool _inline_cache_get(InlineCache &r_cache, Object *p_object, const StringName &p_name, Variant &r_ret);
+	static bool _inline_cache_set(InlineCache &r_cache, Object *p_object, const StringName &p_name, const Variant &p_value, bool &r_valid);
+	static bool _inline_cache_call(InlineCache &r_cache, Object *p_object, const StringName &p_name, const Variant **p_args, int p_argcount, Variant &r_ret, Variant::CallError &r_err);
+
 	friend class GDScriptLanguage;
 
 	SelfList<GDScriptFunction> function_list;
@@ -303,7 +429,8 @@ public:
 		String script_path;
 #endif
 		Array keeper;
-		Vector<uint8_t> stack;
+		uint8_t *stack; // Frame from GDScriptLanguage::alloc_frame(), holds the Variant stack followed by call arguments.
+		uint32_t stack_capacity;
 		int stack_size;
 		Variant self;
 		uint32_t alloca_size;
@@ -319,6 +446,7 @@ public:
 	int get_code_size() const;
 	Variant get_constant(int p_idx) const;
 	StringName get_global_name(int p_idx) const;
+	MethodBind *get_method_bind(int p_idx) const;
 	StringName get_name() const;
 	int get_max_stack_size() const;
 	int get_default_argument_count() const;
@@ -362,6 +490,9 @@ class GDScriptFunctionState : public Reference {
 	Variant _signal_callback(const Variant **p_args, int p_argcount, Variant::CallError &r_error);
 	Ref<GDScriptFunctionState> first_state;
 
+	bool completed;
+	Variant completed_result;
+
 	SelfList<GDScriptFunctionState> scripts_list;
 	SelfList<GDScriptFunctionState> instances_list;
 
@@ -373,6 +504,7 @@ public:
 	Variant resume(const Variant &p_arg = Variant());
 
 	void _clear_stack();
+	void _release_frame();
 	void _clear_connections();
 
 	GDScriptFunctionState();
@@ -40,10 +40,24 @@
 #include "core/script_language.h"
 #include "gdscript.h"
 
+void *GDScriptParser::_alloc_node_memory(uint32_t p_size) {
+
+	p_size = (p_size + PAD_ALIGN - 1) & ~uint32_t(PAD_ALIGN - 1);
+
+	if (node_blocks.size() == 0 || node_block_used + p_size > NODE_BLOCK_SIZE) {
+		node_blocks.push_back((uint8_t *)memalloc(MAX(p_size, (uint32_t)NODE_BLOCK_SIZE)));
+		node_block_used = 0;
+	}
+
+	void *memory = node_blocks[node_blocks.size() - 1] + node_block_used;
+	node_block_used += p_size;
+	return memory;
+}
+
 template <class T>
 T *GDScriptParser::alloc_node() {
 
-	T *t = memnew(T);
+	T *t = memnew_placement(_alloc_node_memory(sizeof(T)), T);
 
 	t->next = list;
 	list = t;
@@ -8890,8 +8904,14 @@ void GDScriptParser::clear() {
 
 		Node *l = list;
 		list = list->next;
-		memdelete(l);
+		l->~Node();
+	}
+
+	for (uint32_t i = 0; i < node_blocks.size(); i++) {
+		memfree(node_blocks[i]);
 	}
+	node_blocks.clear();
+	node_block_used = 0;
 
 	head = NULL;
 	list = NULL;
@@ -8982,6 +9002,7 @@ GDScriptParser::GDScriptParser() {
 
 	head = NULL;
 	list = NULL;
+	node_block_used = 0;
 	tokenizer = NULL;
 	pending_newline = -1;
 	clear();
@@ -31,6 +31,7 @@
 #ifndef GDSCRIPT_PARSER_H
 #define GDSCRIPT_PARSER_H
 
+#include "core/local_vector.h"
 #include "core/map.h"
 #include "core/object.h"
 #include "core/script_language.h"
@@ -535,6 +536,16 @@ private:
 	template <class T>
 	T *alloc_node();
 
+	// Nodes are constructed in place inside large blocks owned by the parser,
+	// so building a tree costs a handful of allocations and clear() releases
+	// all of them at once after running the node destructors.
+	enum {
+		NODE_BLOCK_SIZE = 64 * 1024
+	};
+	LocalVector<uint8_t *> node_blocks;
+	uint32_t node_block_used;
+	void *_alloc_node_memory(uint32_t p_size);
+
 	bool validating;
 	bool for_completion;
 	int parenthesis;
@@ -0,0 +1,284 @@
+/*************************************************************************/
+/*  gdscript_preloader.cpp                                               */
+/*************************************************************************/
+/*                       This file is part of:                           */
+/*                           GODOT ENGINE                                */
+/*                      https://godotengine.org                          */
+/*************************************************************************/
+/* Copyright (c) 2007-2021 Juan Linietsky, Ariel Manzur.                 */
+/* Copyright (c) 2014-2021 Godot Engine contributors (cf. AUTHORS.md).   */
+/*                                                                       */
+/* Permission is hereby granted, free of charge, to any person obtaining */
+/* a copy of this software and associated documentation files (the       */
+/* "Software"), to deal in the Software without restriction, including   */
+/* without limitation the rights to use, copy, modify, merge, publish,   */
+/* distribute, sublicense, and/or sell copies of the Software, and to    */
+/* permit persons to whom the Software is furnished to do so, subject to */
+/* the following conditions:                                             */
+/*                                                                       */
+/* The above copyright notice and this permission notice shall be        */
+/* included in all copies or substantial portions of the Software.       */
+/*                                                                       */
+/* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,       */
+/* EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF    */
+/* MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.*/
+/* IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY  */
+/* CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,  */
+/* TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE     */
+/* SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.                */
+/*************************************************************************/
+
+#include "gdscript_preloader.h"
+
+#include "core/io/resource_loader.h"
+#include "core/os/file_access.h"
+#include "core/os/os.h"
+#include "core/os/threaded_array_processor.h"
+#include "core/script_language.h"
+#include "gdscript_compiled_cache.h"
+#include "gdscript_tokenizer.h"
+
+int GDScriptPreloader::_add(const String &p_path) {
+
+	Map<String, int>::Element *E = entry_map.find(p_path);
+	if (E) {
+		return E->get();
+	}
+
+	int idx = entries.size();
+	entries.push_back(Entry());
+	entries[idx].path = p_path;
+	entry_map[p_path] = idx;
+	return idx;
+}
+
+void GDScriptPreloader::_add_resource_scripts(const String &p_path, Set<String> &r_visited) {
+
+	if (r_visited.has(p_path)) {
+		return;
+	}
+	r_visited.insert(p_path);
+
+	List<String> dependencies;
+	ResourceLoader::get_dependencies(p_path, &dependencies);
+	for (List<String>::Element *E = dependencies.front(); E; E = E->next()) {
+		String path = E->get().get_slice("::", 0);
+		if (path.get_extension() == "gd") {
+			_add(path);
+		} else {
+			_add_resource_scripts(path, r_visited);
+		}
+	}
+}
+
+void GDScriptPreloader::_mark_serial(int p_entry) {
+
+	if (entries[p_entry].serial) {
+		return;
+	}
+	entries[p_entry].serial = true;
+
+	for (int i = 0; i < entries[p_entry].dependents.size(); i++) {
+		_mark_serial(entries[p_entry].dependents[i]);
+	}
+}
+
+void GDScriptPreloader::_scan_script(uint32_t p_index, void *p_userdata) {
+
+	Entry &e = entries[batch[p_index]];
+
+	GDScriptTokenizerText text;
+	GDScriptTokenizerBuffer buffer;
+	GDScriptTokenizer *tokenizer = NULL;
+
+	String path = ResourceLoader::path_remap(e.path);
+	if (path.ends_with(".gd")) {
+		FileAccessRef file = FileAccess::open(path, FileAccess::READ);
+		if (file) {
+			text.set_code(file->get_as_utf8_string());
+			tokenizer = &text;
+		}
+	} else if (path.ends_with(".gdc")) {
+		Vector<uint8_t> tokens = FileAccess::get_file_as_array(path);
+		if (GDScriptCompiledCache::is_cache(tokens)) {
+			tokens = GDScriptCompiledCache::get_tokens(tokens);
+		}
+		if (!tokens.empty() && buffer.set_code_buffer(tokens) == OK) {
+			tokenizer = &buffer;
+		}
+	}
+
+	if (!tokenizer) {
+		// Encrypted or unreadable, leave it to the regular loader.
+		e.serial = true;
+		return;
+	}
+
+	// Resolved the same way GDScriptParser does.
+	String base_dir = e.path.get_base_dir();
+
+	while (true) {
+		String dependency;
+
+		switch (tokenizer->get_token()) {
+			case GDScriptTokenizer::TK_EOF: {
+				return;
+			} break;
+			case GDScriptTokenizer::TK_ERROR: {
+				e.serial = true; // Report the error from the calling thread.
+				return;
+			} break;
+			case GDScriptTokenizer::TK_PR_PRELOAD: {
+				if (tokenizer->get_token(1) == GDScriptTokenizer::TK_PARENTHESIS_OPEN && tokenizer->get_token(2) == GDScriptTokenizer::TK_CONSTANT && tokenizer->get_token_constant(2).get_type() == Variant::STRING) {
+					dependency = tokenizer->get_token_constant(2);
+				}
+			} break;
+			case GDScriptTokenizer::TK_PR_EXTENDS: {
+				if (tokenizer->get_token(1) == GDScriptTokenizer::TK_CONSTANT && tokenizer->get_token_constant(1).get_type() == Variant::STRING) {
+					dependency = tokenizer->get_token_constant(1);
+				}
+			} break;
+			case GDScriptTokenizer::TK_IDENTIFIER: {
+				StringName identifier = tokenizer->get_token_identifier();
+				if (ScriptServer::is_global_class(identifier)) {
+					dependency = ScriptServer::get_global_class_path(identifier);
+				}
+			} break;
+			default: {
+			}
+		}
+
+		if (dependency != String()) {
+			if (!dependency.is_abs_path() && base_dir != "") {
+				dependency = base_dir.plus_file(dependency);
+			}
+			dependency = dependency.replace("///", "//").simplify_path();
+			if (dependency != e.path && e.dependency_paths.find(dependency) == -1) {
+				e.dependency_paths.push_back(dependency);
+			}
+		}
+
+		tokenizer->advance();
+	}
+}
+
+void GDScriptPreloader::_load_script(uint32_t p_index, void *p_userdata) {
+
+	Entry &e = entries[batch[p_index]];
+
+	uint64_t begin = OS::get_singleton()->get_ticks_usec();
+	e.resource = ResourceLoader::load(e.path, "Script");
+	e.usec = OS::get_singleton()->get_ticks_usec() - begin;
+}
+
+void GDScriptPreloader::add_path(const String &p_path) {
+
+	if (p_path.get_extension() == "gd") {
+		_add(p_path);
+	} else {
+		Set<String> visited;
+		_add_resource_scripts(p_path, visited);
+	}
+}
+
+void GDScriptPreloader::load(List<RES> *r_loaded, List<Timing> *r_timings) {
+
+	// Scan newly found scripts until the set is closed over its dependencies.
+	while (true) {
+		batch.clear();
+		for (uint32_t i = 0; i < entries.size(); i++) {
+			if (!entries[i].scanned) {
+				batch.push_back(i);
+			}
+		}
+		if (batch.empty()) {
+			break;
+		}
+
+		thread_process_array(batch.size(), this, &GDScriptPreloader::_scan_script, (void *)NULL);
+
+		for (uint32_t i = 0; i < batch.size(); i++) {
+			int idx = batch[i];
+			entries[idx].scanned = true;
+
+			for (int j = 0; j < entries[idx].dependency_paths.size(); j++) {
+				const String &path = entries[idx].dependency_paths[j];
+				if (path.get_extension() != "gd") {
+					// Scenes and other resources may touch the servers while loading.
+					entries[idx].serial = true;
+					continue;
+				}
+				int dep = _add(path);
+				entries[idx].dependencies.push_back(dep);
+				entries[dep].dependents.push_back(idx);
+			}
+		}
+	}
+
+	for (uint32_t i = 0; i < entries.size(); i++) {
+		entries[i].pending = entries[i].dependencies.size();
+		if (entries[i].serial) {
+			entries[i].serial = false;
+			_mark_serial(i);
+		}
+	}
+
+	batch.clear();
+	for (uint32_t i = 0; i < entries.size(); i++) {
+		if (!entries[i].serial && entries[i].pending == 0) {
+			batch.push_back(i);
+		}
+	}
+
+	int wave = 0;
+	while (!batch.empty()) {
+		thread_process_array(batch.size(), this, &GDScriptPreloader::_load_script, (void *)NULL);
+
+		LocalVector<int> next;
+		for (uint32_t i = 0; i < batch.size(); i++) {
+			Entry &e = entries[batch[i]];
+			e.wave = wave;
+			if (e.resource.is_null()) {
+				// Loading it again would only print the same errors twice. Dependents load on the
+				// calling thread, where their own load of it can still break into the debugger.
+				e.failed = true;
+				_mark_serial(batch[i]);
+				continue;
+			}
+			for (int j = 0; j < e.dependents.size(); j++) {
+				Entry &dependent = entries[e.dependents[j]];
+				dependent.pending--;
+				if (dependent.pending == 0 && !dependent.serial) {
+					next.push_back(e.dependents[j]);
+				}
+			}
+		}
+
+		batch = next;
+		wave++;
+	}
+
+	// Everything left either depends on something that must load here, or is part of a cycle.
+	for (uint32_t i = 0; i < entries.size(); i++) {
+		Entry &e = entries[i];
+		if (e.resource.is_null() && !e.failed) {
+			uint64_t begin = OS::get_singleton()->get_ticks_usec();
+			e.resource = ResourceLoader::load(e.path, "Script");
+			e.usec = OS::get_singleton()->get_ticks_usec() - begin;
+			e.wave = -1;
+		}
+
+		if (e.resource.is_valid() && r_loaded) {
+			r_loaded->push_back(e.resource);
+		}
+
+		if (r_timings) {
+			Timing timing;
+			timing.path = e.path;
+			timing.wave = e.wave;
+			timing.usec = e.usec;
+			timing.loaded = e.resource.is_valid();
+			r_timings->push_back(timing);
+		}
+	}
+}
@@ -0,0 +1,98 @@
+/*************************************************************************/
+/*  gdscript_preloader.h                                                 */
+/*************************************************************************/
+/*                       This file is part of:                           */
+/*                           GODOT ENGINE                                */
+/*                      https://godotengine.org                          */
+/*************************************************************************/
+/* Copyright (c) 2007-2021 Juan Linietsky, Ariel Manzur.                 */
+/* Copyright (c) 2014-2021 Godot Engine contributors (cf. AUTHORS.md).   */
+/*                                                                       */
+/* Permission is hereby granted, free of charge, to any person obtaining */
+/* a copy of this software and associated documentation files (the       */
+/* "Software"), to deal in the Software without restriction, including   */
+/* without limitation the rights to use, copy, modify, merge, publish,   */
+/* distribute, sublicense, and/or sell copies of the Software, and to    */
+/* permit persons to whom the Software is furnished to do so, subject to */
+/* the following conditions:                                             */
+/*                                                                       */
+/* The above copyright notice and this permission notice shall be        */
+/* included in all copies or substantial portions of the Software.       */
+/*                                                                       */
+/* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,       */
+/* EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF    */
+/* MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.*/
+/* IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY  */
+/* CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,  */
+/* TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE     */
+/* SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.                */
+/*************************************************************************/
+
+#ifndef GDSCRIPT_PRELOADER_H
+#define GDSCRIPT_PRELOADER_H
+
+#include "core/local_vector.h"
+#include "core/resource.h"
+
+// Loads a set of scripts, and the scripts they depend on, ahead of time.
+//
+// The dependency graph (preload, extends and global class references) comes
+// from a token scan. Scripts whose dependencies are all loaded are then
+// tokenized, parsed and compiled on worker threads, one wave at a time, and
+// only registration in the resource cache is serialized. Scripts that depend
+// on other kinds of resources, take part in a cycle or depend on a script that
+// failed to load on a worker are loaded afterwards on the calling thread, the
+// regular way. Scripts that failed are not retried, their errors were already
+// reported from the worker.
+class GDScriptPreloader {
+
+public:
+	struct Timing {
+		String path;
+		int wave; // -1 when loaded on the calling thread.
+		uint64_t usec;
+		bool loaded;
+	};
+
+private:
+	struct Entry {
+		String path;
+		Vector<String> dependency_paths;
+		Vector<int> dependencies;
+		Vector<int> dependents;
+		int pending;
+		int wave;
+		bool scanned;
+		bool serial;
+		bool failed;
+		RES resource;
+		uint64_t usec;
+
+		Entry() :
+				pending(0),
+				wave(-1),
+				scanned(false),
+				serial(false),
+				failed(false),
+				usec(0) {}
+	};
+
+	LocalVector<Entry> entries;
+	Map<String, int> entry_map;
+	LocalVector<int> batch;
+
+	int _add(const String &p_path);
+	void _add_resource_scripts(const String &p_path, Set<String> &r_visited);
+	void _mark_serial(int p_entry);
+
+	void _scan_script(uint32_t p_index, void *p_userdata);
+	void _load_script(uint32_t p_index, void *p_userdata);
+
+public:
+	// Scripts are added directly, other resources contribute the scripts they depend on.
+	void add_path(const String &p_path);
+
+	void load(List<RES> *r_loaded, List<Timing> *r_timings = NULL);
+};
+
+#endif // GDSCRIPT_PRELOADER_H
@@ -0,0 +1,191 @@
+/*************************************************************************/
+/*  gdscript_sampler.cpp                                                 */
+/*************************************************************************/
+/*                       This file is part of:                           */
+/*                           GODOT ENGINE                                */
+/*                      https://godotengine.org                          */
+/*************************************************************************/
+/* Copyright (c) 2007-2021 Juan Linietsky, Ariel Manzur.                 */
+/* Copyright (c) 2014-2021 Godot Engine contributors (cf. AUTHORS.md).   */
+/*                                                                       */
+/* Permission is hereby granted, free of charge, to any person obtaining */
+/* a copy of this software and associated documentation files (the       */
+/* "Software"), to deal in the Software without restriction, including   */
+/* without limitation the rights to use, copy, modify, merge, publish,   */
+/* distribute, sublicense, and/or sell copies of the Software, and to    */
+/* permit persons to whom the Software is furnished to do so, subject to */
+/* the following conditions:                                             */
+/*                                                                       */
+/* The above copyright notice and this permission notice shall be        */
+/* included in all copies or substantial portions of the Software.       */
+/*                                                                       */
+/* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,       */
+/* EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF    */
+/* MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.*/
+/* IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY  */
+/* CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,  */
+/* TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE     */
+/* SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.                */
+/*************************************************************************/
+
+#include "gdscript_sampler.h"
+
+#include "core/os/file_access.h"
+#include "core/os/os.h"
+#include "gdscript.h"
+
+GDScriptSampler *GDScriptSampler::singleton = NULL;
+
+void GDScriptSampler::_thread_func(void *p_userdata) {
+
+	GDScriptSampler *sampler = (GDScriptSampler *)p_userdata;
+	while (!sampler->exit_thread.is_set()) {
+		OS::get_singleton()->delay_usec(sampler->interval_usec);
+		sampler->pending.increment();
+	}
+}
+
+uint32_t GDScriptSampler::_get_named_frame(const String &p_name) {
+
+	const uint32_t *frame = named_frames.getptr(p_name);
+	if (frame) {
+		return *frame;
+	}
+
+	uint32_t idx = frame_names.size();
+	frame_names.push_back(p_name);
+	named_frames[p_name] = idx;
+	return idx;
+}
+
+uint32_t GDScriptSampler::_get_function_frame(const GDScriptFunction *p_function) {
+
+	// Functions are cached by address, which can be reused once a function is freed.
+	uint32_t free_count = GDScriptLanguage::get_singleton()->get_function_free_count();
+	if (free_count != function_frames_free_count) {
+		function_frames.clear();
+		function_frames_free_count = free_count;
+	}
+
+	uint64_t key = (uint64_t)(uintptr_t)p_function;
+	const uint32_t *frame = function_frames.getptr(key);
+	if (frame) {
+		return *frame;
+	}
+
+	String name = String(p_function->name) + " (" + String(p_function->source) + ":" + itos(p_function->_initial_line) + ")";
+	uint32_t idx = _get_named_frame(name);
+	function_frames[key] = idx;
+	return idx;
+}
+
+uint32_t GDScriptSampler::_get_child(uint32_t p_parent, uint32_t p_frame) {
+
+	uint64_t key = (uint64_t(p_parent) << 32) | p_frame;
+	const uint32_t *child = children.getptr(key);
+	if (child) {
+		return *child;
+	}
+
+	Node node;
+	node.frame = p_frame;
+	node.parent = p_parent;
+	node.samples = 0;
+	uint32_t idx = nodes.size();
+	nodes.push_back(node);
+	children[key] = idx;
+	return idx;
+}
+
+void GDScriptSampler::_take(uint32_t p_leaf_frame) {
+
+	// Only this thread consumes samples, so no count can be lost between these two calls.
+	uint32_t count = pending.get();
+	pending.sub(count);
+
+	uint32_t node = ROOT_NODE;
+	int stack_depth = MIN(depth, (int)MAX_DEPTH);
+	for (int i = 0; i < stack_depth; i++) {
+		node = _get_child(node, _get_function_frame(stack[i]));
+	}
+	if (p_leaf_frame != NO_FRAME) {
+		node = _get_child(node, p_leaf_frame);
+	}
+
+	nodes[node].samples += count;
+	total_samples += count;
+}
+
+void GDScriptSampler::sample_call(const String &p_type, const StringName &p_method) {
+
+	_take(_get_named_frame(p_type + "." + String(p_method)));
+}
+
+void GDScriptSampler::sample_call(Variant::Type p_base_type, Object *p_base_object, const StringName &p_method) {
+
+	String type = Variant::get_type_name(p_base_type);
+	// The call may have freed it.
+	if (p_base_object && ObjectDB::instance_validate(p_base_object)) {
+		type = p_base_object->get_class();
+	}
+
+	sample_call(type, p_method);
+}
+
+String GDScriptSampler::get_collapsed_stacks() const {
+
+	String result;
+	for (uint32_t i = 0; i < nodes.size(); i++) {
+		if (nodes[i].samples == 0) {
+			continue;
+		}
+
+		String line;
+		for (uint32_t n = i; n != ROOT_NODE; n = nodes[n].parent) {
+			line = line.empty() ? frame_names[nodes[n].frame] : frame_names[nodes[n].frame] + ";" + line;
+		}
+		result += line + " " + itos(nodes[i].samples) + "\n";
+	}
+	return result;
+}
+
+Error GDScriptSampler::save_collapsed_stacks(const String &p_path) const {
+
+	Error err;
+	FileAccessRef file = FileAccess::open(p_path, FileAccess::WRITE, &err);
+	ERR_FAIL_COND_V_MSG(!file, err, "Cannot save GDScript samples to '" + p_path + "'.");
+
+	file->store_string(get_collapsed_stacks());
+	return OK;
+}
+
+GDScriptSampler::GDScriptSampler(uint32_t p_interval_usec) {
+
+	ERR_FAIL_COND_MSG(singleton != NULL, "A GDScript sampler is already running.");
+
+	interval_usec = MAX(p_interval_usec, 100u);
+	depth = 0;
+	function_frames_free_count = GDScriptLanguage::get_singleton()->get_function_free_count();
+	total_samples = 0;
+
+	Node root;
+	root.frame = NO_FRAME;
+	root.parent = ROOT_NODE;
+	root.samples = 0;
+	nodes.push_back(root);
+	engine_frame = _get_named_frame("[engine]");
+
+	singleton = this;
+	thread.start(_thread_func, this);
+}
+
+GDScriptSampler::~GDScriptSampler() {
+
+	if (singleton != this) {
+		return;
+	}
+
+	exit_thread.set();
+	thread.wait_to_finish();
+	singleton = NULL;
+}
@@ -0,0 +1,137 @@
+/*************************************************************************/
+/*  gdscript_sampler.h                                                   */
+/*************************************************************************/
+/*                       This file is part of:                           */
+/*                           GODOT ENGINE                                */
+/*                      https://godotengine.org                          */
+/*************************************************************************/
+/* Copyright (c) 2007-2021 Juan Linietsky, Ariel Manzur.                 */
+/* Copyright (c) 2014-2021 Godot Engine contributors (cf. AUTHORS.md).   */
+/*                                                                       */
+/* Permission is hereby granted, free of charge, to any person obtaining */
+/* a copy of this software and associated documentation files (the       */
+/* "Software"), to deal in the Software without restriction, including   */
+/* without limitation the rights to use, copy, modify, merge, publish,   */
+/* distribute, sublicense, and/or sell copies of the Software, and to    */
+/* permit persons to whom the Software is furnished to do so, subject to */
+/* the following conditions:                                             */
+/*                                                                       */
+/* The above copyright notice and this permission notice shall be        */
+/* included in all copies or substantial portions of the Software.       */
+/*                                                                       */
+/* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,       */
+/* EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF    */
+/* MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.*/
+/* IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY  */
+/* CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,  */
+/* TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE     */
+/* SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.                */
+/*************************************************************************/
+
+#ifndef GDSCRIPT_SAMPLER_H
+#define GDSCRIPT_SAMPLER_H
+
+#include "core/hash_map.h"
+#include "core/local_vector.h"
+#include "core/os/thread.h"
+#include "core/safe_refcount.h"
+#include "core/variant.h"
+
+class GDScriptFunction;
+
+// Sampling profiler for scripts running on the main thread.
+//
+// A timer thread counts pending samples at a fixed interval, and the VM takes
+// them at cheap safepoints: function entry, backward jumps and after native
+// calls. Each sample adds the current script call stack to a call tree, so only
+// sampled frames pay for walking the stack. Native calls get a leaf frame of
+// their own, and samples taken while no script was running are counted under
+// an engine frame. The tree is exported as collapsed stacks, the input format
+// of flamegraph tools.
+//
+// The call stack is tracked separately from the debugger's call stack, which
+// only exists when a debugger is attached, so this also works in release builds.
+class GDScriptSampler {
+
+	enum {
+		MAX_DEPTH = 256,
+		ROOT_NODE = 0,
+	};
+
+	static const uint32_t NO_FRAME = 0xFFFFFFFF;
+
+	struct Node {
+		uint32_t frame;
+		uint32_t parent;
+		uint64_t samples; // Samples where this node was the innermost frame.
+	};
+
+	static GDScriptSampler *singleton;
+
+	SafeNumeric<uint32_t> pending;
+	SafeFlag exit_thread;
+	Thread thread;
+	uint32_t interval_usec;
+
+	const GDScriptFunction *stack[MAX_DEPTH];
+	int depth;
+
+	LocalVector<Node> nodes;
+	HashMap<uint64_t, uint32_t> children; // Parent node and frame to child node.
+	LocalVector<String> frame_names;
+	HashMap<uint64_t, uint32_t> function_frames;
+	HashMap<String, uint32_t> named_frames;
+	uint32_t function_frames_free_count;
+	uint32_t engine_frame;
+	uint64_t total_samples;
+
+	static void _thread_func(void *p_userdata);
+
+	uint32_t _get_named_frame(const String &p_name);
+	uint32_t _get_function_frame(const GDScriptFunction *p_function);
+	uint32_t _get_child(uint32_t p_parent, uint32_t p_frame);
+	void _take(uint32_t p_leaf_frame);
+
+public:
+	_FORCE_INLINE_ static GDScriptSampler *get_singleton() { return singleton; }
+
+	_FORCE_INLINE_ bool has_pending() const { return pending.get() != 0; }
+
+	_FORCE_INLINE_ void enter_function(const GDScriptFunction *p_function) {
+		if (unlikely(has_pending())) {
+			// Samples pending when called from the engine were spent outside of scripts.
+			if (depth == 0) {
+				_take(engine_frame);
+			} else {
+				_take(NO_FRAME);
+			}
+		}
+		if (depth < MAX_DEPTH) {
+			stack[depth] = p_function;
+		}
+		depth++;
+	}
+
+	_FORCE_INLINE_ void exit_function() {
+		if (depth > 0) {
+			depth--;
+		}
+	}
+
+	// Takes pending samples in the innermost script function.
+	void sample() { _take(NO_FRAME); }
+	// Takes pending samples in a native call that just returned.
+	void sample_call(const String &p_type, const StringName &p_method);
+	// Same, with the receiver as it was before the call, as the return value may have been stored over it.
+	void sample_call(Variant::Type p_base_type, Object *p_base_object, const StringName &p_method);
+
+	uint64_t get_total_samples() const { return total_samples; }
+	String get_collapsed_stacks() const;
+	Error save_collapsed_stacks(const String &p_path) const;
+
+	// Starts sampling, only one sampler can be active at a time.
+	GDScriptSampler(uint32_t p_interval_usec);
+	~GDScriptSampler();
+};
+
+#endif // GDSCRIPT_SAMPLER_H
@@ -368,6 +368,111 @@ static bool _is_text_char(CharType c) {
 	return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9') || c == '_';
 }
 
+// Words the tokenizer treats specially (constants, built-in types, built-in
+// functions and keywords) in one open addressing table, so an identifier is
+// resolved with a single lookup on its characters instead of comparing it
+// against each list in turn.
+class _ReservedWords {
+
+public:
+	enum Kind {
+		KIND_CONSTANT,
+		KIND_TYPE,
+		KIND_BUILT_IN_FUNC,
+		KIND_KEYWORD,
+	};
+
+	struct Word {
+		const char *text;
+		int length;
+		uint32_t hash;
+		Kind kind;
+		int value;
+	};
+
+private:
+	enum {
+		TABLE_SIZE = 512, // Power of two, well above twice the word count.
+		TABLE_MASK = TABLE_SIZE - 1,
+	};
+
+	Word table[TABLE_SIZE];
+
+	static bool _matches(const Word &p_word, const CharType *p_chars, int p_len) {
+
+		if (p_word.length != p_len) {
+			return false;
+		}
+		for (int i = 0; i < p_len; i++) {
+			if (CharType(p_word.text[i]) != p_chars[i]) {
+				return false;
+			}
+		}
+		return true;
+	}
+
+	void _add(const char *p_text, Kind p_kind, int p_value) {
+
+		int length = strlen(p_text);
+		uint32_t hash = String::hash(p_text, length);
+		uint32_t pos = hash & TABLE_MASK;
+		while (table[pos].text) {
+			if (table[pos].hash == hash && strcmp(table[pos].text, p_text) == 0) {
+				return; // The first list a word appears in takes precedence.
+			}
+			pos = (pos + 1) & TABLE_MASK;
+		}
+
+		Word &word = table[pos];
+		word.text = p_text;
+		word.length = length;
+		word.hash = hash;
+		word.kind = p_kind;
+		word.value = p_value;
+	}
+
+public:
+	const Word *find(const CharType *p_chars, int p_len, uint32_t p_hash) const {
+
+		uint32_t pos = p_hash & TABLE_MASK;
+		while (table[pos].text) {
+			if (table[pos].hash == p_hash && _matches(table[pos], p_chars, p_len)) {
+				return &table[pos];
+			}
+			pos = (pos + 1) & TABLE_MASK;
+		}
+		return NULL;
+	}
+
+	_ReservedWords() {
+
+		for (int i = 0; i < TABLE_SIZE; i++) {
+			table[i].text = NULL;
+		}
+
+		_add("null", KIND_CONSTANT, 0);
+		_add("true", KIND_CONSTANT, 1);
+		_add("false", KIND_CONSTANT, 2);
+
+		for (int i = 0; _type_list[i].text; i++) {
+			_add(_type_list[i].text, KIND_TYPE, _type_list[i].type);
+		}
+		for (int i = 0; i < GDScriptFunctions::FUNC_MAX; i++) {
+			_add(GDScriptFunctions::get_func_name(GDScriptFunctions::Function(i)), KIND_BUILT_IN_FUNC, i);
+		}
+		for (int i = 0; _keyword_list[i].text; i++) {
+			_add(_keyword_list[i].text, KIND_KEYWORD, _keyword_list[i].token);
+		}
+	}
+};
+
+static const _ReservedWords &_get_reserved_words() {
+
+	// Built on first use; tokenizers may run on several threads at once.
+	static const _ReservedWords words;
+	return words;
+}
+
 static bool _is_number(CharType c) {
 
 	return (c >= '0' && c <= '9');
@@ -976,84 +1081,38 @@ void GDScriptTokenizerText::_advance() {
 
 				if (_is_text_char(GETCHAR(0))) {
 					// parse identifier
-					String str;
-					str += CharType(GETCHAR(0));
-
+					const CharType *word = &_code[code_pos];
 					int i = 1;
 					while (_is_text_char(GETCHAR(i))) {
-						str += CharType(GETCHAR(i));
 						i++;
 					}
 
-					bool identifier = false;
-
-					if (str == "null") {
-						_make_constant(Variant());
-
-					} else if (str == "true") {
-						_make_constant(true);
+					uint32_t hash = String::hash(word, i);
+					const _ReservedWords::Word *reserved = _get_reserved_words().find(word, i, hash);
 
-					} else if (str == "false") {
-						_make_constant(false);
+					if (!reserved) {
+						_make_identifier(_intern_identifier(word, i, hash));
 					} else {
-
-						bool found = false;
-
-						{
-
-							int idx = 0;
-
-							while (_type_list[idx].text) {
-
-								if (str == _type_list[idx].text) {
-									_make_type(_type_list[idx].type);
-									found = true;
-									break;
-								}
-								idx++;
-							}
-						}
-
-						if (!found) {
-
-							//built in func?
-
-							for (int j = 0; j < GDScriptFunctions::FUNC_MAX; j++) {
-
-								if (str == GDScriptFunctions::get_func_name(GDScriptFunctions::Function(j))) {
-
-									_make_built_in_func(GDScriptFunctions::Function(j));
-									found = true;
-									break;
+						switch (reserved->kind) {
+							case _ReservedWords::KIND_CONSTANT: {
+								if (reserved->value == 0) {
+									_make_constant(Variant());
+								} else {
+									_make_constant(reserved->value == 1);
 								}
-							}
-						}
-
-						if (!found) {
-							//keyword
-
-							int idx = 0;
-							found = false;
-
-							while (_keyword_list[idx].text) {
-
-								if (str == _keyword_list[idx].text) {
-									_make_token(_keyword_list[idx].token);
-									found = true;
-									break;
-								}
-								idx++;
-							}
+							} break;
+							case _ReservedWords::KIND_TYPE: {
+								_make_type(Variant::Type(reserved->value));
+							} break;
+							case _ReservedWords::KIND_BUILT_IN_FUNC: {
+								_make_built_in_func(GDScriptFunctions::Function(reserved->value));
+							} break;
+							case _ReservedWords::KIND_KEYWORD: {
+								_make_token(Token(reserved->value));
+							} break;
 						}
-
-						if (!found)
-							identifier = true;
 					}
-
-					if (identifier) {
-						_make_identifier(str);
-					}
-					INCPOS(str.length());
+					INCPOS(i);
 					return;
 				}
 
@@ -1068,8 +1127,26 @@ void GDScriptTokenizerText::_advance() {
 	}
 }
 
+StringName GDScriptTokenizerText::_intern_identifier(const CharType *p_chars, int p_len, uint32_t p_hash) {
+
+	CachedIdentifier *cached = identifier_cache.getptr(p_hash);
+	if (cached) {
+		if (cached->name.length() == p_len && memcmp(cached->name.ptr(), p_chars, p_len * sizeof(CharType)) == 0) {
+			return cached->string_name;
+		}
+		// Hash collision, rare enough to just skip the cache.
+		return StringName(String(p_chars, p_len));
+	}
+
+	CachedIdentifier &identifier = identifier_cache[p_hash];
+	identifier.name = String(p_chars, p_len);
+	identifier.string_name = identifier.name;
+	return identifier.string_name;
+}
+
 void GDScriptTokenizerText::set_code(const String &p_code) {
 
+	identifier_cache.clear();
 	code = p_code;
 	len = p_code.length();
 	if (len) {
@@ -31,6 +31,7 @@
 #ifndef GDSCRIPT_TOKENIZER_H
 #define GDSCRIPT_TOKENIZER_H
 
+#include "core/hash_map.h"
 #include "core/pair.h"
 #include "core/string_name.h"
 #include "core/ustring.h"
@@ -214,6 +215,16 @@ class GDScriptTokenizerText : public GDScriptTokenizer {
 	void _make_type(const Variant::Type &p_type);
 	void _make_error(const String &p_error);
 
+	// Identifiers already seen in this code, keyed by the hash of their
+	// characters, so repeated names skip building a String and looking up
+	// the global StringName table again.
+	struct CachedIdentifier {
+		String name;
+		StringName string_name;
+	};
+	HashMap<uint32_t, CachedIdentifier> identifier_cache;
+	StringName _intern_identifier(const CharType *p_chars, int p_len, uint32_t p_hash);
+
 	String code;
 	int len;
 	int code_pos;
@@ -35,6 +35,7 @@
 #include "core/os/dir_access.h"
 #include "core/os/file_access.h"
 #include "gdscript.h"
+#include "gdscript_compiled_cache.h"
 #include "gdscript_tokenizer.h"
 
 GDScriptLanguage *script_language_gd = NULL;
@@ -83,6 +84,12 @@ public:
 
 		if (!file.empty()) {
 
+			// Ship the compiled code when the script compiles here, the tokens stay inside as a fallback.
+			Vector<uint8_t> compiled;
+			if (GDScriptCompiledCache::save(p_path, txt, file, p_features.has("debug"), compiled) == OK) {
+				file = compiled;
+			}
+
 			if (script_mode == EditorExportPreset::MODE_SCRIPT_ENCRYPTED) {
 
 				String tmp_path = EditorSettings::get_singleton()->get_cache_dir().plus_file("script.gde");
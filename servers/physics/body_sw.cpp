@@ -570,22 +570,26 @@ void BodySW::integrate_forces(real_t p_step) {
 	biased_angular_velocity = Vector3();
 	biased_linear_velocity = Vector3();
 
-	if (do_motion) { //shapes temporarily extend for raycast
-		_update_shapes_with_motion(motion);
-	}
+	motion_pending = do_motion;
+	pending_motion = motion;
 
 	def_area = NULL; // clear the area, so it is set in the next frame
 	contact_count = 0;
 }
 
+void BodySW::finish_integrate_forces() {
+
+	if (motion_pending) { //shapes temporarily extend for raycast
+		_update_shapes_with_motion(pending_motion);
+		motion_pending = false;
+	}
+}
+
 void BodySW::integrate_velocities(real_t p_step) {
 
 	if (mode == PhysicsServer::BODY_MODE_STATIC)
 		return;
 
-	if (fi_callback)
-		get_space()->body_add_to_state_query_list(&direct_state_query_list);
-
 	//apply axis lock linear
 	for (int i = 0; i < 3; i++) {
 		if (is_axis_locked((PhysicsServer::BodyAxis)(1 << i))) {
@@ -606,9 +610,6 @@ void BodySW::integrate_velocities(real_t p_step) {
 
 		_set_transform(new_transform, false);
 		_set_inv_transform(new_transform.affine_inverse());
-		if (contacts.size() == 0 && linear_velocity == Vector3() && angular_velocity == Vector3())
-			set_active(false); //stopped moving, deactivate
-
 		return;
 	}
 
@@ -635,15 +636,28 @@ void BodySW::integrate_velocities(real_t p_step) {
 
 	transform.origin += total_linear_velocity * p_step;
 
-	_set_transform(transform);
+	_set_transform(transform, false);
 	_set_inv_transform(get_transform().inverse());
 
 	_update_transform_dependant();
+}
 
-	/*
-	if (fi_callback) {
+void BodySW::finish_integrate_velocities() {
+
+	if (mode == PhysicsServer::BODY_MODE_STATIC)
+		return;
+
+	if (fi_callback)
 		get_space()->body_add_to_state_query_list(&direct_state_query_list);
-	*/
+
+	if (mode == PhysicsServer::BODY_MODE_KINEMATIC) {
+
+		if (contacts.size() == 0 && linear_velocity == Vector3() && angular_velocity == Vector3())
+			set_active(false); //stopped moving, deactivate
+		return;
+	}
+
+	_update_shapes();
 }
 
 /*
@@ -790,6 +804,7 @@ BodySW::BodySW() :
 	island_list_next = NULL;
 	first_time_kinematic = false;
 	first_integration = false;
+	motion_pending = false;
 	_set_static(false);
 
 	contact_count = 0;
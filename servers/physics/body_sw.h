@@ -88,6 +88,8 @@ class BodySW : public CollisionObjectSW {
 	bool active;
 
 	bool first_integration;
+	bool motion_pending; // integrate_forces() left pending_motion for finish_integrate_forces().
+	Vector3 pending_motion;
 
 	bool continuous_cd;
 	bool can_sleep;
@@ -221,19 +223,30 @@ public:
 		linear_velocity += p_j * _inv_mass;
 	}
 
+	// Static and kinematic bodies take no impulses, so they are skipped before writing
+	// anything. Islands solved on different threads can share such a body.
 	_FORCE_INLINE_ void apply_impulse(const Vector3 &p_pos, const Vector3 &p_j) {
 
+		if (mode <= PhysicsServer::BODY_MODE_KINEMATIC) {
+			return;
+		}
 		linear_velocity += p_j * _inv_mass;
 		angular_velocity += _inv_inertia_tensor.xform((p_pos - center_of_mass).cross(p_j));
 	}
 
 	_FORCE_INLINE_ void apply_torque_impulse(const Vector3 &p_j) {
 
+		if (mode <= PhysicsServer::BODY_MODE_KINEMATIC) {
+			return;
+		}
 		angular_velocity += _inv_inertia_tensor.xform(p_j);
 	}
 
 	_FORCE_INLINE_ void apply_bias_impulse(const Vector3 &p_pos, const Vector3 &p_j, real_t p_max_delta_av = -1.0) {
 
+		if (mode <= PhysicsServer::BODY_MODE_KINEMATIC) {
+			return;
+		}
 		biased_linear_velocity += p_j * _inv_mass;
 		if (p_max_delta_av != 0.0) {
 			Vector3 delta_av = _inv_inertia_tensor.xform((p_pos - center_of_mass).cross(p_j));
@@ -246,6 +259,9 @@ public:
 
 	_FORCE_INLINE_ void apply_bias_torque_impulse(const Vector3 &p_j) {
 
+		if (mode <= PhysicsServer::BODY_MODE_KINEMATIC) {
+			return;
+		}
 		biased_angular_velocity += _inv_inertia_tensor.xform(p_j);
 	}
 
@@ -305,8 +321,13 @@ public:
 	void set_axis_lock(PhysicsServer::BodyAxis p_axis, bool lock);
 	bool is_axis_locked(PhysicsServer::BodyAxis p_axis) const;
 
+	// integrate_forces() and integrate_velocities() only change the body itself, so they can run
+	// for several bodies at once. The matching finish_*() updates the broadphase and the lists of
+	// the space, one body at a time.
 	void integrate_forces(real_t p_step);
+	void finish_integrate_forces();
 	void integrate_velocities(real_t p_step);
+	void finish_integrate_velocities();
 
 	_FORCE_INLINE_ Vector3 get_velocity_in_local_point(const Vector3 &rel_pos) const {
 
@@ -49,6 +49,50 @@ _FORCE_INLINE_ static bool _can_collide_with(CollisionObjectSW *p_object, uint32
 	return true;
 }
 
+// Intersects the segment with one shape of an object, and keeps the hit if it is closer along p_dir than r_min_d.
+_FORCE_INLINE_ static bool _intersect_ray_shape(const CollisionObjectSW *p_col_obj, int p_shape_idx, const Vector3 &p_from, const Vector3 &p_to, const Vector3 &p_dir, real_t &r_min_d, Vector3 &r_point, Vector3 &r_normal) {
+
+	Transform inv_xform = p_col_obj->get_shape_inv_transform(p_shape_idx) * p_col_obj->get_inv_transform();
+
+	Vector3 local_from = inv_xform.xform(p_from);
+	Vector3 local_to = inv_xform.xform(p_to);
+
+	const ShapeSW *shape = p_col_obj->get_shape(p_shape_idx);
+
+	Vector3 shape_point, shape_normal;
+
+	if (!shape->intersect_segment(local_from, local_to, shape_point, shape_normal)) {
+		return false;
+	}
+
+	Transform xform = p_col_obj->get_transform() * p_col_obj->get_shape_transform(p_shape_idx);
+	shape_point = xform.xform(shape_point);
+
+	real_t ld = p_dir.dot(shape_point);
+
+	if (ld >= r_min_d) {
+		return false;
+	}
+
+	r_min_d = ld;
+	r_point = shape_point;
+	r_normal = inv_xform.basis.xform_inv(shape_normal).normalized();
+	return true;
+}
+
+_FORCE_INLINE_ static void _fill_ray_result(const CollisionObjectSW *p_col_obj, int p_shape_idx, const Vector3 &p_point, const Vector3 &p_normal, PhysicsDirectSpaceState::RayResult &r_result) {
+
+	r_result.collider_id = p_col_obj->get_instance_id();
+	if (r_result.collider_id != 0)
+		r_result.collider = ObjectDB::get_instance(r_result.collider_id);
+	else
+		r_result.collider = NULL;
+	r_result.normal = p_normal;
+	r_result.position = p_point;
+	r_result.rid = p_col_obj->get_self();
+	r_result.shape = p_shape_idx;
+}
+
 int PhysicsDirectSpaceStateSW::intersect_point(const Vector3 &p_point, ShapeResult *r_results, int p_result_max, const Set<RID> &p_exclude, uint32_t p_collision_mask, bool p_collide_with_bodies, bool p_collide_with_areas) {
 
 	ERR_FAIL_COND_V(space->locked, false);
@@ -127,48 +171,139 @@ bool PhysicsDirectSpaceStateSW::intersect_ray(const Vector3 &p_from, const Vecto
 		const CollisionObjectSW *col_obj = space->intersection_query_results[i];
 
 		int shape_idx = space->intersection_query_subindex_results[i];
-		Transform inv_xform = col_obj->get_shape_inv_transform(shape_idx) * col_obj->get_inv_transform();
 
-		Vector3 local_from = inv_xform.xform(begin);
-		Vector3 local_to = inv_xform.xform(end);
+		if (_intersect_ray_shape(col_obj, shape_idx, begin, end, normal, min_d, res_point, res_normal)) {
 
-		const ShapeSW *shape = col_obj->get_shape(shape_idx);
+			res_shape = shape_idx;
+			res_obj = col_obj;
+			collided = true;
+		}
+	}
 
-		Vector3 shape_point, shape_normal;
+	if (!collided)
+		return false;
 
-		if (shape->intersect_segment(local_from, local_to, shape_point, shape_normal)) {
+	_fill_ray_result(res_obj, res_shape, res_point, res_normal, r_result);
 
-			Transform xform = col_obj->get_transform() * col_obj->get_shape_transform(shape_idx);
-			shape_point = xform.xform(shape_point);
+	return true;
+}
 
-			real_t ld = normal.dot(shape_point);
+void PhysicsDirectSpaceStateSW::_add_batch_candidates(BatchCandidates &r_candidates, int p_amount, const Set<RID> &p_exclude, uint32_t p_collision_mask, bool p_collide_with_bodies, bool p_collide_with_areas) {
 
-			if (ld < min_d) {
+	for (int i = 0; i < p_amount; i++) {
 
-				min_d = ld;
-				res_point = shape_point;
-				res_normal = inv_xform.basis.xform_inv(shape_normal).normalized();
-				res_shape = shape_idx;
-				res_obj = col_obj;
-				collided = true;
+		CollisionObjectSW *col_obj = r_candidates.cull_results[i];
+
+		if (!_can_collide_with(col_obj, p_collision_mask, p_collide_with_bodies, p_collide_with_areas))
+			continue;
+
+		if (p_exclude.has(col_obj->get_self()))
+			continue;
+
+		r_candidates.objects.push_back(col_obj);
+		r_candidates.shapes.push_back(r_candidates.cull_subindex_results[i]);
+	}
+}
+
+void PhysicsDirectSpaceStateSW::_cull_batch(BatchCandidates &r_candidates, int p_count, const Vector3 *p_ray_points, const Set<RID> &p_exclude, uint32_t p_collision_mask, bool p_collide_with_bodies, bool p_collide_with_areas) {
+
+	// Queries next to each other in the batch (e.g. the rays of one agent) are usually close in space too,
+	// so each chunk of them first tries to use a single cull of their merged bounds. The aabbs must be filled.
+
+	r_candidates.objects.clear();
+	r_candidates.shapes.clear();
+	r_candidates.ranges.resize(p_count * 2);
+	r_candidates.cull_results.resize(SpaceSW::INTERSECTION_QUERY_MAX);
+	r_candidates.cull_subindex_results.resize(SpaceSW::INTERSECTION_QUERY_MAX);
+	CollisionObjectSW **results = r_candidates.cull_results.ptr();
+	int *subindex_results = r_candidates.cull_subindex_results.ptr();
+
+	for (int from = 0; from < p_count; from += BATCH_CHUNK_SIZE) {
+
+		int to = MIN(from + BATCH_CHUNK_SIZE, p_count);
+
+		AABB chunk_aabb = r_candidates.aabbs[from];
+		for (int i = from + 1; i < to; i++) {
+			chunk_aabb.merge_with(r_candidates.aabbs[i]);
+		}
+
+		int amount = space->broadphase->cull_aabb(chunk_aabb, results, SpaceSW::INTERSECTION_QUERY_MAX, subindex_results);
+
+		if (amount <= BATCH_MAX_SHARED_CANDIDATES) {
+
+			uint32_t begin = r_candidates.objects.size();
+			_add_batch_candidates(r_candidates, amount, p_exclude, p_collision_mask, p_collide_with_bodies, p_collide_with_areas);
+			for (int i = from; i < to; i++) {
+				r_candidates.ranges[i * 2 + 0] = begin;
+				r_candidates.ranges[i * 2 + 1] = r_candidates.objects.size();
 			}
+			continue;
+		}
+
+		for (int i = from; i < to; i++) {
+
+			if (p_ray_points) {
+				amount = space->broadphase->cull_segment(p_ray_points[i * 2 + 0], p_ray_points[i * 2 + 1], results, SpaceSW::INTERSECTION_QUERY_MAX, subindex_results);
+			} else {
+				amount = space->broadphase->cull_aabb(r_candidates.aabbs[i], results, SpaceSW::INTERSECTION_QUERY_MAX, subindex_results);
+			}
+
+			r_candidates.ranges[i * 2 + 0] = r_candidates.objects.size();
+			_add_batch_candidates(r_candidates, amount, p_exclude, p_collision_mask, p_collide_with_bodies, p_collide_with_areas);
+			r_candidates.ranges[i * 2 + 1] = r_candidates.objects.size();
 		}
 	}
+}
 
-	if (!collided)
-		return false;
+void PhysicsDirectSpaceStateSW::intersect_rays_batch(const Vector3 *p_points, int p_ray_count, RayResult *r_results, bool *r_hits, const Set<RID> &p_exclude, uint32_t p_collision_mask, bool p_collide_with_bodies, bool p_collide_with_areas) {
 
-	r_result.collider_id = res_obj->get_instance_id();
-	if (r_result.collider_id != 0)
-		r_result.collider = ObjectDB::get_instance(r_result.collider_id);
-	else
-		r_result.collider = NULL;
-	r_result.normal = res_normal;
-	r_result.position = res_point;
-	r_result.rid = res_obj->get_self();
-	r_result.shape = res_shape;
+	ERR_FAIL_COND(space->locked);
 
-	return true;
+	if (p_ray_count <= 0)
+		return;
+
+	BatchCandidates candidates;
+	candidates.aabbs.resize(p_ray_count);
+	for (int i = 0; i < p_ray_count; i++) {
+		candidates.aabbs[i] = AABB(p_points[i * 2 + 0], Vector3());
+		candidates.aabbs[i].expand_to(p_points[i * 2 + 1]);
+	}
+
+	_cull_batch(candidates, p_ray_count, p_points, p_exclude, p_collision_mask, p_collide_with_bodies, p_collide_with_areas);
+
+	// The 3D stepper has no worker pool, so unlike 2D the rays are all tested on the calling thread.
+	for (int i = 0; i < p_ray_count; i++) {
+
+		const Vector3 &from = p_points[i * 2 + 0];
+		const Vector3 &to = p_points[i * 2 + 1];
+		Vector3 dir = (to - from).normalized();
+
+		real_t min_d = 1e10;
+		Vector3 res_point, res_normal;
+		int res_shape = 0;
+		const CollisionObjectSW *res_obj = NULL;
+
+		for (uint32_t j = candidates.ranges[i * 2 + 0]; j < candidates.ranges[i * 2 + 1]; j++) {
+
+			const CollisionObjectSW *col_obj = candidates.objects[j];
+			int shape_idx = candidates.shapes[j];
+
+			// Shared candidates may be anywhere in the chunk.
+			if (!col_obj->get_shape_aabb(shape_idx).intersects_segment(from, to))
+				continue;
+
+			if (_intersect_ray_shape(col_obj, shape_idx, from, to, dir, min_d, res_point, res_normal)) {
+
+				res_shape = shape_idx;
+				res_obj = col_obj;
+			}
+		}
+
+		r_hits[i] = res_obj != NULL;
+		if (res_obj) {
+			_fill_ray_result(res_obj, res_shape, res_point, res_normal, r_results[i]);
+		}
+	}
 }
 
 int PhysicsDirectSpaceStateSW::intersect_shape(const RID &p_shape, const Transform &p_xform, real_t p_margin, ShapeResult *r_results, int p_result_max, const Set<RID> &p_exclude, uint32_t p_collision_mask, bool p_collide_with_bodies, bool p_collide_with_areas) {
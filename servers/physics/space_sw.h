@@ -38,6 +38,7 @@
 #include "broad_phase_sw.h"
 #include "collision_object_sw.h"
 #include "core/hash_map.h"
+#include "core/local_vector.h"
 #include "core/project_settings.h"
 #include "core/typedefs.h"
 
@@ -45,11 +46,31 @@ class PhysicsDirectSpaceStateSW : public PhysicsDirectSpaceState {
 
 	GDCLASS(PhysicsDirectSpaceStateSW, PhysicsDirectSpaceState);
 
+	enum {
+		BATCH_CHUNK_SIZE = 16, // Consecutive queries of a batch that try to share one broadphase cull.
+		BATCH_MAX_SHARED_CANDIDATES = 64, // Past this, the queries of a chunk are too spread out and cull on their own.
+	};
+
+	// Candidates of the queries in a batch, filtered once per cull, and the range each query tests.
+	// Culls go into buffers of their own rather than the space's query results.
+	struct BatchCandidates {
+		LocalVector<AABB> aabbs;
+		LocalVector<CollisionObjectSW *> objects;
+		LocalVector<int> shapes;
+		LocalVector<uint32_t> ranges; // Begin and end in objects, for each query.
+		LocalVector<CollisionObjectSW *> cull_results;
+		LocalVector<int> cull_subindex_results;
+	};
+
+	void _add_batch_candidates(BatchCandidates &r_candidates, int p_amount, const Set<RID> &p_exclude, uint32_t p_collision_mask, bool p_collide_with_bodies, bool p_collide_with_areas);
+	void _cull_batch(BatchCandidates &r_candidates, int p_count, const Vector3 *p_ray_points, const Set<RID> &p_exclude, uint32_t p_collision_mask, bool p_collide_with_bodies, bool p_collide_with_areas);
+
 public:
 	SpaceSW *space;
 
 	virtual int intersect_point(const Vector3 &p_point, ShapeResult *r_results, int p_result_max, const Set<RID> &p_exclude = Set<RID>(), uint32_t p_collision_mask = 0xFFFFFFFF, bool p_collide_with_bodies = true, bool p_collide_with_areas = false);
 	virtual bool intersect_ray(const Vector3 &p_from, const Vector3 &p_to, RayResult &r_result, const Set<RID> &p_exclude = Set<RID>(), uint32_t p_collision_mask = 0xFFFFFFFF, bool p_collide_with_bodies = true, bool p_collide_with_areas = false, bool p_pick_ray = false);
+	virtual void intersect_rays_batch(const Vector3 *p_points, int p_ray_count, RayResult *r_results, bool *r_hits, const Set<RID> &p_exclude = Set<RID>(), uint32_t p_collision_mask = 0xFFFFFFFF, bool p_collide_with_bodies = true, bool p_collide_with_areas = false);
 	virtual int intersect_shape(const RID &p_shape, const Transform &p_xform, real_t p_margin, ShapeResult *r_results, int p_result_max, const Set<RID> &p_exclude = Set<RID>(), uint32_t p_collision_mask = 0xFFFFFFFF, bool p_collide_with_bodies = true, bool p_collide_with_areas = false);
 	virtual bool cast_motion(const RID &p_shape, const Transform &p_xform, const Vector3 &p_motion, real_t p_margin, real_t &p_closest_safe, real_t &p_closest_unsafe, const Set<RID> &p_exclude = Set<RID>(), uint32_t p_collision_mask = 0xFFFFFFFF, bool p_collide_with_bodies = true, bool p_collide_with_areas = false, ShapeRestInfo *r_info = NULL);
 	virtual bool collide_shape(RID p_shape, const Transform &p_shape_xform, real_t p_margin, Vector3 *r_results, int p_result_max, int &r_result_count, const Set<RID> &p_exclude = Set<RID>(), uint32_t p_collision_mask = 0xFFFFFFFF, bool p_collide_with_bodies = true, bool p_collide_with_areas = false);
@@ -32,6 +32,7 @@
 #include "joints_sw.h"
 
 #include "core/os/os.h"
+#include "core/project_settings.h"
 
 void StepSW::_populate_island(BodySW *p_body, BodySW **p_island, ConstraintSW **p_constraint_island) {
 
@@ -144,6 +145,32 @@ void StepSW::_check_suspend(BodySW *p_island, real_t p_delta) {
 	}
 }
 
+void StepSW::_integrate_forces_job(uint32_t p_job, void *p_userdata) {
+
+	uint32_t from = p_job * BODY_BATCH_SIZE;
+	uint32_t to = MIN(from + BODY_BATCH_SIZE, bodies.size());
+	for (uint32_t i = from; i < to; i++) {
+		bodies[i]->integrate_forces(step_delta);
+	}
+}
+
+void StepSW::_integrate_velocities_job(uint32_t p_job, void *p_userdata) {
+
+	uint32_t from = p_job * BODY_BATCH_SIZE;
+	uint32_t to = MIN(from + BODY_BATCH_SIZE, bodies.size());
+	for (uint32_t i = from; i < to; i++) {
+		bodies[i]->integrate_velocities(step_delta);
+	}
+}
+
+void StepSW::_solve_islands_job(uint32_t p_job, void *p_userdata) {
+
+	// Islands share no dynamic body, see BodySW::apply_impulse().
+	for (uint32_t i = island_batches[p_job]; i < island_batches[p_job + 1]; i++) {
+		_solve_island(constraint_islands[i], step_iterations, step_delta);
+	}
+}
+
 void StepSW::step(SpaceSW *p_space, real_t p_delta, int p_iterations) {
 
 	p_space->lock(); // can't access space during this
@@ -157,17 +184,23 @@ void StepSW::step(SpaceSW *p_space, real_t p_delta, int p_iterations) {
 	uint64_t profile_begtime = OS::get_singleton()->get_ticks_usec();
 	uint64_t profile_endtime = 0;
 
-	int active_count = 0;
+	step_delta = p_delta;
+	step_iterations = p_iterations;
 
+	bodies.clear();
 	const SelfList<BodySW> *b = body_list->first();
 	while (b) {
-
-		b->self()->integrate_forces(p_delta);
+		bodies.push_back(b->self());
 		b = b->next();
-		active_count++;
 	}
 
-	p_space->set_active_objects(active_count);
+	uint32_t body_jobs = (bodies.size() + BODY_BATCH_SIZE - 1) / BODY_BATCH_SIZE;
+	work_pool.do_work(body_jobs, this, &StepSW::_integrate_forces_job, (void *)NULL);
+	for (uint32_t i = 0; i < bodies.size(); i++) {
+		bodies[i]->finish_integrate_forces();
+	}
+
+	p_space->set_active_objects(bodies.size());
 
 	{ //profile
 		profile_endtime = OS::get_singleton()->get_ticks_usec();
@@ -179,12 +212,11 @@ void StepSW::step(SpaceSW *p_space, real_t p_delta, int p_iterations) {
 
 	BodySW *island_list = NULL;
 	ConstraintSW *constraint_island_list = NULL;
-	b = body_list->first();
 
 	int island_count = 0;
 
-	while (b) {
-		BodySW *body = b->self();
+	for (uint32_t i = 0; i < bodies.size(); i++) {
+		BodySW *body = bodies[i];
 
 		if (body->get_island_step() != _step) {
 
@@ -201,7 +233,6 @@ void StepSW::step(SpaceSW *p_space, real_t p_delta, int p_iterations) {
 				island_count++;
 			}
 		}
-		b = b->next();
 	}
 
 	p_space->set_island_count(island_count);
@@ -248,12 +279,29 @@ void StepSW::step(SpaceSW *p_space, real_t p_delta, int p_iterations) {
 	/* SOLVE CONSTRAINT ISLANDS */
 
 	{
+		// Islands are independent, each job solves one or more of them in list order.
+		constraint_islands.clear();
+		island_batches.clear();
+
+		uint32_t batch_constraints = 0;
 		ConstraintSW *ci = constraint_island_list;
 		while (ci) {
-			//iterating each island separatedly improves cache efficiency
-			_solve_island(ci, p_iterations, p_delta);
+			if (batch_constraints == 0) {
+				island_batches.push_back(constraint_islands.size());
+			}
+			constraint_islands.push_back(ci);
+
+			for (ConstraintSW *c = ci; c; c = c->get_island_next()) {
+				batch_constraints++;
+			}
+			if (batch_constraints >= ISLAND_BATCH_MIN_CONSTRAINTS) {
+				batch_constraints = 0;
+			}
 			ci = ci->get_island_list_next();
 		}
+		island_batches.push_back(constraint_islands.size());
+
+		work_pool.do_work(island_batches.size() - 1, this, &StepSW::_solve_islands_job, (void *)NULL);
 	}
 
 	{ //profile
@@ -264,11 +312,9 @@ void StepSW::step(SpaceSW *p_space, real_t p_delta, int p_iterations) {
 
 	/* INTEGRATE VELOCITIES */
 
-	b = body_list->first();
-	while (b) {
-		const SelfList<BodySW> *n = b->next();
-		b->self()->integrate_velocities(p_delta);
-		b = n;
+	work_pool.do_work(body_jobs, this, &StepSW::_integrate_velocities_job, (void *)NULL);
+	for (uint32_t i = 0; i < bodies.size(); i++) {
+		bodies[i]->finish_integrate_velocities(); // may take the body out of the active list
 	}
 
 	/* SLEEP / WAKE UP ISLANDS */
@@ -296,4 +342,16 @@ void StepSW::step(SpaceSW *p_space, real_t p_delta, int p_iterations) {
 StepSW::StepSW() {
 
 	_step = 1;
+	step_delta = 0;
+	step_iterations = 0;
+
+	// 0 uses one thread per processor.
+	int thread_count = GLOBAL_DEF("physics/3d/solver_thread_count", 0);
+	ProjectSettings::get_singleton()->set_custom_property_info("physics/3d/solver_thread_count", PropertyInfo(Variant::INT, "physics/3d/solver_thread_count", PROPERTY_HINT_RANGE, "0,64,1,or_greater"));
+	work_pool.init(thread_count > 0 ? thread_count : -1);
+}
+
+StepSW::~StepSW() {
+
+	work_pool.finish();
 }
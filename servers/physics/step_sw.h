@@ -31,20 +31,42 @@
 #ifndef STEP_SW_H
 #define STEP_SW_H
 
+#include "core/local_vector.h"
+#include "core/os/thread_work_pool.h"
 #include "space_sw.h"
 
 class StepSW {
 
+	enum {
+		BODY_BATCH_SIZE = 64, // Bodies integrated by one job.
+		ISLAND_BATCH_MIN_CONSTRAINTS = 64, // Small islands are solved together until a job has this many constraints.
+	};
+
 	uint64_t _step;
 
+	ThreadWorkPool work_pool;
+
+	// Filled by step() for the jobs, in the order the islands were built; the result
+	// doesn't depend on which thread runs what.
+	real_t step_delta;
+	int step_iterations;
+	LocalVector<BodySW *> bodies;
+	LocalVector<ConstraintSW *> constraint_islands;
+	LocalVector<uint32_t> island_batches; // First island of each job, followed by the island count.
+
 	void _populate_island(BodySW *p_body, BodySW **p_island, ConstraintSW **p_constraint_island);
 	void _setup_island(ConstraintSW *p_island, real_t p_delta);
 	void _solve_island(ConstraintSW *p_island, int p_iterations, real_t p_delta);
 	void _check_suspend(BodySW *p_island, real_t p_delta);
 
+	void _integrate_forces_job(uint32_t p_job, void *p_userdata);
+	void _integrate_velocities_job(uint32_t p_job, void *p_userdata);
+	void _solve_islands_job(uint32_t p_job, void *p_userdata);
+
 public:
 	void step(SpaceSW *p_space, real_t p_delta, int p_iterations);
 	StepSW();
+	~StepSW();
 };
 
 #endif // STEP__SW_H
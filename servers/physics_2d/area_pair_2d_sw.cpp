@@ -41,27 +41,33 @@ bool AreaPair2DSW::setup(real_t p_step) {
 		result = true;
 	}
 
-	if (result != colliding) {
+	_set_colliding(result);
 
-		if (result) {
+	return false; //never do any post solving
+}
 
-			if (area->get_space_override_mode() != Physics2DServer::AREA_SPACE_OVERRIDE_DISABLED)
-				body->add_area(area);
-			if (area->has_monitor_callback())
-				area->add_body_to_query(body, body_shape, area_shape);
+void AreaPair2DSW::_set_colliding(bool p_colliding) {
 
-		} else {
+	if (p_colliding == colliding) {
+		return;
+	}
 
-			if (area->get_space_override_mode() != Physics2DServer::AREA_SPACE_OVERRIDE_DISABLED)
-				body->remove_area(area);
-			if (area->has_monitor_callback())
-				area->remove_body_from_query(body, body_shape, area_shape);
-		}
+	if (p_colliding) {
 
-		colliding = result;
+		if (area->get_space_override_mode() != Physics2DServer::AREA_SPACE_OVERRIDE_DISABLED)
+			body->add_area(area);
+		if (area->has_monitor_callback())
+			area->add_body_to_query(body, body_shape, area_shape);
+
+	} else {
+
+		if (area->get_space_override_mode() != Physics2DServer::AREA_SPACE_OVERRIDE_DISABLED)
+			body->remove_area(area);
+		if (area->has_monitor_callback())
+			area->remove_body_from_query(body, body_shape, area_shape);
 	}
 
-	return false; //never do any post solving
+	colliding = p_colliding;
 }
 
 void AreaPair2DSW::solve(real_t p_step) {
@@ -43,10 +43,17 @@ class AreaPair2DSW : public Constraint2DSW {
 	int area_shape;
 	bool colliding;
 
+	void _set_colliding(bool p_colliding);
+
 public:
 	bool setup(real_t p_step);
 	void solve(real_t p_step);
 
+	int get_state_size() const { return sizeof(bool); }
+	void save_state(uint8_t *r_state) const { *r_state = colliding; }
+	void restore_state(const uint8_t *p_state) { _set_colliding(*p_state); }
+	void reset_state() { _set_colliding(false); }
+
 	AreaPair2DSW(Body2DSW *p_body, int p_body_shape, Area2DSW *p_area, int p_area_shape);
 	~AreaPair2DSW();
 };
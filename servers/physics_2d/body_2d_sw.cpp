@@ -111,6 +111,7 @@ void Body2DSW::set_active(bool p_active) {
 
 	active = p_active;
 	if (!p_active) {
+		ccd_motion = Vector2(); // Pairs set up for an active neighbour still read it.
 		if (get_space())
 			get_space()->body_remove_from_active_list(&active_list);
 	} else {
@@ -212,11 +213,40 @@ real_t Body2DSW::get_param(Physics2DServer::BodyParameter p_param) const {
 	return 0;
 }
 
+void Body2DSW::_leave_island() {
+
+	if (!island) {
+		return;
+	}
+
+	// The other bodies rebuild the island, without this one.
+	island->dirty = true;
+	int64_t idx = island->bodies.find(this);
+	if (idx >= 0) {
+		island->bodies.remove_unordered(idx);
+	}
+	if (island->bodies.empty()) {
+		get_space()->island_free(island);
+	}
+	island = NULL;
+}
+
 void Body2DSW::set_mode(Physics2DServer::BodyMode p_mode) {
 
 	Physics2DServer::BodyMode prev = mode;
 	mode = p_mode;
 
+	if (prev != mode) {
+		// Whether this body links islands changes, so the neighbours' islands need a rebuild too.
+		for (Map<Constraint2DSW *, int>::Element *E = constraint_map.front(); E; E = E->next()) {
+			Constraint2DSW *c = E->key();
+			for (int i = 0; i < c->get_body_count(); i++) {
+				c->get_body_ptr()[i]->set_island_dirty();
+			}
+		}
+		_leave_island();
+	}
+
 	switch (p_mode) {
 		//CLEAR UP EVERYTHING IN CASE IT NOT WORKS!
 		case Physics2DServer::BODY_MODE_STATIC:
@@ -307,6 +337,7 @@ void Body2DSW::set_state(Physics2DServer::BodyState p_state, const Variant &p_va
 				break;
 			*/
 			linear_velocity = p_variant;
+			ccd_motion = Vector2(); // Swept again from the new velocity on the next step.
 			wakeup();
 
 		} break;
@@ -316,6 +347,7 @@ void Body2DSW::set_state(Physics2DServer::BodyState p_state, const Variant &p_va
 				break;
 			*/
 			angular_velocity = p_variant;
+			ccd_motion = Vector2();
 			wakeup();
 
 		} break;
@@ -329,6 +361,7 @@ void Body2DSW::set_state(Physics2DServer::BodyState p_state, const Variant &p_va
 				//biased_linear_velocity=Vector3();
 				angular_velocity = 0;
 				//biased_angular_velocity=Vector3();
+				ccd_motion = Vector2();
 				set_active(false);
 			} else {
 				if (mode != Physics2DServer::BODY_MODE_STATIC)
@@ -371,6 +404,7 @@ void Body2DSW::set_space(Space2DSW *p_space) {
 	if (get_space()) {
 
 		wakeup_neighbours();
+		_leave_island();
 
 		if (inertia_update_list.in_list())
 			get_space()->body_remove_from_inertia_update_list(&inertia_update_list);
@@ -477,14 +511,19 @@ void Body2DSW::integrate_forces(real_t p_step) {
 
 	Vector2 motion;
 	bool do_motion = false;
+	ccd_motion = Vector2();
 
 	if (mode == Physics2DServer::BODY_MODE_KINEMATIC) {
 
 		//compute motion, angular and etc. velocities from prev transform
-		motion = new_transform.get_origin() - get_transform().get_origin();
+		//when the step is split in substeps, only cover the matching fraction of the way each time
+		int substeps_left = get_space()->get_substeps_left();
+		kinematic_step_transform = substeps_left > 1 ? get_transform().interpolate_with(new_transform, 1.0 / substeps_left) : new_transform;
+
+		motion = kinematic_step_transform.get_origin() - get_transform().get_origin();
 		linear_velocity = motion / p_step;
 
-		real_t rot = new_transform.get_rotation() - get_transform().get_rotation();
+		real_t rot = kinematic_step_transform.get_rotation() - get_transform().get_rotation();
 		angular_velocity = remainder(rot, 2.0 * Math_PI) / p_step;
 
 		do_motion = true;
@@ -523,7 +562,26 @@ void Body2DSW::integrate_forces(real_t p_step) {
 
 		if (continuous_cd_mode != Physics2DServer::CCD_MODE_DISABLED) {
 
+			// Only bodies moving more than a third of a shape's size can skip past anything. Slower ones
+			// keep tight AABBs, so they don't pick up extra pairs and their pairs skip the CCD tests.
 			motion = linear_velocity * p_step;
+			real_t mlen = motion.length();
+			bool fast = false;
+			if (mlen > CMP_EPSILON) {
+				Vector2 mnormal = motion / mlen;
+				for (int i = 0; i < get_shape_count() && !fast; i++) {
+					if (is_shape_set_as_disabled(i)) {
+						continue;
+					}
+					real_t min, max;
+					get_shape(i)->project_rangev(mnormal, get_transform() * get_shape_transform(i), min, max);
+					fast = mlen > (max - min) * 0.3;
+				}
+			}
+			if (!fast) {
+				motion = Vector2();
+			}
+			ccd_motion = motion;
 			do_motion = true;
 		}
 	}
@@ -534,29 +592,31 @@ void Body2DSW::integrate_forces(real_t p_step) {
 	biased_angular_velocity = 0;
 	biased_linear_velocity = Vector2();
 
-	if (do_motion) { //shapes temporarily extend for raycast
-		_update_shapes_with_motion(motion);
-	}
+	motion_pending = do_motion;
+	pending_motion = motion;
 
 	// damp_area=NULL; // clear the area, so it is set in the next frame
 	def_area = NULL; // clear the area, so it is set in the next frame
 	contact_count = 0;
 }
 
+void Body2DSW::finish_integrate_forces() {
+
+	if (motion_pending) { //shapes temporarily extend for raycast
+		_update_shapes_with_motion(pending_motion);
+		motion_pending = false;
+	}
+}
+
 void Body2DSW::integrate_velocities(real_t p_step) {
 
 	if (mode == Physics2DServer::BODY_MODE_STATIC)
 		return;
 
-	if (fi_callback)
-		get_space()->body_add_to_state_query_list(&direct_state_query_list);
-
 	if (mode == Physics2DServer::BODY_MODE_KINEMATIC) {
 
-		_set_transform(new_transform, false);
-		_set_inv_transform(new_transform.affine_inverse());
-		if (contacts.size() == 0 && linear_velocity == Vector2() && angular_velocity == 0)
-			set_active(false); //stopped moving, deactivate
+		_set_transform(kinematic_step_transform, false);
+		_set_inv_transform(kinematic_step_transform.affine_inverse());
 		return;
 	}
 
@@ -566,7 +626,7 @@ void Body2DSW::integrate_velocities(real_t p_step) {
 	real_t angle = get_transform().get_rotation() + total_angular_velocity * p_step;
 	Vector2 pos = get_transform().get_origin() + total_linear_velocity * p_step;
 
-	_set_transform(Transform2D(angle, pos), continuous_cd_mode == Physics2DServer::CCD_MODE_DISABLED);
+	_set_transform(Transform2D(angle, pos), false);
 	_set_inv_transform(get_transform().inverse());
 
 	if (continuous_cd_mode != Physics2DServer::CCD_MODE_DISABLED)
@@ -575,6 +635,56 @@ void Body2DSW::integrate_velocities(real_t p_step) {
 	//_update_inertia_tensor();
 }
 
+void Body2DSW::finish_integrate_velocities() {
+
+	if (mode == Physics2DServer::BODY_MODE_STATIC)
+		return;
+
+	//with solver substeps this runs several times before the queries are called, only queue once
+	if (fi_callback && !direct_state_query_list.in_list())
+		get_space()->body_add_to_state_query_list(&direct_state_query_list);
+
+	if (mode == Physics2DServer::BODY_MODE_KINEMATIC) {
+
+		if (contacts.size() == 0 && linear_velocity == Vector2() && angular_velocity == 0)
+			set_active(false); //stopped moving, deactivate
+		return;
+	}
+
+	if (continuous_cd_mode == Physics2DServer::CCD_MODE_DISABLED)
+		_update_shapes();
+}
+
+void Body2DSW::save_state(State &r_state) const {
+
+	r_state.transform = get_transform();
+	r_state.inv_transform = get_inv_transform();
+	r_state.new_transform = new_transform;
+	r_state.linear_velocity = linear_velocity;
+	r_state.angular_velocity = angular_velocity;
+	r_state.applied_force = applied_force;
+	r_state.applied_torque = applied_torque;
+	r_state.still_time = still_time;
+	r_state.active = active;
+	r_state.first_integration = first_integration;
+	r_state.first_time_kinematic = first_time_kinematic;
+}
+
+void Body2DSW::restore_state(const State &p_state) {
+
+	_set_transform(p_state.transform);
+	_set_inv_transform(p_state.inv_transform); // Saved as well, recomputing it may round differently.
+	new_transform = p_state.new_transform;
+	linear_velocity = p_state.linear_velocity;
+	angular_velocity = p_state.angular_velocity;
+	applied_force = p_state.applied_force;
+	applied_torque = p_state.applied_torque;
+	still_time = p_state.still_time;
+	first_integration = p_state.first_integration;
+	first_time_kinematic = p_state.first_time_kinematic;
+	set_active(p_state.active);
+}
+
 void Body2DSW::wakeup_neighbours() {
 
 	for (Map<Constraint2DSW *, int>::Element *E = constraint_map.front(); E; E = E->next()) {
@@ -684,6 +794,7 @@ Body2DSW::Body2DSW() :
 	island_step = 0;
 	island_next = NULL;
 	island_list_next = NULL;
+	island = NULL;
 	_set_static(false);
 	first_time_kinematic = false;
 	linear_damp = -1;
@@ -693,6 +804,7 @@ Body2DSW::Body2DSW() :
 	contact_count = 0;
 	gravity_scale = 1.0;
 	first_integration = false;
+	motion_pending = false;
 
 	still_time = 0;
 	continuous_cd_mode = Physics2DServer::CCD_MODE_DISABLED;
@@ -33,10 +33,22 @@
 
 #include "area_2d_sw.h"
 #include "collision_object_2d_sw.h"
+#include "core/local_vector.h"
 #include "core/vset.h"
 
+class Body2DSW;
 class Constraint2DSW;
 
+// Rigid and character bodies linked by constraints, with all those constraints. Static and kinematic
+// bodies don't link islands. Islands are kept between steps, and only rebuilt once marked dirty by a
+// constraint or a body joining or leaving them, so resting and unchanged parts of the world cost little.
+struct Island2DSW {
+	LocalVector<Body2DSW *> bodies;
+	LocalVector<Constraint2DSW *> constraints; // Must not be read once dirty, some may be gone.
+	uint64_t step; // Last step the island was queued for.
+	bool dirty;
+};
+
 class Body2DSW : public CollisionObject2DSW {
 
 	Physics2DServer::BodyMode mode;
@@ -80,9 +92,13 @@ class Body2DSW : public CollisionObject2DSW {
 	bool can_sleep;
 	bool first_time_kinematic;
 	bool first_integration;
+	bool motion_pending; // integrate_forces() left pending_motion for finish_integrate_forces().
+	Vector2 pending_motion;
+	Vector2 ccd_motion; // Swept by the broadphase AABBs this step, zero unless the body is fast enough to tunnel.
 	void _update_inertia();
 	virtual void _shapes_changed();
 	Transform2D new_transform;
+	Transform2D kinematic_step_transform; // Where a kinematic body ends the current (sub)step, on the way to new_transform.
 
 	Map<Constraint2DSW *, int> constraint_map;
 
@@ -91,7 +107,10 @@ class Body2DSW : public CollisionObject2DSW {
 		Area2DSW *area;
 		int refCount;
 		_FORCE_INLINE_ bool operator==(const AreaCMP &p_cmp) const { return area->get_self() == p_cmp.area->get_self(); }
-		_FORCE_INLINE_ bool operator<(const AreaCMP &p_cmp) const { return area->get_priority() < p_cmp.area->get_priority(); }
+		_FORCE_INLINE_ bool operator<(const AreaCMP &p_cmp) const {
+			// Ties go by space order, so areas with the same priority are combined in the same order every time.
+			return area->get_priority() == p_cmp.area->get_priority() ? area->get_space_order() < p_cmp.area->get_space_order() : area->get_priority() < p_cmp.area->get_priority();
+		}
 		_FORCE_INLINE_ AreaCMP() {}
 		_FORCE_INLINE_ AreaCMP(Area2DSW *p_area) {
 			area = p_area;
@@ -129,8 +148,10 @@ class Body2DSW : public CollisionObject2DSW {
 	uint64_t island_step;
 	Body2DSW *island_next;
 	Body2DSW *island_list_next;
+	Island2DSW *island;
 
 	_FORCE_INLINE_ void _compute_area_gravity_and_dampenings(const Area2DSW *p_area);
+	void _leave_island();
 
 	friend class Physics2DDirectBodyStateSW; // i give up, too many functions to expose
 
@@ -180,10 +201,27 @@ public:
 	_FORCE_INLINE_ Body2DSW *get_island_list_next() const { return island_list_next; }
 	_FORCE_INLINE_ void set_island_list_next(Body2DSW *p_next) { island_list_next = p_next; }
 
-	_FORCE_INLINE_ void add_constraint(Constraint2DSW *p_constraint, int p_pos) { constraint_map[p_constraint] = p_pos; }
-	_FORCE_INLINE_ void remove_constraint(Constraint2DSW *p_constraint) { constraint_map.erase(p_constraint); }
+	_FORCE_INLINE_ Island2DSW *get_island() const { return island; }
+	_FORCE_INLINE_ void set_island(Island2DSW *p_island) { island = p_island; }
+	_FORCE_INLINE_ void set_island_dirty() {
+		if (island) {
+			island->dirty = true;
+		}
+	}
+
+	_FORCE_INLINE_ void add_constraint(Constraint2DSW *p_constraint, int p_pos) {
+		constraint_map[p_constraint] = p_pos;
+		set_island_dirty();
+	}
+	_FORCE_INLINE_ void remove_constraint(Constraint2DSW *p_constraint) {
+		constraint_map.erase(p_constraint);
+		set_island_dirty();
+	}
 	const Map<Constraint2DSW *, int> &get_constraint_map() const { return constraint_map; }
-	_FORCE_INLINE_ void clear_constraint_map() { constraint_map.clear(); }
+	_FORCE_INLINE_ void clear_constraint_map() {
+		constraint_map.clear();
+		set_island_dirty();
+	}
 
 	_FORCE_INLINE_ void set_omit_force_integration(bool p_omit_force_integration) { omit_force_integration = p_omit_force_integration; }
 	_FORCE_INLINE_ bool get_omit_force_integration() const { return omit_force_integration; }
@@ -204,8 +242,13 @@ public:
 		linear_velocity += p_impulse * _inv_mass;
 	}
 
+	// Static and kinematic bodies take no impulses, so they are skipped before writing
+	// anything. Islands solved on different threads can share such a body.
 	_FORCE_INLINE_ void apply_impulse(const Vector2 &p_offset, const Vector2 &p_impulse) {
 
+		if (mode <= Physics2DServer::BODY_MODE_KINEMATIC) {
+			return;
+		}
 		linear_velocity += p_impulse * _inv_mass;
 		angular_velocity += _inv_inertia * p_offset.cross(p_impulse);
 	}
@@ -216,6 +259,9 @@ public:
 
 	_FORCE_INLINE_ void apply_bias_impulse(const Vector2 &p_pos, const Vector2 &p_j) {
 
+		if (mode <= Physics2DServer::BODY_MODE_KINEMATIC) {
+			return;
+		}
 		biased_linear_velocity += p_j * _inv_mass;
 		biased_angular_velocity += _inv_inertia * p_pos.cross(p_j);
 	}
@@ -273,20 +319,45 @@ public:
 	_FORCE_INLINE_ real_t get_linear_damp() const { return linear_damp; }
 	_FORCE_INLINE_ real_t get_angular_damp() const { return angular_damp; }
 
+	// integrate_forces() and integrate_velocities() only change the body itself, so they can run
+	// for several bodies at once. The matching finish_*() updates the broadphase and the lists of
+	// the space, one body at a time.
 	void integrate_forces(real_t p_step);
+	void finish_integrate_forces();
 	void integrate_velocities(real_t p_step);
+	void finish_integrate_velocities();
+
+	_FORCE_INLINE_ const Vector2 &get_ccd_motion() const { return ccd_motion; }
 
 	_FORCE_INLINE_ Vector2 get_motion() const {
 
 		if (mode > Physics2DServer::BODY_MODE_KINEMATIC) {
 			return new_transform.get_origin() - get_transform().get_origin();
 		} else if (mode == Physics2DServer::BODY_MODE_KINEMATIC) {
-			return get_transform().get_origin() - new_transform.get_origin(); //kinematic simulates forward
+			return get_transform().get_origin() - kinematic_step_transform.get_origin(); //kinematic simulates forward
 		}
 		return Vector2();
 	}
 
 	void call_queries();
+
+	// What a body carries from one step to the next, for saving and restoring the space state.
+	struct State {
+		Transform2D transform;
+		Transform2D inv_transform;
+		Transform2D new_transform;
+		Vector2 linear_velocity;
+		real_t angular_velocity;
+		Vector2 applied_force;
+		real_t applied_torque;
+		real_t still_time;
+		bool active;
+		bool first_integration;
+		bool first_time_kinematic;
+	};
+
+	void save_state(State &r_state) const;
+	void restore_state(const State &p_state);
 	void wakeup_neighbours();
 
 	bool sleep_test(real_t p_step);
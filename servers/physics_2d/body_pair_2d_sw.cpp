@@ -42,6 +42,25 @@ void BodyPair2DSW::_add_contact(const Vector2 &p_point_A, const Vector2 &p_point
 	self->_contact_added_callback(p_point_A, p_point_B);
 }
 
+struct _CCDContactData {
+	BodyPair2DSW *pair;
+	Vector2 motion_left;
+	bool swap;
+};
+
+void BodyPair2DSW::_add_ccd_contact(const Vector2 &p_point_A, const Vector2 &p_point_B, void *p_userdata) {
+
+	_CCDContactData *data = (_CCDContactData *)p_userdata;
+
+	// The point on the moving body is where it would end the step, so the contact stops it at the time of impact.
+	Vector2 point_A = p_point_A + data->motion_left;
+	if (data->swap) {
+		data->pair->_contact_added_callback(p_point_B, point_A);
+	} else {
+		data->pair->_contact_added_callback(point_A, p_point_B);
+	}
+}
+
 void BodyPair2DSW::_contact_added_callback(const Vector2 &p_point_A, const Vector2 &p_point_B) {
 
 	// check if we already have the contact
@@ -65,24 +84,29 @@ void BodyPair2DSW::_contact_added_callback(const Vector2 &p_point_A, const Vecto
 	contact.mass_normal = 0; // will be computed in setup()
 
 	// attempt to determine if the contact will be reused
+	// pick the closest candidate, so both points of a resting manifold keep their own impulses
 
 	real_t recycle_radius_2 = space->get_contact_recycle_radius() * space->get_contact_recycle_radius();
+	real_t closest_dist = 1e20;
 
 	for (int i = 0; i < contact_count; i++) {
 
 		Contact &c = contacts[i];
-		if (
-				c.local_A.distance_squared_to(local_A) < (recycle_radius_2) &&
-				c.local_B.distance_squared_to(local_B) < (recycle_radius_2)) {
+		real_t dist_A = c.local_A.distance_squared_to(local_A);
+		real_t dist_B = c.local_B.distance_squared_to(local_B);
+		if (dist_A < recycle_radius_2 && dist_B < recycle_radius_2 && dist_A + dist_B < closest_dist) {
 
-			contact.acc_normal_impulse = c.acc_normal_impulse;
-			contact.acc_tangent_impulse = c.acc_tangent_impulse;
-			contact.acc_bias_impulse = c.acc_bias_impulse;
+			closest_dist = dist_A + dist_B;
 			new_index = i;
-			break;
 		}
 	}
 
+	if (new_index < contact_count) {
+
+		contact.acc_normal_impulse = contacts[new_index].acc_normal_impulse;
+		contact.acc_tangent_impulse = contacts[new_index].acc_tangent_impulse;
+	}
+
 	// figure out if the contact amount must be reduced to fit the new contact
 
 	if (new_index == MAX_CONTACTS) {
@@ -168,9 +192,9 @@ void BodyPair2DSW::_validate_contacts() {
 	}
 }
 
-bool BodyPair2DSW::_test_ccd(real_t p_step, Body2DSW *p_A, int p_shape_A, const Transform2D &p_xform_A, Body2DSW *p_B, int p_shape_B, const Transform2D &p_xform_B, bool p_swap_result) {
+bool BodyPair2DSW::_test_ccd(Body2DSW *p_A, int p_shape_A, const Transform2D &p_xform_A, Body2DSW *p_B, int p_shape_B, const Transform2D &p_xform_B, bool p_swap_result) {
 
-	Vector2 motion = p_A->get_linear_velocity() * p_step;
+	Vector2 motion = p_A->get_ccd_motion(); // Zero unless the body moves fast enough to tunnel.
 	real_t mlen = motion.length();
 	if (mlen < CMP_EPSILON)
 		return false;
@@ -219,6 +243,47 @@ bool BodyPair2DSW::_test_ccd(real_t p_step, Body2DSW *p_A, int p_shape_A, const
 	return true;
 }
 
+bool BodyPair2DSW::_test_ccd_cast(Body2DSW *p_A, int p_shape_A, const Transform2D &p_xform_A, Body2DSW *p_B, int p_shape_B, const Transform2D &p_xform_B, bool p_swap_result) {
+
+	Vector2 motion = p_A->get_ccd_motion();
+	if (motion == Vector2())
+		return false;
+
+	const Shape2DSW *shape_A_ptr = p_A->get_shape(p_shape_A);
+	const Shape2DSW *shape_B_ptr = p_B->get_shape(p_shape_B);
+
+	// Most candidates from the swept AABBs miss the swept shape too.
+	Vector2 mnormal = motion.normalized();
+	Vector2 sep = mnormal;
+	if (!CollisionSolver2DSW::solve(shape_A_ptr, p_xform_A, motion, shape_B_ptr, p_xform_B, Vector2(), NULL, NULL, &sep))
+		return false;
+
+	// Time of impact, only advancing to fractions of the motion known to be clear, as in cast_motion().
+	real_t safe = 0;
+	real_t unsafe = 1;
+	for (int i = 0; i < CCD_TOI_ITERATIONS; i++) {
+
+		real_t ofs = (safe + unsafe) * 0.5;
+		sep = mnormal;
+		if (CollisionSolver2DSW::solve(shape_A_ptr, p_xform_A, motion * ofs, shape_B_ptr, p_xform_B, Vector2(), NULL, NULL, &sep)) {
+			unsafe = ofs;
+		} else {
+			safe = ofs;
+		}
+	}
+
+	Transform2D xform_A_toi = p_xform_A;
+	xform_A_toi.elements[2] += motion * unsafe;
+
+	_CCDContactData data;
+	data.pair = this;
+	data.motion_left = motion * (1.0 - unsafe);
+	data.swap = p_swap_result;
+
+	sep = mnormal;
+	return CollisionSolver2DSW::solve(shape_A_ptr, xform_A_toi, Vector2(), shape_B_ptr, p_xform_B, Vector2(), _add_ccd_contact, &data, &sep);
+}
+
 real_t combine_bounce(Body2DSW *A, Body2DSW *B) {
 	return CLAMP(A->get_bounce() + B->get_bounce(), 0, 1);
 }
@@ -227,8 +292,28 @@ real_t combine_friction(Body2DSW *A, Body2DSW *B) {
 	return ABS(MIN(A->get_friction(), B->get_friction()));
 }
 
+void BodyPair2DSW::add_to_separation_batch(SeparationBatch2DSW *p_batch) {
+
+	// Shape casts need the motion, the batch only tests the current positions.
+	if (A->get_continuous_collision_detection_mode() == Physics2DServer::CCD_MODE_CAST_SHAPE || B->get_continuous_collision_detection_mode() == Physics2DServer::CCD_MODE_CAST_SHAPE) {
+		return;
+	}
+
+	const Shape2DSW *shape_A_ptr = A->get_shape(shape_A);
+	const Shape2DSW *shape_B_ptr = B->get_shape(shape_B);
+
+	if (!SeparationBatch2DSW::can_test(shape_A_ptr) || !SeparationBatch2DSW::can_test(shape_B_ptr)) {
+		return;
+	}
+
+	p_batch->add(shape_A_ptr, A->get_transform() * A->get_shape_transform(shape_A), shape_B_ptr, B->get_transform() * B->get_shape_transform(shape_B), &batch_separated);
+}
+
 bool BodyPair2DSW::setup(real_t p_step) {
 
+	bool separated = batch_separated;
+	batch_separated = false;
+
 	//cannot collide
 	if (!A->test_collision_mask(B) || A->has_exception(B->get_self()) || B->has_exception(A->get_self()) || (A->get_mode() <= Physics2DServer::BODY_MODE_KINEMATIC && B->get_mode() <= Physics2DServer::BODY_MODE_KINEMATIC && A->get_max_contacts_reported() == 0 && B->get_max_contacts_reported() == 0)) {
 		collided = false;
@@ -267,18 +352,28 @@ bool BodyPair2DSW::setup(real_t p_step) {
 
 	bool prev_collided = collided;
 
-	collided = CollisionSolver2DSW::solve(shape_A_ptr, xform_A, motion_A, shape_B_ptr, xform_B, motion_B, _add_contact, this, &sep_axis);
+	if (separated) {
+		collided = false;
+	} else {
+		collided = CollisionSolver2DSW::solve(shape_A_ptr, xform_A, motion_A, shape_B_ptr, xform_B, motion_B, _add_contact, this, &sep_axis);
+	}
 	if (!collided) {
 
-		//test ccd (currently just a raycast)
+		//test ccd, a raycast from the support point or a shape cast to the time of impact
 
 		if (A->get_continuous_collision_detection_mode() == Physics2DServer::CCD_MODE_CAST_RAY && A->get_mode() > Physics2DServer::BODY_MODE_KINEMATIC) {
-			if (_test_ccd(p_step, A, shape_A, xform_A, B, shape_B, xform_B))
+			if (_test_ccd(A, shape_A, xform_A, B, shape_B, xform_B))
+				collided = true;
+		} else if (A->get_continuous_collision_detection_mode() == Physics2DServer::CCD_MODE_CAST_SHAPE && A->get_mode() > Physics2DServer::BODY_MODE_KINEMATIC) {
+			if (_test_ccd_cast(A, shape_A, xform_A, B, shape_B, xform_B))
 				collided = true;
 		}
 
 		if (B->get_continuous_collision_detection_mode() == Physics2DServer::CCD_MODE_CAST_RAY && B->get_mode() > Physics2DServer::BODY_MODE_KINEMATIC) {
-			if (_test_ccd(p_step, B, shape_B, xform_B, A, shape_A, xform_A, true))
+			if (_test_ccd(B, shape_B, xform_B, A, shape_A, xform_A, true))
+				collided = true;
+		} else if (B->get_continuous_collision_detection_mode() == Physics2DServer::CCD_MODE_CAST_SHAPE && B->get_mode() > Physics2DServer::BODY_MODE_KINEMATIC) {
+			if (_test_ccd_cast(B, shape_B, xform_B, A, shape_A, xform_A, true))
 				collided = true;
 		}
 
@@ -417,7 +512,8 @@ bool BodyPair2DSW::setup(real_t p_step) {
 
 		c.bias = -bias * inv_dt * MIN(0.0f, -depth + max_penetration);
 		c.depth = depth;
-		//c.acc_bias_impulse=0;
+		// Biased velocities start from zero every step, so the bias impulse must too, or it can turn negative and pull the bodies together.
+		c.acc_bias_impulse = 0;
 
 #ifdef ACCUMULATE_IMPULSES
 		{
@@ -442,14 +538,119 @@ bool BodyPair2DSW::setup(real_t p_step) {
 		do_process = true;
 	}
 
+	_setup_block_solver();
+
 	return do_process;
 }
 
+void BodyPair2DSW::_setup_block_solver() {
+
+	block_solver = false;
+
+	if (contact_count != 2 || !contacts[0].active || !contacts[1].active) {
+		return;
+	}
+
+	const Contact &c1 = contacts[0];
+	const Contact &c2 = contacts[1];
+
+	real_t inv_mass_A = A->get_inv_mass();
+	real_t inv_mass_B = B->get_inv_mass();
+	real_t inv_inertia_A = A->get_inv_inertia();
+	real_t inv_inertia_B = B->get_inv_inertia();
+
+	real_t rn1A = c1.rA.cross(c1.normal);
+	real_t rn1B = c1.rB.cross(c1.normal);
+	real_t rn2A = c2.rA.cross(c2.normal);
+	real_t rn2B = c2.rB.cross(c2.normal);
+
+	real_t k11 = 1.0 / c1.mass_normal;
+	real_t k22 = 1.0 / c2.mass_normal;
+	real_t k12 = (inv_mass_A + inv_mass_B) * c1.normal.dot(c2.normal) + inv_inertia_A * rn1A * rn2A + inv_inertia_B * rn1B * rn2B;
+
+	// Nearly redundant points (e.g. a box resting on a corner) make the system ill-conditioned, solve those one point at a time.
+	real_t det = k11 * k22 - k12 * k12;
+	if (k11 * k11 >= BLOCK_SOLVER_MAX_CONDITION * det) {
+		return;
+	}
+
+	block_solver = true;
+	block_k12 = k12;
+	real_t inv_det = 1.0 / det;
+	block_mass[0] = k22 * inv_det;
+	block_mass[1] = -k12 * inv_det;
+	block_mass[2] = k11 * inv_det;
+}
+
+void BodyPair2DSW::_solve_block() {
+
+	// Solves the normal impulses of both points together as a 2x2 LCP, by trying each case in turn:
+	// both points pushing, only the first, only the second, and none.
+	// vn = K * x + b, with x the new accumulated impulses, and the aim is vn >= 0, x >= 0 and vn . x = 0.
+
+	Contact &c1 = contacts[0];
+	Contact &c2 = contacts[1];
+
+	Vector2 cr1A(-A->get_angular_velocity() * c1.rA.y, A->get_angular_velocity() * c1.rA.x);
+	Vector2 cr1B(-B->get_angular_velocity() * c1.rB.y, B->get_angular_velocity() * c1.rB.x);
+	Vector2 cr2A(-A->get_angular_velocity() * c2.rA.y, A->get_angular_velocity() * c2.rA.x);
+	Vector2 cr2B(-B->get_angular_velocity() * c2.rB.y, B->get_angular_velocity() * c2.rB.x);
+
+	real_t vn1 = (B->get_linear_velocity() + cr1B - A->get_linear_velocity() - cr1A).dot(c1.normal);
+	real_t vn2 = (B->get_linear_velocity() + cr2B - A->get_linear_velocity() - cr2A).dot(c2.normal);
+
+	real_t a1 = c1.acc_normal_impulse;
+	real_t a2 = c2.acc_normal_impulse;
+	real_t k11 = 1.0 / c1.mass_normal;
+	real_t k22 = 1.0 / c2.mass_normal;
+
+	// The bounce is the target velocity, so it is folded into b.
+	real_t b1 = vn1 + c1.bounce - (k11 * a1 + block_k12 * a2);
+	real_t b2 = vn2 + c2.bounce - (block_k12 * a1 + k22 * a2);
+
+	real_t x1, x2;
+
+	x1 = -(block_mass[0] * b1 + block_mass[1] * b2);
+	x2 = -(block_mass[1] * b1 + block_mass[2] * b2);
+	if (x1 < 0 || x2 < 0) {
+
+		x1 = -c1.mass_normal * b1;
+		x2 = 0;
+		if (x1 < 0 || block_k12 * x1 + b2 < 0) {
+
+			x1 = 0;
+			x2 = -c2.mass_normal * b2;
+			if (x2 < 0 || block_k12 * x2 + b1 < 0) {
+
+				if (b1 < 0 || b2 < 0) {
+					// No case fits, which only happens through round-off. Keep the previous impulses.
+					return;
+				}
+				x1 = 0;
+				x2 = 0;
+			}
+		}
+	}
+
+	c1.acc_normal_impulse = x1;
+	c2.acc_normal_impulse = x2;
+
+	Vector2 j1 = c1.normal * (x1 - a1);
+	Vector2 j2 = c2.normal * (x2 - a2);
+
+	A->apply_impulse(c1.rA, -j1);
+	B->apply_impulse(c1.rB, j1);
+	A->apply_impulse(c2.rA, -j2);
+	B->apply_impulse(c2.rB, j2);
+}
+
 void BodyPair2DSW::solve(real_t p_step) {
 
 	if (!collided)
 		return;
 
+	real_t friction = combine_friction(A, B);
+
 	for (int i = 0; i < contact_count; ++i) {
 
 		Contact &c = contacts[i];
@@ -482,11 +683,11 @@ void BodyPair2DSW::solve(real_t p_step) {
 		A->apply_bias_impulse(c.rA, -jb);
 		B->apply_bias_impulse(c.rB, jb);
 
-		real_t jn = -(c.bounce + vn) * c.mass_normal;
 		real_t jnOld = c.acc_normal_impulse;
-		c.acc_normal_impulse = MAX(jnOld + jn, 0.0f);
-
-		real_t friction = combine_friction(A, B);
+		if (!block_solver) {
+			real_t jn = -(c.bounce + vn) * c.mass_normal;
+			c.acc_normal_impulse = MAX(jnOld + jn, 0.0f);
+		}
 
 		real_t jtMax = friction * c.acc_normal_impulse;
 		real_t jt = -vt * c.mass_tangent;
@@ -498,6 +699,63 @@ void BodyPair2DSW::solve(real_t p_step) {
 		A->apply_impulse(c.rA, -j);
 		B->apply_impulse(c.rB, j);
 	}
+
+	// With the block solver, the loop above only applied friction (bounded by the last normal impulses).
+	if (block_solver) {
+		_solve_block();
+	}
+}
+
+void BodyPair2DSW::save_state(uint8_t *r_state) const {
+
+	// Zeroed and copied member by member, so the padding is zero and equal states are equal bytes.
+	State state = State();
+	state.sep_axis = sep_axis;
+	for (int i = 0; i < MAX_CONTACTS; i++) {
+		const Contact &src = contacts[i];
+		Contact &dst = state.contacts[i];
+		dst.position = src.position;
+		dst.normal = src.normal;
+		dst.local_A = src.local_A;
+		dst.local_B = src.local_B;
+		dst.acc_normal_impulse = src.acc_normal_impulse;
+		dst.acc_tangent_impulse = src.acc_tangent_impulse;
+		dst.acc_bias_impulse = src.acc_bias_impulse;
+		dst.mass_normal = src.mass_normal;
+		dst.mass_tangent = src.mass_tangent;
+		dst.bias = src.bias;
+		dst.depth = src.depth;
+		dst.active = src.active;
+		dst.rA = src.rA;
+		dst.rB = src.rB;
+		dst.reused = src.reused;
+		dst.bounce = src.bounce;
+	}
+	state.contact_count = contact_count;
+	state.collided = collided;
+	state.oneway_disabled = oneway_disabled;
+	memcpy(r_state, &state, sizeof(State));
+}
+
+void BodyPair2DSW::restore_state(const uint8_t *p_state) {
+
+	State state;
+	memcpy(&state, p_state, sizeof(State));
+	sep_axis = state.sep_axis;
+	for (int i = 0; i < MAX_CONTACTS; i++) {
+		contacts[i] = state.contacts[i];
+	}
+	contact_count = state.contact_count;
+	collided = state.collided;
+	oneway_disabled = state.oneway_disabled;
+}
+
+void BodyPair2DSW::reset_state() {
+
+	sep_axis = Vector2();
+	contact_count = 0;
+	collided = false;
+	oneway_disabled = false;
 }
 
 BodyPair2DSW::BodyPair2DSW(Body2DSW *p_A, int p_shape_A, Body2DSW *p_B, int p_shape_B) :
@@ -513,6 +771,8 @@ BodyPair2DSW::BodyPair2DSW(Body2DSW *p_A, int p_shape_A, Body2DSW *p_B, int p_sh
 	contact_count = 0;
 	collided = false;
 	oneway_disabled = false;
+	batch_separated = false;
+	block_solver = false;
 }
 
 BodyPair2DSW::~BodyPair2DSW() {
@@ -37,7 +37,9 @@
 class BodyPair2DSW : public Constraint2DSW {
 
 	enum {
-		MAX_CONTACTS = 2
+		MAX_CONTACTS = 2,
+		BLOCK_SOLVER_MAX_CONDITION = 1000, // Past this condition number estimate, the points are solved one at a time.
+		CCD_TOI_ITERATIONS = 8 // Bisections of the swept shape test to find the time of impact.
 	};
 	union {
 		struct {
@@ -78,17 +80,40 @@ class BodyPair2DSW : public Constraint2DSW {
 	int contact_count;
 	bool collided;
 	bool oneway_disabled;
+	bool batch_separated; // Set by the separation batch, valid for the next setup() only.
 	int cc;
 
-	bool _test_ccd(real_t p_step, Body2DSW *p_A, int p_shape_A, const Transform2D &p_xform_A, Body2DSW *p_B, int p_shape_B, const Transform2D &p_xform_B, bool p_swap_result = false);
+	bool block_solver; // Both contacts are active and well conditioned, their normal impulses are solved together.
+	real_t block_k12; // Off-diagonal term of the normal mass matrix K.
+	real_t block_mass[3]; // Inverse of K, as the 11, 12 and 22 terms.
+
+	struct State {
+		Vector2 sep_axis;
+		Contact contacts[MAX_CONTACTS];
+		int contact_count;
+		bool collided;
+		bool oneway_disabled;
+	};
+
+	bool _test_ccd(Body2DSW *p_A, int p_shape_A, const Transform2D &p_xform_A, Body2DSW *p_B, int p_shape_B, const Transform2D &p_xform_B, bool p_swap_result = false);
+	bool _test_ccd_cast(Body2DSW *p_A, int p_shape_A, const Transform2D &p_xform_A, Body2DSW *p_B, int p_shape_B, const Transform2D &p_xform_B, bool p_swap_result = false);
 	void _validate_contacts();
+	void _setup_block_solver();
+	void _solve_block();
 	static void _add_contact(const Vector2 &p_point_A, const Vector2 &p_point_B, void *p_self);
+	static void _add_ccd_contact(const Vector2 &p_point_A, const Vector2 &p_point_B, void *p_userdata);
 	_FORCE_INLINE_ void _contact_added_callback(const Vector2 &p_point_A, const Vector2 &p_point_B);
 
 public:
+	void add_to_separation_batch(SeparationBatch2DSW *p_batch);
 	bool setup(real_t p_step);
 	void solve(real_t p_step);
 
+	int get_state_size() const { return sizeof(State); }
+	void save_state(uint8_t *r_state) const;
+	void restore_state(const uint8_t *p_state);
+	void reset_state();
+
 	BodyPair2DSW(Body2DSW *p_A, int p_shape_A, Body2DSW *p_B, int p_shape_B);
 	~BodyPair2DSW();
 };
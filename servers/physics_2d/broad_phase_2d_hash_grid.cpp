@@ -34,86 +34,185 @@
 
 #define LARGE_ELEMENT_FI 1.01239812
 
-void BroadPhase2DHashGrid::_pair_attempt(Element *p_elem, Element *p_with) {
+int BroadPhase2DHashGrid::_cell_set_inc(CellSet &p_set, Element *p_elem) {
+
+	// Cells hold few elements, a binary search over a flat array beats a tree.
+	uint32_t lo = 0;
+	uint32_t hi = p_set.size();
+	while (lo < hi) {
+		uint32_t mid = (lo + hi) / 2;
+		if (p_set[mid].element < p_elem) {
+			lo = mid + 1;
+		} else {
+			hi = mid;
+		}
+	}
 
-	Map<Element *, PairData *>::Element *E = p_elem->paired.find(p_with);
+	if (lo < p_set.size() && p_set[lo].element == p_elem) {
+		return ++p_set[lo].rc;
+	}
+
+	CellEntry entry;
+	entry.element = p_elem;
+	entry.rc = 1;
+	p_set.insert(lo, entry);
+	return 1;
+}
+
+int BroadPhase2DHashGrid::_cell_set_dec(CellSet &p_set, Element *p_elem) {
+
+	uint32_t lo = 0;
+	uint32_t hi = p_set.size();
+	while (lo < hi) {
+		uint32_t mid = (lo + hi) / 2;
+		if (p_set[mid].element < p_elem) {
+			lo = mid + 1;
+		} else {
+			hi = mid;
+		}
+	}
+
+	ERR_FAIL_COND_V(lo >= p_set.size() || p_set[lo].element != p_elem, -1);
+
+	int rc = --p_set[lo].rc;
+	if (rc == 0) {
+		p_set.remove(lo);
+	}
+	return rc;
+}
+
+void BroadPhase2DHashGrid::_pair_attempt(Element *p_elem, Element *p_with) {
 
 	ERR_FAIL_COND(p_elem->_static && p_with->_static);
 
-	if (!E) {
+	uint64_t key = _get_pair_key(p_elem->self, p_with->self);
+	PairData *pd = NULL;
+
+	if (pair_map.lookup(key, pd)) {
+		pd->rc++;
+		return;
+	}
 
-		PairData *pd = memnew(PairData);
-		p_elem->paired[p_with] = pd;
-		p_with->paired[p_elem] = pd;
+	if (free_pairs.size()) {
+		pd = free_pairs[free_pairs.size() - 1];
+		free_pairs.resize(free_pairs.size() - 1);
 	} else {
-		E->get()->rc++;
+		pd = memnew(PairData);
 	}
+
+	pd->a = p_elem;
+	pd->b = p_with;
+	pd->index_a = p_elem->pairs.size();
+	pd->index_b = p_with->pairs.size();
+	pd->colliding = false;
+	pd->rc = 1;
+	pd->ud = NULL;
+
+	p_elem->pairs.push_back(pd);
+	p_with->pairs.push_back(pd);
+	pair_map.insert(key, pd);
+}
+
+void BroadPhase2DHashGrid::_remove_pair(PairData *p_pair) {
+
+	// Swap with the last pair of each list, which then takes over the freed position.
+	Element *elems[2] = { p_pair->a, p_pair->b };
+	uint32_t indices[2] = { p_pair->index_a, p_pair->index_b };
+
+	for (int i = 0; i < 2; i++) {
+		LocalVector<PairData *> &pairs = elems[i]->pairs;
+		PairData *last = pairs[pairs.size() - 1];
+		pairs[indices[i]] = last;
+		if (last->a == elems[i]) {
+			last->index_a = indices[i];
+		} else {
+			last->index_b = indices[i];
+		}
+		pairs.resize(pairs.size() - 1);
+	}
+
+	pair_map.remove(_get_pair_key(p_pair->a->self, p_pair->b->self));
+	free_pairs.push_back(p_pair);
 }
 
 void BroadPhase2DHashGrid::_unpair_attempt(Element *p_elem, Element *p_with) {
 
-	Map<Element *, PairData *>::Element *E = p_elem->paired.find(p_with);
+	PairData *pd = NULL;
+	bool paired = pair_map.lookup(_get_pair_key(p_elem->self, p_with->self), pd);
 
-	ERR_FAIL_COND(!E); //this should really be paired..
+	ERR_FAIL_COND(!paired); //this should really be paired..
 
-	E->get()->rc--;
+	pd->rc--;
 
-	if (E->get()->rc == 0) {
+	if (pd->rc == 0) {
 
-		if (E->get()->colliding) {
+		if (pd->colliding) {
 			//uncollide
 			if (unpair_callback) {
-				unpair_callback(p_elem->owner, p_elem->subindex, p_with->owner, p_with->subindex, E->get()->ud, unpair_userdata);
+				unpair_callback(p_elem->owner, p_elem->subindex, p_with->owner, p_with->subindex, pd->ud, unpair_userdata);
 			}
 		}
 
-		memdelete(E->get());
-		p_elem->paired.erase(E);
-		p_with->paired.erase(p_elem);
+		_remove_pair(pd);
 	}
 }
 
-void BroadPhase2DHashGrid::_check_motion(Element *p_elem) {
+void BroadPhase2DHashGrid::_check_motion(Element *p_elem, uint32_t p_skip_bulk_before) {
+
+	for (uint32_t i = 0; i < p_elem->pairs.size(); i++) {
 
-	for (Map<Element *, PairData *>::Element *E = p_elem->paired.front(); E; E = E->next()) {
+		PairData *pd = p_elem->pairs[i];
+		Element *other = pd->a == p_elem ? pd->b : pd->a;
 
-		bool physical_collision = p_elem->aabb.intersects(E->key()->aabb);
-		bool logical_collision = p_elem->owner->test_collision_mask(E->key()->owner);
+		if (other->bulk_index < p_skip_bulk_before) {
+			continue; // Already checked from the other side by end_bulk_move().
+		}
+
+		bool physical_collision = p_elem->aabb.intersects(other->aabb);
+		bool logical_collision = p_elem->owner->test_collision_mask(other->owner);
 
 		if (physical_collision) {
-			if (!E->get()->colliding || (logical_collision && !E->get()->ud && pair_callback)) {
-				E->get()->ud = pair_callback(p_elem->owner, p_elem->subindex, E->key()->owner, E->key()->subindex, pair_userdata);
-			} else if (E->get()->colliding && !logical_collision && E->get()->ud && unpair_callback) {
-				unpair_callback(p_elem->owner, p_elem->subindex, E->key()->owner, E->key()->subindex, E->get()->ud, unpair_userdata);
-				E->get()->ud = nullptr;
+			if (!pd->colliding || (logical_collision && !pd->ud && pair_callback)) {
+				pd->ud = pair_callback(p_elem->owner, p_elem->subindex, other->owner, other->subindex, pair_userdata);
+			} else if (pd->colliding && !logical_collision && pd->ud && unpair_callback) {
+				unpair_callback(p_elem->owner, p_elem->subindex, other->owner, other->subindex, pd->ud, unpair_userdata);
+				pd->ud = nullptr;
 			}
-			E->get()->colliding = true;
+			pd->colliding = true;
 		} else { // No physcial_collision
-			if (E->get()->colliding && unpair_callback) {
-				unpair_callback(p_elem->owner, p_elem->subindex, E->key()->owner, E->key()->subindex, E->get()->ud, unpair_userdata);
+			if (pd->colliding && unpair_callback) {
+				unpair_callback(p_elem->owner, p_elem->subindex, other->owner, other->subindex, pd->ud, unpair_userdata);
 			}
-			E->get()->colliding = false;
+			pd->colliding = false;
 		}
 	}
 }
 
-void BroadPhase2DHashGrid::_enter_grid(Element *p_elem, const Rect2 &p_rect, bool p_static) {
+bool BroadPhase2DHashGrid::_is_large(const Rect2 &p_rect) const {
 
 	Vector2 sz = (p_rect.size / cell_size * LARGE_ELEMENT_FI); //use magic number to avoid floating point issues
-	if (sz.width * sz.height > large_object_min_surface) {
+	return sz.width * sz.height > large_object_min_surface;
+}
+
+void BroadPhase2DHashGrid::_enter_grid(Element *p_elem, const Rect2 &p_rect, bool p_static) {
+
+	if (_is_large(p_rect)) {
 		//large object, do not use grid, must check against all elements
-		for (Map<ID, Element>::Element *E = element_map.front(); E; E = E->next()) {
-			if (E->key() == p_elem->self)
+		for (uint32_t i = 0; i < elements.size(); i++) {
+			Element *e = elements[i];
+			if (!e)
+				continue;
+			if (e == p_elem)
 				continue; // do not pair against itself
-			if (E->get().owner == p_elem->owner)
+			if (e->owner == p_elem->owner)
 				continue;
-			if (E->get()._static && p_static)
+			if (e->_static && p_static)
 				continue;
 
-			_pair_attempt(p_elem, &E->get());
+			_pair_attempt(p_elem, e);
 		}
 
-		large_elements[p_elem].inc();
+		_cell_set_inc(large_elements, p_elem);
 		return;
 	}
 
@@ -144,18 +243,23 @@ void BroadPhase2DHashGrid::_enter_grid(Element *p_elem, const Rect2 &p_rect, boo
 
 			if (!pb) {
 				//does not exist, create!
-				pb = memnew(PosBin);
+				if (free_bins) {
+					pb = free_bins;
+					free_bins = pb->next;
+				} else {
+					pb = memnew(PosBin);
+				}
 				pb->key = pk;
 				pb->next = hash_table[idx];
 				hash_table[idx] = pb;
 			}
 
 			if (p_static) {
-				if (pb->static_object_set[p_elem].inc() == 1) {
+				if (_cell_set_inc(pb->static_object_set, p_elem) == 1) {
 					entered = true;
 				}
 			} else {
-				if (pb->object_set[p_elem].inc() == 1) {
+				if (_cell_set_inc(pb->object_set, p_elem) == 1) {
 
 					entered = true;
 				}
@@ -163,20 +267,22 @@ void BroadPhase2DHashGrid::_enter_grid(Element *p_elem, const Rect2 &p_rect, boo
 
 			if (entered) {
 
-				for (Map<Element *, RC>::Element *E = pb->object_set.front(); E; E = E->next()) {
+				for (uint32_t k = 0; k < pb->object_set.size(); k++) {
 
-					if (E->key()->owner == p_elem->owner)
+					Element *e = pb->object_set[k].element;
+					if (e->owner == p_elem->owner)
 						continue;
-					_pair_attempt(p_elem, E->key());
+					_pair_attempt(p_elem, e);
 				}
 
 				if (!p_static) {
 
-					for (Map<Element *, RC>::Element *E = pb->static_object_set.front(); E; E = E->next()) {
+					for (uint32_t k = 0; k < pb->static_object_set.size(); k++) {
 
-						if (E->key()->owner == p_elem->owner)
+						Element *e = pb->static_object_set[k].element;
+						if (e->owner == p_elem->owner)
 							continue;
-						_pair_attempt(p_elem, E->key());
+						_pair_attempt(p_elem, e);
 					}
 				}
 			}
@@ -185,35 +291,34 @@ void BroadPhase2DHashGrid::_enter_grid(Element *p_elem, const Rect2 &p_rect, boo
 
 	//pair separatedly with large elements
 
-	for (Map<Element *, RC>::Element *E = large_elements.front(); E; E = E->next()) {
+	for (uint32_t i = 0; i < large_elements.size(); i++) {
 
-		if (E->key() == p_elem)
+		Element *e = large_elements[i].element;
+		if (e == p_elem)
 			continue; // do not pair against itself
-		if (E->key()->owner == p_elem->owner)
+		if (e->owner == p_elem->owner)
 			continue;
-		if (E->key()->_static && p_static)
+		if (e->_static && p_static)
 			continue;
 
-		_pair_attempt(E->key(), p_elem);
+		_pair_attempt(e, p_elem);
 	}
 }
 
 void BroadPhase2DHashGrid::_exit_grid(Element *p_elem, const Rect2 &p_rect, bool p_static) {
 
-	Vector2 sz = (p_rect.size / cell_size * LARGE_ELEMENT_FI);
-	if (sz.width * sz.height > large_object_min_surface) {
+	if (_is_large(p_rect)) {
 
 		//unpair all elements, instead of checking all, just check what is already paired, so we at least save from checking static vs static
-		Map<Element *, PairData *>::Element *E = p_elem->paired.front();
-		while (E) {
-			Map<Element *, PairData *>::Element *next = E->next();
-			_unpair_attempt(p_elem, E->key());
-			E = next;
+		//backwards, as unpairing moves the last pair into the freed position
+		for (int i = (int)p_elem->pairs.size() - 1; i >= 0; i--) {
+			if (i >= (int)p_elem->pairs.size())
+				continue;
+			PairData *pd = p_elem->pairs[i];
+			_unpair_attempt(p_elem, pd->a == p_elem ? pd->b : pd->a);
 		}
 
-		if (large_elements[p_elem].dec() == 0) {
-			large_elements.erase(p_elem);
-		}
+		_cell_set_dec(large_elements, p_elem);
 		return;
 	}
 
@@ -245,35 +350,35 @@ void BroadPhase2DHashGrid::_exit_grid(Element *p_elem, const Rect2 &p_rect, bool
 			bool exited = false;
 
 			if (p_static) {
-				if (pb->static_object_set[p_elem].dec() == 0) {
+				if (_cell_set_dec(pb->static_object_set, p_elem) == 0) {
 
-					pb->static_object_set.erase(p_elem);
 					exited = true;
 				}
 			} else {
-				if (pb->object_set[p_elem].dec() == 0) {
+				if (_cell_set_dec(pb->object_set, p_elem) == 0) {
 
-					pb->object_set.erase(p_elem);
 					exited = true;
 				}
 			}
 
 			if (exited) {
 
-				for (Map<Element *, RC>::Element *E = pb->object_set.front(); E; E = E->next()) {
+				for (uint32_t k = 0; k < pb->object_set.size(); k++) {
 
-					if (E->key()->owner == p_elem->owner)
+					Element *e = pb->object_set[k].element;
+					if (e->owner == p_elem->owner)
 						continue;
-					_unpair_attempt(p_elem, E->key());
+					_unpair_attempt(p_elem, e);
 				}
 
 				if (!p_static) {
 
-					for (Map<Element *, RC>::Element *E = pb->static_object_set.front(); E; E = E->next()) {
+					for (uint32_t k = 0; k < pb->static_object_set.size(); k++) {
 
-						if (E->key()->owner == p_elem->owner)
+						Element *e = pb->static_object_set[k].element;
+						if (e->owner == p_elem->owner)
 							continue;
-						_unpair_attempt(p_elem, E->key());
+						_unpair_attempt(p_elem, e);
 					}
 				}
 			}
@@ -299,114 +404,176 @@ void BroadPhase2DHashGrid::_exit_grid(Element *p_elem, const Rect2 &p_rect, bool
 					ERR_CONTINUE(!px);
 				}
 
-				memdelete(pb);
+				pb->next = free_bins;
+				free_bins = pb;
 			}
 		}
 	}
 
-	for (Map<Element *, RC>::Element *E = large_elements.front(); E; E = E->next()) {
-		if (E->key() == p_elem)
+	for (uint32_t i = 0; i < large_elements.size(); i++) {
+
+		Element *e = large_elements[i].element;
+		if (e == p_elem)
 			continue; // do not pair against itself
-		if (E->key()->owner == p_elem->owner)
+		if (e->owner == p_elem->owner)
 			continue;
-		if (E->key()->_static && p_static)
+		if (e->_static && p_static)
 			continue;
 
 		//unpair from large elements
-		_unpair_attempt(p_elem, E->key());
+		_unpair_attempt(p_elem, e);
 	}
 }
 
 BroadPhase2DHashGrid::ID BroadPhase2DHashGrid::create(CollisionObject2DSW *p_object, int p_subindex) {
 
-	current++;
+	ID id;
+	if (free_ids.size()) {
+		id = free_ids[free_ids.size() - 1];
+		free_ids.resize(free_ids.size() - 1);
+	} else {
+		elements.push_back(NULL);
+		id = elements.size();
+	}
 
-	Element e;
-	e.owner = p_object;
-	e._static = false;
-	e.subindex = p_subindex;
-	e.self = current;
-	e.pass = 0;
+	Element *e = memnew(Element);
+	e->owner = p_object;
+	e->_static = false;
+	e->subindex = p_subindex;
+	e->self = id;
+	e->pass = 0;
+	e->bulk_index = BULK_NONE;
 
-	element_map[current] = e;
-	return current;
+	elements[id - 1] = e;
+	return id;
 }
 
 void BroadPhase2DHashGrid::move(ID p_id, const Rect2 &p_aabb) {
 
-	Map<ID, Element>::Element *E = element_map.find(p_id);
-	ERR_FAIL_COND(!E);
+	Element *e = _get_element(p_id);
+	ERR_FAIL_COND(!e);
 
-	Element &e = E->get();
+	if (p_aabb != e->aabb) {
 
-	if (p_aabb != e.aabb) {
+		bool same_cells = false;
+		if (p_aabb != Rect2() && e->aabb != Rect2() && !_is_large(p_aabb) && !_is_large(e->aabb)) {
+			// Entering and leaving the same cells only adds and removes references.
+			same_cells = (p_aabb.position / cell_size).floor() == (e->aabb.position / cell_size).floor() &&
+						 ((p_aabb.position + p_aabb.size) / cell_size).floor() == ((e->aabb.position + e->aabb.size) / cell_size).floor();
+		}
+
+		if (!same_cells) {
+
+			if (p_aabb != Rect2()) {
+
+				_enter_grid(e, p_aabb, e->_static);
+			}
 
-		if (p_aabb != Rect2()) {
+			if (e->aabb != Rect2()) {
 
-			_enter_grid(&e, p_aabb, e._static);
+				_exit_grid(e, e->aabb, e->_static);
+			}
 		}
 
-		if (e.aabb != Rect2()) {
+		e->aabb = p_aabb;
+	}
 
-			_exit_grid(&e, e.aabb, e._static);
+	if (bulk_moving) {
+		if (e->bulk_index == BULK_NONE) {
+			e->bulk_index = bulk_moved.size();
+			bulk_moved.push_back(e);
 		}
+		return;
+	}
+
+	_check_motion(e);
+}
+
+void BroadPhase2DHashGrid::begin_bulk_move() {
+
+	bulk_moving = true;
+}
+
+void BroadPhase2DHashGrid::end_bulk_move() {
 
-		e.aabb = p_aabb;
+	bulk_moving = false;
+
+	// A pair of two moved elements is checked only from the one that comes first.
+	for (uint32_t i = 0; i < bulk_moved.size(); i++) {
+		_check_motion(bulk_moved[i], i);
 	}
 
-	_check_motion(&e);
+	for (uint32_t i = 0; i < bulk_moved.size(); i++) {
+		bulk_moved[i]->bulk_index = BULK_NONE;
+	}
+	bulk_moved.clear();
 }
 
 void BroadPhase2DHashGrid::set_static(ID p_id, bool p_static) {
 
-	Map<ID, Element>::Element *E = element_map.find(p_id);
-	ERR_FAIL_COND(!E);
-
-	Element &e = E->get();
+	Element *e = _get_element(p_id);
+	ERR_FAIL_COND(!e);
 
-	if (e._static == p_static)
+	if (e->_static == p_static)
 		return;
 
-	if (e.aabb != Rect2())
-		_exit_grid(&e, e.aabb, e._static);
+	if (e->aabb != Rect2())
+		_exit_grid(e, e->aabb, e->_static);
 
-	e._static = p_static;
+	e->_static = p_static;
 
-	if (e.aabb != Rect2()) {
-		_enter_grid(&e, e.aabb, e._static);
-		_check_motion(&e);
+	if (e->aabb != Rect2()) {
+		_enter_grid(e, e->aabb, e->_static);
+		_check_motion(e);
 	}
 }
 void BroadPhase2DHashGrid::remove(ID p_id) {
 
-	Map<ID, Element>::Element *E = element_map.find(p_id);
-	ERR_FAIL_COND(!E);
+	Element *e = _get_element(p_id);
+	ERR_FAIL_COND(!e);
 
-	Element &e = E->get();
+	if (e->aabb != Rect2())
+		_exit_grid(e, e->aabb, e->_static);
+
+	// Large elements also pair with elements that are outside the grid.
+	while (e->pairs.size()) {
+		PairData *pd = e->pairs[e->pairs.size() - 1];
+		if (pd->colliding && unpair_callback) {
+			Element *other = pd->a == e ? pd->b : pd->a;
+			unpair_callback(e->owner, e->subindex, other->owner, other->subindex, pd->ud, unpair_userdata);
+		}
+		_remove_pair(pd);
+	}
 
-	if (e.aabb != Rect2())
-		_exit_grid(&e, e.aabb, e._static);
+	if (e->bulk_index != BULK_NONE) {
+		Element *last = bulk_moved[bulk_moved.size() - 1];
+		bulk_moved[e->bulk_index] = last;
+		last->bulk_index = e->bulk_index;
+		bulk_moved.resize(bulk_moved.size() - 1);
+	}
 
-	element_map.erase(p_id);
+	elements[p_id - 1] = NULL;
+	free_ids.push_back(p_id);
+	memdelete(e);
 }
 
 CollisionObject2DSW *BroadPhase2DHashGrid::get_object(ID p_id) const {
 
-	const Map<ID, Element>::Element *E = element_map.find(p_id);
-	ERR_FAIL_COND_V(!E, NULL);
-	return E->get().owner;
+	const Element *e = _get_element(p_id);
+	ERR_FAIL_COND_V(!e, NULL);
+	return e->owner;
 }
 bool BroadPhase2DHashGrid::is_static(ID p_id) const {
 
-	const Map<ID, Element>::Element *E = element_map.find(p_id);
-	ERR_FAIL_COND_V(!E, false);
-	return E->get()._static;
+	const Element *e = _get_element(p_id);
+	ERR_FAIL_COND_V(!e, false);
+	return e->_static;
 }
 int BroadPhase2DHashGrid::get_subindex(ID p_id) const {
 
-	const Map<ID, Element>::Element *E = element_map.find(p_id);
-	ERR_FAIL_COND_V(!E, -1);
-	return E->get().subindex;
+	const Element *e = _get_element(p_id);
+	ERR_FAIL_COND_V(!e, -1);
+	return e->subindex;
 }
 
 template <bool use_aabb, bool use_segment>
@@ -431,43 +598,47 @@ void BroadPhase2DHashGrid::_cull(const Point2i p_cell, const Rect2 &p_aabb, cons
 	if (!pb)
 		return;
 
-	for (Map<Element *, RC>::Element *E = pb->object_set.front(); E; E = E->next()) {
+	for (uint32_t i = 0; i < pb->object_set.size(); i++) {
+
+		Element *e = pb->object_set[i].element;
 
 		if (index >= p_max_results)
 			break;
-		if (E->key()->pass == pass)
+		if (e->pass == pass)
 			continue;
 
-		E->key()->pass = pass;
+		e->pass = pass;
 
-		if (use_aabb && !p_aabb.intersects(E->key()->aabb))
+		if (use_aabb && !p_aabb.intersects(e->aabb))
 			continue;
 
-		if (use_segment && !E->key()->aabb.intersects_segment(p_from, p_to))
+		if (use_segment && !e->aabb.intersects_segment(p_from, p_to))
 			continue;
 
-		p_results[index] = E->key()->owner;
-		p_result_indices[index] = E->key()->subindex;
+		p_results[index] = e->owner;
+		p_result_indices[index] = e->subindex;
 		index++;
 	}
 
-	for (Map<Element *, RC>::Element *E = pb->static_object_set.front(); E; E = E->next()) {
+	for (uint32_t i = 0; i < pb->static_object_set.size(); i++) {
+
+		Element *e = pb->static_object_set[i].element;
 
 		if (index >= p_max_results)
 			break;
-		if (E->key()->pass == pass)
+		if (e->pass == pass)
 			continue;
 
-		if (use_aabb && !p_aabb.intersects(E->key()->aabb)) {
+		if (use_aabb && !p_aabb.intersects(e->aabb)) {
 			continue;
 		}
 
-		if (use_segment && !E->key()->aabb.intersects_segment(p_from, p_to))
+		if (use_segment && !e->aabb.intersects_segment(p_from, p_to))
 			continue;
 
-		E->key()->pass = pass;
-		p_results[index] = E->key()->owner;
-		p_result_indices[index] = E->key()->subindex;
+		e->pass = pass;
+		p_results[index] = e->owner;
+		p_result_indices[index] = e->subindex;
 		index++;
 	}
 }
@@ -547,25 +718,27 @@ int BroadPhase2DHashGrid::cull_segment(const Vector2 &p_from, const Vector2 &p_t
 			break;
 	}
 
-	for (Map<Element *, RC>::Element *E = large_elements.front(); E; E = E->next()) {
+	for (uint32_t i = 0; i < large_elements.size(); i++) {
+
+		Element *e = large_elements[i].element;
 
 		if (cullcount >= p_max_results)
 			break;
-		if (E->key()->pass == pass)
+		if (e->pass == pass)
 			continue;
 
-		E->key()->pass = pass;
+		e->pass = pass;
 
 		/*
-		if (use_aabb && !p_aabb.intersects(E->key()->aabb))
+		if (use_aabb && !p_aabb.intersects(e->aabb))
 			continue;
 		*/
 
-		if (!E->key()->aabb.intersects_segment(p_from, p_to))
+		if (!e->aabb.intersects_segment(p_from, p_to))
 			continue;
 
-		p_results[cullcount] = E->key()->owner;
-		p_result_indices[cullcount] = E->key()->subindex;
+		p_results[cullcount] = e->owner;
+		p_result_indices[cullcount] = e->subindex;
 		cullcount++;
 	}
 
@@ -588,25 +761,27 @@ int BroadPhase2DHashGrid::cull_aabb(const Rect2 &p_aabb, CollisionObject2DSW **p
 		}
 	}
 
-	for (Map<Element *, RC>::Element *E = large_elements.front(); E; E = E->next()) {
+	for (uint32_t i = 0; i < large_elements.size(); i++) {
+
+		Element *e = large_elements[i].element;
 
 		if (cullcount >= p_max_results)
 			break;
-		if (E->key()->pass == pass)
+		if (e->pass == pass)
 			continue;
 
-		E->key()->pass = pass;
+		e->pass = pass;
 
-		if (!p_aabb.intersects(E->key()->aabb))
+		if (!p_aabb.intersects(e->aabb))
 			continue;
 
 		/*
-		if (!E->key()->aabb.intersects_segment(p_from,p_to))
+		if (!e->aabb.intersects_segment(p_from,p_to))
 			continue;
 		*/
 
-		p_results[cullcount] = E->key()->owner;
-		p_result_indices[cullcount] = E->key()->subindex;
+		p_results[cullcount] = e->owner;
+		p_result_indices[cullcount] = e->subindex;
 		cullcount++;
 	}
 	return cullcount;
@@ -646,9 +821,10 @@ BroadPhase2DHashGrid::BroadPhase2DHashGrid() {
 
 	for (uint32_t i = 0; i < hash_table_size; i++)
 		hash_table[i] = NULL;
+	free_bins = NULL;
 	pass = 1;
 
-	current = 0;
+	bulk_moving = false;
 }
 
 BroadPhase2DHashGrid::~BroadPhase2DHashGrid() {
@@ -661,7 +837,27 @@ BroadPhase2DHashGrid::~BroadPhase2DHashGrid() {
 		}
 	}
 
+	while (free_bins) {
+		PosBin *pb = free_bins;
+		free_bins = pb->next;
+		memdelete(pb);
+	}
+
 	memdelete_arr(hash_table);
+
+	for (OAHashMap<uint64_t, PairData *>::Iterator it = pair_map.iter(); it.valid; it = pair_map.next_iter(it)) {
+		memdelete(*it.value);
+	}
+
+	for (uint32_t i = 0; i < free_pairs.size(); i++) {
+		memdelete(free_pairs[i]);
+	}
+
+	for (uint32_t i = 0; i < elements.size(); i++) {
+		if (elements[i]) {
+			memdelete(elements[i]);
+		}
+	}
 }
 
 /* 3D version of voxel traversal:
@@ -32,20 +32,27 @@
 #define BROAD_PHASE_2D_HASH_GRID_H
 
 #include "broad_phase_2d_sw.h"
-#include "core/map.h"
+#include "core/local_vector.h"
+#include "core/oa_hash_map.h"
 
 class BroadPhase2DHashGrid : public BroadPhase2DSW {
 
+	struct Element;
+
+	// Shared by the two elements, found through pair_map or their pair lists.
 	struct PairData {
 
+		Element *a;
+		Element *b;
+		uint32_t index_a; // Position in a->pairs.
+		uint32_t index_b; // Position in b->pairs.
 		bool colliding;
 		int rc;
 		void *ud;
-		PairData() {
-			colliding = false;
-			rc = 1;
-			ud = NULL;
-		}
+	};
+
+	enum {
+		BULK_NONE = 0xFFFFFFFF
 	};
 
 	struct Element {
@@ -56,61 +63,41 @@ class BroadPhase2DHashGrid : public BroadPhase2DSW {
 		Rect2 aabb;
 		int subindex;
 		uint64_t pass;
-		Map<Element *, PairData *> paired;
+		uint32_t bulk_index; // Position in bulk_moved, BULK_NONE when not waiting for end_bulk_move().
+		LocalVector<PairData *> pairs;
 	};
 
-	struct RC {
-
-		int ref;
+	// Reference counted element of a cell (or of large_elements), kept sorted by address.
+	struct CellEntry {
 
-		_FORCE_INLINE_ int inc() {
-			ref++;
-			return ref;
-		}
-		_FORCE_INLINE_ int dec() {
-			ref--;
-			return ref;
-		}
-
-		_FORCE_INLINE_ RC() {
-			ref = 0;
-		}
+		Element *element;
+		int rc;
 	};
 
-	Map<ID, Element> element_map;
-	Map<Element *, RC> large_elements;
+	typedef LocalVector<CellEntry> CellSet;
 
-	ID current;
+	static int _cell_set_inc(CellSet &p_set, Element *p_elem);
+	static int _cell_set_dec(CellSet &p_set, Element *p_elem);
 
-	uint64_t pass;
+	LocalVector<Element *> elements; // Indexed by ID - 1, NULL for removed IDs.
+	LocalVector<ID> free_ids;
+	CellSet large_elements;
 
-	struct PairKey {
+	uint64_t pass;
 
-		union {
-			struct {
-				ID a;
-				ID b;
-			};
-			uint64_t key;
-		};
+	OAHashMap<uint64_t, PairData *> pair_map; // Key made of both IDs, see _get_pair_key().
+	LocalVector<PairData *> free_pairs;
 
-		_FORCE_INLINE_ bool operator<(const PairKey &p_key) const {
-			return key < p_key.key;
-		}
+	_FORCE_INLINE_ static uint64_t _get_pair_key(ID p_a, ID p_b) {
+		return p_a < p_b ? ((uint64_t)p_a << 32) | p_b : ((uint64_t)p_b << 32) | p_a;
+	}
 
-		PairKey() { key = 0; }
-		PairKey(ID p_a, ID p_b) {
-			if (p_a > p_b) {
-				a = p_b;
-				b = p_a;
-			} else {
-				a = p_a;
-				b = p_b;
-			}
-		}
-	};
+	_FORCE_INLINE_ Element *_get_element(ID p_id) const {
+		return p_id > 0 && p_id <= elements.size() ? elements[p_id - 1] : NULL;
+	}
 
-	Map<PairKey, PairData> pair_map;
+	bool bulk_moving;
+	LocalVector<Element *> bulk_moved;
 
 	int cell_size;
 	int large_object_min_surface;
@@ -120,6 +107,7 @@ class BroadPhase2DHashGrid : public BroadPhase2DSW {
 	UnpairCallback unpair_callback;
 	void *unpair_userdata;
 
+	_FORCE_INLINE_ bool _is_large(const Rect2 &p_rect) const;
 	void _enter_grid(Element *p_elem, const Rect2 &p_rect, bool p_static);
 	void _exit_grid(Element *p_elem, const Rect2 &p_rect, bool p_static);
 	template <bool use_aabb, bool use_segment>
@@ -155,21 +143,25 @@ class BroadPhase2DHashGrid : public BroadPhase2DSW {
 	struct PosBin {
 
 		PosKey key;
-		Map<Element *, RC> object_set;
-		Map<Element *, RC> static_object_set;
+		CellSet object_set;
+		CellSet static_object_set;
 		PosBin *next;
 	};
 
 	uint32_t hash_table_size;
 	PosBin **hash_table;
+	PosBin *free_bins; // Emptied bins, kept with their memory for the next cell that gets entered.
 
 	void _pair_attempt(Element *p_elem, Element *p_with);
 	void _unpair_attempt(Element *p_elem, Element *p_with);
-	void _check_motion(Element *p_elem);
+	void _remove_pair(PairData *p_pair);
+	void _check_motion(Element *p_elem, uint32_t p_skip_bulk_before = 0);
 
 public:
 	virtual ID create(CollisionObject2DSW *p_object, int p_subindex = 0);
 	virtual void move(ID p_id, const Rect2 &p_aabb);
+	virtual void begin_bulk_move();
+	virtual void end_bulk_move();
 	virtual void set_static(ID p_id, bool p_static);
 	virtual void remove(ID p_id);
 
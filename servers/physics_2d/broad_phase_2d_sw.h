@@ -51,7 +51,13 @@ public:
 	// 0 is an invalid ID
 	virtual ID create(CollisionObject2DSW *p_object_, int p_subindex = 0) = 0;
 	virtual void move(ID p_id, const Rect2 &p_aabb) = 0;
+	// Between these, move() may put off reporting pairs until end_bulk_move(), when each
+	// pair is checked once against the final bounds of both elements.
+	virtual void begin_bulk_move() {}
+	virtual void end_bulk_move() {}
 	virtual void set_static(ID p_id, bool p_static) = 0;
+	// Called when the collision layer or mask of the owner changes, pairs rejected by the old ones may now collide.
+	virtual void recheck_pairs(ID p_id) {}
 	virtual void remove(ID p_id) = 0;
 
 	virtual CollisionObject2DSW *get_object(ID p_id) const = 0;
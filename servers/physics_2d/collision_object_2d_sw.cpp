@@ -163,6 +163,18 @@ void CollisionObject2DSW::_set_static(bool p_static) {
 	}
 }
 
+void CollisionObject2DSW::_recheck_pairs() {
+
+	if (!space)
+		return;
+	for (int i = 0; i < get_shape_count(); i++) {
+		const Shape &s = shapes[i];
+		if (s.bpid > 0) {
+			space->get_broadphase()->recheck_pairs(s.bpid);
+		}
+	}
+}
+
 void CollisionObject2DSW::_unregister_shapes() {
 
 	for (int i = 0; i < shapes.size(); i++) {
@@ -271,5 +283,6 @@ CollisionObject2DSW::CollisionObject2DSW(Type p_type) :
 	canvas_instance_id = 0;
 	collision_mask = 1;
 	collision_layer = 1;
+	space_order = 0;
 	pickable = true;
 }
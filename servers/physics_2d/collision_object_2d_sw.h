@@ -76,13 +76,13 @@ private:
 	Transform2D inv_transform;
 	uint32_t collision_mask;
 	uint32_t collision_layer;
+	uint32_t space_order; // Objects added to the space before have lower values, see Constraint2DSW::get_order_key().
 	bool _static;
 
 	SelfList<CollisionObject2DSW> pending_shape_update_list;
 
-	void _update_shapes();
-
 protected:
+	void _update_shapes();
 	void _update_shapes_with_motion(const Vector2 &p_motion);
 	void _unregister_shapes();
 
@@ -94,6 +94,7 @@ protected:
 	}
 	_FORCE_INLINE_ void _set_inv_transform(const Transform2D &p_transform) { inv_transform = p_transform; }
 	void _set_static(bool p_static);
+	void _recheck_pairs();
 
 	virtual void _shapes_changed() = 0;
 	void _set_space(Space2DSW *p_space);
@@ -113,6 +114,9 @@ public:
 	void _shape_changed();
 
 	_FORCE_INLINE_ Type get_type() const { return type; }
+
+	_FORCE_INLINE_ void set_space_order(uint32_t p_order) { space_order = p_order; }
+	_FORCE_INLINE_ uint32_t get_space_order() const { return space_order; }
 	void add_shape(Shape2DSW *p_shape, const Transform2D &p_transform = Transform2D(), bool p_disabled = false);
 	void set_shape(int p_index, Shape2DSW *p_shape);
 	void set_shape_transform(int p_index, const Transform2D &p_transform);
@@ -172,12 +176,14 @@ public:
 	void set_collision_mask(uint32_t p_mask) {
 		collision_mask = p_mask;
 		_shape_changed();
+		_recheck_pairs();
 	}
 	_FORCE_INLINE_ uint32_t get_collision_mask() const { return collision_mask; }
 
 	void set_collision_layer(uint32_t p_layer) {
 		collision_layer = p_layer;
 		_shape_changed();
+		_recheck_pairs();
 	}
 	_FORCE_INLINE_ uint32_t get_collision_layer() const { return collision_layer; }
 
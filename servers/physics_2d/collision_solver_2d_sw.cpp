@@ -250,3 +250,119 @@ bool CollisionSolver2DSW::solve(const Shape2DSW *p_shape_A, const Transform2D &p
 		return collision_solver(p_shape_A, p_transform_A, p_motion_A, p_shape_B, p_transform_B, p_motion_B, p_result_callback, p_userdata, false, sep_axis, margin_A, margin_B);
 	}
 }
+
+bool SeparationBatch2DSW::_get_rounded_box(const Shape2DSW *p_shape, const Transform2D &p_xform, Vector2 &r_axis_x, Vector2 &r_axis_y, real_t &r_radius) {
+
+	switch (p_shape->get_type()) {
+		case Physics2DServer::SHAPE_CIRCLE: {
+
+			// Scaled circles are ellipses, bound them with the largest scale (or the diagonal of a skewed basis).
+			real_t scale;
+			if (Math::is_zero_approx(p_xform.elements[0].dot(p_xform.elements[1]))) {
+				scale = Math::sqrt(MAX(p_xform.elements[0].length_squared(), p_xform.elements[1].length_squared()));
+			} else {
+				scale = Math::sqrt(p_xform.elements[0].length_squared() + p_xform.elements[1].length_squared());
+			}
+
+			r_axis_x = Vector2();
+			r_axis_y = Vector2();
+			r_radius = static_cast<const CircleShape2DSW *>(p_shape)->get_radius() * scale;
+		} break;
+		case Physics2DServer::SHAPE_RECTANGLE: {
+
+			const Vector2 &half_extents = static_cast<const RectangleShape2DSW *>(p_shape)->get_half_extents();
+			r_axis_x = p_xform.elements[0] * half_extents.x;
+			r_axis_y = p_xform.elements[1] * half_extents.y;
+			r_radius = 0;
+		} break;
+		default: {
+			return false;
+		}
+	}
+
+	return true;
+}
+
+bool SeparationBatch2DSW::add(const Shape2DSW *p_shape_A, const Transform2D &p_xform_A, const Shape2DSW *p_shape_B, const Transform2D &p_xform_B, bool *r_separated) {
+
+	Vector2 axis_A_x, axis_A_y, axis_B_x, axis_B_y;
+	real_t radius_A, radius_B;
+
+	if (!_get_rounded_box(p_shape_A, p_xform_A, axis_A_x, axis_A_y, radius_A) || !_get_rounded_box(p_shape_B, p_xform_B, axis_B_x, axis_B_y, radius_B)) {
+		return false;
+	}
+
+	Vector2 offset = p_xform_B.get_origin() - p_xform_A.get_origin();
+
+	fields[FIELD_OFFSET_X].push_back(offset.x);
+	fields[FIELD_OFFSET_Y].push_back(offset.y);
+	fields[FIELD_A_X_X].push_back(axis_A_x.x);
+	fields[FIELD_A_X_Y].push_back(axis_A_x.y);
+	fields[FIELD_A_Y_X].push_back(axis_A_y.x);
+	fields[FIELD_A_Y_Y].push_back(axis_A_y.y);
+	fields[FIELD_A_RADIUS].push_back(radius_A);
+	fields[FIELD_B_X_X].push_back(axis_B_x.x);
+	fields[FIELD_B_X_Y].push_back(axis_B_x.y);
+	fields[FIELD_B_Y_X].push_back(axis_B_y.x);
+	fields[FIELD_B_Y_Y].push_back(axis_B_y.y);
+	fields[FIELD_B_RADIUS].push_back(radius_B);
+	results.push_back(r_separated);
+
+	return true;
+}
+
+// Tests the pairs on axis (m_nx, m_ny), which doesn't need to be normalized. The radius
+// is compared squared and ABS() is a plain select, so nothing keeps the loop from vectorizing.
+#define SEPARATION_BATCH_TEST_AXIS(m_nx, m_ny)                                             \
+	{                                                                                      \
+		real_t nx = (m_nx);                                                                \
+		real_t ny = (m_ny);                                                                \
+		real_t gap = ABS(offset_x[i] * nx + offset_y[i] * ny) -                            \
+					 ABS(ax_x[i] * nx + ax_y[i] * ny) - ABS(ay_x[i] * nx + ay_y[i] * ny) - \
+					 ABS(bx_x[i] * nx + bx_y[i] * ny) - ABS(by_x[i] * nx + by_y[i] * ny);  \
+		real_t radius = a_radius[i] + b_radius[i] + (real_t)CMP_EPSILON;                   \
+		sep |= (gap > 0) & (gap * gap > radius * radius * (nx * nx + ny * ny));            \
+	}
+
+void SeparationBatch2DSW::run() {
+
+	uint32_t count = results.size();
+	separated.resize(count);
+
+	const real_t *__restrict offset_x = fields[FIELD_OFFSET_X].ptr();
+	const real_t *__restrict offset_y = fields[FIELD_OFFSET_Y].ptr();
+	const real_t *__restrict ax_x = fields[FIELD_A_X_X].ptr();
+	const real_t *__restrict ax_y = fields[FIELD_A_X_Y].ptr();
+	const real_t *__restrict ay_x = fields[FIELD_A_Y_X].ptr();
+	const real_t *__restrict ay_y = fields[FIELD_A_Y_Y].ptr();
+	const real_t *__restrict a_radius = fields[FIELD_A_RADIUS].ptr();
+	const real_t *__restrict bx_x = fields[FIELD_B_X_X].ptr();
+	const real_t *__restrict bx_y = fields[FIELD_B_X_Y].ptr();
+	const real_t *__restrict by_x = fields[FIELD_B_Y_X].ptr();
+	const real_t *__restrict by_y = fields[FIELD_B_Y_Y].ptr();
+	const real_t *__restrict b_radius = fields[FIELD_B_RADIUS].ptr();
+	uint32_t *__restrict out = separated.ptr();
+
+	// No branches or calls in here, so that the compiler can run several pairs per instruction.
+	for (uint32_t i = 0; i < count; i++) {
+
+		int sep = 0;
+		SEPARATION_BATCH_TEST_AXIS(offset_x[i], offset_y[i]);
+		SEPARATION_BATCH_TEST_AXIS(ax_x[i], ax_y[i]);
+		SEPARATION_BATCH_TEST_AXIS(ay_x[i], ay_y[i]);
+		SEPARATION_BATCH_TEST_AXIS(bx_x[i], bx_y[i]);
+		SEPARATION_BATCH_TEST_AXIS(by_x[i], by_y[i]);
+		out[i] = sep;
+	}
+
+	for (uint32_t i = 0; i < count; i++) {
+		*results[i] = out[i];
+	}
+
+	for (int i = 0; i < FIELD_MAX; i++) {
+		fields[i].clear();
+	}
+	results.clear();
+}
+
+#undef SEPARATION_BATCH_TEST_AXIS
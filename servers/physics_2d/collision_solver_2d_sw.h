@@ -31,6 +31,7 @@
 #ifndef COLLISION_SOLVER_2D_SW_H
 #define COLLISION_SOLVER_2D_SW_H
 
+#include "core/local_vector.h"
 #include "shape_2d_sw.h"
 
 class CollisionSolver2DSW {
@@ -47,4 +48,44 @@ public:
 	static bool solve(const Shape2DSW *p_shape_A, const Transform2D &p_transform_A, const Vector2 &p_motion_A, const Shape2DSW *p_shape_B, const Transform2D &p_transform_B, const Vector2 &p_motion_B, CallbackResult p_result_callback, void *p_userdata, Vector2 *sep_axis = NULL, real_t p_margin_A = 0, real_t p_margin_B = 0);
 };
 
+// Tests many pairs of circles and rectangles for separation at once, so that the full
+// solve can be skipped for them. Each shape becomes a box with rounded corners in world
+// space, stored by field in flat arrays, and is tested on the axes of both boxes and on
+// the axis between their centers. The test is conservative, pairs it keeps may still
+// turn out separated in the full solve.
+class SeparationBatch2DSW {
+
+	enum Field {
+		FIELD_OFFSET_X, // Center of B relative to A.
+		FIELD_OFFSET_Y,
+		FIELD_A_X_X, // Half extent axes of A.
+		FIELD_A_X_Y,
+		FIELD_A_Y_X,
+		FIELD_A_Y_Y,
+		FIELD_A_RADIUS,
+		FIELD_B_X_X,
+		FIELD_B_X_Y,
+		FIELD_B_Y_X,
+		FIELD_B_Y_Y,
+		FIELD_B_RADIUS,
+		FIELD_MAX
+	};
+
+	LocalVector<real_t> fields[FIELD_MAX];
+	LocalVector<uint32_t> separated; // Same width as real_t on most builds, which keeps the test loop vectorizable.
+	LocalVector<bool *> results;
+
+	static bool _get_rounded_box(const Shape2DSW *p_shape, const Transform2D &p_xform, Vector2 &r_axis_x, Vector2 &r_axis_y, real_t &r_radius);
+
+public:
+	static bool can_test(const Shape2DSW *p_shape) {
+		return p_shape->get_type() == Physics2DServer::SHAPE_CIRCLE || p_shape->get_type() == Physics2DServer::SHAPE_RECTANGLE;
+	}
+
+	// Returns false if the pair can't be tested, otherwise r_separated is set by run().
+	bool add(const Shape2DSW *p_shape_A, const Transform2D &p_xform_A, const Shape2DSW *p_shape_B, const Transform2D &p_xform_B, bool *r_separated);
+	_FORCE_INLINE_ uint32_t get_pair_count() const { return results.size(); }
+	void run();
+};
+
 #endif // COLLISION_SOLVER_2D_SW_H
@@ -33,14 +33,26 @@
 
 #include "body_2d_sw.h"
 
+class SeparationBatch2DSW;
+
 class Constraint2DSW : public RID_Data {
+public:
+	enum OrderKind {
+		ORDER_BODY_PAIR,
+		ORDER_AREA_PAIR,
+		ORDER_AREA2_PAIR,
+		ORDER_JOINT
+	};
 
+private:
 	Body2DSW **_body_ptr;
 	int _body_count;
 	uint64_t island_step;
 	Constraint2DSW *island_next;
 	Constraint2DSW *island_list_next;
 	bool disabled_collisions_between_bodies;
+	uint64_t order_key;
+	uint32_t order_subkey;
 
 	RID self;
 
@@ -50,6 +62,8 @@ protected:
 		_body_count = p_body_count;
 		island_step = 0;
 		disabled_collisions_between_bodies = true;
+		order_key = 0;
+		order_subkey = 0;
 	}
 
 public:
@@ -71,6 +85,31 @@ public:
 	_FORCE_INLINE_ void disable_collisions_between_bodies(const bool p_disabled) { disabled_collisions_between_bodies = p_disabled; }
 	_FORCE_INLINE_ bool is_disabled_collisions_between_bodies() const { return disabled_collisions_between_bodies; }
 
+	// Made from the order objects were added to the space in, never from memory addresses.
+	// Deterministic spaces solve constraints in this order, and saved states are matched by it.
+	static _FORCE_INLINE_ uint64_t make_order_key(OrderKind p_kind, uint32_t p_first, uint32_t p_second) {
+		return (uint64_t(p_kind) << 62) | (uint64_t(p_first & 0x7FFFFFFF) << 31) | uint64_t(p_second & 0x7FFFFFFF);
+	}
+	_FORCE_INLINE_ void set_order_key(uint64_t p_key, uint32_t p_subkey) {
+		order_key = p_key;
+		order_subkey = p_subkey;
+	}
+	_FORCE_INLINE_ uint64_t get_order_key() const { return order_key; }
+	_FORCE_INLINE_ OrderKind get_order_kind() const { return OrderKind(order_key >> 62); }
+	_FORCE_INLINE_ uint32_t get_order_subkey() const { return order_subkey; }
+	_FORCE_INLINE_ bool is_ordered_before(const Constraint2DSW *p_other) const {
+		return order_key == p_other->order_key ? order_subkey < p_other->order_subkey : order_key < p_other->order_key;
+	}
+
+	// What carries over from one step to the next, such as accumulated impulses for warm starting.
+	// Saved with the space state, and reset when a saved state didn't have this constraint.
+	virtual int get_state_size() const { return 0; }
+	virtual void save_state(uint8_t *r_state) const {}
+	virtual void restore_state(const uint8_t *p_state) {}
+	virtual void reset_state() {}
+
+	// Called before setup(), constraints between shapes can queue a separation test there.
+	virtual void add_to_separation_batch(SeparationBatch2DSW *p_batch) {}
 	virtual bool setup(real_t p_step) = 0;
 	virtual void solve(real_t p_step) = 0;
 
@@ -89,6 +89,38 @@ normal_relative_velocity(Body2DSW *a, Body2DSW *b, Vector2 rA, Vector2 rB, Vecto
 	return relative_velocity(a, b, rA, rB).dot(n);
 }
 
+// Joints are ordered by the bodies they link, then by creation among the joints linking the same bodies,
+// so their keys don't depend on the joints created before elsewhere in the server.
+void Joint2DSW::init_order_key() {
+
+	Body2DSW *A = get_body_ptr()[0];
+	Body2DSW *B = get_body_count() > 1 ? get_body_ptr()[1] : NULL;
+
+	uint32_t subkey = 0;
+	for (const Map<Constraint2DSW *, int>::Element *E = A->get_constraint_map().front(); E; E = E->next()) {
+
+		const Constraint2DSW *c = E->key();
+		if (c == this || E->get() != 0 || c->get_order_kind() != ORDER_JOINT) {
+			continue;
+		}
+		if ((c->get_body_count() > 1 ? c->get_body_ptr()[1] : NULL) == B) {
+			subkey = MAX(subkey, c->get_order_subkey() + 1);
+		}
+	}
+
+	set_order_key(make_order_key(ORDER_JOINT, 0, 0), subkey);
+	update_order_key();
+}
+
+// Called again when one of the bodies is added to a space, as that gives it a new space order.
+void Joint2DSW::update_order_key() {
+
+	Body2DSW *A = get_body_ptr()[0];
+	Body2DSW *B = get_body_count() > 1 ? get_body_ptr()[1] : NULL;
+
+	set_order_key(make_order_key(ORDER_JOINT, A->get_space_order(), B ? B->get_space_order() : 0x7FFFFFFF), get_order_subkey());
+}
+
 bool PinJoint2DSW::setup(real_t p_step) {
 
 	Space2DSW *space = A->get_space();
@@ -51,6 +51,10 @@ public:
 	_FORCE_INLINE_ real_t get_max_bias() const { return max_bias; }
 
 	virtual Physics2DServer::JointType get_type() const = 0;
+
+	void init_order_key();
+	void update_order_key();
+
 	Joint2DSW(Body2DSW **p_body_ptr = NULL, int p_body_count = 0) :
 			Constraint2DSW(p_body_ptr, p_body_count) {
 		bias = 0;
@@ -83,6 +87,11 @@ public:
 	virtual bool setup(real_t p_step);
 	virtual void solve(real_t p_step);
 
+	virtual int get_state_size() const { return sizeof(Vector2); }
+	virtual void save_state(uint8_t *r_state) const { memcpy(r_state, &P, sizeof(Vector2)); }
+	virtual void restore_state(const uint8_t *p_state) { memcpy(&P, p_state, sizeof(Vector2)); }
+	virtual void reset_state() { P = Vector2(); }
+
 	void set_param(Physics2DServer::PinJointParam p_param, real_t p_value);
 	real_t get_param(Physics2DServer::PinJointParam p_param) const;
 
@@ -121,6 +130,11 @@ public:
 	virtual bool setup(real_t p_step);
 	virtual void solve(real_t p_step);
 
+	virtual int get_state_size() const { return sizeof(Vector2); }
+	virtual void save_state(uint8_t *r_state) const { memcpy(r_state, &jn_acc, sizeof(Vector2)); }
+	virtual void restore_state(const uint8_t *p_state) { memcpy(&jn_acc, p_state, sizeof(Vector2)); }
+	virtual void reset_state() { jn_acc = Vector2(); }
+
 	GrooveJoint2DSW(const Vector2 &p_a_groove1, const Vector2 &p_a_groove2, const Vector2 &p_b_anchor, Body2DSW *p_body_a, Body2DSW *p_body_b);
 	~GrooveJoint2DSW();
 };
@@ -30,6 +30,7 @@
 
 #include "physics_2d_server_sw.h"
 #include "broad_phase_2d_basic.h"
+#include "broad_phase_2d_bvh.h"
 #include "broad_phase_2d_hash_grid.h"
 #include "collision_solver_2d_sw.h"
 #include "core/os/os.h"
@@ -312,6 +313,20 @@ Physics2DDirectSpaceState *Physics2DServerSW::space_get_direct_state(RID p_space
 	return space->get_direct_state();
 }
 
+PoolVector<uint8_t> Physics2DServerSW::space_save_state(RID p_space) const {
+
+	const Space2DSW *space = space_owner.get(p_space);
+	ERR_FAIL_COND_V(!space, PoolVector<uint8_t>());
+	return space->save_state();
+}
+
+bool Physics2DServerSW::space_restore_state(RID p_space, const PoolVector<uint8_t> &p_state) {
+
+	Space2DSW *space = space_owner.get(p_space);
+	ERR_FAIL_COND_V(!space, false);
+	return space->restore_state(p_state);
+}
+
 RID Physics2DServerSW::area_create() {
 
 	Area2DSW *area = memnew(Area2DSW);
@@ -1143,6 +1158,7 @@ RID Physics2DServerSW::pin_joint_create(const Vector2 &p_pos, RID p_body_a, RID
 	}
 
 	Joint2DSW *joint = memnew(PinJoint2DSW(p_pos, A, B));
+	joint->init_order_key();
 	RID self = joint_owner.make_rid(joint);
 	joint->set_self(self);
 
@@ -1158,6 +1174,7 @@ RID Physics2DServerSW::groove_joint_create(const Vector2 &p_a_groove1, const Vec
 	ERR_FAIL_COND_V(!B, RID());
 
 	Joint2DSW *joint = memnew(GrooveJoint2DSW(p_a_groove1, p_a_groove2, p_b_anchor, A, B));
+	joint->init_order_key();
 	RID self = joint_owner.make_rid(joint);
 	joint->set_self(self);
 	return self;
@@ -1172,6 +1189,7 @@ RID Physics2DServerSW::damped_spring_joint_create(const Vector2 &p_anchor_a, con
 	ERR_FAIL_COND_V(!B, RID());
 
 	Joint2DSW *joint = memnew(DampedSpringJoint2DSW(p_anchor_a, p_anchor_b, A, B));
+	joint->init_order_key();
 	RID self = joint_owner.make_rid(joint);
 	joint->set_self(self);
 	return self;
@@ -1314,7 +1332,6 @@ void Physics2DServerSW::init() {
 
 	doing_sync = false;
 	last_step = 0.001;
-	iterations = 8; // 8?
 	stepper = memnew(Step2DSW);
 	direct_state = memnew(Physics2DDirectBodyStateSW);
 };
@@ -1333,7 +1350,14 @@ void Physics2DServerSW::step(real_t p_step) {
 	collision_pairs = 0;
 	for (Set<const Space2DSW *>::Element *E = active_spaces.front(); E; E = E->next()) {
 
-		stepper->step((Space2DSW *)E->get(), p_step, iterations);
+		Space2DSW *space = (Space2DSW *)E->get();
+		int substeps = space->get_solver_substeps();
+		for (int i = substeps; i > 0; i--) {
+			space->set_substeps_left(i);
+			stepper->step(space, p_step / substeps, space->get_solver_iterations());
+		}
+		space->set_substeps_left(1);
+
 		island_count += E->get()->get_island_count();
 		active_objects += E->get()->get_active_objects();
 		collision_pairs += E->get()->get_collision_pairs();
@@ -1440,7 +1464,13 @@ Physics2DServerSW *Physics2DServerSW::singletonsw = NULL;
 Physics2DServerSW::Physics2DServerSW() {
 
 	singletonsw = this;
-	BroadPhase2DSW::create_func = BroadPhase2DHashGrid::_create;
+	bool use_bvh = GLOBAL_GET("physics/2d/use_bvh");
+
+	if (use_bvh) {
+		BroadPhase2DSW::create_func = BroadPhase2DBVH::_create;
+	} else {
+		BroadPhase2DSW::create_func = BroadPhase2DHashGrid::_create;
+	}
 	//BroadPhase2DSW::create_func=BroadPhase2DBasic::_create;
 
 	active = true;
@@ -44,7 +44,6 @@ class Physics2DServerSW : public Physics2DServer {
 	friend class Physics2DDirectSpaceStateSW;
 	friend class Physics2DDirectBodyStateSW;
 	bool active;
-	int iterations;
 	bool doing_sync;
 	real_t last_step;
 
@@ -124,6 +123,9 @@ public:
 	// this function only works on physics process, errors and returns null otherwise
 	virtual Physics2DDirectSpaceState *space_get_direct_state(RID p_space);
 
+	virtual PoolVector<uint8_t> space_save_state(RID p_space) const;
+	virtual bool space_restore_state(RID p_space, const PoolVector<uint8_t> &p_state);
+
 	/* AREA API */
 
 	virtual RID area_create();
@@ -40,9 +40,88 @@ void Physics2DServerWrapMT::thread_exit() {
 void Physics2DServerWrapMT::thread_step(real_t p_delta) {
 
 	physics_2d_server->step(p_delta);
+	if (snapshot_reads) {
+		_publish_snapshot();
+	}
 	step_sem.post();
 }
 
+void Physics2DServerWrapMT::_publish_snapshot() {
+
+	// The main thread only reads the front snapshot until it syncs with this step.
+	Snapshot &snapshot = snapshots[1 - snapshot_front];
+	if (snapshot.version != snapshot_version) {
+		snapshot.index = snapshot_body_index;
+		snapshot.bodies.resize(snapshot_body_list.size());
+		snapshot.version = snapshot_version;
+	}
+
+	for (uint32_t i = 0; i < snapshot_body_list.size(); i++) {
+		RID body = snapshot_body_list[i];
+		BodySnapshot &state = snapshot.bodies[i];
+		state.transform = physics_2d_server->body_get_state(body, BODY_STATE_TRANSFORM);
+		state.linear_velocity = physics_2d_server->body_get_state(body, BODY_STATE_LINEAR_VELOCITY);
+		state.angular_velocity = physics_2d_server->body_get_state(body, BODY_STATE_ANGULAR_VELOCITY);
+		state.sleeping = physics_2d_server->body_get_state(body, BODY_STATE_SLEEPING);
+		state.can_sleep = physics_2d_server->body_get_state(body, BODY_STATE_CAN_SLEEP);
+	}
+}
+
+const Physics2DServerWrapMT::BodySnapshot *Physics2DServerWrapMT::_get_body_snapshot(RID p_body) const {
+
+	if (!snapshot_reads || Thread::get_caller_id() != main_thread) {
+		return NULL;
+	}
+
+	const Snapshot &snapshot = snapshots[snapshot_front];
+	const uint32_t *index = snapshot.index.getptr(p_body.get_id());
+	return index ? &snapshot.bodies[*index] : NULL;
+}
+
+void Physics2DServerWrapMT::thread_body_set_space(RID p_body, RID p_space) {
+
+	physics_2d_server->body_set_space(p_body, p_space);
+
+	if (!snapshot_reads) {
+		return;
+	}
+
+	if (p_space.is_valid()) {
+		if (!snapshot_body_index.has(p_body.get_id())) {
+			snapshot_body_index[p_body.get_id()] = snapshot_body_list.size();
+			snapshot_body_list.push_back(p_body);
+			snapshot_version++;
+		}
+	} else {
+		_snapshot_remove_body(p_body);
+	}
+}
+
+void Physics2DServerWrapMT::_snapshot_remove_body(RID p_body) {
+
+	const uint32_t *index = snapshot_body_index.getptr(p_body.get_id());
+	if (!index) {
+		return;
+	}
+
+	uint32_t i = *index;
+	RID last = snapshot_body_list[snapshot_body_list.size() - 1];
+	snapshot_body_list.remove_unordered(i);
+	snapshot_body_index.erase(p_body.get_id());
+	if (last != p_body) {
+		snapshot_body_index[last.get_id()] = i;
+	}
+	snapshot_version++;
+}
+
+void Physics2DServerWrapMT::thread_free(RID p_rid) {
+
+	if (snapshot_reads) {
+		_snapshot_remove_body(p_rid);
+	}
+	physics_2d_server->free(p_rid);
+}
+
 void Physics2DServerWrapMT::_thread_callback(void *_instance) {
 
 	Physics2DServerWrapMT *vsmt = reinterpret_cast<Physics2DServerWrapMT *>(_instance);
@@ -87,13 +166,75 @@ void Physics2DServerWrapMT::sync() {
 	if (create_thread) {
 		if (first_frame)
 			first_frame = false;
-		else
+		else {
 			step_sem.wait(); //must not wait if a step was not issued
+			if (snapshot_reads) {
+				snapshot_front = 1 - snapshot_front; // The step published into the back one.
+			}
+		}
 	}
 
 	physics_2d_server->sync();
 }
 
+void Physics2DServerWrapMT::body_set_state(RID p_body, BodyState p_state, const Variant &p_value) {
+
+	if (Thread::get_caller_id() != server_thread) {
+		command_queue.push(physics_2d_server, &Physics2DServer::body_set_state, p_body, p_state, p_value);
+
+		// Written through, so the caller reads back what it set until the next snapshot.
+		BodySnapshot *state = const_cast<BodySnapshot *>(_get_body_snapshot(p_body));
+		if (state) {
+			switch (p_state) {
+				case BODY_STATE_TRANSFORM: {
+					state->transform = p_value;
+				} break;
+				case BODY_STATE_LINEAR_VELOCITY: {
+					state->linear_velocity = p_value;
+				} break;
+				case BODY_STATE_ANGULAR_VELOCITY: {
+					state->angular_velocity = p_value;
+				} break;
+				case BODY_STATE_SLEEPING: {
+					state->sleeping = p_value;
+				} break;
+				case BODY_STATE_CAN_SLEEP: {
+					state->can_sleep = p_value;
+				} break;
+			}
+		}
+	} else {
+		physics_2d_server->body_set_state(p_body, p_state, p_value);
+	}
+}
+
+Variant Physics2DServerWrapMT::body_get_state(RID p_body, BodyState p_state) const {
+
+	const BodySnapshot *state = _get_body_snapshot(p_body);
+	if (state) {
+		switch (p_state) {
+			case BODY_STATE_TRANSFORM:
+				return state->transform;
+			case BODY_STATE_LINEAR_VELOCITY:
+				return state->linear_velocity;
+			case BODY_STATE_ANGULAR_VELOCITY:
+				return state->angular_velocity;
+			case BODY_STATE_SLEEPING:
+				return state->sleeping;
+			case BODY_STATE_CAN_SLEEP:
+				return state->can_sleep;
+		}
+	}
+
+	if (Thread::get_caller_id() != server_thread) {
+		Variant ret;
+		command_queue.push_and_ret(physics_2d_server, &Physics2DServer::body_get_state, p_body, p_state, &ret);
+		return ret;
+	} else {
+		return physics_2d_server->body_get_state(p_body, p_state);
+	}
+}
+
 void Physics2DServerWrapMT::flush_queries() {
 
 	physics_2d_server->flush_queries();
@@ -160,6 +301,13 @@ Physics2DServerWrapMT::Physics2DServerWrapMT(Physics2DServer *p_contained, bool
 
 	main_thread = Thread::get_caller_id();
 	first_frame = true;
+
+	// Only worth it with a physics thread, otherwise reads don't wait for anything.
+	snapshot_reads = p_create_thread && GLOBAL_DEF("physics/2d/thread_snapshot_reads", false);
+	snapshot_front = 0;
+	snapshot_version = 0;
+	snapshots[0].version = 0;
+	snapshots[1].version = 0;
 }
 
 Physics2DServerWrapMT::~Physics2DServerWrapMT() {
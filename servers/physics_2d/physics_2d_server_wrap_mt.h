@@ -32,6 +32,8 @@
 #define PHYSICS2DSERVERWRAPMT_H
 
 #include "core/command_queue_mt.h"
+#include "core/hash_map.h"
+#include "core/local_vector.h"
 #include "core/os/thread.h"
 #include "core/project_settings.h"
 #include "core/safe_refcount.h"
@@ -71,6 +73,37 @@ class Physics2DServerWrapMT : public Physics2DServer {
 	Mutex alloc_mutex;
 	int pool_max_size;
 
+	// With snapshot reads, the physics thread publishes the state of every body in a space after each step.
+	// The main thread reads the last published state instead of waiting for the step to finish.
+	struct BodySnapshot {
+		Transform2D transform;
+		Vector2 linear_velocity;
+		real_t angular_velocity;
+		bool sleeping;
+		bool can_sleep;
+	};
+
+	struct Snapshot {
+		HashMap<uint32_t, uint32_t> index; // By RID id.
+		LocalVector<BodySnapshot> bodies;
+		uint64_t version;
+	};
+
+	bool snapshot_reads;
+	// Written by the physics thread during a step, the main thread swaps them once the step is synced.
+	mutable Snapshot snapshots[2];
+	int snapshot_front;
+	// Owned by the physics thread.
+	LocalVector<RID> snapshot_body_list;
+	HashMap<uint32_t, uint32_t> snapshot_body_index;
+	uint64_t snapshot_version;
+
+	void _publish_snapshot();
+	const BodySnapshot *_get_body_snapshot(RID p_body) const;
+	void _snapshot_remove_body(RID p_body);
+	void thread_body_set_space(RID p_body, RID p_space);
+	void thread_free(RID p_rid);
+
 public:
 #define ServerName Physics2DServer
 #define ServerNameWrapMT Physics2DServerWrapMT
@@ -117,6 +150,9 @@ public:
 		return physics_2d_server->space_get_direct_state(p_space);
 	}
 
+	FUNC1RC(PoolVector<uint8_t>, space_save_state, RID);
+	FUNC2R(bool, space_restore_state, RID, const PoolVector<uint8_t> &);
+
 	FUNC2(space_set_debug_contacts, RID, int);
 	virtual Vector<Vector2> space_get_contacts(RID p_space) const {
 
@@ -178,7 +214,17 @@ public:
 	//FUNC2RID(body,BodyMode,bool);
 	FUNCRID(body)
 
-	FUNC2(body_set_space, RID, RID);
+	virtual void body_set_space(RID p_body, RID p_space) {
+
+		if (Thread::get_caller_id() != server_thread) {
+			if (snapshot_reads && !p_space.is_valid()) {
+				snapshots[snapshot_front].index.erase(p_body.get_id());
+			}
+			command_queue.push(this, &Physics2DServerWrapMT::thread_body_set_space, p_body, p_space);
+		} else {
+			thread_body_set_space(p_body, p_space);
+		}
+	}
 	FUNC1RC(RID, body_get_space, RID);
 
 	FUNC2(body_set_mode, RID, BodyMode);
@@ -218,8 +264,8 @@ public:
 	FUNC3(body_set_param, RID, BodyParameter, real_t);
 	FUNC2RC(real_t, body_get_param, RID, BodyParameter);
 
-	FUNC3(body_set_state, RID, BodyState, const Variant &);
-	FUNC2RC(Variant, body_get_state, RID, BodyState);
+	virtual void body_set_state(RID p_body, BodyState p_state, const Variant &p_value);
+	virtual Variant body_get_state(RID p_body, BodyState p_state) const;
 
 	FUNC2(body_set_applied_force, RID, const Vector2 &);
 	FUNC1RC(Vector2, body_get_applied_force, RID);
@@ -303,7 +349,17 @@ public:
 
 	/* MISC */
 
-	FUNC1(free, RID);
+	virtual void free(RID p_rid) {
+
+		if (Thread::get_caller_id() != server_thread) {
+			if (snapshot_reads) {
+				snapshots[snapshot_front].index.erase(p_rid.get_id());
+			}
+			command_queue.push(this, &Physics2DServerWrapMT::thread_free, p_rid);
+		} else {
+			thread_free(p_rid);
+		}
+	}
 	FUNC1(set_active, bool);
 
 	virtual void init();
@@ -49,6 +49,97 @@ _FORCE_INLINE_ static bool _can_collide_with(CollisionObject2DSW *p_object, uint
 	return true;
 }
 
+// Intersects the segment with one shape of an object, and keeps the hit if it is closer along p_dir than r_min_d.
+_FORCE_INLINE_ static bool _intersect_ray_shape(const CollisionObject2DSW *p_col_obj, int p_shape_idx, const Vector2 &p_from, const Vector2 &p_to, const Vector2 &p_dir, real_t &r_min_d, Vector2 &r_point, Vector2 &r_normal) {
+
+	Transform2D inv_xform = p_col_obj->get_shape_inv_transform(p_shape_idx) * p_col_obj->get_inv_transform();
+
+	Vector2 local_from = inv_xform.xform(p_from);
+	Vector2 local_to = inv_xform.xform(p_to);
+
+	/*local_from = col_obj->get_inv_transform().xform(begin);
+	local_from = col_obj->get_shape_inv_transform(shape_idx).xform(local_from);
+
+	local_to = col_obj->get_inv_transform().xform(end);
+	local_to = col_obj->get_shape_inv_transform(shape_idx).xform(local_to);*/
+
+	const Shape2DSW *shape = p_col_obj->get_shape(p_shape_idx);
+
+	Vector2 shape_point, shape_normal;
+
+	if (!shape->intersect_segment(local_from, local_to, shape_point, shape_normal)) {
+		return false;
+	}
+
+	Transform2D xform = p_col_obj->get_transform() * p_col_obj->get_shape_transform(p_shape_idx);
+	shape_point = xform.xform(shape_point);
+
+	real_t ld = p_dir.dot(shape_point);
+
+	if (ld >= r_min_d) {
+		return false;
+	}
+
+	r_min_d = ld;
+	r_point = shape_point;
+	r_normal = inv_xform.basis_xform_inv(shape_normal).normalized();
+	return true;
+}
+
+_FORCE_INLINE_ static void _fill_ray_result(const CollisionObject2DSW *p_col_obj, int p_shape_idx, const Vector2 &p_point, const Vector2 &p_normal, Physics2DDirectSpaceState::RayResult &r_result) {
+
+	r_result.collider_id = p_col_obj->get_instance_id();
+	if (r_result.collider_id != 0)
+		r_result.collider = ObjectDB::get_instance(r_result.collider_id);
+	r_result.normal = p_normal;
+	r_result.metadata = p_col_obj->get_shape_metadata(p_shape_idx);
+	r_result.position = p_point;
+	r_result.rid = p_col_obj->get_self();
+	r_result.shape = p_shape_idx;
+}
+
+// Finds how far the shape can move along p_motion before touching one shape of an object.
+// Returns false if they never touch, or if they already overlap at the start.
+_FORCE_INLINE_ static bool _cast_motion_shape(const Shape2DSW *p_shape, const Transform2D &p_xform, const Vector2 &p_motion, real_t p_margin, const CollisionObject2DSW *p_col_obj, int p_shape_idx, real_t &r_safe, real_t &r_unsafe) {
+
+	Transform2D col_obj_xform = p_col_obj->get_transform() * p_col_obj->get_shape_transform(p_shape_idx);
+	//test initial overlap, does it collide if going all the way?
+	if (!CollisionSolver2DSW::solve(p_shape, p_xform, p_motion, p_col_obj->get_shape(p_shape_idx), col_obj_xform, Vector2(), NULL, NULL, NULL, p_margin)) {
+		return false;
+	}
+
+	//test initial overlap, ignore objects it's inside of.
+	if (CollisionSolver2DSW::solve(p_shape, p_xform, Vector2(), p_col_obj->get_shape(p_shape_idx), col_obj_xform, Vector2(), NULL, NULL, NULL, p_margin)) {
+
+		return false;
+	}
+
+	//just do kinematic solving
+	real_t low = 0;
+	real_t hi = 1;
+	Vector2 mnormal = p_motion.normalized();
+
+	for (int j = 0; j < 8; j++) { //steps should be customizable..
+
+		real_t ofs = (low + hi) * 0.5;
+
+		Vector2 sep = mnormal; //important optimization for this to work fast enough
+		bool collided = CollisionSolver2DSW::solve(p_shape, p_xform, p_motion * ofs, p_col_obj->get_shape(p_shape_idx), col_obj_xform, Vector2(), NULL, NULL, &sep, p_margin);
+
+		if (collided) {
+
+			hi = ofs;
+		} else {
+
+			low = ofs;
+		}
+	}
+
+	r_safe = low;
+	r_unsafe = hi;
+	return true;
+}
+
 int Physics2DDirectSpaceStateSW::_intersect_point_impl(const Vector2 &p_point, ShapeResult *r_results, int p_result_max, const Set<RID> &p_exclude, uint32_t p_collision_mask, bool p_collide_with_bodies, bool p_collide_with_areas, bool p_pick_point, bool p_filter_by_canvas, ObjectID p_canvas_instance_id) {
 
 	if (p_result_max <= 0)
@@ -144,53 +235,156 @@ bool Physics2DDirectSpaceStateSW::intersect_ray(const Vector2 &p_from, const Vec
 		const CollisionObject2DSW *col_obj = space->intersection_query_results[i];
 
 		int shape_idx = space->intersection_query_subindex_results[i];
-		Transform2D inv_xform = col_obj->get_shape_inv_transform(shape_idx) * col_obj->get_inv_transform();
 
-		Vector2 local_from = inv_xform.xform(begin);
-		Vector2 local_to = inv_xform.xform(end);
+		if (_intersect_ray_shape(col_obj, shape_idx, begin, end, normal, min_d, res_point, res_normal)) {
+
+			res_shape = shape_idx;
+			res_obj = col_obj;
+			collided = true;
+		}
+	}
+
+	if (!collided)
+		return false;
+
+	_fill_ray_result(res_obj, res_shape, res_point, res_normal, r_result);
+
+	return true;
+}
+
+void Physics2DDirectSpaceStateSW::_add_batch_candidates(BatchCandidates &r_candidates, int p_amount, const Set<RID> &p_exclude, uint32_t p_collision_mask, bool p_collide_with_bodies, bool p_collide_with_areas) {
+
+	for (int i = 0; i < p_amount; i++) {
 
-		/*local_from = col_obj->get_inv_transform().xform(begin);
-		local_from = col_obj->get_shape_inv_transform(shape_idx).xform(local_from);
+		CollisionObject2DSW *col_obj = r_candidates.cull_results[i];
 
-		local_to = col_obj->get_inv_transform().xform(end);
-		local_to = col_obj->get_shape_inv_transform(shape_idx).xform(local_to);*/
+		if (!_can_collide_with(col_obj, p_collision_mask, p_collide_with_bodies, p_collide_with_areas))
+			continue;
+
+		if (p_exclude.has(col_obj->get_self()))
+			continue;
 
-		const Shape2DSW *shape = col_obj->get_shape(shape_idx);
+		r_candidates.objects.push_back(col_obj);
+		r_candidates.shapes.push_back(r_candidates.cull_subindex_results[i]);
+	}
+}
 
-		Vector2 shape_point, shape_normal;
+void Physics2DDirectSpaceStateSW::_cull_batch(BatchCandidates &r_candidates, int p_count, const Vector2 *p_ray_points, const Set<RID> &p_exclude, uint32_t p_collision_mask, bool p_collide_with_bodies, bool p_collide_with_areas) {
 
-		if (shape->intersect_segment(local_from, local_to, shape_point, shape_normal)) {
+	// Queries next to each other in the batch (e.g. the rays of one agent) are usually close in space too,
+	// so each chunk of them first tries to use a single cull of their merged bounds. The rects must be filled.
 
-			Transform2D xform = col_obj->get_transform() * col_obj->get_shape_transform(shape_idx);
-			shape_point = xform.xform(shape_point);
+	r_candidates.objects.clear();
+	r_candidates.shapes.clear();
+	r_candidates.ranges.resize(p_count * 2);
+	r_candidates.cull_results.resize(Space2DSW::INTERSECTION_QUERY_MAX);
+	r_candidates.cull_subindex_results.resize(Space2DSW::INTERSECTION_QUERY_MAX);
+	CollisionObject2DSW **results = r_candidates.cull_results.ptr();
+	int *subindex_results = r_candidates.cull_subindex_results.ptr();
 
-			real_t ld = normal.dot(shape_point);
+	for (int from = 0; from < p_count; from += BATCH_CHUNK_SIZE) {
 
-			if (ld < min_d) {
+		int to = MIN(from + BATCH_CHUNK_SIZE, p_count);
+
+		Rect2 chunk_rect = r_candidates.rects[from];
+		for (int i = from + 1; i < to; i++) {
+			chunk_rect = chunk_rect.merge(r_candidates.rects[i]);
+		}
 
-				min_d = ld;
-				res_point = shape_point;
-				res_normal = inv_xform.basis_xform_inv(shape_normal).normalized();
-				res_shape = shape_idx;
-				res_obj = col_obj;
-				collided = true;
+		int amount = space->broadphase->cull_aabb(chunk_rect, results, Space2DSW::INTERSECTION_QUERY_MAX, subindex_results);
+
+		if (amount <= BATCH_MAX_SHARED_CANDIDATES) {
+
+			uint32_t begin = r_candidates.objects.size();
+			_add_batch_candidates(r_candidates, amount, p_exclude, p_collision_mask, p_collide_with_bodies, p_collide_with_areas);
+			for (int i = from; i < to; i++) {
+				r_candidates.ranges[i * 2 + 0] = begin;
+				r_candidates.ranges[i * 2 + 1] = r_candidates.objects.size();
 			}
+			continue;
+		}
+
+		for (int i = from; i < to; i++) {
+
+			if (p_ray_points) {
+				amount = space->broadphase->cull_segment(p_ray_points[i * 2 + 0], p_ray_points[i * 2 + 1], results, Space2DSW::INTERSECTION_QUERY_MAX, subindex_results);
+			} else {
+				amount = space->broadphase->cull_aabb(r_candidates.rects[i], results, Space2DSW::INTERSECTION_QUERY_MAX, subindex_results);
+			}
+
+			r_candidates.ranges[i * 2 + 0] = r_candidates.objects.size();
+			_add_batch_candidates(r_candidates, amount, p_exclude, p_collision_mask, p_collide_with_bodies, p_collide_with_areas);
+			r_candidates.ranges[i * 2 + 1] = r_candidates.objects.size();
 		}
 	}
+}
 
-	if (!collided)
-		return false;
+void Physics2DDirectSpaceStateSW::_intersect_ray_job(uint32_t p_index, RayBatch *p_batch) {
 
-	r_result.collider_id = res_obj->get_instance_id();
-	if (r_result.collider_id != 0)
-		r_result.collider = ObjectDB::get_instance(r_result.collider_id);
-	r_result.normal = res_normal;
-	r_result.metadata = res_obj->get_shape_metadata(res_shape);
-	r_result.position = res_point;
-	r_result.rid = res_obj->get_self();
-	r_result.shape = res_shape;
+	const Vector2 &from = p_batch->points[p_index * 2 + 0];
+	const Vector2 &to = p_batch->points[p_index * 2 + 1];
+	Vector2 dir = (to - from).normalized();
 
-	return true;
+	real_t min_d = 1e10;
+	Vector2 res_point, res_normal;
+	int res_shape = 0;
+	const CollisionObject2DSW *res_obj = NULL;
+
+	const BatchCandidates &candidates = *p_batch->candidates;
+	for (uint32_t i = candidates.ranges[p_index * 2 + 0]; i < candidates.ranges[p_index * 2 + 1]; i++) {
+
+		const CollisionObject2DSW *col_obj = candidates.objects[i];
+		int shape_idx = candidates.shapes[i];
+
+		// Shared candidates may be anywhere in the chunk.
+		if (!col_obj->get_shape_aabb(shape_idx).intersects_segment(from, to))
+			continue;
+
+		if (_intersect_ray_shape(col_obj, shape_idx, from, to, dir, min_d, res_point, res_normal)) {
+
+			res_shape = shape_idx;
+			res_obj = col_obj;
+		}
+	}
+
+	p_batch->hits[p_index] = res_obj != NULL;
+	if (res_obj) {
+		_fill_ray_result(res_obj, res_shape, res_point, res_normal, p_batch->results[p_index]);
+	}
+}
+
+void Physics2DDirectSpaceStateSW::intersect_rays_batch(const Vector2 *p_points, int p_ray_count, RayResult *r_results, bool *r_hits, const Set<RID> &p_exclude, uint32_t p_collision_mask, bool p_collide_with_bodies, bool p_collide_with_areas) {
+
+	ERR_FAIL_COND(space->locked);
+
+	if (p_ray_count <= 0)
+		return;
+
+	BatchCandidates candidates;
+	candidates.rects.resize(p_ray_count);
+	for (int i = 0; i < p_ray_count; i++) {
+		candidates.rects[i] = Rect2(p_points[i * 2 + 0], Vector2());
+		candidates.rects[i].expand_to(p_points[i * 2 + 1]);
+	}
+
+	_cull_batch(candidates, p_ray_count, p_points, p_exclude, p_collision_mask, p_collide_with_bodies, p_collide_with_areas);
+
+	RayBatch batch;
+	batch.candidates = &candidates;
+	batch.points = p_points;
+	batch.results = r_results;
+	batch.hits = r_hits;
+
+	// The candidates are gathered, what is left only reads the shapes and can be split between threads.
+	// If the worker threads are already busy with a step or a batch from another thread, do_work()
+	// runs the jobs on the calling thread instead.
+	if (p_ray_count >= BATCH_MIN_THREADED_QUERIES) {
+		Physics2DServerSW::singletonsw->stepper->get_work_pool().do_work(p_ray_count, this, &Physics2DDirectSpaceStateSW::_intersect_ray_job, &batch);
+	} else {
+		for (int i = 0; i < p_ray_count; i++) {
+			_intersect_ray_job(i, &batch);
+		}
+	}
 }
 
 int Physics2DDirectSpaceStateSW::intersect_shape(const RID &p_shape, const Transform2D &p_xform, const Vector2 &p_motion, real_t p_margin, ShapeResult *r_results, int p_result_max, const Set<RID> &p_exclude, uint32_t p_collision_mask, bool p_collide_with_bodies, bool p_collide_with_areas) {
@@ -263,38 +457,44 @@ bool Physics2DDirectSpaceStateSW::cast_motion(const RID &p_shape, const Transfor
 		const CollisionObject2DSW *col_obj = space->intersection_query_results[i];
 		int shape_idx = space->intersection_query_subindex_results[i];
 
-		Transform2D col_obj_xform = col_obj->get_transform() * col_obj->get_shape_transform(shape_idx);
-		//test initial overlap, does it collide if going all the way?
-		if (!CollisionSolver2DSW::solve(shape, p_xform, p_motion, col_obj->get_shape(shape_idx), col_obj_xform, Vector2(), NULL, NULL, NULL, p_margin)) {
+		real_t low, hi;
+		if (!_cast_motion_shape(shape, p_xform, p_motion, p_margin, col_obj, shape_idx, low, hi))
 			continue;
+
+		if (low < best_safe) {
+			best_safe = low;
+			best_unsafe = hi;
 		}
+	}
 
-		//test initial overlap, ignore objects it's inside of.
-		if (CollisionSolver2DSW::solve(shape, p_xform, Vector2(), col_obj->get_shape(shape_idx), col_obj_xform, Vector2(), NULL, NULL, NULL, p_margin)) {
+	p_closest_safe = best_safe;
+	p_closest_unsafe = best_unsafe;
 
-			continue;
-		}
+	return true;
+}
 
-		//just do kinematic solving
-		real_t low = 0;
-		real_t hi = 1;
-		Vector2 mnormal = p_motion.normalized();
+void Physics2DDirectSpaceStateSW::_cast_motion_job(uint32_t p_index, MotionBatch *p_batch) {
 
-		for (int j = 0; j < 8; j++) { //steps should be customizable..
+	const Transform2D &xform = p_batch->xforms[p_index];
+	const Vector2 &motion = p_batch->motions[p_index];
+	const Rect2 &rect = p_batch->candidates->rects[p_index];
 
-			real_t ofs = (low + hi) * 0.5;
+	real_t best_safe = 1;
+	real_t best_unsafe = 1;
 
-			Vector2 sep = mnormal; //important optimization for this to work fast enough
-			bool collided = CollisionSolver2DSW::solve(shape, p_xform, p_motion * ofs, col_obj->get_shape(shape_idx), col_obj_xform, Vector2(), NULL, NULL, &sep, p_margin);
+	const BatchCandidates &candidates = *p_batch->candidates;
+	for (uint32_t i = candidates.ranges[p_index * 2 + 0]; i < candidates.ranges[p_index * 2 + 1]; i++) {
 
-			if (collided) {
+		const CollisionObject2DSW *col_obj = candidates.objects[i];
+		int shape_idx = candidates.shapes[i];
 
-				hi = ofs;
-			} else {
+		// Shared candidates may be anywhere in the chunk.
+		if (!col_obj->get_shape_aabb(shape_idx).intersects(rect))
+			continue;
 
-				low = ofs;
-			}
-		}
+		real_t low, hi;
+		if (!_cast_motion_shape(p_batch->shape, xform, motion, p_batch->margin, col_obj, shape_idx, low, hi))
+			continue;
 
 		if (low < best_safe) {
 			best_safe = low;
@@ -302,8 +502,46 @@ bool Physics2DDirectSpaceStateSW::cast_motion(const RID &p_shape, const Transfor
 		}
 	}
 
-	p_closest_safe = best_safe;
-	p_closest_unsafe = best_unsafe;
+	p_batch->closest_safe[p_index] = best_safe;
+	p_batch->closest_unsafe[p_index] = best_unsafe;
+}
+
+bool Physics2DDirectSpaceStateSW::cast_motions_batch(const RID &p_shape, const Transform2D *p_xforms, const Vector2 *p_motions, int p_count, real_t p_margin, real_t *r_closest_safe, real_t *r_closest_unsafe, const Set<RID> &p_exclude, uint32_t p_collision_mask, bool p_collide_with_bodies, bool p_collide_with_areas) {
+
+	ERR_FAIL_COND_V(space->locked, false);
+
+	Shape2DSW *shape = Physics2DServerSW::singletonsw->shape_owner.get(p_shape);
+	ERR_FAIL_COND_V(!shape, false);
+
+	if (p_count <= 0)
+		return true;
+
+	BatchCandidates candidates;
+	candidates.rects.resize(p_count);
+	for (int i = 0; i < p_count; i++) {
+		Rect2 aabb = p_xforms[i].xform(shape->get_aabb());
+		aabb = aabb.merge(Rect2(aabb.position + p_motions[i], aabb.size)); //motion
+		candidates.rects[i] = aabb.grow(p_margin);
+	}
+
+	_cull_batch(candidates, p_count, NULL, p_exclude, p_collision_mask, p_collide_with_bodies, p_collide_with_areas);
+
+	MotionBatch batch;
+	batch.candidates = &candidates;
+	batch.shape = shape;
+	batch.xforms = p_xforms;
+	batch.motions = p_motions;
+	batch.margin = p_margin;
+	batch.closest_safe = r_closest_safe;
+	batch.closest_unsafe = r_closest_unsafe;
+
+	if (p_count >= BATCH_MIN_THREADED_QUERIES) {
+		Physics2DServerSW::singletonsw->stepper->get_work_pool().do_work(p_count, this, &Physics2DDirectSpaceStateSW::_cast_motion_job, &batch);
+	} else {
+		for (int i = 0; i < p_count; i++) {
+			_cast_motion_job(i, &batch);
+		}
+	}
 
 	return true;
 }
@@ -1174,28 +1412,46 @@ void *Space2DSW::_broadphase_pair(CollisionObject2DSW *A, int p_subindex_A, Coll
 	Space2DSW *self = (Space2DSW *)p_self;
 	self->collision_pairs++;
 
+	Constraint2DSW *c;
 	if (type_A == CollisionObject2DSW::TYPE_AREA) {
 
 		Area2DSW *area = static_cast<Area2DSW *>(A);
 		if (type_B == CollisionObject2DSW::TYPE_AREA) {
 
 			Area2DSW *area_b = static_cast<Area2DSW *>(B);
-			Area2Pair2DSW *area2_pair = memnew(Area2Pair2DSW(area_b, p_subindex_B, area, p_subindex_A));
-			return area2_pair;
+			c = memnew(Area2Pair2DSW(area_b, p_subindex_B, area, p_subindex_A));
+			_set_pair_order_key(c, Constraint2DSW::ORDER_AREA2_PAIR, A, p_subindex_A, B, p_subindex_B);
 		} else {
 
 			Body2DSW *body = static_cast<Body2DSW *>(B);
-			AreaPair2DSW *area_pair = memnew(AreaPair2DSW(body, p_subindex_B, area, p_subindex_A));
-			return area_pair;
+			c = memnew(AreaPair2DSW(body, p_subindex_B, area, p_subindex_A));
+			_set_pair_order_key(c, Constraint2DSW::ORDER_AREA_PAIR, B, p_subindex_B, A, p_subindex_A);
 		}
 
 	} else {
 
-		BodyPair2DSW *b = memnew(BodyPair2DSW((Body2DSW *)A, p_subindex_A, (Body2DSW *)B, p_subindex_B));
-		return b;
+		// The broadphase reports pairs in an order that depends on memory addresses. Which body is A
+		// changes how the contacts are computed, so a deterministic space always picks the older one.
+		if (self->deterministic && A->get_space_order() > B->get_space_order()) {
+			SWAP(A, B);
+			SWAP(p_subindex_A, p_subindex_B);
+		}
+		c = memnew(BodyPair2DSW((Body2DSW *)A, p_subindex_A, (Body2DSW *)B, p_subindex_B));
+		_set_pair_order_key(c, Constraint2DSW::ORDER_BODY_PAIR, A, p_subindex_A, B, p_subindex_B);
 	}
 
-	return NULL;
+	self->restore_constraint_state(c);
+	return c;
+}
+
+void Space2DSW::_set_pair_order_key(Constraint2DSW *p_constraint, Constraint2DSW::OrderKind p_kind, const CollisionObject2DSW *p_A, int p_shape_A, const CollisionObject2DSW *p_B, int p_shape_B) {
+
+	// Body pairs get the same key whichever body the broadphase reported first.
+	if (p_kind != Constraint2DSW::ORDER_AREA_PAIR && p_A->get_space_order() > p_B->get_space_order()) {
+		SWAP(p_A, p_B);
+		SWAP(p_shape_A, p_shape_B);
+	}
+	p_constraint->set_order_key(Constraint2DSW::make_order_key(p_kind, p_A->get_space_order(), p_B->get_space_order()), (uint32_t(p_shape_A) << 16) | (uint32_t(p_shape_B) & 0xFFFF));
 }
 
 void Space2DSW::_broadphase_unpair(CollisionObject2DSW *A, int p_subindex_A, CollisionObject2DSW *B, int p_subindex_B, void *p_data, void *p_self) {
@@ -1232,6 +1488,233 @@ void Space2DSW::body_remove_from_inertia_update_list(SelfList<Body2DSW> *p_body)
 	inertia_update_list.remove(p_body);
 }
 
+Island2DSW *Space2DSW::island_create() {
+
+	Island2DSW *island;
+	if (island_pool.size()) {
+		island = island_pool[island_pool.size() - 1];
+		island_pool.resize(island_pool.size() - 1);
+	} else {
+		island = memnew(Island2DSW);
+	}
+	island->step = 0;
+	island->dirty = true;
+	return island;
+}
+
+void Space2DSW::island_free(Island2DSW *p_island) {
+
+	// Kept for reuse, so islands splitting and merging don't allocate once warmed up.
+	p_island->bodies.clear();
+	p_island->constraints.clear();
+	island_pool.push_back(p_island);
+}
+
+// Saved states are raw copies of the simulation data, only meant to be restored by the same build.
+struct _SpaceStateHeader {
+	uint32_t body_state_size;
+	uint32_t body_count;
+	uint32_t constraint_count;
+};
+
+struct _SpaceOrderCmp {
+	_FORCE_INLINE_ bool operator()(const CollisionObject2DSW *p_a, const CollisionObject2DSW *p_b) const {
+		return p_a->get_space_order() < p_b->get_space_order();
+	}
+};
+
+struct _ConstraintOrderCmp {
+	_FORCE_INLINE_ bool operator()(const Constraint2DSW *p_a, const Constraint2DSW *p_b) const {
+		return p_a->is_ordered_before(p_b);
+	}
+};
+
+template <class T>
+static void _write_state(LocalVector<uint8_t> &r_data, const T &p_value) {
+
+	uint32_t ofs = r_data.size();
+	r_data.resize(ofs + sizeof(T));
+	memcpy(&r_data[ofs], &p_value, sizeof(T));
+}
+
+template <class T>
+static bool _read_state(const uint8_t *p_data, uint32_t p_size, uint32_t &r_ofs, T &r_value) {
+
+	ERR_FAIL_COND_V_MSG(r_ofs + sizeof(T) > p_size, false, "Truncated 2D physics space state.");
+	memcpy(&r_value, p_data + r_ofs, sizeof(T));
+	r_ofs += sizeof(T);
+	return true;
+}
+
+PoolVector<uint8_t> Space2DSW::save_state() const {
+
+	// Written in space order, so the same simulation always gives the same bytes.
+	LocalVector<Body2DSW *> bodies;
+	LocalVector<Constraint2DSW *> constraints;
+	for (const Set<CollisionObject2DSW *>::Element *E = objects.front(); E; E = E->next()) {
+
+		if (E->get()->get_type() != CollisionObject2DSW::TYPE_BODY) {
+			continue;
+		}
+		Body2DSW *body = static_cast<Body2DSW *>(E->get());
+		if (body->get_mode() != Physics2DServer::BODY_MODE_STATIC) {
+			bodies.push_back(body);
+		}
+		for (const Map<Constraint2DSW *, int>::Element *F = body->get_constraint_map().front(); F; F = F->next()) {
+			if (F->get() == 0 && F->key()->get_state_size()) {
+				constraints.push_back(F->key());
+			}
+		}
+	}
+	bodies.sort_custom<_SpaceOrderCmp>();
+	constraints.sort_custom<_ConstraintOrderCmp>();
+
+	LocalVector<uint8_t> data;
+	_SpaceStateHeader header;
+	header.body_state_size = sizeof(Body2DSW::State);
+	header.body_count = bodies.size();
+	header.constraint_count = constraints.size();
+	_write_state(data, header);
+
+	for (uint32_t i = 0; i < bodies.size(); i++) {
+		Body2DSW::State state = Body2DSW::State(); // Zeroes the padding too.
+		bodies[i]->save_state(state);
+		_write_state(data, bodies[i]->get_space_order());
+		_write_state(data, state);
+	}
+
+	for (uint32_t i = 0; i < constraints.size(); i++) {
+		Constraint2DSW *c = constraints[i];
+		uint32_t size = c->get_state_size();
+		_write_state(data, c->get_order_key());
+		_write_state(data, c->get_order_subkey());
+		_write_state(data, size);
+		uint32_t ofs = data.size();
+		data.resize(ofs + size);
+		c->save_state(&data[ofs]);
+	}
+
+	PoolVector<uint8_t> state;
+	state.resize(data.size());
+	PoolVector<uint8_t>::Write w = state.write();
+	memcpy(w.ptr(), data.ptr(), data.size());
+	return state;
+}
+
+bool Space2DSW::restore_state(const PoolVector<uint8_t> &p_state) {
+
+	ERR_FAIL_COND_V_MSG(locked, false, "Can't restore a 2D physics space state while the space is being stepped.");
+
+	PoolVector<uint8_t>::Read r = p_state.read();
+	const uint8_t *data = r.ptr();
+	uint32_t size = p_state.size();
+	uint32_t ofs = 0;
+
+	_SpaceStateHeader header;
+	if (!_read_state(data, size, ofs, header)) {
+		return false;
+	}
+	ERR_FAIL_COND_V_MSG(header.body_state_size != sizeof(Body2DSW::State), false, "2D physics space state saved by a different build.");
+
+	uint32_t bodies_ofs = ofs;
+	ERR_FAIL_COND_V_MSG(uint64_t(header.body_count) * (sizeof(uint32_t) + sizeof(Body2DSW::State)) > size - ofs, false, "Truncated 2D physics space state.");
+	ofs += header.body_count * (sizeof(uint32_t) + sizeof(Body2DSW::State));
+
+	// Constraint states are kept until the next step is set up, for the pairs the bodies find again.
+	restored_constraint_states.clear();
+	restored_constraint_data.clear();
+	for (uint32_t i = 0; i < header.constraint_count; i++) {
+		RestoredConstraintState cs;
+		if (!_read_state(data, size, ofs, cs.key) || !_read_state(data, size, ofs, cs.subkey) || !_read_state(data, size, ofs, cs.size)) {
+			clear_restored_constraint_states();
+			return false;
+		}
+		if (cs.size > size - ofs) {
+			clear_restored_constraint_states();
+			ERR_FAIL_V_MSG(false, "Truncated 2D physics space state.");
+		}
+		cs.offset = restored_constraint_data.size();
+		restored_constraint_data.resize(cs.offset + cs.size);
+		memcpy(&restored_constraint_data[cs.offset], data + ofs, cs.size);
+		ofs += cs.size;
+		restored_constraint_states.push_back(cs);
+	}
+
+	HashMap<uint32_t, Body2DSW *> bodies;
+	for (const Set<CollisionObject2DSW *>::Element *E = objects.front(); E; E = E->next()) {
+		if (E->get()->get_type() == CollisionObject2DSW::TYPE_BODY) {
+			bodies[E->get()->get_space_order()] = static_cast<Body2DSW *>(E->get());
+		}
+	}
+
+	// Moving the bodies back and updating the broadphase pairs them as they were, new pairs take their state then.
+	ofs = bodies_ofs;
+	for (uint32_t i = 0; i < header.body_count; i++) {
+		uint32_t order;
+		Body2DSW::State state;
+		_read_state(data, size, ofs, order);
+		_read_state(data, size, ofs, state);
+
+		Body2DSW **body = bodies.getptr(order);
+		if (body && (*body)->get_mode() != Physics2DServer::BODY_MODE_STATIC) {
+			(*body)->restore_state(state);
+		}
+	}
+	broadphase->update();
+
+	for (const Set<CollisionObject2DSW *>::Element *E = objects.front(); E; E = E->next()) {
+		if (E->get()->get_type() != CollisionObject2DSW::TYPE_BODY) {
+			continue;
+		}
+		const Map<Constraint2DSW *, int> &constraint_map = static_cast<Body2DSW *>(E->get())->get_constraint_map();
+		for (const Map<Constraint2DSW *, int>::Element *F = constraint_map.front(); F; F = F->next()) {
+			if (F->get() == 0) {
+				restore_constraint_state(F->key());
+			}
+		}
+	}
+
+	return true;
+}
+
+void Space2DSW::restore_constraint_state(Constraint2DSW *p_constraint) {
+
+	if (restored_constraint_states.empty() || !p_constraint->get_state_size()) {
+		return;
+	}
+
+	uint64_t key = p_constraint->get_order_key();
+	uint32_t subkey = p_constraint->get_order_subkey();
+
+	int64_t lo = 0;
+	int64_t hi = int64_t(restored_constraint_states.size()) - 1;
+	while (lo <= hi) {
+		int64_t mid = (lo + hi) / 2;
+		const RestoredConstraintState &cs = restored_constraint_states[mid];
+		if (cs.key == key && cs.subkey == subkey) {
+			if (cs.size == uint32_t(p_constraint->get_state_size())) {
+				p_constraint->restore_state(&restored_constraint_data[cs.offset]);
+				return;
+			}
+			break;
+		}
+		if (cs.key == key ? cs.subkey < subkey : cs.key < key) {
+			lo = mid + 1;
+		} else {
+			hi = mid - 1;
+		}
+	}
+
+	// Didn't exist when the state was saved.
+	p_constraint->reset_state();
+}
+
+void Space2DSW::clear_restored_constraint_states() {
+
+	restored_constraint_states.clear();
+	restored_constraint_data.clear();
+}
+
 BroadPhase2DSW *Space2DSW::get_broadphase() {
 
 	return broadphase;
@@ -1241,6 +1724,17 @@ void Space2DSW::add_object(CollisionObject2DSW *p_object) {
 
 	ERR_FAIL_COND(objects.has(p_object));
 	objects.insert(p_object);
+	p_object->set_space_order(object_order++);
+
+	if (p_object->get_type() == CollisionObject2DSW::TYPE_BODY) {
+		// Joint keys are made from the space order of their bodies.
+		const Map<Constraint2DSW *, int> &constraint_map = static_cast<Body2DSW *>(p_object)->get_constraint_map();
+		for (const Map<Constraint2DSW *, int>::Element *E = constraint_map.front(); E; E = E->next()) {
+			if (E->key()->get_order_kind() == Constraint2DSW::ORDER_JOINT) {
+				static_cast<Joint2DSW *>(E->key())->update_order_key();
+			}
+		}
+	}
 }
 
 void Space2DSW::remove_object(CollisionObject2DSW *p_object) {
@@ -1331,6 +1825,9 @@ void Space2DSW::set_param(Physics2DServer::SpaceParameter p_param, real_t p_valu
 		case Physics2DServer::SPACE_PARAM_BODY_TIME_TO_SLEEP: body_time_to_sleep = p_value; break;
 		case Physics2DServer::SPACE_PARAM_CONSTRAINT_DEFAULT_BIAS: constraint_bias = p_value; break;
 		case Physics2DServer::SPACE_PARAM_TEST_MOTION_MIN_CONTACT_DEPTH: test_motion_min_contact_depth = p_value; break;
+		case Physics2DServer::SPACE_PARAM_SOLVER_ITERATIONS: solver_iterations = MAX((int)p_value, 1); break;
+		case Physics2DServer::SPACE_PARAM_SOLVER_SUBSTEPS: solver_substeps = MAX((int)p_value, 1); break;
+		case Physics2DServer::SPACE_PARAM_DETERMINISTIC: deterministic = p_value != 0; break;
 	}
 }
 
@@ -1346,6 +1843,9 @@ real_t Space2DSW::get_param(Physics2DServer::SpaceParameter p_param) const {
 		case Physics2DServer::SPACE_PARAM_BODY_TIME_TO_SLEEP: return body_time_to_sleep;
 		case Physics2DServer::SPACE_PARAM_CONSTRAINT_DEFAULT_BIAS: return constraint_bias;
 		case Physics2DServer::SPACE_PARAM_TEST_MOTION_MIN_CONTACT_DEPTH: return test_motion_min_contact_depth;
+		case Physics2DServer::SPACE_PARAM_SOLVER_ITERATIONS: return solver_iterations;
+		case Physics2DServer::SPACE_PARAM_SOLVER_SUBSTEPS: return solver_substeps;
+		case Physics2DServer::SPACE_PARAM_DETERMINISTIC: return deterministic;
 	}
 	return 0;
 }
@@ -1389,6 +1889,13 @@ Space2DSW::Space2DSW() {
 	body_angular_velocity_sleep_threshold = GLOBAL_DEF("physics/2d/sleep_threshold_angular", (8.0 / 180.0 * Math_PI));
 	body_time_to_sleep = GLOBAL_DEF("physics/2d/time_before_sleep", 0.5);
 	ProjectSettings::get_singleton()->set_custom_property_info("physics/2d/time_before_sleep", PropertyInfo(Variant::REAL, "physics/2d/time_before_sleep", PROPERTY_HINT_RANGE, "0,5,0.01,or_greater"));
+	solver_iterations = MAX((int)GLOBAL_DEF("physics/2d/solver_iterations", 8), 1);
+	ProjectSettings::get_singleton()->set_custom_property_info("physics/2d/solver_iterations", PropertyInfo(Variant::INT, "physics/2d/solver_iterations", PROPERTY_HINT_RANGE, "1,64,1,or_greater"));
+	solver_substeps = MAX((int)GLOBAL_DEF("physics/2d/solver_substeps", 1), 1);
+	ProjectSettings::get_singleton()->set_custom_property_info("physics/2d/solver_substeps", PropertyInfo(Variant::INT, "physics/2d/solver_substeps", PROPERTY_HINT_RANGE, "1,16,1,or_greater"));
+	deterministic = GLOBAL_DEF("physics/2d/deterministic", false);
+	object_order = 0;
+	substeps_left = 1;
 
 	broadphase = BroadPhase2DSW::create_func();
 	broadphase->set_pair_callback(_broadphase_pair, this);
@@ -1406,4 +1913,7 @@ Space2DSW::~Space2DSW() {
 
 	memdelete(broadphase);
 	memdelete(direct_access);
+	for (uint32_t i = 0; i < island_pool.size(); i++) {
+		memdelete(island_pool[i]);
+	}
 }
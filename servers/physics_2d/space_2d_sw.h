@@ -38,6 +38,7 @@
 #include "broad_phase_2d_sw.h"
 #include "collision_object_2d_sw.h"
 #include "core/hash_map.h"
+#include "core/local_vector.h"
 #include "core/project_settings.h"
 #include "core/typedefs.h"
 
@@ -47,14 +48,57 @@ class Physics2DDirectSpaceStateSW : public Physics2DDirectSpaceState {
 
 	int _intersect_point_impl(const Vector2 &p_point, ShapeResult *r_results, int p_result_max, const Set<RID> &p_exclude, uint32_t p_collision_mask, bool p_collide_with_bodies, bool p_collide_with_areas, bool p_pick_point, bool p_filter_by_canvas = false, ObjectID p_canvas_instance_id = 0);
 
+	enum {
+		BATCH_CHUNK_SIZE = 16, // Consecutive queries of a batch that try to share one broadphase cull.
+		BATCH_MAX_SHARED_CANDIDATES = 64, // Past this, the queries of a chunk are too spread out and cull on their own.
+		BATCH_MIN_THREADED_QUERIES = 64,
+	};
+
+	// Candidates of the queries in a batch, filtered once per cull, and the range each query tests.
+	// Culls go into buffers of their own rather than the space's query results. The broadphase culls
+	// still aren't safe to run from several threads, so like other queries a batch can't run while
+	// another thread queries the same space.
+	struct BatchCandidates {
+		LocalVector<Rect2> rects;
+		LocalVector<CollisionObject2DSW *> objects;
+		LocalVector<int> shapes;
+		LocalVector<uint32_t> ranges; // Begin and end in objects, for each query.
+		LocalVector<CollisionObject2DSW *> cull_results;
+		LocalVector<int> cull_subindex_results;
+	};
+
+	struct RayBatch {
+		const BatchCandidates *candidates;
+		const Vector2 *points;
+		RayResult *results;
+		bool *hits;
+	};
+
+	struct MotionBatch {
+		const BatchCandidates *candidates;
+		const Shape2DSW *shape;
+		const Transform2D *xforms;
+		const Vector2 *motions;
+		real_t margin;
+		real_t *closest_safe;
+		real_t *closest_unsafe;
+	};
+
+	void _add_batch_candidates(BatchCandidates &r_candidates, int p_amount, const Set<RID> &p_exclude, uint32_t p_collision_mask, bool p_collide_with_bodies, bool p_collide_with_areas);
+	void _cull_batch(BatchCandidates &r_candidates, int p_count, const Vector2 *p_ray_points, const Set<RID> &p_exclude, uint32_t p_collision_mask, bool p_collide_with_bodies, bool p_collide_with_areas);
+	void _intersect_ray_job(uint32_t p_index, RayBatch *p_batch);
+	void _cast_motion_job(uint32_t p_index, MotionBatch *p_batch);
+
 public:
 	Space2DSW *space;
 
 	virtual int intersect_point(const Vector2 &p_point, ShapeResult *r_results, int p_result_max, const Set<RID> &p_exclude = Set<RID>(), uint32_t p_collision_mask = 0xFFFFFFFF, bool p_collide_with_bodies = true, bool p_collide_with_areas = false, bool p_pick_point = false);
 	virtual int intersect_point_on_canvas(const Vector2 &p_point, ObjectID p_canvas_instance_id, ShapeResult *r_results, int p_result_max, const Set<RID> &p_exclude = Set<RID>(), uint32_t p_collision_mask = 0xFFFFFFFF, bool p_collide_with_bodies = true, bool p_collide_with_areas = false, bool p_pick_point = false);
 	virtual bool intersect_ray(const Vector2 &p_from, const Vector2 &p_to, RayResult &r_result, const Set<RID> &p_exclude = Set<RID>(), uint32_t p_collision_mask = 0xFFFFFFFF, bool p_collide_with_bodies = true, bool p_collide_with_areas = false);
+	virtual void intersect_rays_batch(const Vector2 *p_points, int p_ray_count, RayResult *r_results, bool *r_hits, const Set<RID> &p_exclude = Set<RID>(), uint32_t p_collision_mask = 0xFFFFFFFF, bool p_collide_with_bodies = true, bool p_collide_with_areas = false);
 	virtual int intersect_shape(const RID &p_shape, const Transform2D &p_xform, const Vector2 &p_motion, real_t p_margin, ShapeResult *r_results, int p_result_max, const Set<RID> &p_exclude = Set<RID>(), uint32_t p_collision_mask = 0xFFFFFFFF, bool p_collide_with_bodies = true, bool p_collide_with_areas = false);
 	virtual bool cast_motion(const RID &p_shape, const Transform2D &p_xform, const Vector2 &p_motion, real_t p_margin, real_t &p_closest_safe, real_t &p_closest_unsafe, const Set<RID> &p_exclude = Set<RID>(), uint32_t p_collision_mask = 0xFFFFFFFF, bool p_collide_with_bodies = true, bool p_collide_with_areas = false);
+	virtual bool cast_motions_batch(const RID &p_shape, const Transform2D *p_xforms, const Vector2 *p_motions, int p_count, real_t p_margin, real_t *r_closest_safe, real_t *r_closest_unsafe, const Set<RID> &p_exclude = Set<RID>(), uint32_t p_collision_mask = 0xFFFFFFFF, bool p_collide_with_bodies = true, bool p_collide_with_areas = false);
 	virtual bool collide_shape(RID p_shape, const Transform2D &p_shape_xform, const Vector2 &p_motion, real_t p_margin, Vector2 *r_results, int p_result_max, int &r_result_count, const Set<RID> &p_exclude = Set<RID>(), uint32_t p_collision_mask = 0xFFFFFFFF, bool p_collide_with_bodies = true, bool p_collide_with_areas = false);
 	virtual bool rest_info(RID p_shape, const Transform2D &p_shape_xform, const Vector2 &p_motion, real_t p_margin, ShapeRestInfo *r_info, const Set<RID> &p_exclude = Set<RID>(), uint32_t p_collision_mask = 0xFFFFFFFF, bool p_collide_with_bodies = true, bool p_collide_with_areas = false);
 
@@ -92,6 +136,23 @@ private:
 	SelfList<Body2DSW>::List state_query_list;
 	SelfList<Area2DSW>::List monitor_query_list;
 	SelfList<Area2DSW>::List area_moved_list;
+	LocalVector<Island2DSW *> island_pool;
+
+	uint32_t object_order; // Given to the next object added, see CollisionObject2DSW::get_space_order().
+	bool deterministic;
+
+	// Constraint states from the last restored space state, sorted by order key. Pairs the broadphase
+	// creates again before the next step is set up take theirs from here.
+	struct RestoredConstraintState {
+		uint64_t key;
+		uint32_t subkey;
+		uint32_t offset; // In restored_constraint_data.
+		uint32_t size;
+	};
+	LocalVector<RestoredConstraintState> restored_constraint_states;
+	LocalVector<uint8_t> restored_constraint_data;
+
+	static void _set_pair_order_key(Constraint2DSW *p_constraint, Constraint2DSW::OrderKind p_kind, const CollisionObject2DSW *p_A, int p_shape_A, const CollisionObject2DSW *p_B, int p_shape_B);
 
 	static void *_broadphase_pair(CollisionObject2DSW *A, int p_subindex_A, CollisionObject2DSW *B, int p_subindex_B, void *p_self);
 	static void _broadphase_unpair(CollisionObject2DSW *A, int p_subindex_A, CollisionObject2DSW *B, int p_subindex_B, void *p_data, void *p_self);
@@ -105,6 +166,9 @@ private:
 	real_t contact_max_allowed_penetration;
 	real_t constraint_bias;
 	real_t test_motion_min_contact_depth;
+	int solver_iterations;
+	int solver_substeps;
+	int substeps_left;
 
 	enum {
 
@@ -147,6 +211,14 @@ public:
 	void area_remove_from_moved_list(SelfList<Area2DSW> *p_area);
 	const SelfList<Area2DSW>::List &get_moved_area_list() const;
 
+	Island2DSW *island_create();
+	void island_free(Island2DSW *p_island);
+
+	PoolVector<uint8_t> save_state() const;
+	bool restore_state(const PoolVector<uint8_t> &p_state);
+	void restore_constraint_state(Constraint2DSW *p_constraint);
+	void clear_restored_constraint_states();
+
 	void body_add_to_state_query_list(SelfList<Body2DSW> *p_body);
 	void body_remove_from_state_query_list(SelfList<Body2DSW> *p_body);
 
@@ -166,6 +238,13 @@ public:
 	_FORCE_INLINE_ real_t get_body_linear_velocity_sleep_threshold() const { return body_linear_velocity_sleep_threshold; }
 	_FORCE_INLINE_ real_t get_body_angular_velocity_sleep_threshold() const { return body_angular_velocity_sleep_threshold; }
 	_FORCE_INLINE_ real_t get_body_time_to_sleep() const { return body_time_to_sleep; }
+	_FORCE_INLINE_ bool is_deterministic() const { return deterministic; }
+	_FORCE_INLINE_ int get_solver_iterations() const { return solver_iterations; }
+	_FORCE_INLINE_ int get_solver_substeps() const { return solver_substeps; }
+
+	// Substeps left in the current step, including the one being stepped. Kinematic bodies use it to spread their motion.
+	_FORCE_INLINE_ void set_substeps_left(int p_substeps_left) { substeps_left = p_substeps_left; }
+	_FORCE_INLINE_ int get_substeps_left() const { return substeps_left; }
 
 	void update();
 	void setup();
@@ -30,31 +30,106 @@
 
 #include "step_2d_sw.h"
 #include "core/os/os.h"
+#include "core/project_settings.h"
 
-void Step2DSW::_populate_island(Body2DSW *p_body, Body2DSW **p_island, Constraint2DSW **p_constraint_island) {
+struct _IslandBodyCmp {
+	_FORCE_INLINE_ bool operator()(const Body2DSW *p_a, const Body2DSW *p_b) const {
+		return p_a->get_space_order() < p_b->get_space_order();
+	}
+};
+
+struct _IslandConstraintCmp {
+	_FORCE_INLINE_ bool operator()(const Constraint2DSW *p_a, const Constraint2DSW *p_b) const {
+		return p_a->is_ordered_before(p_b);
+	}
+};
+
+void Step2DSW::_build_island(Space2DSW *p_space, Body2DSW *p_root) {
+
+	Island2DSW *island = p_root->get_island();
+	if (island) {
+		for (uint32_t i = 0; i < island->bodies.size(); i++) {
+			if (island->bodies[i]->get_island() == island) {
+				island->bodies[i]->set_island(NULL);
+			}
+		}
+		island->bodies.clear();
+		island->constraints.clear();
+	} else {
+		island = p_space->island_create();
+	}
 
-	p_body->set_island_step(_step);
-	p_body->set_island_next(*p_island);
-	*p_island = p_body;
+	island_stack.clear();
+	island_stack.push_back(p_root);
+	p_root->set_island(island);
+	island->bodies.push_back(p_root);
 
-	for (Map<Constraint2DSW *, int>::Element *E = p_body->get_constraint_map().front(); E; E = E->next()) {
+	while (island_stack.size()) {
+		Body2DSW *body = island_stack[island_stack.size() - 1];
+		island_stack.resize(island_stack.size() - 1);
 
-		Constraint2DSW *c = (Constraint2DSW *)E->key();
-		if (c->get_island_step() == _step)
-			continue; //already processed
-		c->set_island_step(_step);
-		c->set_island_next(*p_constraint_island);
-		*p_constraint_island = c;
+		for (Map<Constraint2DSW *, int>::Element *E = body->get_constraint_map().front(); E; E = E->next()) {
 
-		for (int i = 0; i < c->get_body_count(); i++) {
-			if (i == E->get())
-				continue;
-			Body2DSW *b = c->get_body_ptr()[i];
-			if (b->get_island_step() == _step || b->get_mode() == Physics2DServer::BODY_MODE_STATIC || b->get_mode() == Physics2DServer::BODY_MODE_KINEMATIC)
-				continue; //no go
-			_populate_island(c->get_body_ptr()[i], p_island, p_constraint_island);
+			Constraint2DSW *c = E->key();
+			Body2DSW **c_bodies = c->get_body_ptr();
+
+			// Only added through its first dynamic body, so it's in the island once.
+			int first_dynamic = 0;
+			while (c_bodies[first_dynamic]->get_mode() <= Physics2DServer::BODY_MODE_KINEMATIC) {
+				first_dynamic++;
+			}
+			if (first_dynamic == E->get()) {
+				island->constraints.push_back(c);
+			}
+
+			for (int i = 0; i < c->get_body_count(); i++) {
+				Body2DSW *b = c_bodies[i];
+				if (b->get_island() == island || b->get_mode() <= Physics2DServer::BODY_MODE_KINEMATIC) {
+					continue;
+				}
+
+				Island2DSW *other = b->get_island();
+				if (other) {
+					// Merged into this one, its remaining bodies are found again or rebuild their own.
+					for (uint32_t j = 0; j < other->bodies.size(); j++) {
+						if (other->bodies[j]->get_island() == other) {
+							other->bodies[j]->set_island(NULL);
+						}
+					}
+					if (other->step == _step) {
+						step_islands.erase(other);
+					}
+					p_space->island_free(other);
+				}
+
+				b->set_island(island);
+				island->bodies.push_back(b);
+				island_stack.push_back(b);
+			}
 		}
 	}
+
+	if (p_space->is_deterministic()) {
+		// The walk above follows constraint maps, which are sorted by address. Constraints are solved one
+		// after the other, each seeing the impulses of the previous ones, so the order changes the result.
+		island->bodies.sort_custom<_IslandBodyCmp>();
+		island->constraints.sort_custom<_IslandConstraintCmp>();
+	}
+
+	island->dirty = false;
+}
+
+void Step2DSW::_queue_island(Space2DSW *p_space, Body2DSW *p_body) {
+
+	if (!p_body->get_island() || p_body->get_island()->dirty) {
+		_build_island(p_space, p_body);
+	}
+
+	Island2DSW *island = p_body->get_island();
+	if (island->step != _step) {
+		island->step = _step;
+		step_islands.push_back(island);
+	}
 }
 
 bool Step2DSW::_setup_island(Constraint2DSW *p_island, real_t p_delta) {
@@ -131,6 +206,32 @@ void Step2DSW::_check_suspend(Body2DSW *p_island, real_t p_delta) {
 	}
 }
 
+void Step2DSW::_integrate_forces_job(uint32_t p_job, void *p_userdata) {
+
+	uint32_t from = p_job * BODY_BATCH_SIZE;
+	uint32_t to = MIN(from + BODY_BATCH_SIZE, bodies.size());
+	for (uint32_t i = from; i < to; i++) {
+		bodies[i]->integrate_forces(step_delta);
+	}
+}
+
+void Step2DSW::_integrate_velocities_job(uint32_t p_job, void *p_userdata) {
+
+	uint32_t from = p_job * BODY_BATCH_SIZE;
+	uint32_t to = MIN(from + BODY_BATCH_SIZE, bodies.size());
+	for (uint32_t i = from; i < to; i++) {
+		bodies[i]->integrate_velocities(step_delta);
+	}
+}
+
+void Step2DSW::_solve_islands_job(uint32_t p_job, void *p_userdata) {
+
+	// Islands share no dynamic body, see Body2DSW::apply_impulse().
+	for (uint32_t i = island_batches[p_job]; i < island_batches[p_job + 1]; i++) {
+		_solve_island(constraint_islands[i], step_iterations, step_delta);
+	}
+}
+
 void Step2DSW::step(Space2DSW *p_space, real_t p_delta, int p_iterations) {
 
 	p_space->lock(); // can't access space during this
@@ -144,17 +245,25 @@ void Step2DSW::step(Space2DSW *p_space, real_t p_delta, int p_iterations) {
 	uint64_t profile_begtime = OS::get_singleton()->get_ticks_usec();
 	uint64_t profile_endtime = 0;
 
-	int active_count = 0;
+	step_delta = p_delta;
+	step_iterations = p_iterations;
 
+	bodies.clear();
 	const SelfList<Body2DSW> *b = body_list->first();
 	while (b) {
-
-		b->self()->integrate_forces(p_delta);
+		bodies.push_back(b->self());
 		b = b->next();
-		active_count++;
 	}
 
-	p_space->set_active_objects(active_count);
+	uint32_t body_jobs = (bodies.size() + BODY_BATCH_SIZE - 1) / BODY_BATCH_SIZE;
+	work_pool.do_work(body_jobs, this, &Step2DSW::_integrate_forces_job, (void *)NULL);
+	p_space->get_broadphase()->begin_bulk_move();
+	for (uint32_t i = 0; i < bodies.size(); i++) {
+		bodies[i]->finish_integrate_forces();
+	}
+	p_space->get_broadphase()->end_bulk_move();
+
+	p_space->set_active_objects(bodies.size());
 
 	{ //profile
 		profile_endtime = OS::get_singleton()->get_ticks_usec();
@@ -166,29 +275,73 @@ void Step2DSW::step(Space2DSW *p_space, real_t p_delta, int p_iterations) {
 
 	Body2DSW *island_list = NULL;
 	Constraint2DSW *constraint_island_list = NULL;
-	b = body_list->first();
 
 	int island_count = 0;
 
-	while (b) {
-		Body2DSW *body = b->self();
+	// Islands persist between steps, only those marked dirty are rebuilt. Kinematic bodies don't
+	// link islands, they queue the islands of the bodies they touch instead.
+	step_islands.clear();
+	Constraint2DSW *kinematic_island = NULL;
 
-		if (body->get_island_step() != _step) {
+	for (uint32_t i = 0; i < bodies.size(); i++) {
+		Body2DSW *body = bodies[i];
 
-			Body2DSW *island = NULL;
-			Constraint2DSW *constraint_island = NULL;
-			_populate_island(body, &island, &constraint_island);
+		if (body->get_mode() > Physics2DServer::BODY_MODE_KINEMATIC) {
+			_queue_island(p_space, body);
+			continue;
+		}
 
-			island->set_island_list_next(island_list);
-			island_list = island;
+		for (Map<Constraint2DSW *, int>::Element *E = body->get_constraint_map().front(); E; E = E->next()) {
 
-			if (constraint_island) {
-				constraint_island->set_island_list_next(constraint_island_list);
-				constraint_island_list = constraint_island;
-				island_count++;
+			Constraint2DSW *c = E->key();
+			bool dynamic = false;
+			for (int j = 0; j < c->get_body_count(); j++) {
+				Body2DSW *b = c->get_body_ptr()[j];
+				if (b->get_mode() > Physics2DServer::BODY_MODE_KINEMATIC) {
+					_queue_island(p_space, b);
+					dynamic = true;
+				}
+			}
+
+			if (!dynamic && c->get_island_step() != _step) {
+				c->set_island_step(_step);
+				c->set_island_next(kinematic_island);
+				kinematic_island = c;
 			}
 		}
-		b = b->next();
+	}
+
+	for (uint32_t i = 0; i < step_islands.size(); i++) {
+		Island2DSW *island = step_islands[i];
+
+		Body2DSW *body_island = NULL;
+		for (uint32_t j = 0; j < island->bodies.size(); j++) {
+			Body2DSW *b = island->bodies[j];
+			b->set_island_step(_step);
+			b->set_island_next(body_island);
+			body_island = b;
+		}
+		body_island->set_island_list_next(island_list);
+		island_list = body_island;
+
+		Constraint2DSW *constraint_island = NULL;
+		for (uint32_t j = 0; j < island->constraints.size(); j++) {
+			Constraint2DSW *c = island->constraints[j];
+			c->set_island_step(_step);
+			c->set_island_next(constraint_island);
+			constraint_island = c;
+		}
+		if (constraint_island) {
+			constraint_island->set_island_list_next(constraint_island_list);
+			constraint_island_list = constraint_island;
+			island_count++;
+		}
+	}
+
+	if (kinematic_island) {
+		kinematic_island->set_island_list_next(constraint_island_list);
+		constraint_island_list = kinematic_island;
+		island_count++;
 	}
 
 	p_space->set_island_count(island_count);
@@ -217,6 +370,18 @@ void Step2DSW::step(Space2DSW *p_space, real_t p_delta, int p_iterations) {
 
 	/* SETUP CONSTRAINT ISLANDS */
 
+	{
+		// Pairs of simple shapes that are clearly apart skip the full solve in setup().
+		Constraint2DSW *ci = constraint_island_list;
+		while (ci) {
+			for (Constraint2DSW *c = ci; c; c = c->get_island_next()) {
+				c->add_to_separation_batch(&separation_batch);
+			}
+			ci = ci->get_island_list_next();
+		}
+		separation_batch.run();
+	}
+
 	{
 		Constraint2DSW *ci = constraint_island_list;
 		Constraint2DSW *prev_ci = NULL;
@@ -264,12 +429,29 @@ void Step2DSW::step(Space2DSW *p_space, real_t p_delta, int p_iterations) {
 	/* SOLVE CONSTRAINT ISLANDS */
 
 	{
+		// Islands are independent, each job solves one or more of them in list order.
+		constraint_islands.clear();
+		island_batches.clear();
+
+		uint32_t batch_constraints = 0;
 		Constraint2DSW *ci = constraint_island_list;
 		while (ci) {
-			//iterating each island separatedly improves cache efficiency
-			_solve_island(ci, p_iterations, p_delta);
+			if (batch_constraints == 0) {
+				island_batches.push_back(constraint_islands.size());
+			}
+			constraint_islands.push_back(ci);
+
+			for (Constraint2DSW *c = ci; c; c = c->get_island_next()) {
+				batch_constraints++;
+			}
+			if (batch_constraints >= ISLAND_BATCH_MIN_CONSTRAINTS) {
+				batch_constraints = 0;
+			}
 			ci = ci->get_island_list_next();
 		}
+		island_batches.push_back(constraint_islands.size());
+
+		work_pool.do_work(island_batches.size() - 1, this, &Step2DSW::_solve_islands_job, (void *)NULL);
 	}
 
 	{ //profile
@@ -280,13 +462,12 @@ void Step2DSW::step(Space2DSW *p_space, real_t p_delta, int p_iterations) {
 
 	/* INTEGRATE VELOCITIES */
 
-	b = body_list->first();
-	while (b) {
-
-		const SelfList<Body2DSW> *n = b->next();
-		b->self()->integrate_velocities(p_delta);
-		b = n; // in case it shuts itself down
+	work_pool.do_work(body_jobs, this, &Step2DSW::_integrate_velocities_job, (void *)NULL);
+	p_space->get_broadphase()->begin_bulk_move();
+	for (uint32_t i = 0; i < bodies.size(); i++) {
+		bodies[i]->finish_integrate_velocities(); // may take the body out of the active list
 	}
+	p_space->get_broadphase()->end_bulk_move();
 
 	/* SLEEP / WAKE UP ISLANDS */
 
@@ -305,6 +486,7 @@ void Step2DSW::step(Space2DSW *p_space, real_t p_delta, int p_iterations) {
 		//profile_begtime=profile_endtime;
 	}
 
+	p_space->clear_restored_constraint_states(); // Pairs found again after a restore were set up by now.
 	p_space->update();
 	p_space->unlock();
 	_step++;
@@ -313,4 +495,16 @@ void Step2DSW::step(Space2DSW *p_space, real_t p_delta, int p_iterations) {
 Step2DSW::Step2DSW() {
 
 	_step = 1;
+	step_delta = 0;
+	step_iterations = 0;
+
+	// 0 uses one thread per processor.
+	int thread_count = GLOBAL_DEF("physics/2d/solver_thread_count", 0);
+	ProjectSettings::get_singleton()->set_custom_property_info("physics/2d/solver_thread_count", PropertyInfo(Variant::INT, "physics/2d/solver_thread_count", PROPERTY_HINT_RANGE, "0,64,1,or_greater"));
+	work_pool.init(thread_count > 0 ? thread_count : -1);
+}
+
+Step2DSW::~Step2DSW() {
+
+	work_pool.finish();
 }
@@ -31,20 +31,51 @@
 #ifndef STEP_2D_SW_H
 #define STEP_2D_SW_H
 
+#include "collision_solver_2d_sw.h"
+#include "core/local_vector.h"
+#include "core/os/thread_work_pool.h"
 #include "space_2d_sw.h"
 
 class Step2DSW {
 
+	enum {
+		BODY_BATCH_SIZE = 64, // Bodies integrated by one job.
+		ISLAND_BATCH_MIN_CONSTRAINTS = 64, // Small islands are solved together until a job has this many constraints.
+	};
+
 	uint64_t _step;
 
-	void _populate_island(Body2DSW *p_body, Body2DSW **p_island, Constraint2DSW **p_constraint_island);
+	ThreadWorkPool work_pool;
+
+	// Filled by step() for the jobs, in the order the islands were built; the result
+	// doesn't depend on which thread runs what.
+	real_t step_delta;
+	int step_iterations;
+	LocalVector<Body2DSW *> bodies;
+	LocalVector<Constraint2DSW *> constraint_islands;
+	LocalVector<uint32_t> island_batches; // First island of each job, followed by the island count.
+	SeparationBatch2DSW separation_batch;
+	LocalVector<Island2DSW *> step_islands; // Islands with an active body, in the order they were queued.
+	LocalVector<Body2DSW *> island_stack;
+
+	void _build_island(Space2DSW *p_space, Body2DSW *p_root);
+	void _queue_island(Space2DSW *p_space, Body2DSW *p_body);
 	bool _setup_island(Constraint2DSW *p_island, real_t p_delta);
 	void _solve_island(Constraint2DSW *p_island, int p_iterations, real_t p_delta);
 	void _check_suspend(Body2DSW *p_island, real_t p_delta);
 
+	void _integrate_forces_job(uint32_t p_job, void *p_userdata);
+	void _integrate_velocities_job(uint32_t p_job, void *p_userdata);
+	void _solve_islands_job(uint32_t p_job, void *p_userdata);
+
 public:
 	void step(Space2DSW *p_space, real_t p_delta, int p_iterations);
+
+	// Also used by batched space queries. While a step uses the threads, those run on the calling thread.
+	ThreadWorkPool &get_work_pool() { return work_pool; }
+
 	Step2DSW();
+	~Step2DSW();
 };
 
 #endif // STEP_2D_SW_H
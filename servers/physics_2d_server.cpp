@@ -328,6 +328,124 @@ Array Physics2DDirectSpaceState::_cast_motion(const Ref<Physics2DShapeQueryParam
 	return ret;
 }
 
+Dictionary Physics2DDirectSpaceState::_intersect_rays_batch(const PoolVector2Array &p_points, const Vector<RID> &p_exclude, uint32_t p_layers, bool p_collide_with_bodies, bool p_collide_with_areas) {
+
+	ERR_FAIL_COND_V_MSG(p_points.size() % 2, Dictionary(), "Points must come in from and to pairs.");
+
+	Set<RID> exclude;
+	for (int i = 0; i < p_exclude.size(); i++)
+		exclude.insert(p_exclude[i]);
+
+	int ray_count = p_points.size() / 2;
+
+	Vector<RayResult> results;
+	results.resize(ray_count);
+	Vector<bool> hits;
+	hits.resize(ray_count);
+
+	{
+		PoolVector2Array::Read r = p_points.read();
+		intersect_rays_batch(r.ptr(), ray_count, results.ptrw(), hits.ptrw(), exclude, p_layers, p_collide_with_bodies, p_collide_with_areas);
+	}
+
+	PoolVector2Array positions;
+	positions.resize(ray_count);
+	PoolVector2Array normals;
+	normals.resize(ray_count);
+	PoolIntArray shapes;
+	shapes.resize(ray_count);
+	Array colliders;
+	colliders.resize(ray_count);
+
+	{
+		PoolVector2Array::Write wp = positions.write();
+		PoolVector2Array::Write wn = normals.write();
+		PoolIntArray::Write ws = shapes.write();
+
+		for (int i = 0; i < ray_count; i++) {
+
+			if (!hits[i]) {
+				ws[i] = -1;
+				continue;
+			}
+
+			wp[i] = results[i].position;
+			wn[i] = results[i].normal;
+			ws[i] = results[i].shape;
+			colliders[i] = results[i].collider;
+		}
+	}
+
+	Dictionary d;
+	d["position"] = positions;
+	d["normal"] = normals;
+	d["shape"] = shapes;
+	d["collider"] = colliders;
+
+	return d;
+}
+
+PoolRealArray Physics2DDirectSpaceState::_cast_motions_batch(const Ref<Physics2DShapeQueryParameters> &p_shape_query, const PoolVector2Array &p_origins, const PoolVector2Array &p_motions) {
+
+	ERR_FAIL_COND_V(!p_shape_query.is_valid(), PoolRealArray());
+	ERR_FAIL_COND_V_MSG(p_origins.size() != p_motions.size(), PoolRealArray(), "There must be one motion per origin.");
+
+	int count = p_origins.size();
+
+	Vector<Transform2D> xforms;
+	xforms.resize(count);
+	Vector<float> safe;
+	safe.resize(count);
+	Vector<float> unsafe;
+	unsafe.resize(count);
+
+	{
+		PoolVector2Array::Read r = p_origins.read();
+		for (int i = 0; i < count; i++) {
+			xforms.write[i] = p_shape_query->transform;
+			xforms.write[i].set_origin(r[i]);
+		}
+	}
+
+	bool res;
+	{
+		PoolVector2Array::Read r = p_motions.read();
+		res = cast_motions_batch(p_shape_query->shape, xforms.ptr(), r.ptr(), count, p_shape_query->margin, safe.ptrw(), unsafe.ptrw(), p_shape_query->exclude, p_shape_query->collision_mask, p_shape_query->collide_with_bodies, p_shape_query->collide_with_areas);
+	}
+	if (!res)
+		return PoolRealArray();
+
+	PoolRealArray ret;
+	ret.resize(count * 2);
+	PoolRealArray::Write w = ret.write();
+	for (int i = 0; i < count; i++) {
+		w[i * 2 + 0] = safe[i];
+		w[i * 2 + 1] = unsafe[i];
+	}
+
+	return ret;
+}
+
+void Physics2DDirectSpaceState::intersect_rays_batch(const Vector2 *p_points, int p_ray_count, RayResult *r_results, bool *r_hits, const Set<RID> &p_exclude, uint32_t p_collision_layer, bool p_collide_with_bodies, bool p_collide_with_areas) {
+
+	for (int i = 0; i < p_ray_count; i++) {
+		r_hits[i] = intersect_ray(p_points[i * 2 + 0], p_points[i * 2 + 1], r_results[i], p_exclude, p_collision_layer, p_collide_with_bodies, p_collide_with_areas);
+	}
+}
+
+bool Physics2DDirectSpaceState::cast_motions_batch(const RID &p_shape, const Transform2D *p_xforms, const Vector2 *p_motions, int p_count, float p_margin, float *r_closest_safe, float *r_closest_unsafe, const Set<RID> &p_exclude, uint32_t p_collision_layer, bool p_collide_with_bodies, bool p_collide_with_areas) {
+
+	for (int i = 0; i < p_count; i++) {
+		r_closest_safe[i] = 1.0f;
+		r_closest_unsafe[i] = 1.0f;
+		if (!cast_motion(p_shape, p_xforms[i], p_motions[i], p_margin, r_closest_safe[i], r_closest_unsafe[i], p_exclude, p_collision_layer, p_collide_with_bodies, p_collide_with_areas)) {
+			return false;
+		}
+	}
+
+	return true;
+}
+
 Array Physics2DDirectSpaceState::_intersect_point_impl(const Vector2 &p_point, int p_max_results, const Vector<RID> &p_exclude, uint32_t p_layers, bool p_collide_with_bodies, bool p_collide_with_areas, bool p_filter_by_canvas, ObjectID p_canvas_instance_id) {
 
 	Set<RID> exclude;
@@ -419,6 +537,8 @@ void Physics2DDirectSpaceState::_bind_methods() {
 	ClassDB::bind_method(D_METHOD("intersect_ray", "from", "to", "exclude", "collision_layer", "collide_with_bodies", "collide_with_areas"), &Physics2DDirectSpaceState::_intersect_ray, DEFVAL(Array()), DEFVAL(0x7FFFFFFF), DEFVAL(true), DEFVAL(false));
 	ClassDB::bind_method(D_METHOD("intersect_shape", "shape", "max_results"), &Physics2DDirectSpaceState::_intersect_shape, DEFVAL(32));
 	ClassDB::bind_method(D_METHOD("cast_motion", "shape"), &Physics2DDirectSpaceState::_cast_motion);
+	ClassDB::bind_method(D_METHOD("intersect_rays_batch", "points", "exclude", "collision_layer", "collide_with_bodies", "collide_with_areas"), &Physics2DDirectSpaceState::_intersect_rays_batch, DEFVAL(Array()), DEFVAL(0x7FFFFFFF), DEFVAL(true), DEFVAL(false));
+	ClassDB::bind_method(D_METHOD("cast_motions_batch", "shape", "origins", "motions"), &Physics2DDirectSpaceState::_cast_motions_batch);
 	ClassDB::bind_method(D_METHOD("collide_shape", "shape", "max_results"), &Physics2DDirectSpaceState::_collide_shape, DEFVAL(32));
 	ClassDB::bind_method(D_METHOD("get_rest_info", "shape"), &Physics2DDirectSpaceState::_get_rest_info);
 }
@@ -559,6 +679,8 @@ void Physics2DServer::_bind_methods() {
 	ClassDB::bind_method(D_METHOD("space_set_param", "space", "param", "value"), &Physics2DServer::space_set_param);
 	ClassDB::bind_method(D_METHOD("space_get_param", "space", "param"), &Physics2DServer::space_get_param);
 	ClassDB::bind_method(D_METHOD("space_get_direct_state", "space"), &Physics2DServer::space_get_direct_state);
+	ClassDB::bind_method(D_METHOD("space_save_state", "space"), &Physics2DServer::space_save_state);
+	ClassDB::bind_method(D_METHOD("space_restore_state", "space", "state"), &Physics2DServer::space_restore_state);
 
 	ClassDB::bind_method(D_METHOD("area_create"), &Physics2DServer::area_create);
 	ClassDB::bind_method(D_METHOD("area_set_space", "area", "space"), &Physics2DServer::area_set_space);
@@ -694,6 +816,9 @@ void Physics2DServer::_bind_methods() {
 	BIND_ENUM_CONSTANT(SPACE_PARAM_BODY_TIME_TO_SLEEP);
 	BIND_ENUM_CONSTANT(SPACE_PARAM_CONSTRAINT_DEFAULT_BIAS);
 	BIND_ENUM_CONSTANT(SPACE_PARAM_TEST_MOTION_MIN_CONTACT_DEPTH);
+	BIND_ENUM_CONSTANT(SPACE_PARAM_SOLVER_ITERATIONS);
+	BIND_ENUM_CONSTANT(SPACE_PARAM_SOLVER_SUBSTEPS);
+	BIND_ENUM_CONSTANT(SPACE_PARAM_DETERMINISTIC);
 
 	BIND_ENUM_CONSTANT(SHAPE_LINE);
 	BIND_ENUM_CONSTANT(SHAPE_RAY);
@@ -319,6 +319,124 @@ Array PhysicsDirectSpaceState::_cast_motion(const Ref<PhysicsShapeQueryParameter
 	ret[1] = closest_unsafe;
 	return ret;
 }
+Dictionary PhysicsDirectSpaceState::_intersect_rays_batch(const PoolVector3Array &p_points, const Vector<RID> &p_exclude, uint32_t p_collision_mask, bool p_collide_with_bodies, bool p_collide_with_areas) {
+
+	ERR_FAIL_COND_V_MSG(p_points.size() % 2, Dictionary(), "Points must come in from and to pairs.");
+
+	Set<RID> exclude;
+	for (int i = 0; i < p_exclude.size(); i++)
+		exclude.insert(p_exclude[i]);
+
+	int ray_count = p_points.size() / 2;
+
+	Vector<RayResult> results;
+	results.resize(ray_count);
+	Vector<bool> hits;
+	hits.resize(ray_count);
+
+	{
+		PoolVector3Array::Read r = p_points.read();
+		intersect_rays_batch(r.ptr(), ray_count, results.ptrw(), hits.ptrw(), exclude, p_collision_mask, p_collide_with_bodies, p_collide_with_areas);
+	}
+
+	PoolVector3Array positions;
+	positions.resize(ray_count);
+	PoolVector3Array normals;
+	normals.resize(ray_count);
+	PoolIntArray shapes;
+	shapes.resize(ray_count);
+	Array colliders;
+	colliders.resize(ray_count);
+
+	{
+		PoolVector3Array::Write wp = positions.write();
+		PoolVector3Array::Write wn = normals.write();
+		PoolIntArray::Write ws = shapes.write();
+
+		for (int i = 0; i < ray_count; i++) {
+
+			if (!hits[i]) {
+				ws[i] = -1;
+				continue;
+			}
+
+			wp[i] = results[i].position;
+			wn[i] = results[i].normal;
+			ws[i] = results[i].shape;
+			colliders[i] = results[i].collider;
+		}
+	}
+
+	Dictionary d;
+	d["position"] = positions;
+	d["normal"] = normals;
+	d["shape"] = shapes;
+	d["collider"] = colliders;
+
+	return d;
+}
+
+PoolRealArray PhysicsDirectSpaceState::_cast_motions_batch(const Ref<PhysicsShapeQueryParameters> &p_shape_query, const PoolVector3Array &p_origins, const PoolVector3Array &p_motions) {
+
+	ERR_FAIL_COND_V(!p_shape_query.is_valid(), PoolRealArray());
+	ERR_FAIL_COND_V_MSG(p_origins.size() != p_motions.size(), PoolRealArray(), "There must be one motion per origin.");
+
+	int count = p_origins.size();
+
+	Vector<Transform> xforms;
+	xforms.resize(count);
+	Vector<float> safe;
+	safe.resize(count);
+	Vector<float> unsafe;
+	unsafe.resize(count);
+
+	{
+		PoolVector3Array::Read r = p_origins.read();
+		for (int i = 0; i < count; i++) {
+			xforms.write[i] = p_shape_query->transform;
+			xforms.write[i].origin = r[i];
+		}
+	}
+
+	bool res;
+	{
+		PoolVector3Array::Read r = p_motions.read();
+		res = cast_motions_batch(p_shape_query->shape, xforms.ptr(), r.ptr(), count, p_shape_query->margin, safe.ptrw(), unsafe.ptrw(), p_shape_query->exclude, p_shape_query->collision_mask, p_shape_query->collide_with_bodies, p_shape_query->collide_with_areas);
+	}
+	if (!res)
+		return PoolRealArray();
+
+	PoolRealArray ret;
+	ret.resize(count * 2);
+	PoolRealArray::Write w = ret.write();
+	for (int i = 0; i < count; i++) {
+		w[i * 2 + 0] = safe[i];
+		w[i * 2 + 1] = unsafe[i];
+	}
+
+	return ret;
+}
+
+void PhysicsDirectSpaceState::intersect_rays_batch(const Vector3 *p_points, int p_ray_count, RayResult *r_results, bool *r_hits, const Set<RID> &p_exclude, uint32_t p_collision_mask, bool p_collide_with_bodies, bool p_collide_with_areas) {
+
+	for (int i = 0; i < p_ray_count; i++) {
+		r_hits[i] = intersect_ray(p_points[i * 2 + 0], p_points[i * 2 + 1], r_results[i], p_exclude, p_collision_mask, p_collide_with_bodies, p_collide_with_areas);
+	}
+}
+
+bool PhysicsDirectSpaceState::cast_motions_batch(const RID &p_shape, const Transform *p_xforms, const Vector3 *p_motions, int p_count, float p_margin, float *r_closest_safe, float *r_closest_unsafe, const Set<RID> &p_exclude, uint32_t p_collision_mask, bool p_collide_with_bodies, bool p_collide_with_areas) {
+
+	for (int i = 0; i < p_count; i++) {
+		r_closest_safe[i] = 1.0f;
+		r_closest_unsafe[i] = 1.0f;
+		if (!cast_motion(p_shape, p_xforms[i], p_motions[i], p_margin, r_closest_safe[i], r_closest_unsafe[i], p_exclude, p_collision_mask, p_collide_with_bodies, p_collide_with_areas)) {
+			return false;
+		}
+	}
+
+	return true;
+}
+
 Array PhysicsDirectSpaceState::_collide_shape(const Ref<PhysicsShapeQueryParameters> &p_shape_query, int p_max_results) {
 
 	ERR_FAIL_COND_V(!p_shape_query.is_valid(), Array());
@@ -364,6 +482,8 @@ void PhysicsDirectSpaceState::_bind_methods() {
 	ClassDB::bind_method(D_METHOD("intersect_ray", "from", "to", "exclude", "collision_mask", "collide_with_bodies", "collide_with_areas"), &PhysicsDirectSpaceState::_intersect_ray, DEFVAL(Array()), DEFVAL(0x7FFFFFFF), DEFVAL(true), DEFVAL(false));
 	ClassDB::bind_method(D_METHOD("intersect_shape", "shape", "max_results"), &PhysicsDirectSpaceState::_intersect_shape, DEFVAL(32));
 	ClassDB::bind_method(D_METHOD("cast_motion", "shape", "motion"), &PhysicsDirectSpaceState::_cast_motion);
+	ClassDB::bind_method(D_METHOD("intersect_rays_batch", "points", "exclude", "collision_mask", "collide_with_bodies", "collide_with_areas"), &PhysicsDirectSpaceState::_intersect_rays_batch, DEFVAL(Array()), DEFVAL(0x7FFFFFFF), DEFVAL(true), DEFVAL(false));
+	ClassDB::bind_method(D_METHOD("cast_motions_batch", "shape", "origins", "motions"), &PhysicsDirectSpaceState::_cast_motions_batch);
 	ClassDB::bind_method(D_METHOD("collide_shape", "shape", "max_results"), &PhysicsDirectSpaceState::_collide_shape, DEFVAL(32));
 	ClassDB::bind_method(D_METHOD("get_rest_info", "shape"), &PhysicsDirectSpaceState::_get_rest_info);
 }
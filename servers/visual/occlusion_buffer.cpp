@@ -0,0 +1,339 @@
+/*************************************************************************/
+/*  occlusion_buffer.cpp                                                 */
+/*************************************************************************/
+/*                       This file is part of:                           */
+/*                           GODOT ENGINE                                */
+/*                      https://godotengine.org                          */
+/*************************************************************************/
+/* Copyright (c) 2007-2021 Juan Linietsky, Ariel Manzur.                 */
+/* Copyright (c) 2014-2021 Godot Engine contributors (cf. AUTHORS.md).   */
+/*                                                                       */
+/* Permission is hereby granted, free of charge, to any person obtaining */
+/* a copy of this software and associated documentation files (the       */
+/* "Software"), to deal in the Software without restriction, including   */
+/* without limitation the rights to use, copy, modify, merge, publish,   */
+/* distribute, sublicense, and/or sell copies of the Software, and to    */
+/* permit persons to whom the Software is furnished to do so, subject to */
+/* the following conditions:                                             */
+/*                                                                       */
+/* The above copyright notice and this permission notice shall be        */
+/* included in all copies or substantial portions of the Software.       */
+/*                                                                       */
+/* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,       */
+/* EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF    */
+/* MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.*/
+/* IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY  */
+/* CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,  */
+/* TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE     */
+/* SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.                */
+/*************************************************************************/
+
+#include "occlusion_buffer.h"
+
+// Depth of the pixels no occluder covers, behind anything in view.
+static const float EMPTY_DEPTH = 1e20;
+// How far in front, in normalized device z, an occluder must be to hide something.
+// Keeps surfaces lying on an occluder, and rounding in the interpolated depths, from hiding instances.
+static const float DEPTH_BIAS = 1e-5;
+
+void OcclusionBuffer::set_size(int p_width, int p_height) {
+
+	tiles_x = (MAX(p_width, (int)MIN_SIZE) + TILE_SIZE - 1) / TILE_SIZE;
+	tiles_y = (MAX(p_height, (int)MIN_SIZE) + TILE_SIZE - 1) / TILE_SIZE;
+	width = tiles_x * TILE_SIZE;
+	height = tiles_y * TILE_SIZE;
+
+	depth.resize(width * height);
+	depth_owner.resize(width * height);
+	tile_max_depth.resize(tiles_x * tiles_y);
+}
+
+void OcclusionBuffer::begin(const CameraMatrix &p_projection, const Transform &p_cam_transform) {
+
+	view_projection = p_projection * CameraMatrix(p_cam_transform.affine_inverse());
+	planes = p_projection.get_projection_planes(p_cam_transform);
+
+	for (uint32_t i = 0; i < depth.size(); i++) {
+		depth[i] = EMPTY_DEPTH;
+		depth_owner[i] = 0;
+	}
+	for (uint32_t i = 0; i < tile_max_depth.size(); i++) {
+		tile_max_depth[i] = EMPTY_DEPTH;
+	}
+	screen_vertices.clear();
+	triangle_owner.clear();
+	occluder_rects.clear();
+}
+
+void OcclusionBuffer::add_occluder(uint32_t p_owner, const Transform &p_transform, const AABB &p_aabb, const PoolVector<Vector3> &p_triangles) {
+
+	AABB aabb = p_transform.xform(p_aabb);
+	for (int i = 0; i < planes.size(); i++) {
+		if (planes[i].distance_to(aabb.get_support(planes[i].normal)) > 0) {
+			return;
+		}
+	}
+
+	// Straight from local space to clip space.
+	CameraMatrix m = view_projection * CameraMatrix(p_transform);
+
+	int count = p_triangles.size() / 3 * 3;
+	PoolVector<Vector3>::Read r = p_triangles.read();
+
+	uint32_t first = screen_vertices.size();
+	uint32_t ofs = first;
+	screen_vertices.resize(ofs + count);
+
+	for (int i = 0; i < count; i += 3) {
+
+		bool in_front = true;
+		for (int j = 0; j < 3; j++) {
+
+			const Vector3 &v = r[i + j];
+			real_t x = m.matrix[0][0] * v.x + m.matrix[1][0] * v.y + m.matrix[2][0] * v.z + m.matrix[3][0];
+			real_t y = m.matrix[0][1] * v.x + m.matrix[1][1] * v.y + m.matrix[2][1] * v.z + m.matrix[3][1];
+			real_t z = m.matrix[0][2] * v.x + m.matrix[1][2] * v.y + m.matrix[2][2] * v.z + m.matrix[3][2];
+			real_t w = m.matrix[0][3] * v.x + m.matrix[1][3] * v.y + m.matrix[2][3] * v.z + m.matrix[3][3];
+
+			// Not clipped, dropping the triangle only makes the occluder smaller.
+			if (w <= CMP_EPSILON || z < -w) {
+				in_front = false;
+				break;
+			}
+
+			real_t inv_w = 1.0 / w;
+			screen_vertices[ofs + j] = Vector3((x * inv_w * 0.5 + 0.5) * width, (0.5 - y * inv_w * 0.5) * height, z * inv_w);
+		}
+
+		if (in_front) {
+			ofs += 3;
+		}
+	}
+
+	screen_vertices.resize(ofs);
+	if (ofs == first) {
+		return;
+	}
+
+	Vector2 rect_min(1e20, 1e20);
+	Vector2 rect_max(-1e20, -1e20);
+	for (uint32_t i = first; i < ofs; i++) {
+		rect_min.x = MIN(rect_min.x, screen_vertices[i].x);
+		rect_min.y = MIN(rect_min.y, screen_vertices[i].y);
+		rect_max.x = MAX(rect_max.x, screen_vertices[i].x);
+		rect_max.y = MAX(rect_max.y, screen_vertices[i].y);
+	}
+	for (uint32_t i = first; i < ofs; i += 3) {
+		triangle_owner.push_back(p_owner);
+	}
+
+	OccluderRect rect;
+	rect.owner = p_owner;
+	rect.x0 = (int)Math::floor(CLAMP(rect_min.x, 0.0f, (float)width));
+	rect.x1 = (int)Math::ceil(CLAMP(rect_max.x, 0.0f, (float)width));
+	rect.y0 = (int)Math::floor(CLAMP(rect_min.y, 0.0f, (float)height));
+	rect.y1 = (int)Math::ceil(CLAMP(rect_max.y, 0.0f, (float)height));
+	occluder_rects.push_back(rect);
+}
+
+void OcclusionBuffer::_rasterize_band(uint32_t p_band, void *p_userdata) {
+
+	int band_begin = p_band * band_height;
+	int band_end = MIN(band_begin + band_height, height);
+	if (band_begin >= band_end) {
+		return;
+	}
+
+	float *buffer = depth.ptr();
+	uint32_t *owners = depth_owner.ptr();
+	const Vector3 *v = screen_vertices.ptr();
+	uint32_t count = screen_vertices.size();
+
+	for (uint32_t i = 0; i < count; i += 3) {
+
+		Vector3 a = v[i];
+		Vector3 b = v[i + 1];
+		Vector3 c = v[i + 2];
+
+		float area = (b.x - a.x) * (c.y - a.y) - (b.y - a.y) * (c.x - a.x);
+		if (area < 0) {
+			// Occluders are two sided.
+			SWAP(b, c);
+			area = -area;
+		}
+		if (area < CMP_EPSILON) {
+			continue;
+		}
+
+		// Clamped before converting, vertices close to the camera plane land far off screen.
+		int min_x = (int)Math::floor(CLAMP(MIN(a.x, MIN(b.x, c.x)), 0.0f, (float)width));
+		int max_x = (int)Math::ceil(CLAMP(MAX(a.x, MAX(b.x, c.x)), 0.0f, (float)width));
+		int min_y = (int)Math::floor(CLAMP(MIN(a.y, MIN(b.y, c.y)), (float)band_begin, (float)band_end));
+		int max_y = (int)Math::ceil(CLAMP(MAX(a.y, MAX(b.y, c.y)), (float)band_begin, (float)band_end));
+		if (min_x >= max_x || min_y >= max_y) {
+			continue;
+		}
+
+		// Edge functions, positive inside the triangle and proportional to the weight of the opposite vertex.
+		float dx0 = b.y - c.y, dy0 = c.x - b.x;
+		float dx1 = c.y - a.y, dy1 = a.x - c.x;
+		float dx2 = a.y - b.y, dy2 = b.x - a.x;
+
+		float inv_area = 1.0 / area;
+		float za = a.z * inv_area;
+		float zb = b.z * inv_area;
+		float zc = c.z * inv_area;
+
+		uint32_t owner = triangle_owner[i / 3];
+
+		float px = min_x + 0.5;
+		for (int y = min_y; y < max_y; y++) {
+
+			float py = y + 0.5;
+			float e0 = dy0 * (py - b.y) + dx0 * (px - b.x);
+			float e1 = dy1 * (py - c.y) + dx1 * (px - c.x);
+			float e2 = dy2 * (py - a.y) + dx2 * (px - a.x);
+
+			// Branchless, so compilers can vectorize it.
+			float *row = buffer + y * width;
+			uint32_t *row_owner = owners + y * width;
+			for (int x = min_x; x < max_x; x++) {
+
+				float z = e0 * za + e1 * zb + e2 * zc;
+				bool covered = (e0 >= 0) & (e1 >= 0) & (e2 >= 0) & (z < row[x]);
+				row[x] = covered ? z : row[x];
+				row_owner[x] = covered ? owner : row_owner[x];
+
+				e0 += dx0;
+				e1 += dx1;
+				e2 += dx2;
+			}
+		}
+	}
+
+	for (int ty = band_begin / TILE_SIZE; ty < band_end / TILE_SIZE; ty++) {
+		for (int tx = 0; tx < tiles_x; tx++) {
+
+			float tile_max = -EMPTY_DEPTH;
+			for (int y = ty * TILE_SIZE; y < (ty + 1) * TILE_SIZE; y++) {
+
+				const float *row = buffer + y * width + tx * TILE_SIZE;
+				for (int x = 0; x < TILE_SIZE; x++) {
+					tile_max = MAX(tile_max, row[x]);
+				}
+			}
+			tile_max_depth[ty * tiles_x + tx] = tile_max;
+		}
+	}
+}
+
+void OcclusionBuffer::rasterize(ThreadWorkPool &p_work_pool) {
+
+	if (is_empty()) {
+		return;
+	}
+
+	// A couple of bands per thread, as occluders rarely spread evenly on screen.
+	int bands = MIN(p_work_pool.get_thread_count() * 2, tiles_y);
+	band_height = ((tiles_y + bands - 1) / bands) * TILE_SIZE;
+	band_count = (height + band_height - 1) / band_height;
+
+	p_work_pool.do_work(band_count, this, &OcclusionBuffer::_rasterize_band, (void *)NULL);
+}
+
+bool OcclusionBuffer::is_occluded(const AABB &p_aabb, uint32_t p_owner) const {
+
+	if (is_empty()) {
+		return false;
+	}
+
+	const CameraMatrix &m = view_projection;
+
+	float min_x = 1e20, min_y = 1e20, min_z = 1e20;
+	float max_x = -1e20, max_y = -1e20;
+
+	for (int i = 0; i < 8; i++) {
+
+		Vector3 v = p_aabb.get_endpoint(i);
+		real_t x = m.matrix[0][0] * v.x + m.matrix[1][0] * v.y + m.matrix[2][0] * v.z + m.matrix[3][0];
+		real_t y = m.matrix[0][1] * v.x + m.matrix[1][1] * v.y + m.matrix[2][1] * v.z + m.matrix[3][1];
+		real_t z = m.matrix[0][2] * v.x + m.matrix[1][2] * v.y + m.matrix[2][2] * v.z + m.matrix[3][2];
+		real_t w = m.matrix[0][3] * v.x + m.matrix[1][3] * v.y + m.matrix[2][3] * v.z + m.matrix[3][3];
+
+		if (w <= CMP_EPSILON || z < -w) {
+			// Reaches the camera, nothing can be in front of it.
+			return false;
+		}
+
+		real_t inv_w = 1.0 / w;
+		float sx = (x * inv_w * 0.5 + 0.5) * width;
+		float sy = (0.5 - y * inv_w * 0.5) * height;
+		min_x = MIN(min_x, sx);
+		max_x = MAX(max_x, sx);
+		min_y = MIN(min_y, sy);
+		max_y = MAX(max_y, sy);
+		min_z = MIN(min_z, float(z * inv_w));
+	}
+
+	// All the pixels the box touches, even partly, must have an occluder in front of its closest point.
+	int x0 = (int)Math::floor(CLAMP(min_x, 0.0f, (float)width));
+	int x1 = (int)Math::ceil(CLAMP(max_x, 0.0f, (float)width));
+	int y0 = (int)Math::floor(CLAMP(min_y, 0.0f, (float)height));
+	int y1 = (int)Math::ceil(CLAMP(max_y, 0.0f, (float)height));
+	if (x0 >= x1 || y0 >= y1) {
+		return false;
+	}
+
+	min_z -= DEPTH_BIAS;
+
+	// Where the instance's own occluder may be nearest, pixels have to be checked one by one.
+	int self_x0 = 0, self_y0 = 0, self_x1 = 0, self_y1 = 0;
+	if (p_owner) {
+		for (uint32_t i = 0; i < occluder_rects.size(); i++) {
+			const OccluderRect &rect = occluder_rects[i];
+			if (rect.owner == p_owner) {
+				self_x0 = rect.x0;
+				self_y0 = rect.y0;
+				self_x1 = rect.x1;
+				self_y1 = rect.y1;
+				break;
+			}
+		}
+	}
+
+	for (int ty = y0 / TILE_SIZE; ty <= (y1 - 1) / TILE_SIZE; ty++) {
+		for (int tx = x0 / TILE_SIZE; tx <= (x1 - 1) / TILE_SIZE; tx++) {
+
+			bool self_in_tile = tx * TILE_SIZE < self_x1 && (tx + 1) * TILE_SIZE > self_x0 && ty * TILE_SIZE < self_y1 && (ty + 1) * TILE_SIZE > self_y0;
+			if (!self_in_tile && tile_max_depth[ty * tiles_x + tx] < min_z) {
+				continue; // The whole tile hides it.
+			}
+
+			int px0 = MAX(x0, tx * TILE_SIZE);
+			int px1 = MIN(x1, (tx + 1) * TILE_SIZE);
+			int py0 = MAX(y0, ty * TILE_SIZE);
+			int py1 = MIN(y1, (ty + 1) * TILE_SIZE);
+			for (int y = py0; y < py1; y++) {
+				const float *row = depth.ptr() + y * width;
+				const uint32_t *row_owner = depth_owner.ptr() + y * width;
+				for (int x = px0; x < px1; x++) {
+					if (row[x] >= min_z || (p_owner && row_owner[x] == p_owner)) {
+						return false;
+					}
+				}
+			}
+		}
+	}
+
+	return true;
+}
+
+OcclusionBuffer::OcclusionBuffer() {
+
+	width = 0;
+	height = 0;
+	tiles_x = 0;
+	tiles_y = 0;
+	band_count = 0;
+	band_height = TILE_SIZE;
+}
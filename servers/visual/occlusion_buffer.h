@@ -0,0 +1,100 @@
+/*************************************************************************/
+/*  occlusion_buffer.h                                                   */
+/*************************************************************************/
+/*                       This file is part of:                           */
+/*                           GODOT ENGINE                                */
+/*                      https://godotengine.org                          */
+/*************************************************************************/
+/* Copyright (c) 2007-2021 Juan Linietsky, Ariel Manzur.                 */
+/* Copyright (c) 2014-2021 Godot Engine contributors (cf. AUTHORS.md).   */
+/*                                                                       */
+/* Permission is hereby granted, free of charge, to any person obtaining */
+/* a copy of this software and associated documentation files (the       */
+/* "Software"), to deal in the Software without restriction, including   */
+/* without limitation the rights to use, copy, modify, merge, publish,   */
+/* distribute, sublicense, and/or sell copies of the Software, and to    */
+/* permit persons to whom the Software is furnished to do so, subject to */
+/* the following conditions:                                             */
+/*                                                                       */
+/* The above copyright notice and this permission notice shall be        */
+/* included in all copies or substantial portions of the Software.       */
+/*                                                                       */
+/* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,       */
+/* EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF    */
+/* MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.*/
+/* IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY  */
+/* CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,  */
+/* TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE     */
+/* SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.                */
+/*************************************************************************/
+
+#ifndef OCCLUSION_BUFFER_H
+#define OCCLUSION_BUFFER_H
+
+#include "core/local_vector.h"
+#include "core/math/aabb.h"
+#include "core/math/camera_matrix.h"
+#include "core/os/thread_work_pool.h"
+#include "core/pool_vector.h"
+
+// Low resolution depth buffer of the occluders in view, to skip the instances they hide.
+// Occluders are rasterized on the CPU in horizontal bands, one job per band, and the farthest
+// depth of each tile is kept to reject most instances without looking at single pixels.
+// Depths are normalized device z, which interpolates linearly on screen for both projections.
+class OcclusionBuffer {
+
+public:
+	enum {
+		TILE_SIZE = 8, // In pixels, each side.
+		MIN_SIZE = 16,
+	};
+
+private:
+	int width;
+	int height;
+	int tiles_x;
+	int tiles_y;
+	int band_count;
+	int band_height; // In pixels, a multiple of TILE_SIZE.
+
+	CameraMatrix view_projection;
+	Vector<Plane> planes;
+
+	LocalVector<float> depth;
+	LocalVector<uint32_t> depth_owner; // Id of the occluder nearest in each pixel.
+	LocalVector<float> tile_max_depth;
+
+	// Three per triangle, x and y in pixels and z in normalized device coordinates.
+	LocalVector<Vector3> screen_vertices;
+	LocalVector<uint32_t> triangle_owner;
+
+	// Pixels each occluder may cover, for the instances that are occluders themselves.
+	struct OccluderRect {
+		uint32_t owner;
+		int x0, y0, x1, y1;
+	};
+	LocalVector<OccluderRect> occluder_rects;
+
+	void _rasterize_band(uint32_t p_band, void *p_userdata);
+
+public:
+	// Dimensions are rounded up to whole tiles.
+	void set_size(int p_width, int p_height);
+	int get_width() const { return width; }
+	int get_height() const { return height; }
+
+	void begin(const CameraMatrix &p_projection, const Transform &p_cam_transform);
+	// Triangle list in local space. Occluders out of view are skipped, and so are triangles that cross the near plane.
+	// p_owner is a nonzero id of the instance the occluder belongs to.
+	void add_occluder(uint32_t p_owner, const Transform &p_transform, const AABB &p_aabb, const PoolVector<Vector3> &p_triangles);
+	void rasterize(ThreadWorkPool &p_work_pool);
+
+	_FORCE_INLINE_ bool is_empty() const { return screen_vertices.size() == 0; }
+	// Only reads the buffer, so instances can be tested from several threads.
+	// The occluder added with p_owner, if any, never hides its own instance.
+	bool is_occluded(const AABB &p_aabb, uint32_t p_owner = 0) const;
+
+	OcclusionBuffer();
+};
+
+#endif // OCCLUSION_BUFFER_H
@@ -426,6 +426,27 @@ void VisualServerCanvas::canvas_item_set_transform(RID p_item, const Transform2D
 
 	canvas_item->xform = p_transform;
 }
+
+void VisualServerCanvas::canvas_items_set_transforms(const Vector<RID> &p_items, const PoolVector<float> &p_transforms) {
+
+	int count = p_items.size();
+	ERR_FAIL_COND(p_transforms.size() != count * 8);
+
+	const RID *items = p_items.ptr();
+	PoolVector<float>::Read r = p_transforms.read();
+
+	for (int i = 0; i < count; i++) {
+
+		Item *canvas_item = canvas_item_owner.getornull(items[i]);
+		ERR_CONTINUE(!canvas_item);
+
+		// same layout as the 2D multimesh_set_as_bulk_array(): two padded rows of x axis, y axis and origin
+		const float *f = &r[i * 8];
+		canvas_item->xform.elements[0] = Vector2(f[0], f[4]);
+		canvas_item->xform.elements[1] = Vector2(f[1], f[5]);
+		canvas_item->xform.elements[2] = Vector2(f[3], f[7]);
+	}
+}
 void VisualServerCanvas::canvas_item_set_clip(RID p_item, bool p_clip) {
 
 	Item *canvas_item = canvas_item_owner.getornull(p_item);
@@ -183,6 +183,7 @@ public:
 	void canvas_item_set_light_mask(RID p_item, int p_mask);
 
 	void canvas_item_set_transform(RID p_item, const Transform2D &p_transform);
+	void canvas_items_set_transforms(const Vector<RID> &p_items, const PoolVector<float> &p_transforms);
 	void canvas_item_set_clip(RID p_item, bool p_clip);
 	void canvas_item_set_distance_field_mode(RID p_item, bool p_enable);
 	void canvas_item_set_custom_rect(RID p_item, bool p_custom_rect, const Rect2 &p_rect = Rect2());
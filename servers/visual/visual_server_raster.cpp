@@ -103,6 +103,7 @@ void VisualServerRaster::draw(bool p_swap_buffers, double frame_step) {
 
 	VSG::rasterizer->begin_frame(frame_step);
 
+	VSG::scene->begin_frame();
 	VSG::scene->update_dirty_instances(); //update scene stuff
 
 	VSG::viewport->draw_viewports();
@@ -150,6 +151,10 @@ void VisualServerRaster::finish() {
 
 uint64_t VisualServerRaster::get_render_info(RenderInfo p_info) {
 
+	if (p_info == INFO_OCCLUDED_OBJECTS_IN_FRAME) {
+		return VSG::scene->get_occluded_objects_in_frame();
+	}
+
 	return VSG::storage->get_render_info(p_info);
 }
 
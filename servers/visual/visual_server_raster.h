@@ -547,6 +547,7 @@ public:
 	BIND2(instance_set_scenario, RID, RID)
 	BIND2(instance_set_layer_mask, RID, uint32_t)
 	BIND2(instance_set_transform, RID, const Transform &)
+	BIND2(instances_set_transforms, const Vector<RID> &, const PoolVector<float> &)
 	BIND2(instance_attach_object_instance_id, RID, ObjectID)
 	BIND3(instance_set_blend_shape_weight, RID, int, float)
 	BIND3(instance_set_surface_material, RID, int, RID)
@@ -560,6 +561,8 @@ public:
 
 	BIND2(instance_set_extra_visibility_margin, RID, real_t)
 
+	BIND2(instance_set_occluder, RID, const PoolVector<Vector3> &)
+
 	// don't use these in a game!
 	BIND2RC(Vector<ObjectID>, instances_cull_aabb, const AABB &, RID)
 	BIND3RC(Vector<ObjectID>, instances_cull_ray, const Vector3 &, const Vector3 &, RID)
@@ -593,6 +596,7 @@ public:
 	BIND2(canvas_item_set_update_when_visible, RID, bool)
 
 	BIND2(canvas_item_set_transform, RID, const Transform2D &)
+	BIND2(canvas_items_set_transforms, const Vector<RID> &, const PoolVector<float> &)
 	BIND2(canvas_item_set_clip, RID, bool)
 	BIND2(canvas_item_set_distance_field_mode, RID, bool)
 	BIND3(canvas_item_set_custom_rect, RID, bool, const Rect2 &)
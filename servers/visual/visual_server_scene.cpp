@@ -118,7 +118,8 @@ void VisualServerScene::SpatialPartitioningScene_BVH::erase(SpatialPartitionID p
 }
 
 void VisualServerScene::SpatialPartitioningScene_BVH::move(SpatialPartitionID p_handle, const AABB &p_aabb) {
-	_bvh.move(p_handle - 1, p_aabb);
+	// refit later in update(), _update_instance() queues the scenario for it
+	_bvh.move(p_handle - 1, p_aabb, true);
 }
 
 void VisualServerScene::SpatialPartitioningScene_BVH::activate(SpatialPartitionID p_handle, const AABB &p_aabb) {
@@ -148,8 +149,8 @@ void VisualServerScene::SpatialPartitioningScene_BVH::set_pairable(SpatialPartit
 	_bvh.set_pairable(p_handle - 1, p_pairable, p_pairable_type, p_pairable_mask);
 }
 
-int VisualServerScene::SpatialPartitioningScene_BVH::cull_convex(const Vector<Plane> &p_convex, Instance **p_result_array, int p_result_max, uint32_t p_mask) {
-	return _bvh.cull_convex(p_convex, p_result_array, p_result_max, p_mask);
+int VisualServerScene::SpatialPartitioningScene_BVH::cull_convex(const Vector<Plane> &p_convex, Instance **p_result_array, int p_result_max, uint32_t p_mask, LocalVector<uint32_t, uint32_t, true> *p_hits) {
+	return _bvh.cull_convex(p_convex, p_result_array, p_result_max, p_mask, p_hits);
 }
 
 int VisualServerScene::SpatialPartitioningScene_BVH::cull_aabb(const AABB &p_aabb, Instance **p_result_array, int p_result_max, int *p_subindex_array, uint32_t p_mask) {
@@ -186,7 +187,7 @@ void VisualServerScene::SpatialPartitioningScene_Octree::set_pairable(SpatialPar
 	_octree.set_pairable(p_handle, p_pairable, p_pairable_type, p_pairable_mask);
 }
 
-int VisualServerScene::SpatialPartitioningScene_Octree::cull_convex(const Vector<Plane> &p_convex, Instance **p_result_array, int p_result_max, uint32_t p_mask) {
+int VisualServerScene::SpatialPartitioningScene_Octree::cull_convex(const Vector<Plane> &p_convex, Instance **p_result_array, int p_result_max, uint32_t p_mask, LocalVector<uint32_t, uint32_t, true> *p_hits) {
 	return _octree.cull_convex(p_convex, p_result_array, p_result_max, p_mask);
 }
 
@@ -212,7 +213,8 @@ void VisualServerScene::SpatialPartitioningScene_Octree::set_balance(float p_bal
 
 /* SCENARIO API */
 
-VisualServerScene::Scenario::Scenario() {
+VisualServerScene::Scenario::Scenario() :
+		update_item(this) {
 	debug = VS::SCENARIO_DEBUG_DISABLED;
 
 	bool use_bvh_or_octree = GLOBAL_GET("rendering/quality/spatial_partitioning/use_bvh");
@@ -631,6 +633,9 @@ void VisualServerScene::instance_set_scenario(RID p_instance, RID p_scenario) {
 	if (instance->scenario) {
 
 		instance->scenario->instances.remove(&instance->scenario_item);
+		if (instance->occluder_item.in_list()) {
+			instance->scenario->occluders.remove(&instance->occluder_item);
+		}
 
 		if (instance->spatial_partition_id) {
 			instance->scenario->sps->erase(instance->spatial_partition_id);
@@ -675,6 +680,9 @@ void VisualServerScene::instance_set_scenario(RID p_instance, RID p_scenario) {
 		instance->scenario = scenario;
 
 		scenario->instances.add(&instance->scenario_item);
+		if (instance->occluder_triangles.size() >= 3) {
+			scenario->occluders.add(&instance->occluder_item);
+		}
 
 		switch (instance->base_type) {
 
@@ -707,12 +715,9 @@ void VisualServerScene::instance_set_layer_mask(RID p_instance, uint32_t p_mask)
 
 	instance->layer_mask = p_mask;
 }
-void VisualServerScene::instance_set_transform(RID p_instance, const Transform &p_transform) {
-
-	Instance *instance = instance_owner.get(p_instance);
-	ERR_FAIL_COND(!instance);
+void VisualServerScene::_instance_set_transform(Instance *p_instance, const Transform &p_transform) {
 
-	if (instance->transform == p_transform)
+	if (p_instance->transform == p_transform)
 		return; //must be checked to avoid worst evil
 
 #ifdef DEBUG_ENABLED
@@ -728,8 +733,43 @@ void VisualServerScene::instance_set_transform(RID p_instance, const Transform &
 	}
 
 #endif
-	instance->transform = p_transform;
-	_instance_queue_update(instance, true);
+	p_instance->transform = p_transform;
+	_instance_queue_update(p_instance, true);
+}
+
+void VisualServerScene::instance_set_transform(RID p_instance, const Transform &p_transform) {
+
+	Instance *instance = instance_owner.get(p_instance);
+	ERR_FAIL_COND(!instance);
+
+	_instance_set_transform(instance, p_transform);
+}
+
+void VisualServerScene::instances_set_transforms(const Vector<RID> &p_instances, const PoolVector<float> &p_transforms) {
+
+	int count = p_instances.size();
+	ERR_FAIL_COND(p_transforms.size() != count * 12);
+
+	const RID *instances = p_instances.ptr();
+	PoolVector<float>::Read r = p_transforms.read();
+
+	for (int i = 0; i < count; i++) {
+
+		Instance *instance = instance_owner.getornull(instances[i]);
+		ERR_CONTINUE(!instance);
+
+		// same layout as multimesh_set_as_bulk_array(): three basis rows, each followed by one origin component
+		const float *f = &r[i * 12];
+		Transform xform;
+		xform.basis.elements[0] = Vector3(f[0], f[1], f[2]);
+		xform.origin.x = f[3];
+		xform.basis.elements[1] = Vector3(f[4], f[5], f[6]);
+		xform.origin.y = f[7];
+		xform.basis.elements[2] = Vector3(f[8], f[9], f[10]);
+		xform.origin.z = f[11];
+
+		_instance_set_transform(instance, xform);
+	}
 }
 void VisualServerScene::instance_attach_object_instance_id(RID p_instance, ObjectID p_id) {
 
@@ -801,16 +841,7 @@ void VisualServerScene::instance_set_visible(RID p_instance, bool p_visible) {
 	}
 
 	// when showing or hiding geometry, lights must be kept up to date to show / hide shadows
-	if ((1 << instance->base_type) & VS::INSTANCE_GEOMETRY_MASK) {
-		InstanceGeometryData *geom = static_cast<InstanceGeometryData *>(instance->base_data);
-
-		if (geom->can_cast_shadows) {
-			for (List<Instance *>::Element *E = geom->lighting.front(); E; E = E->next()) {
-				InstanceLightData *light = static_cast<InstanceLightData *>(E->get()->base_data);
-				light->shadow_dirty = true;
-			}
-		}
-	}
+	_instance_mark_lights_shadow_dirty(instance);
 
 	switch (instance->base_type) {
 		case VS::INSTANCE_LIGHT: {
@@ -939,6 +970,33 @@ void VisualServerScene::instance_set_extra_visibility_margin(RID p_instance, rea
 	_instance_queue_update(instance, true, false);
 }
 
+void VisualServerScene::instance_set_occluder(RID p_instance, const PoolVector<Vector3> &p_triangles) {
+
+	Instance *instance = instance_owner.get(p_instance);
+	ERR_FAIL_COND(!instance);
+
+	instance->occluder_triangles = p_triangles;
+	instance->occluder_aabb = AABB();
+
+	PoolVector<Vector3>::Read r = p_triangles.read();
+	for (int i = 0; i < p_triangles.size(); i++) {
+		if (i == 0) {
+			instance->occluder_aabb.position = r[i];
+		} else {
+			instance->occluder_aabb.expand_to(r[i]);
+		}
+	}
+
+	bool occluder = p_triangles.size() >= 3;
+	if (instance->scenario && occluder != instance->occluder_item.in_list()) {
+		if (occluder) {
+			instance->scenario->occluders.add(&instance->occluder_item);
+		} else {
+			instance->scenario->occluders.remove(&instance->occluder_item);
+		}
+	}
+}
+
 Vector<ObjectID> VisualServerScene::instances_cull_aabb(const AABB &p_aabb, RID p_scenario) const {
 
 	Vector<ObjectID> instances;
@@ -1056,8 +1114,148 @@ void VisualServerScene::instance_geometry_set_material_override(RID p_instance,
 }
 
 void VisualServerScene::instance_geometry_set_draw_range(RID p_instance, float p_min, float p_max, float p_min_margin, float p_max_margin) {
+
+	Instance *instance = instance_owner.get(p_instance);
+	ERR_FAIL_COND(!instance);
+
+	instance->lod_begin = p_min;
+	instance->lod_end = p_max;
+	instance->lod_begin_hysteresis = p_min_margin;
+	instance->lod_end_hysteresis = p_max_margin;
+	_instance_update_draw_range_enabled(instance);
+	_instance_mark_lights_shadow_dirty(instance);
 }
 void VisualServerScene::instance_geometry_set_as_instance_lod(RID p_instance, RID p_as_lod_of_instance) {
+
+	Instance *instance = instance_owner.get(p_instance);
+	ERR_FAIL_COND(!instance);
+
+	if (instance->lod_owner) {
+		_instance_leave_lod_group(instance);
+	}
+
+	if (p_as_lod_of_instance.is_valid()) {
+		Instance *owner = instance_owner.get(p_as_lod_of_instance);
+		ERR_FAIL_COND(!owner);
+
+		// Groups are flat, a LOD of a LOD joins the same group.
+		if (owner->lod_owner) {
+			owner = owner->lod_owner;
+		}
+		ERR_FAIL_COND_MSG(owner == instance, "An instance can't be a LOD of itself.");
+		ERR_FAIL_COND_MSG(!instance->lod_members.empty(), "An instance that has LODs can't be a LOD of another instance.");
+
+		instance->lod_owner = owner;
+		owner->lod_members.push_back(instance);
+		_instance_update_draw_range_enabled(owner);
+	}
+
+	_instance_update_draw_range_enabled(instance);
+	_instance_mark_lights_shadow_dirty(instance);
+}
+
+void VisualServerScene::_instance_mark_lights_shadow_dirty(Instance *p_instance) {
+
+	if (!((1 << p_instance->base_type) & VS::INSTANCE_GEOMETRY_MASK)) {
+		return;
+	}
+
+	InstanceGeometryData *geom = static_cast<InstanceGeometryData *>(p_instance->base_data);
+
+	if (geom->can_cast_shadows) {
+		for (List<Instance *>::Element *E = geom->lighting.front(); E; E = E->next()) {
+			InstanceLightData *light = static_cast<InstanceLightData *>(E->get()->base_data);
+			light->shadow_dirty = true;
+		}
+	}
+}
+
+void VisualServerScene::_instance_update_draw_range_enabled(Instance *p_instance) {
+
+	p_instance->draw_range_enabled = p_instance->lod_owner || !p_instance->lod_members.empty() || p_instance->lod_begin > 0 || p_instance->lod_end > 0;
+	p_instance->lod_visible = false;
+	p_instance->lod_selected = NULL;
+	p_instance->lod_selected_pass = 0;
+}
+
+void VisualServerScene::_instance_leave_lod_group(Instance *p_instance) {
+
+	Instance *owner = p_instance->lod_owner;
+	owner->lod_members.erase(p_instance);
+	p_instance->lod_owner = NULL;
+	_instance_update_draw_range_enabled(owner);
+	_instance_mark_lights_shadow_dirty(owner);
+}
+
+static _FORCE_INLINE_ float _draw_range_distance(const VisualServerScene::Instance *p_instance, const Vector3 &p_cam_pos) {
+
+	return p_cam_pos.distance_to(p_instance->transformed_aabb.position + p_instance->transformed_aabb.size * 0.5);
+}
+
+static _FORCE_INLINE_ bool _is_in_draw_range(const VisualServerScene::Instance *p_instance, float p_distance, bool p_was_visible) {
+
+	// Once drawn, an instance stays until it's past the margins, so it doesn't pop in and out at the limits.
+	float begin = p_instance->lod_begin;
+	float end = p_instance->lod_end;
+	if (p_was_visible) {
+		begin -= p_instance->lod_begin_hysteresis;
+		end += p_instance->lod_end_hysteresis;
+	}
+
+	return p_distance >= begin && (p_instance->lod_end <= 0 || p_distance < end);
+}
+
+bool VisualServerScene::_instance_check_draw_range(Instance *p_instance, const Vector3 &p_cam_pos, bool p_update) {
+
+	Instance *owner = p_instance->lod_owner ? p_instance->lod_owner : p_instance;
+
+	if (owner->lod_members.empty()) {
+
+		bool visible = _is_in_draw_range(p_instance, _draw_range_distance(p_instance, p_cam_pos), p_instance->lod_visible);
+		if (p_update && visible != p_instance->lod_visible) {
+			p_instance->lod_visible = visible;
+			_instance_mark_lights_shadow_dirty(p_instance);
+		}
+		return visible;
+	}
+
+	// The group picks its member once per pass, from the distance to the owner so all members agree.
+	if (p_update && owner->lod_selected_pass == render_pass) {
+		return owner->lod_selected == p_instance;
+	}
+
+	float distance = _draw_range_distance(owner, p_cam_pos);
+	Instance *selected = NULL;
+
+	if (owner->lod_selected && owner->lod_selected->visible && _is_in_draw_range(owner->lod_selected, distance, true)) {
+		// The member drawn last keeps priority within its margins, so members don't swap back and forth.
+		selected = owner->lod_selected;
+	} else if (owner->visible && _is_in_draw_range(owner, distance, false)) {
+		selected = owner;
+	} else {
+		for (int i = 0; i < owner->lod_members.size(); i++) {
+			Instance *member = owner->lod_members[i];
+			if (member->visible && _is_in_draw_range(member, distance, false)) {
+				selected = member;
+				break;
+			}
+		}
+	}
+
+	if (p_update) {
+		if (selected != owner->lod_selected) {
+			if (owner->lod_selected) {
+				_instance_mark_lights_shadow_dirty(owner->lod_selected);
+			}
+			if (selected) {
+				_instance_mark_lights_shadow_dirty(selected);
+			}
+			owner->lod_selected = selected;
+		}
+		owner->lod_selected_pass = render_pass;
+	}
+
+	return selected == p_instance;
 }
 
 void VisualServerScene::_update_instance(Instance *p_instance) {
@@ -1161,6 +1359,9 @@ void VisualServerScene::_update_instance(Instance *p_instance) {
 
 		p_instance->scenario->sps->move(p_instance->spatial_partition_id, new_aabb);
 	}
+
+	// even when the instance was updated outside update_dirty_instances()
+	_scenario_queue_update(p_instance->scenario);
 }
 
 void VisualServerScene::_update_instance_aabb(Instance *p_instance) {
@@ -1479,7 +1680,78 @@ void VisualServerScene::_update_instance_lightmap_captures(Instance *p_instance)
 	p_instance->lightmap_capture_data.write[0].a = interior ? 0.0f : 1.0f;
 }
 
-bool VisualServerScene::_light_instance_update_shadow(Instance *p_instance, const Transform p_cam_transform, const CameraMatrix &p_cam_projection, bool p_cam_orthogonal, RID p_shadow_atlas, Scenario *p_scenario) {
+void VisualServerScene::_shadow_cull_job(uint32_t p_job, ShadowCullParams *p_params) {
+
+	ShadowCullJob &job = shadow_cull_jobs[p_job];
+	job.cull_count = 0;
+	job.animated_material_found = false;
+
+	if (job.planes.empty()) {
+		return;
+	}
+
+	Instance **result = job.result.ptr();
+	int cull_count = p_params->scenario->sps->cull_convex(job.planes, result, MAX_INSTANCE_CULL, VS::INSTANCE_GEOMETRY_MASK, &job.hits);
+
+	for (int j = 0; j < cull_count; j++) {
+
+		Instance *instance = result[j];
+		if (!instance->visible || !((1 << instance->base_type) & VS::INSTANCE_GEOMETRY_MASK) || !static_cast<InstanceGeometryData *>(instance->base_data)->can_cast_shadows || !_instance_in_draw_range(instance, p_params->cam_pos, p_params->update_draw_ranges)) {
+			cull_count--;
+			SWAP(result[j], result[cull_count]);
+			j--;
+			continue;
+		}
+
+		if (static_cast<InstanceGeometryData *>(instance->base_data)->material_is_animated) {
+			job.animated_material_found = true;
+		}
+
+		if (job.directional) {
+			float min, max;
+			instance->transformed_aabb.project_range_in_plane(Plane(job.z_vec, 0), min, max);
+			if (max > job.z_max)
+				job.z_max = max;
+		}
+	}
+
+	job.cull_count = cull_count;
+}
+
+bool VisualServerScene::_cull_shadow_jobs(int p_count, Scenario *p_scenario, const Vector3 &p_cam_pos, bool p_update_draw_ranges) {
+
+	// Culling in parallel needs a partitioning that can be read from several threads.
+	bool parallel = p_count > 1 && cull_work_pool.get_thread_count() > 1 && p_scenario->sps->can_cull_in_parallel();
+
+	ShadowCullParams params;
+	params.scenario = p_scenario;
+	params.cam_pos = p_cam_pos;
+	// Jobs running at the same time can't write to the instances, so the LODs they see are the ones the camera picked.
+	params.update_draw_ranges = p_update_draw_ranges && !parallel;
+
+	for (int i = 0; i < p_count; i++) {
+		if (shadow_cull_jobs[i].result.size() < MAX_INSTANCE_CULL) {
+			shadow_cull_jobs[i].result.resize(MAX_INSTANCE_CULL);
+		}
+	}
+
+	if (parallel) {
+		cull_work_pool.do_work(p_count, this, &VisualServerScene::_shadow_cull_job, &params);
+	} else {
+		for (int i = 0; i < p_count; i++) {
+			_shadow_cull_job(i, &params);
+		}
+	}
+
+	bool animated_material_found = false;
+	for (int i = 0; i < p_count; i++) {
+		animated_material_found = animated_material_found || shadow_cull_jobs[i].animated_material_found;
+	}
+
+	return animated_material_found;
+}
+
+bool VisualServerScene::_light_instance_update_shadow(Instance *p_instance, const Transform p_cam_transform, const CameraMatrix &p_cam_projection, bool p_cam_orthogonal, RID p_shadow_atlas, Scenario *p_scenario, bool p_update_draw_ranges) {
 
 	InstanceLightData *light = static_cast<InstanceLightData *>(p_instance->base_data);
 
@@ -1516,7 +1788,7 @@ bool VisualServerScene::_light_instance_update_shadow(Instance *p_instance, cons
 				for (int i = 0; i < cull_count; i++) {
 
 					Instance *instance = instance_shadow_cull_result[i];
-					if (!instance->visible || !((1 << instance->base_type) & VS::INSTANCE_GEOMETRY_MASK) || !static_cast<InstanceGeometryData *>(instance->base_data)->can_cast_shadows) {
+					if (!instance->visible || !((1 << instance->base_type) & VS::INSTANCE_GEOMETRY_MASK) || !static_cast<InstanceGeometryData *>(instance->base_data)->can_cast_shadows || !_instance_in_draw_range(instance, p_cam_transform.origin, p_update_draw_ranges)) {
 						continue;
 					}
 
@@ -1568,8 +1840,32 @@ bool VisualServerScene::_light_instance_update_shadow(Instance *p_instance, cons
 
 			float first_radius = 0.0;
 
+			Transform transform = light_transform; //discard scale and stabilize light
+
+			Vector3 x_vec = transform.basis.get_axis(Vector3::AXIS_X).normalized();
+			Vector3 y_vec = transform.basis.get_axis(Vector3::AXIS_Y).normalized();
+			Vector3 z_vec = transform.basis.get_axis(Vector3::AXIS_Z).normalized();
+			//z_vec points agsint the camera, like in default opengl
+
+			// FIXME: z_max_cam is defined, computed, but not used below when setting up
+			// ortho_camera. Commented out for now to fix warnings but should be investigated.
+			struct SplitCamera {
+				float x_min_cam, x_max_cam;
+				float y_min_cam, y_max_cam;
+				float z_min_cam;
+				//float z_max_cam;
+				float bias_scale;
+				bool valid;
+			};
+
+			SplitCamera split_cameras[4];
+
 			for (int i = 0; i < splits; i++) {
 
+				SplitCamera &split = split_cameras[i];
+				split.valid = false;
+				shadow_cull_jobs[i].planes.clear();
+
 				// setup a camera matrix for that range!
 				CameraMatrix camera_matrix;
 
@@ -1594,25 +1890,11 @@ bool VisualServerScene::_light_instance_update_shadow(Instance *p_instance, cons
 
 				// obtain the light frustm ranges (given endpoints)
 
-				Transform transform = light_transform; //discard scale and stabilize light
-
-				Vector3 x_vec = transform.basis.get_axis(Vector3::AXIS_X).normalized();
-				Vector3 y_vec = transform.basis.get_axis(Vector3::AXIS_Y).normalized();
-				Vector3 z_vec = transform.basis.get_axis(Vector3::AXIS_Z).normalized();
-				//z_vec points agsint the camera, like in default opengl
-
 				float x_min = 0.f, x_max = 0.f;
 				float y_min = 0.f, y_max = 0.f;
 				float z_min = 0.f, z_max = 0.f;
 
-				// FIXME: z_max_cam is defined, computed, but not used below when setting up
-				// ortho_camera. Commented out for now to fix warnings but should be investigated.
-				float x_min_cam = 0.f, x_max_cam = 0.f;
-				float y_min_cam = 0.f, y_max_cam = 0.f;
-				float z_min_cam = 0.f;
-				//float z_max_cam = 0.f;
-
-				float bias_scale = 1.0;
+				split.bias_scale = 1.0;
 
 				//used for culling
 
@@ -1665,15 +1947,15 @@ bool VisualServerScene::_light_instance_update_shadow(Instance *p_instance, cons
 					if (i == 0) {
 						first_radius = radius;
 					} else {
-						bias_scale = radius / first_radius;
+						split.bias_scale = radius / first_radius;
 					}
 
-					x_max_cam = x_vec.dot(center) + radius;
-					x_min_cam = x_vec.dot(center) - radius;
-					y_max_cam = y_vec.dot(center) + radius;
-					y_min_cam = y_vec.dot(center) - radius;
-					//z_max_cam = z_vec.dot(center) + radius;
-					z_min_cam = z_vec.dot(center) - radius;
+					split.x_max_cam = x_vec.dot(center) + radius;
+					split.x_min_cam = x_vec.dot(center) - radius;
+					split.y_max_cam = y_vec.dot(center) + radius;
+					split.y_min_cam = y_vec.dot(center) - radius;
+					//split.z_max_cam = z_vec.dot(center) + radius;
+					split.z_min_cam = z_vec.dot(center) - radius;
 
 					if (depth_range_mode == VS::LIGHT_DIRECTIONAL_SHADOW_DEPTH_RANGE_STABLE) {
 						//this trick here is what stabilizes the shadow (make potential jaggies to not move)
@@ -1681,68 +1963,65 @@ bool VisualServerScene::_light_instance_update_shadow(Instance *p_instance, cons
 
 						float unit = radius * 2.0 / texture_size;
 
-						x_max_cam = Math::stepify(x_max_cam, unit);
-						x_min_cam = Math::stepify(x_min_cam, unit);
-						y_max_cam = Math::stepify(y_max_cam, unit);
-						y_min_cam = Math::stepify(y_min_cam, unit);
+						split.x_max_cam = Math::stepify(split.x_max_cam, unit);
+						split.x_min_cam = Math::stepify(split.x_min_cam, unit);
+						split.y_max_cam = Math::stepify(split.y_max_cam, unit);
+						split.y_min_cam = Math::stepify(split.y_min_cam, unit);
 					}
 				}
 
 				//now that we now all ranges, we can proceed to make the light frustum planes, for culling octree
 
-				Vector<Plane> light_frustum_planes;
-				light_frustum_planes.resize(6);
+				ShadowCullJob &job = shadow_cull_jobs[i];
+				job.planes.resize(6);
 
 				//right/left
-				light_frustum_planes.write[0] = Plane(x_vec, x_max);
-				light_frustum_planes.write[1] = Plane(-x_vec, -x_min);
+				job.planes.write[0] = Plane(x_vec, x_max);
+				job.planes.write[1] = Plane(-x_vec, -x_min);
 				//top/bottom
-				light_frustum_planes.write[2] = Plane(y_vec, y_max);
-				light_frustum_planes.write[3] = Plane(-y_vec, -y_min);
+				job.planes.write[2] = Plane(y_vec, y_max);
+				job.planes.write[3] = Plane(-y_vec, -y_min);
 				//near/far
-				light_frustum_planes.write[4] = Plane(z_vec, z_max + 1e6);
-				light_frustum_planes.write[5] = Plane(-z_vec, -z_min); // z_min is ok, since casters further than far-light plane are not needed
-
-				int cull_count = p_scenario->sps->cull_convex(light_frustum_planes, instance_shadow_cull_result, MAX_INSTANCE_CULL, VS::INSTANCE_GEOMETRY_MASK);
-
-				// a pre pass will need to be needed to determine the actual z-near to be used
+				job.planes.write[4] = Plane(z_vec, z_max + 1e6);
+				job.planes.write[5] = Plane(-z_vec, -z_min); // z_min is ok, since casters further than far-light plane are not needed
+
+				// the casters found by the job push z_max further, so they all fit in the ortho camera
+				job.directional = true;
+				job.z_vec = z_vec;
+				job.z_max = z_max;
+				split.valid = true;
+			}
 
-				Plane near_plane(light_transform.origin, -light_transform.basis.get_axis(2));
+			_cull_shadow_jobs(splits, p_scenario, p_cam_transform.origin, p_update_draw_ranges);
 
-				for (int j = 0; j < cull_count; j++) {
+			Plane near_plane(light_transform.origin, -light_transform.basis.get_axis(2));
 
-					float min, max;
-					Instance *instance = instance_shadow_cull_result[j];
-					if (!instance->visible || !((1 << instance->base_type) & VS::INSTANCE_GEOMETRY_MASK) || !static_cast<InstanceGeometryData *>(instance->base_data)->can_cast_shadows) {
-						cull_count--;
-						SWAP(instance_shadow_cull_result[j], instance_shadow_cull_result[cull_count]);
-						j--;
-						continue;
-					}
+			for (int i = 0; i < splits; i++) {
 
-					instance->transformed_aabb.project_range_in_plane(Plane(z_vec, 0), min, max);
-					instance->depth = near_plane.distance_to(instance->transform.origin);
-					instance->depth_layer = 0;
-					if (max > z_max)
-						z_max = max;
+				const SplitCamera &split = split_cameras[i];
+				if (!split.valid) {
+					continue;
 				}
 
+				ShadowCullJob &job = shadow_cull_jobs[i];
+				job.update_depths(near_plane);
+
 				{
 
 					CameraMatrix ortho_camera;
-					real_t half_x = (x_max_cam - x_min_cam) * 0.5;
-					real_t half_y = (y_max_cam - y_min_cam) * 0.5;
+					real_t half_x = (split.x_max_cam - split.x_min_cam) * 0.5;
+					real_t half_y = (split.y_max_cam - split.y_min_cam) * 0.5;
 
-					ortho_camera.set_orthogonal(-half_x, half_x, -half_y, half_y, 0, (z_max - z_min_cam));
+					ortho_camera.set_orthogonal(-half_x, half_x, -half_y, half_y, 0, (job.z_max - split.z_min_cam));
 
 					Transform ortho_transform;
 					ortho_transform.basis = transform.basis;
-					ortho_transform.origin = x_vec * (x_min_cam + half_x) + y_vec * (y_min_cam + half_y) + z_vec * z_max;
+					ortho_transform.origin = x_vec * (split.x_min_cam + half_x) + y_vec * (split.y_min_cam + half_y) + z_vec * job.z_max;
 
-					VSG::scene_render->light_instance_set_shadow_transform(light->instance, ortho_camera, ortho_transform, 0, distances[i + 1], i, bias_scale);
+					VSG::scene_render->light_instance_set_shadow_transform(light->instance, ortho_camera, ortho_transform, 0, distances[i + 1], i, split.bias_scale);
 				}
 
-				VSG::scene_render->render_shadow(light->instance, p_shadow_atlas, i, (RasterizerScene::InstanceBase **)instance_shadow_cull_result, cull_count);
+				VSG::scene_render->render_shadow(light->instance, p_shadow_atlas, i, (RasterizerScene::InstanceBase **)job.result.ptr(), job.cull_count);
 			}
 
 		} break;
@@ -1752,44 +2031,34 @@ bool VisualServerScene::_light_instance_update_shadow(Instance *p_instance, cons
 
 			if (shadow_mode == VS::LIGHT_OMNI_SHADOW_DUAL_PARABOLOID || !VSG::scene_render->light_instances_can_render_shadow_cube()) {
 
-				for (int i = 0; i < 2; i++) {
+				//using this one ensures that raster deferred will have it
 
-					//using this one ensures that raster deferred will have it
+				float radius = VSG::storage->light_get_param(p_instance->base, VS::LIGHT_PARAM_RANGE);
 
-					float radius = VSG::storage->light_get_param(p_instance->base, VS::LIGHT_PARAM_RANGE);
+				for (int i = 0; i < 2; i++) {
 
 					float z = i == 0 ? -1 : 1;
-					Vector<Plane> planes;
-					planes.resize(6);
-					planes.write[0] = light_transform.xform(Plane(Vector3(0, 0, z), radius));
-					planes.write[1] = light_transform.xform(Plane(Vector3(1, 0, z).normalized(), radius));
-					planes.write[2] = light_transform.xform(Plane(Vector3(-1, 0, z).normalized(), radius));
-					planes.write[3] = light_transform.xform(Plane(Vector3(0, 1, z).normalized(), radius));
-					planes.write[4] = light_transform.xform(Plane(Vector3(0, -1, z).normalized(), radius));
-					planes.write[5] = light_transform.xform(Plane(Vector3(0, 0, -z), 0));
-
-					int cull_count = p_scenario->sps->cull_convex(planes, instance_shadow_cull_result, MAX_INSTANCE_CULL, VS::INSTANCE_GEOMETRY_MASK);
-					Plane near_plane(light_transform.origin, light_transform.basis.get_axis(2) * z);
-
-					for (int j = 0; j < cull_count; j++) {
-
-						Instance *instance = instance_shadow_cull_result[j];
-						if (!instance->visible || !((1 << instance->base_type) & VS::INSTANCE_GEOMETRY_MASK) || !static_cast<InstanceGeometryData *>(instance->base_data)->can_cast_shadows) {
-							cull_count--;
-							SWAP(instance_shadow_cull_result[j], instance_shadow_cull_result[cull_count]);
-							j--;
-						} else {
-							if (static_cast<InstanceGeometryData *>(instance->base_data)->material_is_animated) {
-								animated_material_found = true;
-							}
+					ShadowCullJob &job = shadow_cull_jobs[i];
+					job.planes.resize(6);
+					job.planes.write[0] = light_transform.xform(Plane(Vector3(0, 0, z), radius));
+					job.planes.write[1] = light_transform.xform(Plane(Vector3(1, 0, z).normalized(), radius));
+					job.planes.write[2] = light_transform.xform(Plane(Vector3(-1, 0, z).normalized(), radius));
+					job.planes.write[3] = light_transform.xform(Plane(Vector3(0, 1, z).normalized(), radius));
+					job.planes.write[4] = light_transform.xform(Plane(Vector3(0, -1, z).normalized(), radius));
+					job.planes.write[5] = light_transform.xform(Plane(Vector3(0, 0, -z), 0));
+					job.directional = false;
+				}
 
-							instance->depth = near_plane.distance_to(instance->transform.origin);
-							instance->depth_layer = 0;
-						}
-					}
+				animated_material_found = _cull_shadow_jobs(2, p_scenario, p_cam_transform.origin, p_update_draw_ranges);
+
+				for (int i = 0; i < 2; i++) {
+
+					float z = i == 0 ? -1 : 1;
+					ShadowCullJob &job = shadow_cull_jobs[i];
+					job.update_depths(Plane(light_transform.origin, light_transform.basis.get_axis(2) * z));
 
 					VSG::scene_render->light_instance_set_shadow_transform(light->instance, CameraMatrix(), light_transform, radius, 0, i);
-					VSG::scene_render->render_shadow(light->instance, p_shadow_atlas, i, (RasterizerScene::InstanceBase **)instance_shadow_cull_result, cull_count);
+					VSG::scene_render->render_shadow(light->instance, p_shadow_atlas, i, (RasterizerScene::InstanceBase **)job.result.ptr(), job.cull_count);
 				}
 			} else { //shadow cube
 
@@ -1797,52 +2066,45 @@ bool VisualServerScene::_light_instance_update_shadow(Instance *p_instance, cons
 				CameraMatrix cm;
 				cm.set_perspective(90, 1, 0.01, radius);
 
+				static const Vector3 view_normals[6] = {
+					Vector3(-1, 0, 0),
+					Vector3(+1, 0, 0),
+					Vector3(0, -1, 0),
+					Vector3(0, +1, 0),
+					Vector3(0, 0, -1),
+					Vector3(0, 0, +1)
+				};
+				static const Vector3 view_up[6] = {
+					Vector3(0, -1, 0),
+					Vector3(0, -1, 0),
+					Vector3(0, 0, -1),
+					Vector3(0, 0, +1),
+					Vector3(0, -1, 0),
+					Vector3(0, -1, 0)
+				};
+
+				Transform xforms[6];
+
 				for (int i = 0; i < 6; i++) {
 
 					//using this one ensures that raster deferred will have it
 
-					static const Vector3 view_normals[6] = {
-						Vector3(-1, 0, 0),
-						Vector3(+1, 0, 0),
-						Vector3(0, -1, 0),
-						Vector3(0, +1, 0),
-						Vector3(0, 0, -1),
-						Vector3(0, 0, +1)
-					};
-					static const Vector3 view_up[6] = {
-						Vector3(0, -1, 0),
-						Vector3(0, -1, 0),
-						Vector3(0, 0, -1),
-						Vector3(0, 0, +1),
-						Vector3(0, -1, 0),
-						Vector3(0, -1, 0)
-					};
-
-					Transform xform = light_transform * Transform().looking_at(view_normals[i], view_up[i]);
-
-					Vector<Plane> planes = cm.get_projection_planes(xform);
-
-					int cull_count = p_scenario->sps->cull_convex(planes, instance_shadow_cull_result, MAX_INSTANCE_CULL, VS::INSTANCE_GEOMETRY_MASK);
-
-					Plane near_plane(xform.origin, -xform.basis.get_axis(2));
-					for (int j = 0; j < cull_count; j++) {
-
-						Instance *instance = instance_shadow_cull_result[j];
-						if (!instance->visible || !((1 << instance->base_type) & VS::INSTANCE_GEOMETRY_MASK) || !static_cast<InstanceGeometryData *>(instance->base_data)->can_cast_shadows) {
-							cull_count--;
-							SWAP(instance_shadow_cull_result[j], instance_shadow_cull_result[cull_count]);
-							j--;
-						} else {
-							if (static_cast<InstanceGeometryData *>(instance->base_data)->material_is_animated) {
-								animated_material_found = true;
-							}
-							instance->depth = near_plane.distance_to(instance->transform.origin);
-							instance->depth_layer = 0;
-						}
-					}
+					xforms[i] = light_transform * Transform().looking_at(view_normals[i], view_up[i]);
+
+					ShadowCullJob &job = shadow_cull_jobs[i];
+					job.planes = cm.get_projection_planes(xforms[i]);
+					job.directional = false;
+				}
 
-					VSG::scene_render->light_instance_set_shadow_transform(light->instance, cm, xform, radius, 0, i);
-					VSG::scene_render->render_shadow(light->instance, p_shadow_atlas, i, (RasterizerScene::InstanceBase **)instance_shadow_cull_result, cull_count);
+				animated_material_found = _cull_shadow_jobs(6, p_scenario, p_cam_transform.origin, p_update_draw_ranges);
+
+				for (int i = 0; i < 6; i++) {
+
+					ShadowCullJob &job = shadow_cull_jobs[i];
+					job.update_depths(Plane(xforms[i].origin, -xforms[i].basis.get_axis(2)));
+
+					VSG::scene_render->light_instance_set_shadow_transform(light->instance, cm, xforms[i], radius, 0, i);
+					VSG::scene_render->render_shadow(light->instance, p_shadow_atlas, i, (RasterizerScene::InstanceBase **)job.result.ptr(), job.cull_count);
 				}
 
 				//restore the regular DP matrix
@@ -1858,28 +2120,16 @@ bool VisualServerScene::_light_instance_update_shadow(Instance *p_instance, cons
 			CameraMatrix cm;
 			cm.set_perspective(angle * 2.0, 1.0, 0.01, radius);
 
-			Vector<Plane> planes = cm.get_projection_planes(light_transform);
-			int cull_count = p_scenario->sps->cull_convex(planes, instance_shadow_cull_result, MAX_INSTANCE_CULL, VS::INSTANCE_GEOMETRY_MASK);
+			ShadowCullJob &job = shadow_cull_jobs[0];
+			job.planes = cm.get_projection_planes(light_transform);
+			job.directional = false;
 
-			Plane near_plane(light_transform.origin, -light_transform.basis.get_axis(2));
-			for (int j = 0; j < cull_count; j++) {
+			animated_material_found = _cull_shadow_jobs(1, p_scenario, p_cam_transform.origin, p_update_draw_ranges);
 
-				Instance *instance = instance_shadow_cull_result[j];
-				if (!instance->visible || !((1 << instance->base_type) & VS::INSTANCE_GEOMETRY_MASK) || !static_cast<InstanceGeometryData *>(instance->base_data)->can_cast_shadows) {
-					cull_count--;
-					SWAP(instance_shadow_cull_result[j], instance_shadow_cull_result[cull_count]);
-					j--;
-				} else {
-					if (static_cast<InstanceGeometryData *>(instance->base_data)->material_is_animated) {
-						animated_material_found = true;
-					}
-					instance->depth = near_plane.distance_to(instance->transform.origin);
-					instance->depth_layer = 0;
-				}
-			}
+			job.update_depths(Plane(light_transform.origin, -light_transform.basis.get_axis(2)));
 
 			VSG::scene_render->light_instance_set_shadow_transform(light->instance, cm, light_transform, radius, 0, 0);
-			VSG::scene_render->render_shadow(light->instance, p_shadow_atlas, 0, (RasterizerScene::InstanceBase **)instance_shadow_cull_result, cull_count);
+			VSG::scene_render->render_shadow(light->instance, p_shadow_atlas, 0, (RasterizerScene::InstanceBase **)job.result.ptr(), job.cull_count);
 
 		} break;
 	}
@@ -2022,6 +2272,144 @@ void VisualServerScene::render_camera(Ref<ARVRInterface> &p_interface, ARVRInter
 	_render_scene(cam_transform, camera_matrix, false, camera->env, p_scenario, p_shadow_atlas, RID(), -1);
 };
 
+void VisualServerScene::_occlusion_test_job(uint32_t p_chunk, void *p_userdata) {
+
+	int from = p_chunk * OCCLUSION_TEST_CHUNK;
+	int to = MIN(from + (int)OCCLUSION_TEST_CHUNK, instance_cull_count);
+
+	for (int i = from; i < to; i++) {
+		Instance *ins = instance_cull_result[i];
+		// Lights and probes light what's in view even when hidden themselves.
+		instance_occluded[i] = ((1 << ins->base_type) & VS::INSTANCE_GEOMETRY_MASK) && occlusion_buffer.is_occluded(ins->transformed_aabb, ins->self.get_id());
+	}
+}
+
+void VisualServerScene::_occlusion_cull(const Transform &p_cam_transform, const CameraMatrix &p_cam_projection, Scenario *p_scenario) {
+
+	real_t aspect = p_cam_projection.get_aspect();
+	int height = aspect > CMP_EPSILON ? int(occlusion_buffer_width / aspect) : occlusion_buffer_width;
+	occlusion_buffer.set_size(occlusion_buffer_width, CLAMP(height, 1, occlusion_buffer_width * 2));
+	occlusion_buffer.begin(p_cam_projection, p_cam_transform);
+
+	for (SelfList<Instance> *E = p_scenario->occluders.first(); E; E = E->next()) {
+
+		Instance *ins = E->self();
+		if (ins->visible) {
+			occlusion_buffer.add_occluder(ins->self.get_id(), ins->transform, ins->occluder_aabb, ins->occluder_triangles);
+		}
+	}
+
+	if (occlusion_buffer.is_empty()) {
+		return;
+	}
+
+	occlusion_buffer.rasterize(cull_work_pool);
+	cull_work_pool.do_work((instance_cull_count + OCCLUSION_TEST_CHUNK - 1) / OCCLUSION_TEST_CHUNK, this, &VisualServerScene::_occlusion_test_job, (void *)NULL);
+
+	int count = 0;
+	for (int i = 0; i < instance_cull_count; i++) {
+		if (instance_occluded[i]) {
+			instance_cull_result[i]->last_render_pass = 0;
+		} else {
+			instance_cull_result[count++] = instance_cull_result[i];
+		}
+	}
+
+	occlusion_culled_count += instance_cull_count - count;
+	instance_cull_count = count;
+}
+
+void VisualServerScene::_prepare_instance_geometry(Instance *p_instance, const Plane &p_near_plane, float p_z_far) {
+
+	InstanceGeometryData *geom = static_cast<InstanceGeometryData *>(p_instance->base_data);
+
+	if (geom->lighting_dirty) {
+		int l = 0;
+		//only called when lights AABB enter/exit this geometry
+		p_instance->light_instances.resize(geom->lighting.size());
+
+		for (List<Instance *>::Element *E = geom->lighting.front(); E; E = E->next()) {
+
+			InstanceLightData *light = static_cast<InstanceLightData *>(E->get()->base_data);
+
+			p_instance->light_instances.write[l++] = light->instance;
+		}
+
+		geom->lighting_dirty = false;
+	}
+
+	if (geom->reflection_dirty) {
+		int l = 0;
+		//only called when reflection probe AABB enter/exit this geometry
+		p_instance->reflection_probe_instances.resize(geom->reflection_probes.size());
+
+		for (List<Instance *>::Element *E = geom->reflection_probes.front(); E; E = E->next()) {
+
+			InstanceReflectionProbeData *reflection_probe = static_cast<InstanceReflectionProbeData *>(E->get()->base_data);
+
+			p_instance->reflection_probe_instances.write[l++] = reflection_probe->instance;
+		}
+
+		geom->reflection_dirty = false;
+	}
+
+	if (geom->gi_probes_dirty) {
+		int l = 0;
+		//only called when reflection probe AABB enter/exit this geometry
+		p_instance->gi_probe_instances.resize(geom->gi_probes.size());
+
+		for (List<Instance *>::Element *E = geom->gi_probes.front(); E; E = E->next()) {
+
+			InstanceGIProbeData *gi_probe = static_cast<InstanceGIProbeData *>(E->get()->base_data);
+
+			p_instance->gi_probe_instances.write[l++] = gi_probe->probe_instance;
+		}
+
+		geom->gi_probes_dirty = false;
+	}
+
+	p_instance->depth = p_near_plane.distance_to(p_instance->transform.origin);
+	p_instance->depth_layer = CLAMP(int(p_instance->depth * 16 / p_z_far), 0, 15);
+}
+
+void VisualServerScene::_prepare_instance_job(uint32_t p_chunk, PrepareCullParams *p_params) {
+
+	int from = p_chunk * INSTANCE_PREPARE_CHUNK;
+	int to = MIN(from + (int)INSTANCE_PREPARE_CHUNK, instance_cull_count);
+
+	for (int i = from; i < to; i++) {
+
+		Instance *ins = instance_cull_result[i];
+		uint8_t flags = 0;
+
+		if ((p_params->camera_layer_mask & ins->layer_mask) == 0) {
+
+			//failure
+		} else if (!((1 << ins->base_type) & VS::INSTANCE_GEOMETRY_MASK) || ins->base_type == VS::INSTANCE_PARTICLES || ins->redraw_if_visible || (ins->draw_range_enabled && (ins->lod_owner || !ins->lod_members.empty()))) {
+
+			flags = INSTANCE_CULL_SERIAL;
+		} else if (ins->visible && ins->cast_shadows != VS::SHADOW_CASTING_SETTING_SHADOWS_ONLY) {
+
+			bool in_range = true;
+			if (ins->draw_range_enabled) {
+				// Same as _instance_check_draw_range(), the lights are told after the jobs.
+				in_range = _is_in_draw_range(ins, _draw_range_distance(ins, p_params->cam_pos), ins->lod_visible);
+				if (p_params->update_draw_ranges && in_range != ins->lod_visible) {
+					ins->lod_visible = in_range;
+					flags |= INSTANCE_CULL_DRAW_RANGE_CHANGED;
+				}
+			}
+
+			if (in_range) {
+				_prepare_instance_geometry(ins, p_params->near_plane, p_params->z_far);
+				flags |= INSTANCE_CULL_KEEP;
+			}
+		}
+
+		instance_cull_flags[i] = flags;
+	}
+}
+
 void VisualServerScene::_prepare_scene(const Transform p_cam_transform, const CameraMatrix &p_cam_projection, bool p_cam_orthogonal, RID p_force_environment, uint32_t p_visible_layers, RID p_scenario, RID p_shadow_atlas, RID p_reflection_probe) {
 	// Note, in stereo rendering:
 	// - p_cam_transform will be a transform in the middle of our two eyes
@@ -2041,6 +2429,9 @@ void VisualServerScene::_prepare_scene(const Transform p_cam_transform, const Ca
 	Plane near_plane(p_cam_transform.origin, -p_cam_transform.basis.get_axis(2).normalized());
 	float z_far = p_cam_projection.get_z_far();
 
+	// Reflection probes see the scene from elsewhere, they must not switch the LODs the camera draws.
+	bool update_draw_ranges = !p_reflection_probe.is_valid();
+
 	/* STEP 2 - CULL */
 	instance_cull_count = scenario->sps->cull_convex(planes, instance_cull_result, MAX_INSTANCE_CULL);
 	light_cull_count = 0;
@@ -2056,156 +2447,129 @@ void VisualServerScene::_prepare_scene(const Transform p_cam_transform, const Ca
 	print_line("OTP: "+itos(p_scenario->octree.get_pair_count()));
 	*/
 
-	/* STEP 3 - PROCESS PORTALS, VALIDATE ROOMS */
-	//removed, will replace with culling
+	/* STEP 3 - REMOVE OCCLUDED OBJECTS */
 
-	/* STEP 4 - REMOVE FURTHER CULLED OBJECTS, ADD LIGHTS */
+	// Not for reflection probes, they are rendered rarely and from few places.
+	if (occlusion_culling && !p_reflection_probe.is_valid() && scenario->occluders.first()) {
+		_occlusion_cull(p_cam_transform, p_cam_projection, scenario);
+	}
 
-	for (int i = 0; i < instance_cull_count; i++) {
+	/* STEP 4 - REMOVE FURTHER CULLED OBJECTS, ADD LIGHTS */
 
-		Instance *ins = instance_cull_result[i];
+	// Plain geometry is prepared by parallel jobs, the rest is done here while compacting the results.
+	PrepareCullParams prepare_params;
+	prepare_params.camera_layer_mask = camera_layer_mask;
+	prepare_params.cam_pos = p_cam_transform.origin;
+	prepare_params.near_plane = near_plane;
+	prepare_params.z_far = z_far;
+	prepare_params.update_draw_ranges = update_draw_ranges;
 
-		bool keep = false;
+	cull_work_pool.do_work((instance_cull_count + INSTANCE_PREPARE_CHUNK - 1) / INSTANCE_PREPARE_CHUNK, this, &VisualServerScene::_prepare_instance_job, &prepare_params);
 
-		if ((camera_layer_mask & ins->layer_mask) == 0) {
+	int prepared_count = 0;
 
-			//failure
-		} else if (ins->base_type == VS::INSTANCE_LIGHT && ins->visible) {
+	for (int i = 0; i < instance_cull_count; i++) {
 
-			if (light_cull_count < MAX_LIGHTS_CULLED) {
+		Instance *ins = instance_cull_result[i];
+		uint8_t flags = instance_cull_flags[i];
 
-				InstanceLightData *light = static_cast<InstanceLightData *>(ins->base_data);
+		if (flags & INSTANCE_CULL_DRAW_RANGE_CHANGED) {
+			_instance_mark_lights_shadow_dirty(ins);
+		}
 
-				if (!light->geometries.empty()) {
-					//do not add this light if no geometry is affected by it..
-					light_cull_result[light_cull_count] = ins;
-					light_instance_cull_result[light_cull_count] = light->instance;
-					if (p_shadow_atlas.is_valid() && VSG::storage->light_has_shadow(ins->base)) {
-						VSG::scene_render->light_instance_mark_visible(light->instance); //mark it visible for shadow allocation later
-					}
+		bool keep = flags & INSTANCE_CULL_KEEP;
 
-					light_cull_count++;
-				}
-			}
-		} else if (ins->base_type == VS::INSTANCE_REFLECTION_PROBE && ins->visible) {
+		if (flags & INSTANCE_CULL_SERIAL) {
 
-			if (reflection_probe_cull_count < MAX_REFLECTION_PROBES_CULLED) {
+			if (ins->base_type == VS::INSTANCE_LIGHT && ins->visible) {
 
-				InstanceReflectionProbeData *reflection_probe = static_cast<InstanceReflectionProbeData *>(ins->base_data);
+				if (light_cull_count < MAX_LIGHTS_CULLED) {
 
-				if (p_reflection_probe != reflection_probe->instance) {
-					//avoid entering The Matrix
+					InstanceLightData *light = static_cast<InstanceLightData *>(ins->base_data);
 
-					if (!reflection_probe->geometries.empty()) {
+					if (!light->geometries.empty()) {
 						//do not add this light if no geometry is affected by it..
-
-						if (reflection_probe->reflection_dirty || VSG::scene_render->reflection_probe_instance_needs_redraw(reflection_probe->instance)) {
-							if (!reflection_probe->update_list.in_list()) {
-								reflection_probe->render_step = 0;
-								reflection_probe_render_list.add_last(&reflection_probe->update_list);
-							}
-
-							reflection_probe->reflection_dirty = false;
+						light_cull_result[light_cull_count] = ins;
+						light_instance_cull_result[light_cull_count] = light->instance;
+						if (p_shadow_atlas.is_valid() && VSG::storage->light_has_shadow(ins->base)) {
+							VSG::scene_render->light_instance_mark_visible(light->instance); //mark it visible for shadow allocation later
 						}
 
-						if (VSG::scene_render->reflection_probe_instance_has_reflection(reflection_probe->instance)) {
-							reflection_probe_instance_cull_result[reflection_probe_cull_count] = reflection_probe->instance;
-							reflection_probe_cull_count++;
-						}
+						light_cull_count++;
 					}
 				}
-			}
+			} else if (ins->base_type == VS::INSTANCE_REFLECTION_PROBE && ins->visible) {
 
-		} else if (ins->base_type == VS::INSTANCE_GI_PROBE && ins->visible) {
+				if (reflection_probe_cull_count < MAX_REFLECTION_PROBES_CULLED) {
 
-			InstanceGIProbeData *gi_probe = static_cast<InstanceGIProbeData *>(ins->base_data);
-			if (!gi_probe->update_element.in_list()) {
-				gi_probe_update_list.add(&gi_probe->update_element);
-			}
+					InstanceReflectionProbeData *reflection_probe = static_cast<InstanceReflectionProbeData *>(ins->base_data);
 
-		} else if (((1 << ins->base_type) & VS::INSTANCE_GEOMETRY_MASK) && ins->visible && ins->cast_shadows != VS::SHADOW_CASTING_SETTING_SHADOWS_ONLY) {
+					if (p_reflection_probe != reflection_probe->instance) {
+						//avoid entering The Matrix
 
-			keep = true;
+						if (!reflection_probe->geometries.empty()) {
+							//do not add this light if no geometry is affected by it..
 
-			InstanceGeometryData *geom = static_cast<InstanceGeometryData *>(ins->base_data);
+							if (reflection_probe->reflection_dirty || VSG::scene_render->reflection_probe_instance_needs_redraw(reflection_probe->instance)) {
+								if (!reflection_probe->update_list.in_list()) {
+									reflection_probe->render_step = 0;
+									reflection_probe_render_list.add_last(&reflection_probe->update_list);
+								}
 
-			if (ins->redraw_if_visible) {
-				VisualServerRaster::redraw_request();
-			}
+								reflection_probe->reflection_dirty = false;
+							}
 
-			if (ins->base_type == VS::INSTANCE_PARTICLES) {
-				//particles visible? process them
-				if (VSG::storage->particles_is_inactive(ins->base)) {
-					//but if nothing is going on, don't do it.
-					keep = false;
-				} else {
-					VSG::storage->particles_request_process(ins->base);
-					//particles visible? request redraw
-					VisualServerRaster::redraw_request();
+							if (VSG::scene_render->reflection_probe_instance_has_reflection(reflection_probe->instance)) {
+								reflection_probe_instance_cull_result[reflection_probe_cull_count] = reflection_probe->instance;
+								reflection_probe_cull_count++;
+							}
+						}
+					}
 				}
-			}
-
-			if (geom->lighting_dirty) {
-				int l = 0;
-				//only called when lights AABB enter/exit this geometry
-				ins->light_instances.resize(geom->lighting.size());
-
-				for (List<Instance *>::Element *E = geom->lighting.front(); E; E = E->next()) {
 
-					InstanceLightData *light = static_cast<InstanceLightData *>(E->get()->base_data);
+			} else if (ins->base_type == VS::INSTANCE_GI_PROBE && ins->visible) {
 
-					ins->light_instances.write[l++] = light->instance;
+				InstanceGIProbeData *gi_probe = static_cast<InstanceGIProbeData *>(ins->base_data);
+				if (!gi_probe->update_element.in_list()) {
+					gi_probe_update_list.add(&gi_probe->update_element);
 				}
 
-				geom->lighting_dirty = false;
-			}
-
-			if (geom->reflection_dirty) {
-				int l = 0;
-				//only called when reflection probe AABB enter/exit this geometry
-				ins->reflection_probe_instances.resize(geom->reflection_probes.size());
+			} else if (((1 << ins->base_type) & VS::INSTANCE_GEOMETRY_MASK) && ins->visible && ins->cast_shadows != VS::SHADOW_CASTING_SETTING_SHADOWS_ONLY && _instance_in_draw_range(ins, p_cam_transform.origin, update_draw_ranges)) {
 
-				for (List<Instance *>::Element *E = geom->reflection_probes.front(); E; E = E->next()) {
+				keep = true;
 
-					InstanceReflectionProbeData *reflection_probe = static_cast<InstanceReflectionProbeData *>(E->get()->base_data);
-
-					ins->reflection_probe_instances.write[l++] = reflection_probe->instance;
+				if (ins->redraw_if_visible) {
+					VisualServerRaster::redraw_request();
 				}
 
-				geom->reflection_dirty = false;
-			}
-
-			if (geom->gi_probes_dirty) {
-				int l = 0;
-				//only called when reflection probe AABB enter/exit this geometry
-				ins->gi_probe_instances.resize(geom->gi_probes.size());
-
-				for (List<Instance *>::Element *E = geom->gi_probes.front(); E; E = E->next()) {
-
-					InstanceGIProbeData *gi_probe = static_cast<InstanceGIProbeData *>(E->get()->base_data);
-
-					ins->gi_probe_instances.write[l++] = gi_probe->probe_instance;
+				if (ins->base_type == VS::INSTANCE_PARTICLES) {
+					//particles visible? process them
+					if (VSG::storage->particles_is_inactive(ins->base)) {
+						//but if nothing is going on, don't do it.
+						keep = false;
+					} else {
+						VSG::storage->particles_request_process(ins->base);
+						//particles visible? request redraw
+						VisualServerRaster::redraw_request();
+					}
 				}
 
-				geom->gi_probes_dirty = false;
+				_prepare_instance_geometry(ins, near_plane, z_far);
 			}
-
-			ins->depth = near_plane.distance_to(ins->transform.origin);
-			ins->depth_layer = CLAMP(int(ins->depth * 16 / z_far), 0, 15);
 		}
 
 		if (!keep) {
 			// remove, no reason to keep
-			instance_cull_count--;
-			SWAP(instance_cull_result[i], instance_cull_result[instance_cull_count]);
-			i--;
 			ins->last_render_pass = 0; // make invalid
 		} else {
 
 			ins->last_render_pass = render_pass;
+			instance_cull_result[prepared_count++] = ins;
 		}
 	}
 
+	instance_cull_count = prepared_count;
+
 	/* STEP 5 - PROCESS LIGHTS */
 
 	RID *directional_light_ptr = &light_instance_cull_result[light_cull_count];
@@ -2243,7 +2607,7 @@ void VisualServerScene::_prepare_scene(const Transform p_cam_transform, const Ca
 
 		for (int i = 0; i < directional_shadow_count; i++) {
 
-			_light_instance_update_shadow(lights_with_shadow[i], p_cam_transform, p_cam_projection, p_cam_orthogonal, p_shadow_atlas, scenario);
+			_light_instance_update_shadow(lights_with_shadow[i], p_cam_transform, p_cam_projection, p_cam_orthogonal, p_shadow_atlas, scenario, update_draw_ranges);
 		}
 	}
 
@@ -2342,7 +2706,7 @@ void VisualServerScene::_prepare_scene(const Transform p_cam_transform, const Ca
 
 			if (redraw) {
 				//must redraw!
-				light->shadow_dirty = _light_instance_update_shadow(ins, p_cam_transform, p_cam_projection, p_cam_orthogonal, p_shadow_atlas, scenario);
+				light->shadow_dirty = _light_instance_update_shadow(ins, p_cam_transform, p_cam_projection, p_cam_orthogonal, p_shadow_atlas, scenario, update_draw_ranges);
 			}
 		}
 	}
@@ -3630,22 +3994,31 @@ void VisualServerScene::update_dirty_instances() {
 
 	VSG::storage->update_dirty_resources();
 
-	// this is just to get access to scenario so we can update the spatial partitioning scheme
-	Scenario *scenario = nullptr;
-	if (_instance_update_list.first()) {
-		scenario = _instance_update_list.first()->self()->scenario;
-	}
-
 	while (_instance_update_list.first()) {
 
-		_update_dirty_instance(_instance_update_list.first()->self());
+		Instance *instance = _instance_update_list.first()->self();
+		if (instance->scenario) {
+			_scenario_queue_update(instance->scenario);
+		}
+
+		_update_dirty_instance(instance);
 	}
 
-	if (scenario) {
+	// the BVH defers refitting moved instances to update(), so every scenario touched must be updated
+	while (_scenario_update_list.first()) {
+
+		Scenario *scenario = _scenario_update_list.first()->self();
+		_scenario_update_list.remove(_scenario_update_list.first());
 		scenario->sps->update();
 	}
 }
 
+void VisualServerScene::begin_frame() {
+
+	occlusion_culled_in_frame = occlusion_culled_count;
+	occlusion_culled_count = 0;
+}
+
 bool VisualServerScene::free(RID p_rid) {
 
 	if (camera_owner.owns(p_rid)) {
@@ -3679,6 +4052,10 @@ bool VisualServerScene::free(RID p_rid) {
 		instance_set_base(p_rid, RID());
 		instance_geometry_set_material_override(p_rid, RID());
 		instance_attach_skeleton(p_rid, RID());
+		instance_geometry_set_as_instance_lod(p_rid, RID());
+		while (instance->lod_members.size()) {
+			instance_geometry_set_as_instance_lod(instance->lod_members[0]->self, RID());
+		}
 
 		update_dirty_instances(); //in case something changed this
 
@@ -3701,6 +4078,17 @@ VisualServerScene::VisualServerScene() {
 	render_pass = 1;
 	singleton = this;
 	_use_bvh = GLOBAL_DEF("rendering/quality/spatial_partitioning/use_bvh", true);
+
+	occlusion_culling = GLOBAL_DEF("rendering/quality/occlusion_culling/enabled", false);
+	occlusion_buffer_width = GLOBAL_DEF("rendering/quality/occlusion_culling/buffer_width", 256);
+	ProjectSettings::get_singleton()->set_custom_property_info("rendering/quality/occlusion_culling/buffer_width", PropertyInfo(Variant::INT, "rendering/quality/occlusion_culling/buffer_width", PROPERTY_HINT_RANGE, "64,1024,8"));
+	occlusion_culled_count = 0;
+	occlusion_culled_in_frame = 0;
+
+	// 0 uses one thread per processor.
+	int cull_thread_count = GLOBAL_DEF("rendering/threads/cull_thread_count", 0);
+	ProjectSettings::get_singleton()->set_custom_property_info("rendering/threads/cull_thread_count", PropertyInfo(Variant::INT, "rendering/threads/cull_thread_count", PROPERTY_HINT_RANGE, "0,64,1,or_greater"));
+	cull_work_pool.init(cull_thread_count > 0 ? cull_thread_count : -1);
 }
 
 VisualServerScene::~VisualServerScene() {
@@ -3708,4 +4096,6 @@ VisualServerScene::~VisualServerScene() {
 	probe_bake_thread_exit = true;
 	probe_bake_sem.post();
 	probe_bake_thread.wait_to_finish();
+
+	cull_work_pool.finish();
 }
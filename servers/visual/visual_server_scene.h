@@ -31,6 +31,7 @@
 #ifndef VISUALSERVERSCENE_H
 #define VISUALSERVERSCENE_H
 
+#include "servers/visual/occlusion_buffer.h"
 #include "servers/visual/rasterizer.h"
 
 #include "core/math/bvh.h"
@@ -38,6 +39,7 @@
 #include "core/math/octree.h"
 #include "core/os/semaphore.h"
 #include "core/os/thread.h"
+#include "core/os/thread_work_pool.h"
 #include "core/safe_refcount.h"
 #include "core/self_list.h"
 #include "servers/arvr/arvr_interface.h"
@@ -51,6 +53,9 @@ public:
 		MAX_REFLECTION_PROBES_CULLED = 4096,
 		MAX_ROOM_CULL = 32,
 		MAX_EXTERIOR_PORTALS = 128,
+		OCCLUSION_TEST_CHUNK = 256, // Instances tested against the occlusion buffer in one job.
+		INSTANCE_PREPARE_CHUNK = 256, // Culled instances prepared for drawing in one job.
+		MAX_SHADOW_CULL_JOBS = 6, // One per cube map face.
 	};
 
 	uint64_t render_pass;
@@ -123,8 +128,10 @@ public:
 		virtual void force_collision_check(SpatialPartitionID p_handle) {}
 		virtual void update() {}
 		virtual void update_collisions() {}
+		virtual bool can_cull_in_parallel() const { return false; }
 		virtual void set_pairable(SpatialPartitionID p_handle, bool p_pairable, uint32_t p_pairable_type, uint32_t p_pairable_mask) = 0;
-		virtual int cull_convex(const Vector<Plane> &p_convex, Instance **p_result_array, int p_result_max, uint32_t p_mask = 0xFFFFFFFF) = 0;
+		// p_hits is per thread scratch, only used when can_cull_in_parallel() is true.
+		virtual int cull_convex(const Vector<Plane> &p_convex, Instance **p_result_array, int p_result_max, uint32_t p_mask = 0xFFFFFFFF, LocalVector<uint32_t, uint32_t, true> *p_hits = nullptr) = 0;
 		virtual int cull_aabb(const AABB &p_aabb, Instance **p_result_array, int p_result_max, int *p_subindex_array = nullptr, uint32_t p_mask = 0xFFFFFFFF) = 0;
 		virtual int cull_segment(const Vector3 &p_from, const Vector3 &p_to, Instance **p_result_array, int p_result_max, int *p_subindex_array = nullptr, uint32_t p_mask = 0xFFFFFFFF) = 0;
 
@@ -152,7 +159,7 @@ public:
 		void erase(SpatialPartitionID p_handle);
 		void move(SpatialPartitionID p_handle, const AABB &p_aabb);
 		void set_pairable(SpatialPartitionID p_handle, bool p_pairable, uint32_t p_pairable_type, uint32_t p_pairable_mask);
-		int cull_convex(const Vector<Plane> &p_convex, Instance **p_result_array, int p_result_max, uint32_t p_mask = 0xFFFFFFFF);
+		int cull_convex(const Vector<Plane> &p_convex, Instance **p_result_array, int p_result_max, uint32_t p_mask = 0xFFFFFFFF, LocalVector<uint32_t, uint32_t, true> *p_hits = nullptr);
 		int cull_aabb(const AABB &p_aabb, Instance **p_result_array, int p_result_max, int *p_subindex_array = nullptr, uint32_t p_mask = 0xFFFFFFFF);
 		int cull_segment(const Vector3 &p_from, const Vector3 &p_to, Instance **p_result_array, int p_result_max, int *p_subindex_array = nullptr, uint32_t p_mask = 0xFFFFFFFF);
 		void set_pair_callback(PairCallback p_callback, void *p_userdata);
@@ -173,8 +180,9 @@ public:
 		void force_collision_check(SpatialPartitionID p_handle);
 		void update();
 		void update_collisions();
+		bool can_cull_in_parallel() const { return true; }
 		void set_pairable(SpatialPartitionID p_handle, bool p_pairable, uint32_t p_pairable_type, uint32_t p_pairable_mask);
-		int cull_convex(const Vector<Plane> &p_convex, Instance **p_result_array, int p_result_max, uint32_t p_mask = 0xFFFFFFFF);
+		int cull_convex(const Vector<Plane> &p_convex, Instance **p_result_array, int p_result_max, uint32_t p_mask = 0xFFFFFFFF, LocalVector<uint32_t, uint32_t, true> *p_hits = nullptr);
 		int cull_aabb(const AABB &p_aabb, Instance **p_result_array, int p_result_max, int *p_subindex_array = nullptr, uint32_t p_mask = 0xFFFFFFFF);
 		int cull_segment(const Vector3 &p_from, const Vector3 &p_to, Instance **p_result_array, int p_result_max, int *p_subindex_array = nullptr, uint32_t p_mask = 0xFFFFFFFF);
 		void set_pair_callback(PairCallback p_callback, void *p_userdata);
@@ -198,6 +206,9 @@ public:
 		RID reflection_atlas;
 
 		SelfList<Instance>::List instances;
+		SelfList<Instance>::List occluders;
+
+		SelfList<Scenario> update_item; // Queued until sps->update() refits the instances moved in it.
 
 		Scenario();
 		~Scenario() { memdelete(sps); }
@@ -246,13 +257,24 @@ public:
 		float lod_end;
 		float lod_begin_hysteresis;
 		float lod_end_hysteresis;
-		RID lod_instance;
+		bool lod_visible; // In its draw range at the last check, the hysteresis margins widen the range then.
+		bool draw_range_enabled;
+
+		// LOD groups are an owner and the instances set as its LODs, drawing one of them at most.
+		Instance *lod_owner;
+		Vector<Instance *> lod_members;
+		Instance *lod_selected;
+		uint64_t lod_selected_pass;
 
 		uint64_t last_render_pass;
 		uint64_t last_frame_pass;
 
 		uint64_t version; // changes to this, and changes to base increase version
 
+		PoolVector<Vector3> occluder_triangles;
+		AABB occluder_aabb;
+		SelfList<Instance> occluder_item;
+
 		InstanceBaseData *base_data;
 
 		virtual void base_removed() {
@@ -267,7 +289,8 @@ public:
 
 		Instance() :
 				scenario_item(this),
-				update_item(this) {
+				update_item(this),
+				occluder_item(this) {
 
 			spatial_partition_id = 0;
 			scenario = NULL;
@@ -284,6 +307,12 @@ public:
 			lod_end = 0;
 			lod_begin_hysteresis = 0;
 			lod_end_hysteresis = 0;
+			lod_visible = false;
+			draw_range_enabled = false;
+
+			lod_owner = NULL;
+			lod_selected = NULL;
+			lod_selected_pass = 0;
 
 			last_render_pass = 0;
 			last_frame_pass = 0;
@@ -304,6 +333,13 @@ public:
 
 	SelfList<Instance>::List _instance_update_list;
 	void _instance_queue_update(Instance *p_instance, bool p_update_aabb, bool p_update_materials = false);
+	SelfList<Scenario>::List _scenario_update_list;
+	_FORCE_INLINE_ void _scenario_queue_update(Scenario *p_scenario) {
+		if (!p_scenario->update_item.in_list()) {
+			_scenario_update_list.add(&p_scenario->update_item);
+		}
+	}
+	void _instance_set_transform(Instance *p_instance, const Transform &p_transform);
 
 	struct InstanceGeometryData : public InstanceBaseData {
 
@@ -504,8 +540,50 @@ public:
 		}
 	};
 
+	enum InstanceCullFlags {
+		INSTANCE_CULL_KEEP = 1,
+		INSTANCE_CULL_SERIAL = 2, // Lights, probes, particles and LOD groups touch shared state, they are done after the jobs.
+		INSTANCE_CULL_DRAW_RANGE_CHANGED = 4,
+	};
+
+	struct PrepareCullParams {
+		uint32_t camera_layer_mask;
+		Vector3 cam_pos;
+		Plane near_plane;
+		float z_far;
+		bool update_draw_ranges;
+	};
+
+	// A shadow map (a directional split or an omni/spot face) culled on its own, so all
+	// the maps of a light are culled at once. Rendering them stays on the calling thread.
+	struct ShadowCullJob {
+		Vector<Plane> planes;
+		Vector3 z_vec; // directional splits only, z_max grows along it to fit the casters
+		bool directional;
+
+		LocalVector<Instance *> result;
+		LocalVector<uint32_t, uint32_t, true> hits;
+		int cull_count;
+		float z_max;
+		bool animated_material_found;
+
+		void update_depths(const Plane &p_near_plane) {
+			for (int i = 0; i < cull_count; i++) {
+				result[i]->depth = p_near_plane.distance_to(result[i]->transform.origin);
+				result[i]->depth_layer = 0;
+			}
+		}
+	};
+
+	struct ShadowCullParams {
+		Scenario *scenario;
+		Vector3 cam_pos;
+		bool update_draw_ranges;
+	};
+
 	int instance_cull_count;
 	Instance *instance_cull_result[MAX_INSTANCE_CULL];
+	uint8_t instance_cull_flags[MAX_INSTANCE_CULL];
 	Instance *instance_shadow_cull_result[MAX_INSTANCE_CULL]; //used for generating shadowmaps
 	Instance *light_cull_result[MAX_LIGHTS_CULLED];
 	RID light_instance_cull_result[MAX_LIGHTS_CULLED];
@@ -513,6 +591,15 @@ public:
 	int directional_light_count;
 	RID reflection_probe_instance_cull_result[MAX_REFLECTION_PROBES_CULLED];
 	int reflection_probe_cull_count;
+	ShadowCullJob shadow_cull_jobs[MAX_SHADOW_CULL_JOBS];
+
+	bool occlusion_culling;
+	int occlusion_buffer_width;
+	OcclusionBuffer occlusion_buffer;
+	bool instance_occluded[MAX_INSTANCE_CULL];
+	uint64_t occlusion_culled_count;
+	uint64_t occlusion_culled_in_frame;
+	ThreadWorkPool cull_work_pool;
 
 	RID_Owner<Instance> instance_owner;
 
@@ -522,6 +609,7 @@ public:
 	virtual void instance_set_scenario(RID p_instance, RID p_scenario);
 	virtual void instance_set_layer_mask(RID p_instance, uint32_t p_mask);
 	virtual void instance_set_transform(RID p_instance, const Transform &p_transform);
+	virtual void instances_set_transforms(const Vector<RID> &p_instances, const PoolVector<float> &p_transforms);
 	virtual void instance_attach_object_instance_id(RID p_instance, ObjectID p_id);
 	virtual void instance_set_blend_shape_weight(RID p_instance, int p_shape, float p_weight);
 	virtual void instance_set_surface_material(RID p_instance, int p_surface, RID p_material);
@@ -535,6 +623,8 @@ public:
 
 	virtual void instance_set_extra_visibility_margin(RID p_instance, real_t p_margin);
 
+	virtual void instance_set_occluder(RID p_instance, const PoolVector<Vector3> &p_triangles);
+
 	// don't use these in a game!
 	virtual Vector<ObjectID> instances_cull_aabb(const AABB &p_aabb, RID p_scenario = RID()) const;
 	virtual Vector<ObjectID> instances_cull_ray(const Vector3 &p_from, const Vector3 &p_to, RID p_scenario = RID()) const;
@@ -552,7 +642,24 @@ public:
 	_FORCE_INLINE_ void _update_dirty_instance(Instance *p_instance);
 	_FORCE_INLINE_ void _update_instance_lightmap_captures(Instance *p_instance);
 
-	_FORCE_INLINE_ bool _light_instance_update_shadow(Instance *p_instance, const Transform p_cam_transform, const CameraMatrix &p_cam_projection, bool p_cam_orthogonal, RID p_shadow_atlas, Scenario *p_scenario);
+	void _instance_mark_lights_shadow_dirty(Instance *p_instance);
+	void _instance_update_draw_range_enabled(Instance *p_instance);
+	void _instance_leave_lod_group(Instance *p_instance);
+	bool _instance_check_draw_range(Instance *p_instance, const Vector3 &p_cam_pos, bool p_update);
+	// p_update is false for passes that must not change which LOD is drawn, like reflection probes.
+	_FORCE_INLINE_ bool _instance_in_draw_range(Instance *p_instance, const Vector3 &p_cam_pos, bool p_update) {
+		return !p_instance->draw_range_enabled || _instance_check_draw_range(p_instance, p_cam_pos, p_update);
+	}
+
+	void _shadow_cull_job(uint32_t p_job, ShadowCullParams *p_params);
+	bool _cull_shadow_jobs(int p_count, Scenario *p_scenario, const Vector3 &p_cam_pos, bool p_update_draw_ranges);
+	bool _light_instance_update_shadow(Instance *p_instance, const Transform p_cam_transform, const CameraMatrix &p_cam_projection, bool p_cam_orthogonal, RID p_shadow_atlas, Scenario *p_scenario, bool p_update_draw_ranges);
+
+	void _occlusion_test_job(uint32_t p_chunk, void *p_userdata);
+	void _occlusion_cull(const Transform &p_cam_transform, const CameraMatrix &p_cam_projection, Scenario *p_scenario);
+
+	_FORCE_INLINE_ void _prepare_instance_geometry(Instance *p_instance, const Plane &p_near_plane, float p_z_far);
+	void _prepare_instance_job(uint32_t p_chunk, PrepareCullParams *p_params);
 
 	void _prepare_scene(const Transform p_cam_transform, const CameraMatrix &p_cam_projection, bool p_cam_orthogonal, RID p_force_environment, uint32_t p_visible_layers, RID p_scenario, RID p_shadow_atlas, RID p_reflection_probe);
 	void _render_scene(const Transform p_cam_transform, const CameraMatrix &p_cam_projection, bool p_cam_orthogonal, RID p_force_environment, RID p_scenario, RID p_shadow_atlas, RID p_reflection_probe, int p_reflection_probe_pass);
@@ -610,6 +717,9 @@ public:
 
 	void render_probes();
 
+	void begin_frame();
+	uint64_t get_occluded_objects_in_frame() const { return occlusion_culled_in_frame; }
+
 	bool free(RID p_rid);
 
 	VisualServerScene();